@@ -21,6 +21,8 @@
 #include <vector>
 
 namespace lld {
+template <class Derived, class T> class ICFBase;
+
 namespace coff {
 
 using llvm::COFF::ImportDirectoryTableEntry;
@@ -33,6 +35,7 @@ class Baserel;
 class Defined;
 class DefinedImportData;
 class DefinedRegular;
+class ICF;
 class ObjectFile;
 class OutputSection;
 class SymbolBody;
@@ -114,6 +117,7 @@ protected:
 class SectionChunk : public Chunk {
   // Identical COMDAT Folding feature accesses section internal data.
   friend class ICF;
+  friend class ICFBase<ICF, SectionChunk>;
 
 public:
   class symbol_iterator : public llvm::iterator_adaptor_base<
@@ -201,7 +205,7 @@ private:
 
   // Used for ICF (Identical COMDAT Folding)
   void replace(SectionChunk *Other);
-  uint32_t Color[2] = {0, 0};
+  uint32_t Class[2] = {0, 0};
 
   // Sym points to a section symbol if this is a COMDAT chunk.
   DefinedRegular *Sym = nullptr;
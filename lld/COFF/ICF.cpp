@@ -14,19 +14,19 @@
 //
 // On Windows, ICF is enabled by default.
 //
-// See ELF/ICF.cpp for the details about the algortihm.
+// See ELF/ICF.cpp for the details about the algortihm. The algorithm
+// itself is in lld/Core/ICF.h and is shared with the ELF linker.
 //
 //===----------------------------------------------------------------------===//
 
 #include "Chunks.h"
 #include "Error.h"
 #include "Symbols.h"
-#include "lld/Core/Parallel.h"
+#include "lld/Core/ICF.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
-#include <algorithm>
-#include <atomic>
 #include <vector>
 
 using namespace llvm;
@@ -34,30 +34,20 @@ using namespace llvm;
 namespace lld {
 namespace coff {
 
-class ICF {
+class ICF : public ICFBase<ICF, SectionChunk> {
+  friend ICFBase<ICF, SectionChunk>;
+
 public:
+  ICF() : ICFBase(true) {}
   void run(const std::vector<Chunk *> &V);
 
 private:
-  void segregate(size_t Begin, size_t End, bool Constant);
-
   bool equalsConstant(const SectionChunk *A, const SectionChunk *B);
   bool equalsVariable(const SectionChunk *A, const SectionChunk *B);
+  bool isEquivalent(SectionChunk *A, SectionChunk *B);
 
   uint32_t getHash(SectionChunk *C);
   bool isEligible(SectionChunk *C);
-
-  size_t findBoundary(size_t Begin, size_t End);
-
-  void forEachColorRange(size_t Begin, size_t End,
-                         std::function<void(size_t, size_t)> Fn);
-
-  void forEachColor(std::function<void(size_t, size_t)> Fn);
-
-  std::vector<SectionChunk *> Chunks;
-  int Cnt = 0;
-  std::atomic<uint32_t> NextId = {1};
-  std::atomic<bool> Repeat = {false};
 };
 
 // Returns a hash value for S.
@@ -77,30 +67,13 @@ bool ICF::isEligible(SectionChunk *C) {
   return C->isCOMDAT() && C->isLive() && Global && !Writable;
 }
 
-// Split a range into smaller ranges by recoloring sections
-void ICF::segregate(size_t Begin, size_t End, bool Constant) {
-  while (Begin < End) {
-    // Divide [Begin, End) into two. Let Mid be the start index of the
-    // second group.
-    auto Bound = std::stable_partition(
-        Chunks.begin() + Begin + 1, Chunks.begin() + End, [&](SectionChunk *S) {
-          if (Constant)
-            return equalsConstant(Chunks[Begin], S);
-          return equalsVariable(Chunks[Begin], S);
-        });
-    size_t Mid = Bound - Chunks.begin();
-
-    // Split [Begin, End) into [Begin, Mid) and [Mid, End).
-    uint32_t Id = NextId++;
-    for (size_t I = Begin; I < Mid; ++I)
-      Chunks[I]->Color[(Cnt + 1) % 2] = Id;
-
-    // If we created a group, we need to iterate the main loop again.
-    if (Mid != End)
-      Repeat = true;
-
-    Begin = Mid;
-  }
+// Returns true if two chunks are in the same equivalence class.
+// Ineligible chunks are in the special class 0, and they are
+// equivalent only to themselves.
+bool ICF::isEquivalent(SectionChunk *A, SectionChunk *B) {
+  if (A == B)
+    return true;
+  return A->Class[Current] != 0 && A->Class[Current] == B->Class[Current];
 }
 
 // Compare "non-moving" part of two sections, namely everything
@@ -122,7 +95,7 @@ bool ICF::equalsConstant(const SectionChunk *A, const SectionChunk *B) {
     if (auto *D1 = dyn_cast<DefinedRegular>(B1))
       if (auto *D2 = dyn_cast<DefinedRegular>(B2))
         return D1->getValue() == D2->getValue() &&
-               D1->getChunk()->Color[Cnt % 2] == D2->getChunk()->Color[Cnt % 2];
+               isEquivalent(D1->getChunk(), D2->getChunk());
     return false;
   };
   if (!std::equal(A->Relocs.begin(), A->Relocs.end(), B->Relocs.begin(), Eq))
@@ -147,106 +120,50 @@ bool ICF::equalsVariable(const SectionChunk *A, const SectionChunk *B) {
       return true;
     if (auto *D1 = dyn_cast<DefinedRegular>(B1))
       if (auto *D2 = dyn_cast<DefinedRegular>(B2))
-        return D1->getChunk()->Color[Cnt % 2] == D2->getChunk()->Color[Cnt % 2];
+        return isEquivalent(D1->getChunk(), D2->getChunk());
     return false;
   };
   return std::equal(A->Relocs.begin(), A->Relocs.end(), B->Relocs.begin(), Eq);
 }
 
-size_t ICF::findBoundary(size_t Begin, size_t End) {
-  for (size_t I = Begin + 1; I < End; ++I)
-    if (Chunks[Begin]->Color[Cnt % 2] != Chunks[I]->Color[Cnt % 2])
-      return I;
-  return End;
-}
-
-void ICF::forEachColorRange(size_t Begin, size_t End,
-                            std::function<void(size_t, size_t)> Fn) {
-  if (Begin > 0)
-    Begin = findBoundary(Begin - 1, End);
-
-  while (Begin < End) {
-    size_t Mid = findBoundary(Begin, Chunks.size());
-    Fn(Begin, Mid);
-    Begin = Mid;
-  }
-}
-
-// Call Fn on each color group.
-void ICF::forEachColor(std::function<void(size_t, size_t)> Fn) {
-  // If the number of sections are too small to use threading,
-  // call Fn sequentially.
-  if (Chunks.size() < 1024) {
-    forEachColorRange(0, Chunks.size(), Fn);
-    return;
-  }
-
-  // Split sections into 256 shards and call Fn in parallel.
-  size_t NumShards = 256;
-  size_t Step = Chunks.size() / NumShards;
-  parallel_for(size_t(0), NumShards, [&](size_t I) {
-    forEachColorRange(I * Step, (I + 1) * Step, Fn);
-  });
-  forEachColorRange(Step * NumShards, Chunks.size(), Fn);
-}
-
 // Merge identical COMDAT sections.
 // Two sections are considered the same if their section headers,
 // contents and relocations are all the same.
 void ICF::run(const std::vector<Chunk *> &Vec) {
-  // Collect only mergeable sections and group by hash value.
-  for (Chunk *C : Vec) {
-    auto *SC = dyn_cast<SectionChunk>(C);
-    if (!SC)
-      continue;
+  // Collect only mergeable sections.
+  for (Chunk *C : Vec)
+    if (auto *SC = dyn_cast<SectionChunk>(C))
+      if (isEligible(SC))
+        Sections.push_back(SC);
 
-    if (isEligible(SC)) {
-      // Set MSB to 1 to avoid collisions with non-hash colors.
-      SC->Color[0] = getHash(SC) | (1 << 31);
-      Chunks.push_back(SC);
-    } else {
-      SC->Color[0] = NextId++;
-    }
-  }
-
-  if (Chunks.empty())
+  if (Sections.empty())
     return;
 
-  // From now on, sections in Chunks are ordered so that sections in
-  // the same group are consecutive in the vector.
-  std::stable_sort(Chunks.begin(), Chunks.end(),
-                   [](SectionChunk *A, SectionChunk *B) {
-                     return A->Color[0] < B->Color[0];
-                   });
-
-  // Compare static contents and assign unique IDs for each static content.
-  forEachColor([&](size_t Begin, size_t End) { segregate(Begin, End, true); });
-  ++Cnt;
-
-  // Split groups by comparing relocations until convergence is obtained.
-  do {
-    Repeat = false;
-    forEachColor(
-        [&](size_t Begin, size_t End) { segregate(Begin, End, false); });
-    ++Cnt;
-  } while (Repeat);
+  partition();
 
   if (Config->Verbose)
     outs() << "\nICF needed " << Cnt << " iterations\n";
 
-  // Merge sections in the same colors.
-  forEachColor([&](size_t Begin, size_t End) {
-    if (End - Begin == 1)
-      return;
+  // Merge sections in the same classes.
+  timePhase("merge", [&] {
+    forEachClass([&](size_t Begin, size_t End) {
+      if (End - Begin == 1)
+        return;
 
-    if (Config->Verbose)
-      outs() << "Selected " << Chunks[Begin]->getDebugName() << "\n";
-    for (size_t I = Begin + 1; I < End; ++I) {
       if (Config->Verbose)
-        outs() << "  Removed " << Chunks[I]->getDebugName() << "\n";
-      Chunks[Begin]->replace(Chunks[I]);
-    }
+        outs() << "Selected " << Sections[Begin]->getDebugName() << "\n";
+      for (size_t I = Begin + 1; I < End; ++I) {
+        if (Config->Verbose)
+          outs() << "  Removed " << Sections[I]->getDebugName() << "\n";
+        Sections[Begin]->replace(Sections[I]);
+      }
+    });
   });
+
+  if (Config->Verbose)
+    for (const PhaseTime &P : getPhaseTimes())
+      outs() << "ICF " << P.Name << " phase took "
+             << format("%.2f", P.Milliseconds) << " ms\n";
 }
 
 // Entry point to ICF.
@@ -0,0 +1,198 @@
+//===- CallGraphSort.cpp --------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements --call-graph-ordering-file, which lays out input
+// sections so that functions that call each other frequently are close
+// to each other in the output. That reduces instruction cache and TLB
+// misses of hot code.
+//
+// The input is a list of call edges with execution counts, which can be
+// created from an instrumented or sampled profile. We use the algorithm
+// described in "Optimizing Function Placement for Large-Scale
+// Data-Center Applications" (Ottoni and Maher, CGO 2017), which is
+// called C3. C3 is a variant of the Pettis-Hansen algorithm.
+//
+// Initially, each section is in its own cluster. We visit sections in
+// decreasing order of their density (the number of calls to a section
+// divided by its size). For each section, we find the caller that calls
+// the section most frequently, and append the section's cluster to the
+// caller's cluster. Unlike Pettis-Hansen, this always places a callee
+// after its caller, which is a better order for a processor that
+// prefetches instructions forward. We don't merge clusters if the result
+// is too large to benefit from locality, or if merging would make the
+// density of the hot cluster much lower. Finally, clusters are sorted by
+// density.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CallGraphSort.h"
+#include "Config.h"
+#include "Error.h"
+#include "InputFiles.h"
+#include "InputSection.h"
+#include "SymbolTable.h"
+#include "Symbols.h"
+#include "llvm/ADT/MapVector.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::object;
+
+using namespace lld;
+using namespace lld::elf;
+
+namespace {
+struct Cluster {
+  double getDensity() const {
+    return double(Weight) / std::max<uint64_t>(Size, 1);
+  }
+
+  std::vector<int> Sections;
+  uint64_t Size = 0;
+  uint64_t Weight = 0;
+
+  // The caller that calls this cluster's first section most frequently.
+  int BestPred = -1;
+  uint64_t BestPredWeight = 0;
+};
+} // namespace
+
+// We don't create a cluster larger than this because functions that far
+// apart don't share i-cache lines or pages anyway.
+static const uint64_t MaxClusterSize = 1024 * 1024;
+
+// We don't merge a cluster into another if the merged cluster would be
+// less dense than this fraction of the original one, so that a cold
+// callee doesn't dilute a hot caller.
+static const uint64_t MaxDensityDegradation = 8;
+
+// Returns a map from sections to their priorities. Sections with lower
+// priorities are placed first. Sections not in the map have priority 0,
+// so they are placed after all sections in the call graph.
+template <class ELFT>
+DenseMap<InputSectionBase<ELFT> *, int> elf::computeCallGraphProfileOrder() {
+  // Build a map from symbol names to sections. We use symbols in object
+  // files rather than the symbol table to find local functions as well.
+  DenseMap<StringRef, InputSection<ELFT> *> SymbolSections;
+  for (elf::ObjectFile<ELFT> *File : Symtab<ELFT>::X->getObjectFiles()) {
+    for (SymbolBody *Body : File->getSymbols()) {
+      auto *D = dyn_cast<DefinedRegular<ELFT>>(Body);
+      if (!D || !D->Section)
+        continue;
+      auto *IS = dyn_cast<InputSection<ELFT>>(D->Section->Repl);
+      if (IS && IS->Live && IS->OutSec)
+        SymbolSections.insert({D->getName(), IS});
+    }
+  }
+
+  // Build a graph whose nodes are sections. Calls between functions in
+  // the same section are not interesting.
+  std::vector<InputSection<ELFT> *> Sections;
+  DenseMap<InputSection<ELFT> *, int> SectionIndex;
+  MapVector<std::pair<int, int>, uint64_t> Edges;
+
+  auto GetIndex = [&](InputSection<ELFT> *IS) {
+    auto P = SectionIndex.insert({IS, Sections.size()});
+    if (P.second)
+      Sections.push_back(IS);
+    return P.first->second;
+  };
+
+  for (const CallGraphEdge &E : Config->CallGraphProfile) {
+    InputSection<ELFT> *From = SymbolSections.lookup(E.Caller);
+    InputSection<ELFT> *To = SymbolSections.lookup(E.Callee);
+    if (!From || !To || From == To)
+      continue;
+    Edges[{GetIndex(From), GetIndex(To)}] += E.Count;
+  }
+
+  std::vector<Cluster> Clusters(Sections.size());
+  for (size_t I = 0, E = Sections.size(); I < E; ++I) {
+    Clusters[I].Sections.push_back(I);
+    Clusters[I].Size = Sections[I]->getSize();
+  }
+
+  for (const std::pair<std::pair<int, int>, uint64_t> &P : Edges) {
+    int From = P.first.first;
+    Cluster &To = Clusters[P.first.second];
+    To.Weight += P.second;
+    if (To.BestPred == -1 || To.BestPredWeight < P.second) {
+      To.BestPred = From;
+      To.BestPredWeight = P.second;
+    }
+  }
+
+  // Visit sections in decreasing order of density.
+  std::vector<int> Order(Sections.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  std::stable_sort(Order.begin(), Order.end(), [&](int A, int B) {
+    return Clusters[A].getDensity() > Clusters[B].getDensity();
+  });
+
+  // Leaders[I] is the index of the cluster that section I belongs to.
+  std::vector<int> Leaders(Sections.size());
+  std::iota(Leaders.begin(), Leaders.end(), 0);
+
+  for (int I : Order) {
+    Cluster &C = Clusters[I];
+    if (C.BestPred == -1)
+      continue;
+
+    int PredI = Leaders[C.BestPred];
+    if (PredI == I)
+      continue;
+
+    Cluster &Pred = Clusters[PredI];
+    if (Pred.Size + C.Size > MaxClusterSize)
+      continue;
+
+    double NewDensity = double(Pred.Weight + C.Weight) /
+                        std::max<uint64_t>(Pred.Size + C.Size, 1);
+    if (NewDensity * MaxDensityDegradation < Pred.getDensity())
+      continue;
+
+    // Append C to Pred.
+    for (int S : C.Sections)
+      Leaders[S] = PredI;
+    Pred.Sections.insert(Pred.Sections.end(), C.Sections.begin(),
+                         C.Sections.end());
+    Pred.Size += C.Size;
+    Pred.Weight += C.Weight;
+    C.Sections.clear();
+  }
+
+  // Sort clusters by density and assign priorities to their sections.
+  std::vector<int> Sorted;
+  for (size_t I = 0, E = Clusters.size(); I < E; ++I)
+    if (!Clusters[I].Sections.empty())
+      Sorted.push_back(I);
+  std::stable_sort(Sorted.begin(), Sorted.end(), [&](int A, int B) {
+    return Clusters[A].getDensity() > Clusters[B].getDensity();
+  });
+
+  DenseMap<InputSectionBase<ELFT> *, int> Ret;
+  int Priority = -(int)Sections.size();
+  for (int I : Sorted)
+    for (int S : Clusters[I].Sections)
+      Ret[Sections[S]] = Priority++;
+  log("call graph profile: " + Twine(Sections.size()) + " sections in " +
+      Twine(Sorted.size()) + " clusters");
+  return Ret;
+}
+
+template DenseMap<InputSectionBase<ELF32LE> *, int>
+elf::computeCallGraphProfileOrder<ELF32LE>();
+template DenseMap<InputSectionBase<ELF32BE> *, int>
+elf::computeCallGraphProfileOrder<ELF32BE>();
+template DenseMap<InputSectionBase<ELF64LE> *, int>
+elf::computeCallGraphProfileOrder<ELF64LE>();
+template DenseMap<InputSectionBase<ELF64BE> *, int>
+elf::computeCallGraphProfileOrder<ELF64BE>();
@@ -55,6 +55,14 @@ struct SymbolVersion {
   bool HasWildcard;
 };
 
+// For --call-graph-ordering-file. A call from Caller to Callee that
+// was executed Count times.
+struct CallGraphEdge {
+  llvm::StringRef Caller;
+  llvm::StringRef Callee;
+  uint64_t Count;
+};
+
 // This struct contains symbols version definition that
 // can be found in version script if it is used for link.
 struct VersionDefinition {
@@ -83,9 +91,11 @@ struct Configuration {
   llvm::StringRef OutputFile;
   llvm::StringRef SoName;
   llvm::StringRef Sysroot;
+  llvm::StringRef TimeTraceFile;
   llvm::StringSet<> RetainSymbolsFile;
   std::string RPath;
   std::vector<VersionDefinition> VersionDefinitions;
+  std::vector<CallGraphEdge> CallGraphProfile;
   std::vector<llvm::StringRef> AuxiliaryList;
   std::vector<llvm::StringRef> SearchPaths;
   std::vector<llvm::StringRef> SymbolOrderingFile;
@@ -93,6 +103,7 @@ struct Configuration {
   std::vector<SymbolVersion> VersionScriptGlobals;
   std::vector<SymbolVersion> VersionScriptLocals;
   std::vector<uint8_t> BuildIdVector;
+  std::vector<uint64_t> ScriptHashes;
   bool AllowMultipleDefinition;
   bool AsNeeded = false;
   bool Bsymbolic;
@@ -108,6 +119,7 @@ struct Configuration {
   bool GdbIndex;
   bool GnuHash = false;
   bool ICF;
+  bool Incremental;
   bool Mips64EL = false;
   bool MipsN32Abi = false;
   bool NoGnuUnique;
@@ -127,6 +139,7 @@ struct Configuration {
   bool SysvHash = true;
   bool Target1Rel;
   bool Threads;
+  bool TimeTrace;
   bool Trace;
   bool Verbose;
   bool WarnCommon;
@@ -149,6 +162,7 @@ struct Configuration {
   uint16_t DefaultSymbolVersion = llvm::ELF::VER_NDX_GLOBAL;
   uint16_t EMachine = llvm::ELF::EM_NONE;
   uint64_t ErrorLimit = 20;
+  uint64_t CommandLineHash = 0;
   uint64_t ImageBase;
   uint64_t MaxPageSize;
   uint64_t ZStackSize;
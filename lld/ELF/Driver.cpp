@@ -19,6 +19,7 @@
 #include "SymbolTable.h"
 #include "Target.h"
 #include "Threads.h"
+#include "Trace.h"
 #include "Writer.h"
 #include "lld/Config/Version.h"
 #include "lld/Driver/Driver.h"
@@ -28,6 +29,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <cstdlib>
 #include <utility>
 
@@ -57,6 +59,7 @@ bool elf::link(ArrayRef<const char *> Args, bool CanExitEarly,
   ScriptConfig = make<ScriptConfiguration>();
 
   Driver->main(Args, CanExitEarly);
+  writeTrace();
   freeArena();
   return !ErrorCount;
 }
@@ -235,6 +238,8 @@ static void checkOptions(opt::InputArgList &Args) {
       error("-r and --icf may not be used together");
     if (Config->Pie)
       error("-r and -pie may not be used together");
+    if (Config->Incremental)
+      error("-r and --incremental may not be used together");
   }
 }
 
@@ -323,8 +328,12 @@ void LinkerDriver::main(ArrayRef<const char *> ArgsArr, bool CanExitEarly) {
   }
 
   readConfigs(Args);
+  startTrace();
   initLLVM(Args);
-  createFiles(Args);
+  {
+    TraceScope Scope("Read input files");
+    createFiles(Args);
+  }
   inferMachineType();
   checkOptions(Args);
   if (ErrorCount)
@@ -472,6 +481,21 @@ static std::vector<StringRef> getLines(MemoryBufferRef MB) {
   return Ret;
 }
 
+// Parses --call-graph-ordering-file. Each line consists of a caller
+// symbol name, a callee symbol name and a call count.
+static void readCallGraph(MemoryBufferRef MB) {
+  for (StringRef Line : getLines(MB)) {
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, ' ', -1, false);
+    uint64_t Count;
+    if (Fields.size() != 3 || Fields[2].getAsInteger(10, Count)) {
+      error(MB.getBufferIdentifier() + ": parse error: " + Line);
+      return;
+    }
+    Config->CallGraphProfile.push_back({Fields[0], Fields[1], Count});
+  }
+}
+
 // Initializes Config members by the command line options.
 void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   for (auto *Arg : Args.filtered(OPT_L))
@@ -504,6 +528,7 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->GcSections = getArg(Args, OPT_gc_sections, OPT_no_gc_sections, false);
   Config->GdbIndex = Args.hasArg(OPT_gdb_index);
   Config->ICF = Args.hasArg(OPT_icf);
+  Config->Incremental = Args.hasArg(OPT_incremental);
   Config->NoGnuUnique = Args.hasArg(OPT_no_gnu_unique);
   Config->NoUndefinedVersion = Args.hasArg(OPT_no_undefined_version);
   Config->Nostdlib = Args.hasArg(OPT_nostdlib);
@@ -517,6 +542,8 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->Shared = Args.hasArg(OPT_shared);
   Config->Target1Rel = getArg(Args, OPT_target1_rel, OPT_target1_abs, false);
   Config->Threads = getArg(Args, OPT_threads, OPT_no_threads, true);
+  Config->TimeTrace =
+      Args.hasArg(OPT_time_trace) || Args.hasArg(OPT_time_trace_file);
   Config->Trace = Args.hasArg(OPT_trace);
   Config->Verbose = Args.hasArg(OPT_verbose);
   Config->WarnCommon = Args.hasArg(OPT_warn_common);
@@ -530,6 +557,7 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->OutputFile = getString(Args, OPT_o);
   Config->SoName = getString(Args, OPT_soname);
   Config->Sysroot = getString(Args, OPT_sysroot);
+  Config->TimeTraceFile = getString(Args, OPT_time_trace_file);
 
   Config->Optimize = getInteger(Args, OPT_O, 1);
   Config->LTOO = getInteger(Args, OPT_lto_O, 2);
@@ -542,6 +570,11 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   if (Config->ThinLTOJobs == 0)
     error("--thinlto-jobs: number of threads must be > 0");
 
+  // --incremental updates the output only if the command line is the
+  // same as the previous link's.
+  if (Config->Incremental)
+    Config->CommandLineHash = xxHash64(createResponseFile(Args));
+
   Config->ZCombreloc = !hasZOption(Args, "nocombreloc");
   Config->ZExecstack = hasZOption(Args, "execstack");
   Config->ZNodelete = hasZOption(Args, "nodelete");
@@ -618,6 +651,14 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
     if (Optional<MemoryBufferRef> Buffer = readFile(Arg->getValue()))
       Config->SymbolOrderingFile = getLines(*Buffer);
 
+  if (auto *Arg = Args.getLastArg(OPT_call_graph_ordering_file)) {
+    if (Args.hasArg(OPT_symbol_ordering_file))
+      warn("--symbol-ordering-file is given; ignoring "
+           "--call-graph-ordering-file");
+    else if (Optional<MemoryBufferRef> Buffer = readFile(Arg->getValue()))
+      readCallGraph(*Buffer);
+  }
+
   // If --retain-symbol-file is used, we'll retail only the symbols listed in
   // the file and discard all others.
   if (auto *Arg = Args.getLastArg(OPT_retain_symbols_file)) {
@@ -782,10 +823,18 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
   for (auto *Arg : Args.filtered(OPT_trace_symbol))
     Symtab.trace(Arg->getValue());
 
+  // Hash symbol names in parallel so that serial symbol resolution
+  // below doesn't have to do that.
+  if (Config->Threads)
+    Symtab.hashSymbols(Files);
+
   // Add all files to the symbol table. This will add almost all
   // symbols that we need to the symbol table.
-  for (InputFile *F : Files)
-    Symtab.addFile(F);
+  {
+    TraceScope Scope("Resolve symbols");
+    for (InputFile *F : Files)
+      Symtab.addFile(F);
+  }
 
   // If an entry symbol is in a static archive, pull out that file now
   // to complete the symbol table. After this, no new names except a
@@ -805,6 +854,11 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
   if (ErrorCount)
     return;
 
+  if (Config->Verbose)
+    for (InputFile *F : Files)
+      if (auto *A = dyn_cast<ArchiveFile>(F))
+        A->logStats();
+
   for (auto *Arg : Args.filtered(OPT_wrap))
     Symtab.wrap(Arg->getValue());
 
@@ -827,15 +881,18 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
 
   // MergeInputSection::splitIntoPieces needs to be called before
   // any call of MergeInputSection::getOffset. Do that.
-  forEach(Symtab.Sections.begin(), Symtab.Sections.end(),
-          [](InputSectionBase<ELFT> *S) {
-            if (!S->Live)
-              return;
-            if (S->isCompressed())
-              S->uncompress();
-            if (auto *MS = dyn_cast<MergeInputSection<ELFT>>(S))
-              MS->splitIntoPieces();
-          });
+  {
+    TraceScope Scope("Split sections");
+    forEach(Symtab.Sections.begin(), Symtab.Sections.end(),
+            [](InputSectionBase<ELFT> *S) {
+              if (!S->Live)
+                return;
+              if (S->isCompressed())
+                S->uncompress();
+              if (auto *MS = dyn_cast<MergeInputSection<ELFT>>(S))
+                MS->splitIntoPieces();
+            });
+  }
 
   // Write the result to the file.
   writeResult<ELFT>();
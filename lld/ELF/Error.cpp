@@ -9,6 +9,7 @@
 
 #include "Error.h"
 #include "Config.h"
+#include "Trace.h"
 
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Error.h"
@@ -61,20 +62,26 @@ void elf::warn(const Twine &Msg) {
 }
 
 void elf::error(const Twine &Msg) {
-  std::lock_guard<std::mutex> Lock(Mu);
-
-  if (Config->ErrorLimit == 0 || ErrorCount < Config->ErrorLimit) {
-    print("error: ", raw_ostream::RED);
-    *ErrorOS << Msg << "\n";
-  } else if (ErrorCount == Config->ErrorLimit) {
-    print("error: ", raw_ostream::RED);
-    *ErrorOS << "too many errors emitted, stopping now"
-             << " (use -error-limit=0 to see all errors)\n";
-    if (Config->ExitEarly)
-      exitLld(1);
+  bool Exit = false;
+  {
+    std::lock_guard<std::mutex> Lock(Mu);
+
+    if (Config->ErrorLimit == 0 || ErrorCount < Config->ErrorLimit) {
+      print("error: ", raw_ostream::RED);
+      *ErrorOS << Msg << "\n";
+    } else if (ErrorCount == Config->ErrorLimit) {
+      print("error: ", raw_ostream::RED);
+      *ErrorOS << "too many errors emitted, stopping now"
+               << " (use -error-limit=0 to see all errors)\n";
+      Exit = Config->ExitEarly;
+    }
+
+    ++ErrorCount;
   }
 
-  ++ErrorCount;
+  // exitLld may report errors, so it must be called without Mu held.
+  if (Exit)
+    exitLld(1);
 }
 
 void elf::error(std::error_code EC, const Twine &Prefix) {
@@ -82,6 +89,9 @@ void elf::error(std::error_code EC, const Twine &Prefix) {
 }
 
 void elf::exitLld(int Val) {
+  // Write the --time-trace file, which is useful for failed links too.
+  writeTrace();
+
   // Dealloc/destroy ManagedStatic variables before calling
   // _exit(). In a non-LTO build, this is a nop. In an LTO
   // build allows us to get the output of -time-passes.
@@ -93,9 +103,11 @@ void elf::exitLld(int Val) {
 }
 
 void elf::fatal(const Twine &Msg) {
-  std::lock_guard<std::mutex> Lock(Mu);
-  print("error: ", raw_ostream::RED);
-  *ErrorOS << Msg << "\n";
+  {
+    std::lock_guard<std::mutex> Lock(Mu);
+    print("error: ", raw_ostream::RED);
+    *ErrorOS << Msg << "\n";
+  }
   exitLld(1);
 }
 
@@ -11,6 +11,7 @@
 #define LLD_ELF_GDB_INDEX_H
 
 #include "InputFiles.h"
+#include "llvm/ADT/CachedHashString.h"
 #include "llvm/Object/ELF.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 
@@ -39,6 +40,9 @@ template <class ELFT> class GdbIndexBuilder : public llvm::LoadedObjectInfo {
 public:
   GdbIndexBuilder(InputSection<ELFT> *DebugInfoSec);
 
+  // Returns false if we failed to create a DWARF context.
+  bool isValid() const { return Dwarf != nullptr; }
+
   // Extracts the compilation units. Each first element of pair is a offset of a
   // CU in the .debug_info section and second is the length of that CU.
   std::vector<std::pair<uintX_t, uintX_t>> readCUList();
@@ -59,6 +63,14 @@ private:
   std::unique_ptr<llvm::LoadedObjectInfo> clone() const override;
 };
 
+// A name in .debug_gnu_pubnames or .debug_gnu_pubtypes section.
+struct GdbPubName {
+  llvm::CachedHashStringRef Name;
+  // The hash value of Name as defined by the .gdb_index format.
+  uint32_t Hash;
+  uint8_t Type;
+};
+
 // Element of GdbHashTab hash table.
 struct GdbSymbol {
   GdbSymbol(uint32_t Hash, size_t Offset)
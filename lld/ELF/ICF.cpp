@@ -67,6 +67,9 @@
 // 2.8 GHz 40 core machine. Even without threading, LLD's ICF is still
 // faster than MSVC or gold though.
 //
+// The linker-independent part of this algorithm is in lld/Core/ICF.h
+// so that the COFF linker can share it.
+//
 // [1] Safe ICF: Pointer Safe and Unwinding aware Identical Code Folding
 // in the Gold Linker
 // http://static.googleusercontent.com/media/research.google.com/en//pubs/archive/36912.pdf
@@ -76,13 +79,12 @@
 #include "ICF.h"
 #include "Config.h"
 #include "SymbolTable.h"
-#include "Threads.h"
-
+#include "Trace.h"
+#include "lld/Core/ICF.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Object/ELF.h"
 #include "llvm/Support/ELF.h"
-#include <algorithm>
-#include <atomic>
+#include "llvm/Support/FormatVariadic.h"
 
 using namespace lld;
 using namespace lld::elf;
@@ -91,12 +93,21 @@ using namespace llvm::ELF;
 using namespace llvm::object;
 
 namespace {
-template <class ELFT> class ICF {
+template <class ELFT>
+class ICF : public ICFBase<ICF<ELFT>, InputSection<ELFT>> {
+  typedef ICFBase<ICF<ELFT>, InputSection<ELFT>> Base;
+  friend Base;
+
+  using Base::Sections;
+  using Base::Current;
+  using Base::Cnt;
+
 public:
+  ICF() : Base(Config->Threads) {}
   void run();
 
 private:
-  void segregate(size_t Begin, size_t End, bool Constant);
+  uint32_t getHash(InputSection<ELFT> *S);
 
   template <class RelTy>
   bool constantEq(ArrayRef<RelTy> RelsA, ArrayRef<RelTy> RelsB);
@@ -107,54 +118,12 @@ private:
 
   bool equalsConstant(const InputSection<ELFT> *A, const InputSection<ELFT> *B);
   bool equalsVariable(const InputSection<ELFT> *A, const InputSection<ELFT> *B);
-
-  size_t findBoundary(size_t Begin, size_t End);
-
-  void forEachClassRange(size_t Begin, size_t End,
-                         std::function<void(size_t, size_t)> Fn);
-
-  void forEachClass(std::function<void(size_t, size_t)> Fn);
-
-  std::vector<InputSection<ELFT> *> Sections;
-
-  // We repeat the main loop while `Repeat` is true.
-  std::atomic<bool> Repeat;
-
-  // The main loop counter.
-  int Cnt = 0;
-
-  // We have two locations for equivalence classes. On the first iteration
-  // of the main loop, Class[0] has a valid value, and Class[1] contains
-  // garbage. We read equivalence classes from slot 0 and write to slot 1.
-  // So, Class[0] represents the current class, and Class[1] represents
-  // the next class. On each iteration, we switch their roles and use them
-  // alternately.
-  //
-  // Why are we doing this? Recall that other threads may be working on
-  // other equivalence classes in parallel. They may read sections that we
-  // are updating. We cannot update equivalence classes in place because
-  // it breaks the invariance that all possibly-identical sections must be
-  // in the same equivalence class at any moment. In other words, the for
-  // loop to update equivalence classes is not atomic, and that is
-  // observable from other threads. By writing new classes to other
-  // places, we can keep the invariance.
-  //
-  // Below, `Current` has the index of the current class, and `Next` has
-  // the index of the next class. If threading is enabled, they are either
-  // (0, 1) or (1, 0).
-  //
-  // Note on single-thread: if that's the case, they are always (0, 0)
-  // because we can safely read the next class without worrying about race
-  // conditions. Using the same location makes this algorithm converge
-  // faster because it uses results of the same iteration earlier.
-  int Current = 0;
-  int Next = 0;
 };
 }
 
 // Returns a hash value for S. Note that the information about
 // relocation targets is not included in the hash value.
-template <class ELFT> static uint32_t getHash(InputSection<ELFT> *S) {
+template <class ELFT> uint32_t ICF<ELFT>::getHash(InputSection<ELFT> *S) {
   return hash_combine(S->Flags, S->getSize(), S->NumRelocations);
 }
 
@@ -167,43 +136,6 @@ template <class ELFT> static bool isEligible(InputSection<ELFT> *S) {
          S->Name != ".init" && S->Name != ".fini";
 }
 
-// Split an equivalence class into smaller classes.
-template <class ELFT>
-void ICF<ELFT>::segregate(size_t Begin, size_t End, bool Constant) {
-  // This loop rearranges sections in [Begin, End) so that all sections
-  // that are equal in terms of equals{Constant,Variable} are contiguous
-  // in [Begin, End).
-  //
-  // The algorithm is quadratic in the worst case, but that is not an
-  // issue in practice because the number of the distinct sections in
-  // each range is usually very small.
-
-  while (Begin < End) {
-    // Divide [Begin, End) into two. Let Mid be the start index of the
-    // second group.
-    auto Bound = std::stable_partition(
-        Sections.begin() + Begin + 1, Sections.begin() + End,
-        [&](InputSection<ELFT> *S) {
-          if (Constant)
-            return equalsConstant(Sections[Begin], S);
-          return equalsVariable(Sections[Begin], S);
-        });
-    size_t Mid = Bound - Sections.begin();
-
-    // Now we split [Begin, End) into [Begin, Mid) and [Mid, End) by
-    // updating the sections in [Begin, End). We use Mid as an equivalence
-    // class ID because every group ends with a unique index.
-    for (size_t I = Begin; I < Mid; ++I)
-      Sections[I]->Class[Next] = Mid;
-
-    // If we created a group, we need to iterate the main loop again.
-    if (Mid != End)
-      Repeat = true;
-
-    Begin = Mid;
-  }
-}
-
 // Compare two lists of relocations.
 template <class ELFT>
 template <class RelTy>
@@ -278,57 +210,6 @@ bool ICF<ELFT>::equalsVariable(const InputSection<ELFT> *A,
   return variableEq(A, A->rels(), B, B->rels());
 }
 
-template <class ELFT> size_t ICF<ELFT>::findBoundary(size_t Begin, size_t End) {
-  uint32_t Class = Sections[Begin]->Class[Current];
-  for (size_t I = Begin + 1; I < End; ++I)
-    if (Class != Sections[I]->Class[Current])
-      return I;
-  return End;
-}
-
-// Sections in the same equivalence class are contiguous in Sections
-// vector. Therefore, Sections vector can be considered as contiguous
-// groups of sections, grouped by the class.
-//
-// This function calls Fn on every group that starts within [Begin, End).
-// Note that a group must starts in that range but doesn't necessarily
-// have to end before End.
-template <class ELFT>
-void ICF<ELFT>::forEachClassRange(size_t Begin, size_t End,
-                                  std::function<void(size_t, size_t)> Fn) {
-  if (Begin > 0)
-    Begin = findBoundary(Begin - 1, End);
-
-  while (Begin < End) {
-    size_t Mid = findBoundary(Begin, Sections.size());
-    Fn(Begin, Mid);
-    Begin = Mid;
-  }
-}
-
-// Call Fn on each equivalence class.
-template <class ELFT>
-void ICF<ELFT>::forEachClass(std::function<void(size_t, size_t)> Fn) {
-  // If threading is disabled or the number of sections are
-  // too small to use threading, call Fn sequentially.
-  if (!Config->Threads || Sections.size() < 1024) {
-    forEachClassRange(0, Sections.size(), Fn);
-    ++Cnt;
-    return;
-  }
-
-  Current = Cnt % 2;
-  Next = (Cnt + 1) % 2;
-
-  // Split sections into 256 shards and call Fn in parallel.
-  size_t NumShards = 256;
-  size_t Step = Sections.size() / NumShards;
-  forLoop(0, NumShards,
-          [&](size_t I) { forEachClassRange(I * Step, (I + 1) * Step, Fn); });
-  forEachClassRange(Step * NumShards, Sections.size(), Fn);
-  ++Cnt;
-}
-
 // The main function of ICF.
 template <class ELFT> void ICF<ELFT>::run() {
   // Collect sections to merge.
@@ -337,45 +218,33 @@ template <class ELFT> void ICF<ELFT>::run() {
       if (isEligible(S))
         Sections.push_back(S);
 
-  // Initially, we use hash values to partition sections.
-  for (InputSection<ELFT> *S : Sections)
-    // Set MSB to 1 to avoid collisions with non-hash IDs.
-    S->Class[0] = getHash(S) | (1 << 31);
-
-  // From now on, sections in Sections vector are ordered so that sections
-  // in the same equivalence class are consecutive in the vector.
-  std::stable_sort(Sections.begin(), Sections.end(),
-                   [](InputSection<ELFT> *A, InputSection<ELFT> *B) {
-                     return A->Class[0] < B->Class[0];
-                   });
-
-  // Compare static contents and assign unique IDs for each static content.
-  forEachClass([&](size_t Begin, size_t End) { segregate(Begin, End, true); });
-
-  // Split groups by comparing relocations until convergence is obtained.
-  do {
-    Repeat = false;
-    forEachClass(
-        [&](size_t Begin, size_t End) { segregate(Begin, End, false); });
-  } while (Repeat);
-
+  this->partition();
   log("ICF needed " + Twine(Cnt) + " iterations");
 
   // Merge sections by the equivalence class.
-  forEachClass([&](size_t Begin, size_t End) {
-    if (End - Begin == 1)
-      return;
-
-    log("selected " + Sections[Begin]->Name);
-    for (size_t I = Begin + 1; I < End; ++I) {
-      log("  removed " + Sections[I]->Name);
-      Sections[Begin]->replace(Sections[I]);
-    }
+  this->timePhase("merge", [&] {
+    this->forEachClass([&](size_t Begin, size_t End) {
+      if (End - Begin == 1)
+        return;
+
+      log("selected " + Sections[Begin]->Name);
+      for (size_t I = Begin + 1; I < End; ++I) {
+        log("  removed " + Sections[I]->Name);
+        Sections[Begin]->replace(Sections[I]);
+      }
+    });
   });
+
+  for (const typename Base::PhaseTime &P : this->getPhaseTimes())
+    log("ICF " + P.Name + " phase took " +
+        formatv("{0:f2}", P.Milliseconds).str() + " ms");
 }
 
 // ICF entry point function.
-template <class ELFT> void elf::doIcf() { ICF<ELFT>().run(); }
+template <class ELFT> void elf::doIcf() {
+  TraceScope Scope("ICF");
+  ICF<ELFT>().run();
+}
 
 template void elf::doIcf<ELF32LE>();
 template void elf::doIcf<ELF32BE>();
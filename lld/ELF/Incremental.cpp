@@ -0,0 +1,338 @@
+//===- Incremental.cpp ----------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements --incremental, an opt-in mode to make repeated
+// links in an edit-compile-link loop faster.
+//
+// A regular link creates a new output file and writes all sections to
+// it. With --incremental, we save a small state file next to the output
+// file (<output>.lld-incremental) which contains a hash value of the
+// output file layout and a hash value of each input object file. The
+// next link does symbol resolution and layout as usual, but if the
+// layout turns out to be exactly the same as the previous one, we update
+// the existing output file in place. In that case, we write only sections
+// of object files whose contents have changed and linker-synthesized
+// sections, skipping sections of all the other files. If anything does
+// not match, we just do a regular link.
+//
+// "Layout" here includes everything that the contents of an unchanged
+// input section in the output depend on. That is the command line, the
+// contents of linker scripts, the fillers of output sections, the
+// addresses and sizes of all output and input sections, the output
+// offsets of mergeable section pieces, and the addresses and GOT/PLT
+// slots of all global symbols. As long as they are the same, relocations
+// in unchanged sections are resolved to the same values, so the bytes of
+// the sections are the same too. That means the result of an incremental
+// link is identical to that of a full link.
+//
+// Because any change to the size of a section moves everything after
+// it, this works only for edits that don't change the sizes of sections
+// (such as changing a constant or a condition). We don't add padding
+// between sections to absorb growth because that would make incremental
+// outputs different from regular ones.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Incremental.h"
+#include "Config.h"
+#include "Error.h"
+#include "InputFiles.h"
+#include "InputSection.h"
+#include "LinkerScript.h"
+#include "OutputSections.h"
+#include "SymbolTable.h"
+#include "Symbols.h"
+#include "Target.h"
+#include "Threads.h"
+#include "lld/Config/Version.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace llvm;
+using namespace llvm::ELF;
+using namespace llvm::object;
+
+using namespace lld;
+using namespace lld::elf;
+
+bool elf::UpdatingInPlace;
+
+namespace {
+// The contents of a state file.
+struct State {
+  uint64_t LayoutHash = 0;
+  uint64_t OutputSize = 0;
+  uint64_t OutputTime = 0;
+  std::vector<std::pair<std::string, uint64_t>> Files;
+};
+
+// This class accumulates values to compute a hash value of them.
+class Hasher {
+public:
+  void add(uint64_t V) { Buf.append((const char *)&V, sizeof(V)); }
+  void add(StringRef S) {
+    add(S.size());
+    Buf.append(S.data(), S.size());
+  }
+  uint64_t hash() const { return xxHash64(Buf); }
+
+private:
+  std::string Buf;
+};
+} // namespace
+
+// The state of the current link. It is computed by
+// openIncrementalOutput and saved by saveIncrementalState.
+static State CurrentState;
+
+static std::string getStatePath() {
+  return (Config->OutputFile + ".lld-incremental").str();
+}
+
+static uint64_t getTime(const sys::fs::file_status &St) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             St.getLastModificationTime().time_since_epoch())
+      .count();
+}
+
+static Optional<State> readState() {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getFile(getStatePath());
+  if (!MBOrErr)
+    return None;
+
+  State S;
+  SmallVector<StringRef, 0> Lines;
+  (*MBOrErr)->getBuffer().split(Lines, '\n', -1, false);
+  for (StringRef Line : Lines) {
+    StringRef Key, Rest;
+    std::tie(Key, Rest) = Line.split(' ');
+
+    if (Key == "layout") {
+      if (Rest.getAsInteger(16, S.LayoutHash))
+        return None;
+    } else if (Key == "output") {
+      StringRef Size, Time;
+      std::tie(Size, Time) = Rest.split(' ');
+      if (Size.getAsInteger(10, S.OutputSize) ||
+          Time.getAsInteger(10, S.OutputTime))
+        return None;
+    } else if (Key == "file") {
+      StringRef Hash, Name;
+      std::tie(Hash, Name) = Rest.split(' ');
+      uint64_t V;
+      if (Hash.getAsInteger(16, V))
+        return None;
+      S.Files.push_back({Name, V});
+    } else {
+      return None;
+    }
+  }
+  return S;
+}
+
+// Computes a hash value of everything that the contents of an
+// unchanged input section in the output depend on.
+template <class ELFT>
+static uint64_t getLayoutHash(ArrayRef<OutputSectionBase *> OutputSections,
+                              uint64_t FileSize) {
+  ArrayRef<elf::ObjectFile<ELFT> *> Files = Symtab<ELFT>::X->getObjectFiles();
+  DenseMap<const InputFile *, uint64_t> FileIds;
+  for (size_t I = 0, E = Files.size(); I < E; ++I)
+    FileIds[Files[I]] = I + 1;
+
+  Hasher H;
+  H.add(getLLDVersion());
+  H.add(Config->CommandLineHash);
+  for (uint64_t V : Config->ScriptHashes)
+    H.add(V);
+  H.add(FileSize);
+
+  for (OutputSectionBase *Sec : OutputSections) {
+    H.add(Sec->Name);
+    H.add(Sec->Type);
+    H.add(Sec->Flags);
+    H.add(Sec->Addr);
+    H.add(Sec->Offset);
+    H.add(Sec->Size);
+    if (auto *OS = dyn_cast<OutputSection<ELFT>>(Sec)) {
+      // Gaps between input sections are not rewritten in place.
+      H.add(Script<ELFT>::X->getFiller(OS->Name));
+      for (InputSection<ELFT> *IS : OS->Sections) {
+        H.add(FileIds.lookup(IS->getFile()));
+        H.add(IS->Name);
+        H.add(IS->OutSecOff);
+        H.add(IS->getSize());
+      }
+    }
+  }
+
+  // Sections folded by ICF and pieces of mergeable sections.
+  for (InputSectionBase<ELFT> *IS : Symtab<ELFT>::X->Sections) {
+    H.add(IS->Live);
+    if (auto *S = dyn_cast<InputSection<ELFT>>(IS->Repl)) {
+      H.add(FileIds.lookup(S->getFile()));
+      H.add(S->OutSecOff);
+    } else if (auto *MS = dyn_cast<MergeInputSection<ELFT>>(IS)) {
+      for (const SectionPiece &Piece : MS->Pieces)
+        H.add(Piece.Live ? Piece.OutputOff : -1);
+    }
+  }
+
+  for (const Symbol *S : Symtab<ELFT>::X->getSymbols()) {
+    const SymbolBody *B = S->body();
+    H.add(B->getName());
+    H.add(B->kind());
+    H.add(B->GotIndex);
+    H.add(B->GotPltIndex);
+    H.add(B->PltIndex);
+    H.add(B->GlobalDynIndex);
+    H.add(B->NeedsCopyOrPltAddr);
+    H.add(B->IsInIplt);
+    H.add(B->IsInIgot);
+
+    if (auto *D = dyn_cast<DefinedRegular<ELFT>>(B))
+      if (D->Section && !D->Section->Live)
+        continue;
+    H.add(B->template getVA<ELFT>());
+  }
+  return H.hash();
+}
+
+template <class ELFT>
+static State getState(ArrayRef<OutputSectionBase *> OutputSections,
+                      uint64_t FileSize) {
+  ArrayRef<elf::ObjectFile<ELFT> *> Files = Symtab<ELFT>::X->getObjectFiles();
+
+  State S;
+  S.LayoutHash = getLayoutHash<ELFT>(OutputSections, FileSize);
+  S.OutputSize = FileSize;
+
+  std::vector<uint64_t> Hashes(Files.size());
+  forLoop(0, Files.size(),
+          [&](size_t I) { Hashes[I] = xxHash64(Files[I]->MB.getBuffer()); });
+  for (size_t I = 0, E = Files.size(); I < E; ++I)
+    S.Files.push_back({toString(Files[I]), Hashes[I]});
+  return S;
+}
+
+// Returns the existing output file if it can be updated in place.
+// Otherwise, returns nullptr, and the caller should create a new file.
+template <class ELFT>
+std::unique_ptr<IncrementalOutput>
+elf::openIncrementalOutput(ArrayRef<OutputSectionBase *> OutputSections,
+                           uint64_t FileSize) {
+  UpdatingInPlace = false;
+  CurrentState = State();
+
+  // Thunks and PPC64 .opd sections are written in a special way,
+  // so we don't support them.
+  if (Target->NeedsThunks || Config->EMachine == EM_PPC64 ||
+      Config->OFormatBinary) {
+    log("incremental: not supported for this output");
+    return nullptr;
+  }
+
+  CurrentState = getState<ELFT>(OutputSections, FileSize);
+  Optional<State> Old = readState();
+  if (!Old) {
+    log("incremental: no previous state found");
+    return nullptr;
+  }
+
+  sys::fs::file_status St;
+  if (sys::fs::status(Config->OutputFile, St) || St.getSize() != FileSize ||
+      Old->OutputSize != FileSize || Old->OutputTime != getTime(St)) {
+    log("incremental: output file has been changed");
+    return nullptr;
+  }
+
+  if (Old->LayoutHash != CurrentState.LayoutHash) {
+    log("incremental: layout has been changed");
+    return nullptr;
+  }
+
+  ArrayRef<elf::ObjectFile<ELFT> *> Files = Symtab<ELFT>::X->getObjectFiles();
+  if (Old->Files.size() != Files.size()) {
+    log("incremental: set of input files has been changed");
+    return nullptr;
+  }
+  for (size_t I = 0, E = Files.size(); I < E; ++I) {
+    if (Old->Files[I].first != CurrentState.Files[I].first) {
+      log("incremental: set of input files has been changed");
+      return nullptr;
+    }
+  }
+
+  int FD;
+  if (std::error_code EC = sys::fs::openFileForWrite(
+          Config->OutputFile, FD, sys::fs::F_Append | sys::fs::F_RW)) {
+    log("incremental: cannot open " + Config->OutputFile + ": " +
+        EC.message());
+    return nullptr;
+  }
+
+  std::error_code EC;
+  auto Region = llvm::make_unique<sys::fs::mapped_file_region>(
+      FD, sys::fs::mapped_file_region::readwrite, FileSize, 0, EC);
+  sys::Process::SafelyCloseFileDescriptor(FD);
+  if (EC) {
+    log("incremental: cannot map " + Config->OutputFile + ": " +
+        EC.message());
+    return nullptr;
+  }
+
+  size_t NumChanged = 0;
+  for (size_t I = 0, E = Files.size(); I < E; ++I) {
+    Files[I]->IsUnchanged =
+        (Old->Files[I].second == CurrentState.Files[I].second);
+    if (!Files[I]->IsUnchanged)
+      ++NumChanged;
+  }
+  log("incremental: updating " + Config->OutputFile + " in place (" +
+      Twine(NumChanged) + " of " + Twine(Files.size()) + " files changed)");
+
+  UpdatingInPlace = true;
+  return llvm::make_unique<IncrementalOutput>(std::move(Region));
+}
+
+// Writes the state of the current link to a file so that the next
+// link can use it. Called after the output file is written.
+void elf::saveIncrementalState(uint64_t FileSize) {
+  std::string Path = getStatePath();
+  sys::fs::file_status St;
+  if (CurrentState.Files.empty() || sys::fs::status(Config->OutputFile, St)) {
+    sys::fs::remove(Path);
+    return;
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+  if (EC) {
+    error(EC, "cannot open " + Path);
+    return;
+  }
+
+  OS << "layout " << utohexstr(CurrentState.LayoutHash) << "\n";
+  OS << "output " << FileSize << " " << getTime(St) << "\n";
+  for (std::pair<std::string, uint64_t> &P : CurrentState.Files)
+    OS << "file " << utohexstr(P.second) << " " << P.first << "\n";
+}
+
+template std::unique_ptr<IncrementalOutput>
+elf::openIncrementalOutput<ELF32LE>(ArrayRef<OutputSectionBase *>, uint64_t);
+template std::unique_ptr<IncrementalOutput>
+elf::openIncrementalOutput<ELF32BE>(ArrayRef<OutputSectionBase *>, uint64_t);
+template std::unique_ptr<IncrementalOutput>
+elf::openIncrementalOutput<ELF64LE>(ArrayRef<OutputSectionBase *>, uint64_t);
+template std::unique_ptr<IncrementalOutput>
+elf::openIncrementalOutput<ELF64BE>(ArrayRef<OutputSectionBase *>, uint64_t);
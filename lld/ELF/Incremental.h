@@ -0,0 +1,52 @@
+//===- Incremental.h --------------------------------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_INCREMENTAL_H
+#define LLD_ELF_INCREMENTAL_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/Support/FileSystem.h"
+
+#include <memory>
+
+namespace lld {
+namespace elf {
+
+class OutputSectionBase;
+
+// True if we are updating an existing output file in place rather than
+// creating a new one. If true, sections of files that have not changed
+// since the previous link are not written.
+extern bool UpdatingInPlace;
+
+// An existing output file mapped to memory for in-place update.
+class IncrementalOutput {
+public:
+  explicit IncrementalOutput(
+      std::unique_ptr<llvm::sys::fs::mapped_file_region> Region)
+      : Region(std::move(Region)) {}
+
+  uint8_t *getBufferStart() { return (uint8_t *)Region->data(); }
+  void commit() { Region.reset(); }
+
+private:
+  std::unique_ptr<llvm::sys::fs::mapped_file_region> Region;
+};
+
+template <class ELFT>
+std::unique_ptr<IncrementalOutput>
+openIncrementalOutput(ArrayRef<OutputSectionBase *> OutputSections,
+                      uint64_t FileSize);
+
+void saveIncrementalState(uint64_t FileSize);
+
+} // namespace elf
+} // namespace lld
+
+#endif
@@ -413,6 +413,68 @@ template <class ELFT> void elf::ObjectFile<ELFT>::initializeSymbols() {
   SymbolBodies.reserve(this->Symbols.size());
   for (const Elf_Sym &Sym : this->Symbols)
     SymbolBodies.push_back(createSymbolBody(&Sym));
+
+  // Hash values are needed only until symbols are resolved.
+  HashedGlobalNames = std::vector<CachedHashStringRef>();
+}
+
+// Computes hash values of global symbol names so that they don't have
+// to be computed during symbol resolution. This function is thread-safe
+// and is called for all object files in parallel. It does not report
+// errors; if the file is broken, it just gives up, and the error is
+// reported when the file is parsed.
+template <class ELFT> void elf::ObjectFile<ELFT>::hashGlobalSymbols() {
+  const ELFFile<ELFT> Obj = this->getObj();
+  Expected<Elf_Shdr_Range> ObjSections = Obj.sections();
+  if (!ObjSections) {
+    consumeError(ObjSections.takeError());
+    return;
+  }
+
+  // If there is more than one symbol table, the last one is used.
+  // See initializeSections.
+  const Elf_Shdr *SymtabSec = nullptr;
+  for (const Elf_Shdr &Sec : *ObjSections)
+    if (Sec.sh_type == SHT_SYMTAB)
+      SymtabSec = &Sec;
+  if (!SymtabSec)
+    return;
+
+  Expected<Elf_Sym_Range> Syms = Obj.symbols(SymtabSec);
+  Expected<StringRef> StrTab =
+      Obj.getStringTableForSymtab(*SymtabSec, *ObjSections);
+  if (!Syms || !StrTab) {
+    consumeError(Syms.takeError());
+    consumeError(StrTab.takeError());
+    return;
+  }
+  uint32_t FirstGlobal = SymtabSec->sh_info;
+  if (FirstGlobal == 0 || FirstGlobal > Syms->size())
+    return;
+
+  std::vector<CachedHashStringRef> Names;
+  Names.reserve(Syms->size() - FirstGlobal);
+  for (const Elf_Sym &Sym : Syms->slice(FirstGlobal)) {
+    Expected<StringRef> Name = Sym.getName(*StrTab);
+    if (!Name) {
+      consumeError(Name.takeError());
+      return;
+    }
+    Names.push_back(CachedHashStringRef(*Name));
+  }
+  HashedGlobalNames = std::move(Names);
+}
+
+// Returns the name of a given global symbol, using a precomputed hash
+// value if available.
+template <class ELFT>
+CachedHashStringRef
+elf::ObjectFile<ELFT>::getGlobalSymbolName(const Elf_Sym *Sym) {
+  size_t I = Sym - this->Symbols.begin();
+  if (I >= this->FirstNonLocal &&
+      HashedGlobalNames.size() == this->Symbols.size() - this->FirstNonLocal)
+    return HashedGlobalNames[I - this->FirstNonLocal];
+  return CachedHashStringRef(check(Sym->getName(this->StringTable)));
 }
 
 template <class ELFT>
@@ -466,7 +528,7 @@ SymbolBody *elf::ObjectFile<ELFT>::createSymbolBody(const Elf_Sym *Sym) {
                                              Type, Value, Size, Sec, this);
   }
 
-  StringRef Name = check(Sym->getName(this->StringTable));
+  CachedHashStringRef Name = getGlobalSymbolName(Sym);
 
   switch (Sym->st_shndx) {
   case SHN_UNDEF:
@@ -476,7 +538,7 @@ SymbolBody *elf::ObjectFile<ELFT>::createSymbolBody(const Elf_Sym *Sym) {
         ->body();
   case SHN_COMMON:
     if (Value == 0 || Value >= UINT32_MAX)
-      fatal(toString(this) + ": common symbol '" + Name +
+      fatal(toString(this) + ": common symbol '" + Name.val() +
             "' has invalid alignment: " + Twine(Value));
     return elf::Symtab<ELFT>::X
         ->addCommon(Name, Size, Value, Binding, StOther, Type, this)
@@ -500,13 +562,41 @@ SymbolBody *elf::ObjectFile<ELFT>::createSymbolBody(const Elf_Sym *Sym) {
   }
 }
 
+void ArchiveFile::openArchive() {
+  if (!File)
+    File = check(Archive::create(MB),
+                 MB.getBufferIdentifier() + ": failed to parse archive");
+}
+
+// This function is called for all archive files in parallel, so it
+// must not call fatal(). If the file is broken, it just gives up, and
+// the error is reported on the main thread when the file is parsed.
+void ArchiveFile::hashSymbols() {
+  Expected<std::unique_ptr<Archive>> FileOrErr = Archive::create(MB);
+  if (!FileOrErr) {
+    consumeError(FileOrErr.takeError());
+    return;
+  }
+  File = std::move(*FileOrErr);
+  for (const Archive::Symbol &Sym : File->symbols())
+    HashedNames.push_back(CachedHashStringRef(Sym.getName()));
+}
+
 template <class ELFT> void ArchiveFile::parse() {
-  File = check(Archive::create(MB),
-               MB.getBufferIdentifier() + ": failed to parse archive");
+  openArchive();
 
   // Read the symbol table to construct Lazy objects.
-  for (const Archive::Symbol &Sym : File->symbols())
-    Symtab<ELFT>::X->addLazyArchive(this, Sym);
+  size_t I = 0;
+  for (const Archive::Symbol &Sym : File->symbols()) {
+    if (I < HashedNames.size())
+      Symtab<ELFT>::X->addLazyArchive(this, Sym, HashedNames[I++]);
+    else
+      Symtab<ELFT>::X->addLazyArchive(this, Sym,
+                                      CachedHashStringRef(Sym.getName()));
+  }
+
+  // Hash values are no longer needed.
+  HashedNames = std::vector<CachedHashStringRef>();
 }
 
 // Returns a buffer pointing to a member file containing a given symbol.
@@ -524,6 +614,9 @@ ArchiveFile::getMember(const Archive::Symbol *Sym) {
             "could not get the buffer for the member defining symbol " +
                 Sym->getName());
 
+  ++NumLoadedMembers;
+  LoadedBytes += Ret.getBufferSize();
+
   if (C.getParent()->isThin() && Driver->Tar)
     Driver->Tar->append(relativeToRoot(check(C.getFullName())),
                         Ret.getBuffer());
@@ -532,6 +625,32 @@ ArchiveFile::getMember(const Archive::Symbol *Sym) {
   return {Ret, C.getChildOffset()};
 }
 
+void ArchiveFile::logStats() {
+  if (!File)
+    return;
+
+  size_t NumMembers = 0;
+  uint64_t Bytes = 0;
+  Error Err = Error::success();
+  for (const ErrorOr<Archive::Child> &COrErr : File->children(Err)) {
+    if (!COrErr)
+      return;
+    ++NumMembers;
+    if (Expected<uint64_t> Size = COrErr->getSize())
+      Bytes += *Size;
+    else
+      consumeError(Size.takeError());
+  }
+  if (Err) {
+    consumeError(std::move(Err));
+    return;
+  }
+
+  log(toString(this) + ": loaded " + Twine(NumLoadedMembers) + " of " +
+      Twine(NumMembers) + " members (" + Twine(LoadedBytes) + " of " +
+      Twine(Bytes) + " bytes)");
+}
+
 template <class ELFT>
 SharedFile<ELFT>::SharedFile(MemoryBufferRef M)
     : ELFFileBase<ELFT>(Base::SharedKind, M), AsNeeded(Config->AsNeeded) {}
@@ -744,17 +863,20 @@ static Symbol *createBitcodeSymbol(const std::vector<bool> &KeptComdats,
 
   int C = check(ObjSym.getComdatIndex());
   if (C != -1 && !KeptComdats[C])
-    return Symtab<ELFT>::X->addUndefined(NameRef, /*IsLocal=*/false, Binding,
+    return Symtab<ELFT>::X->addUndefined(CachedHashStringRef(NameRef),
+                                         /*IsLocal=*/false, Binding,
                                          Visibility, Type, CanOmitFromDynSym,
                                          F);
 
   if (Flags & BasicSymbolRef::SF_Undefined)
-    return Symtab<ELFT>::X->addUndefined(NameRef, /*IsLocal=*/false, Binding,
+    return Symtab<ELFT>::X->addUndefined(CachedHashStringRef(NameRef),
+                                         /*IsLocal=*/false, Binding,
                                          Visibility, Type, CanOmitFromDynSym,
                                          F);
 
   if (Flags & BasicSymbolRef::SF_Common)
-    return Symtab<ELFT>::X->addCommon(NameRef, ObjSym.getCommonSize(),
+    return Symtab<ELFT>::X->addCommon(CachedHashStringRef(NameRef),
+                                      ObjSym.getCommonSize(),
                                       ObjSym.getCommonAlignment(), Binding,
                                       Visibility, STT_OBJECT, F);
 
@@ -128,6 +128,7 @@ template <class ELFT> class ObjectFile : public ELFFileBase<ELFT> {
   typedef typename ELFT::Rela Elf_Rela;
   typedef typename ELFT::Sym Elf_Sym;
   typedef typename ELFT::Shdr Elf_Shdr;
+  typedef typename ELFT::ShdrRange Elf_Shdr_Range;
   typedef typename ELFT::SymRange Elf_Sym_Range;
   typedef typename ELFT::Word Elf_Word;
   typedef typename ELFT::uint uintX_t;
@@ -147,6 +148,11 @@ public:
 
   explicit ObjectFile(MemoryBufferRef M);
   void parse(llvm::DenseSet<llvm::CachedHashStringRef> &ComdatGroups);
+  void hashGlobalSymbols();
+
+  ArrayRef<llvm::CachedHashStringRef> getHashedGlobalNames() const {
+    return HashedGlobalNames;
+  }
 
   ArrayRef<InputSectionBase<ELFT> *> getSections() const { return Sections; }
   InputSectionBase<ELFT> *getSection(const Elf_Sym &Sym) const;
@@ -181,6 +187,10 @@ public:
   // symbol table.
   StringRef SourceFile;
 
+  // True if this file has the same contents as in the previous link.
+  // Used by --incremental.
+  bool IsUnchanged = false;
+
 private:
   void
   initializeSections(llvm::DenseSet<llvm::CachedHashStringRef> &ComdatGroups);
@@ -192,6 +202,7 @@ private:
 
   bool shouldMerge(const Elf_Shdr &Sec);
   SymbolBody *createSymbolBody(const Elf_Sym *Sym);
+  llvm::CachedHashStringRef getGlobalSymbolName(const Elf_Sym *Sym);
 
   // List of all sections defined by this file.
   std::vector<InputSectionBase<ELFT> *> Sections;
@@ -199,6 +210,10 @@ private:
   // List of all symbols referenced or defined by this file.
   std::vector<SymbolBody *> SymbolBodies;
 
+  // Names of global symbols with their hash values if they have been
+  // computed by hashGlobalSymbols(). Empty otherwise.
+  std::vector<llvm::CachedHashStringRef> HashedGlobalNames;
+
   // Debugging information to retrieve source file and line for error
   // reporting. Linker may find reasonable number of errors in a
   // single object file, so we cache debugging information in order to
@@ -245,9 +260,28 @@ public:
   // (So that we don't instantiate same members more than once.)
   std::pair<MemoryBufferRef, uint64_t> getMember(const Archive::Symbol *Sym);
 
+  // Reads the archive symbol table and computes hash values of the
+  // symbol names. Called in parallel before parse() if threading is
+  // enabled, so that parse() doesn't have to hash names serially.
+  void hashSymbols();
+  ArrayRef<llvm::CachedHashStringRef> getHashedSymbolNames() const {
+    return HashedNames;
+  }
+
+  // Logs the number of members loaded from this archive. Because
+  // members are loaded only when they are needed, that shows how
+  // much we avoided reading.
+  void logStats();
+
 private:
+  void openArchive();
+
   std::unique_ptr<Archive> File;
   llvm::DenseSet<uint64_t> Seen;
+  std::vector<llvm::CachedHashStringRef> HashedNames;
+
+  size_t NumLoadedMembers = 0;
+  uint64_t LoadedBytes = 0;
 };
 
 class BitcodeFile : public InputFile {
@@ -18,6 +18,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Object/ELF.h"
+#include <atomic>
 #include <mutex>
 
 namespace lld {
@@ -46,7 +47,7 @@ public:
   // If GC is disabled, all sections are considered live by default.
   InputSectionData(Kind SectionKind, StringRef Name, ArrayRef<uint8_t> Data,
                    bool Live)
-      : SectionKind(SectionKind), Live(Live), Assigned(false), Name(Name),
+      : SectionKind(SectionKind), Assigned(false), Live(Live), Name(Name),
         Data(Data) {}
 
 private:
@@ -55,8 +56,12 @@ private:
 public:
   Kind kind() const { return (Kind)SectionKind; }
 
-  unsigned Live : 1;       // for garbage collection
   unsigned Assigned : 1;   // for linker script
+
+  // For garbage collection. This is not a bitfield because the garbage
+  // collector sets this bit from multiple threads.
+  std::atomic<bool> Live;
+
   uint32_t Alignment;
   StringRef Name;
   ArrayRef<uint8_t> Data;
@@ -35,6 +35,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
@@ -1931,6 +1932,10 @@ std::vector<SymbolVersion> ScriptParser::readVersionExtern() {
 }
 
 void elf::readLinkerScript(MemoryBufferRef MB) {
+  // --incremental updates the output only if the linker scripts are
+  // the same as the previous link's.
+  if (Config->Incremental)
+    Config->ScriptHashes.push_back(xxHash64(MB.getBuffer()));
   ScriptParser(MB).readLinkerScript();
 }
 
@@ -27,9 +27,12 @@
 #include "SymbolTable.h"
 #include "Symbols.h"
 #include "Target.h"
+#include "Threads.h"
+#include "Trace.h"
 #include "Writer.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Object/ELF.h"
+#include <algorithm>
 #include <functional>
 #include <vector>
 
@@ -182,41 +185,66 @@ template <class ELFT> static bool isReserved(InputSectionBase<ELFT> *Sec) {
   }
 }
 
+namespace {
+// Sections and mergeable section pieces found live by one task of the
+// mark phase.
+template <class ELFT> struct MarkState {
+  typedef typename ELFT::uint uintX_t;
+
+  std::vector<InputSection<ELFT> *> Queue;
+  std::vector<std::pair<MergeInputSection<ELFT> *, uintX_t>> Pieces;
+};
+} // end anonymous namespace
+
+// Sets the Live bit of the section R refers to. If the section was not
+// live before, it is added to the queue so that its successors are
+// visited. This function is called from multiple threads.
+template <class ELFT>
+static void enqueue(ResolvedReloc<ELFT> R, MarkState<ELFT> &State) {
+  // Skip over discarded sections. This in theory shouldn't happen, because
+  // the ELF spec doesn't allow a relocation to point to a deduplicated
+  // COMDAT section directly. Unfortunately this happens in practice (e.g.
+  // .eh_frame) so we need to add a check.
+  if (!R.Sec || R.Sec == &InputSection<ELFT>::Discarded)
+    return;
+
+  // We don't gc non alloc sections.
+  if (!(R.Sec->Flags & SHF_ALLOC))
+    return;
+
+  // Usually, a whole section is marked as live or dead, but in mergeable
+  // (splittable) sections, each piece of data has independent liveness bit.
+  // So we explicitly tell it which offset is in use. That is not
+  // thread-safe, so we do that later on the main thread.
+  if (auto *MS = dyn_cast<MergeInputSection<ELFT>>(R.Sec))
+    State.Pieces.push_back({MS, R.Offset});
+
+  // Only one thread can change the bit from false to true, so each
+  // section is added to a queue only once. We read the bit first to
+  // avoid writing to the cache line of a section that is already live.
+  if (R.Sec->Live || R.Sec->Live.exchange(true))
+    return;
+  // Add input section to the queue.
+  if (InputSection<ELFT> *S = dyn_cast<InputSection<ELFT>>(R.Sec))
+    State.Queue.push_back(S);
+}
+
 // This is the main function of the garbage collector.
 // Starting from GC-root sections, this function visits all reachable
 // sections to set their "Live" bits.
+//
+// The graph is traversed level by level. Sections in the current queue
+// are split into chunks, and each chunk is scanned by a separate task.
+// Newly found sections are collected into per-task queues, which are
+// then concatenated to form the queue for the next level. Since the Live
+// bit is set atomically, the result is the same as a serial traversal.
 template <class ELFT> void elf::markLive() {
-  SmallVector<InputSection<ELFT> *, 256> Q;
-
-  auto Enqueue = [&](ResolvedReloc<ELFT> R) {
-    // Skip over discarded sections. This in theory shouldn't happen, because
-    // the ELF spec doesn't allow a relocation to point to a deduplicated
-    // COMDAT section directly. Unfortunately this happens in practice (e.g.
-    // .eh_frame) so we need to add a check.
-    if (!R.Sec || R.Sec == &InputSection<ELFT>::Discarded)
-      return;
-
-    // We don't gc non alloc sections.
-    if (!(R.Sec->Flags & SHF_ALLOC))
-      return;
-
-    // Usually, a whole section is marked as live or dead, but in mergeable
-    // (splittable) sections, each piece of data has independent liveness bit.
-    // So we explicitly tell it which offset is in use.
-    if (auto *MS = dyn_cast<MergeInputSection<ELFT>>(R.Sec))
-      MS->markLiveAt(R.Offset);
-
-    if (R.Sec->Live)
-      return;
-    R.Sec->Live = true;
-    // Add input section to the queue.
-    if (InputSection<ELFT> *S = dyn_cast<InputSection<ELFT>>(R.Sec))
-      Q.push_back(S);
-  };
+  TraceScope Scope("Garbage collection");
+  MarkState<ELFT> Root;
 
   auto MarkSymbol = [&](const SymbolBody *Sym) {
     if (auto *D = dyn_cast_or_null<DefinedRegular<ELFT>>(Sym))
-      Enqueue({D->Section, D->Value});
+      enqueue<ELFT>({D->Section, D->Value}, Root);
   };
 
   // Add GC root symbols.
@@ -239,14 +267,49 @@ template <class ELFT> void elf::markLive() {
     // sections that contain personality. We preserve all non-text sections
     // referred by .eh_frame here.
     if (auto *EH = dyn_cast_or_null<EhInputSection<ELFT>>(Sec))
-      scanEhFrameSection<ELFT>(*EH, Enqueue);
+      scanEhFrameSection<ELFT>(
+          *EH, [&](ResolvedReloc<ELFT> R) { enqueue(R, Root); });
     if (isReserved(Sec) || Script<ELFT>::X->shouldKeep(Sec))
-      Enqueue({Sec, 0});
+      enqueue<ELFT>({Sec, 0}, Root);
   }
 
   // Mark all reachable sections.
-  while (!Q.empty())
-    forEachSuccessor<ELFT>(*Q.pop_back_val(), Enqueue);
+  std::vector<InputSection<ELFT> *> Q;
+
+  // Moves sections found by a task to the queue. Piece offsets are
+  // recorded in a set, so the order of markLiveAt calls doesn't matter.
+  auto Collect = [&](MarkState<ELFT> &State) {
+    Q.insert(Q.end(), State.Queue.begin(), State.Queue.end());
+    for (std::pair<MergeInputSection<ELFT> *, typename ELFT::uint> &P :
+         State.Pieces)
+      P.first->markLiveAt(P.second);
+  };
+  Collect(Root);
+
+  while (!Q.empty()) {
+    // Each task scans at least 64 sections because spawning a task
+    // for a few sections is more expensive than scanning them.
+    size_t NumTasks = 1;
+    if (Config->Threads)
+      NumTasks = std::min<size_t>((Q.size() + 63) / 64, 1024);
+
+    std::vector<MarkState<ELFT>> States(NumTasks);
+    auto Fn = [&](size_t I) {
+      size_t Begin = Q.size() * I / NumTasks;
+      size_t End = Q.size() * (I + 1) / NumTasks;
+      for (size_t J = Begin; J < End; ++J)
+        forEachSuccessor<ELFT>(
+            *Q[J], [&](ResolvedReloc<ELFT> R) { enqueue(R, States[I]); });
+    };
+    if (NumTasks == 1)
+      Fn(0);
+    else
+      parallel_for(size_t(0), NumTasks, Fn);
+
+    Q.clear();
+    for (MarkState<ELFT> &State : States)
+      Collect(State);
+  }
 }
 
 template void elf::markLive<ELF32LE>();
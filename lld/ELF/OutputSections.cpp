@@ -10,6 +10,7 @@
 #include "OutputSections.h"
 #include "Config.h"
 #include "EhFrame.h"
+#include "Incremental.h"
 #include "LinkerScript.h"
 #include "Memory.h"
 #include "Strings.h"
@@ -249,18 +250,40 @@ void fill(uint8_t *Buf, size_t Size, uint32_t Filler) {
 }
 
 template <class ELFT> void OutputSection<ELFT>::writeTo(uint8_t *Buf) {
+  writeFiller(Buf);
+  forEach(Sections.begin(), Sections.end(),
+          [=](InputSection<ELFT> *IS) { writeSection(IS); });
+}
+
+// Writes everything but input sections to Buf. The writer calls this
+// function and writeSection separately so that it can write input
+// sections of all output sections in one parallel loop.
+template <class ELFT> void OutputSection<ELFT>::writeFiller(uint8_t *Buf) {
   Loc = Buf;
-  if (uint32_t Filler = Script<ELFT>::X->getFiller(this->Name))
-    fill(Buf, this->Size, Filler);
 
-  auto Fn = [=](InputSection<ELFT> *IS) { IS->writeTo(Buf); };
-  forEach(Sections.begin(), Sections.end(), Fn);
+  // If we are updating an existing output file, gaps between input
+  // sections have already been filled.
+  if (!UpdatingInPlace)
+    if (uint32_t Filler = Script<ELFT>::X->getFiller(this->Name))
+      fill(Buf, this->Size, Filler);
 
   // Linker scripts may have BYTE()-family commands with which you
   // can write arbitrary bytes to the output. Process them if any.
   Script<ELFT>::X->writeDataBytes(this->Name, Buf);
 }
 
+// Copies and relocates IS. Must be called after writeFiller.
+// This function is called from parallel loops, so it must be
+// thread-safe.
+template <class ELFT>
+void OutputSection<ELFT>::writeSection(InputSection<ELFT> *IS) {
+  // Sections of unchanged files have already been written
+  // if we are updating an existing output file.
+  if (UpdatingInPlace && IS->getFile() && IS->getFile()->IsUnchanged)
+    return;
+  IS->writeTo(Loc);
+}
+
 template <class ELFT>
 EhOutputSection<ELFT>::EhOutputSection()
     : OutputSectionBase(".eh_frame", SHT_PROGBITS, SHF_ALLOC) {}
@@ -468,10 +491,18 @@ template <class ELFT>
 MergeOutputSection<ELFT>::MergeOutputSection(StringRef Name, uint32_t Type,
                                              uintX_t Flags, uintX_t Alignment)
     : OutputSectionBase(Name, Type, Flags),
-      Builder(StringTableBuilder::RAW, Alignment) {}
+      Builder(StringTableBuilder::RAW, Alignment), EntryAlignment(Alignment) {}
 
 template <class ELFT> void MergeOutputSection<ELFT>::writeTo(uint8_t *Buf) {
-  Builder.write(Buf);
+  if (shouldTailMerge()) {
+    Builder.write(Buf);
+    return;
+  }
+
+  forEach(UniquePieces.begin(), UniquePieces.end(),
+          [=](const std::pair<StringRef, uintX_t> &P) {
+            memcpy(Buf + P.second, P.first.data(), P.first.size());
+          });
 }
 
 template <class ELFT>
@@ -508,18 +539,70 @@ template <class ELFT> void MergeOutputSection<ELFT>::finalizeTailMerge() {
         Sec->Pieces[I].OutputOff = Builder.getOffset(Sec->getData(I));
 }
 
+// Deduplicates pieces without tail merging. This is the default.
+//
+// Debug sections such as .debug_str can contain tens of millions of
+// pieces, so we deduplicate them in parallel. Pieces are split into
+// shards by their hash values, and each shard is processed by one
+// thread. Each shard visits pieces in the input order, so the first
+// occurrence of each piece (which we call the leader) is always the
+// same. After that, we assign output offsets to leaders in the input
+// order. The result is the same as if we had added all pieces to a
+// StringTableBuilder one at a time.
 template <class ELFT> void MergeOutputSection<ELFT>::finalizeNoTailMerge() {
-  // Add all string pieces to the string table builder to create section
-  // contents. Because we are not tail-optimizing, offsets of strings are
-  // fixed when they are added to the builder (string table builder contains
-  // a hash table from strings to offsets).
-  for (MergeInputSection<ELFT> *Sec : Sections)
-    for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
-      if (Sec->Pieces[I].Live)
-        Sec->Pieces[I].OutputOff = Builder.add(Sec->getData(I));
+  // Pieces are numbered consecutively across input sections.
+  // Begins[I] is the number of the first piece of the I'th section.
+  std::vector<size_t> Begins;
+  size_t NumPieces = 0;
+  for (MergeInputSection<ELFT> *Sec : Sections) {
+    Begins.push_back(NumPieces);
+    NumPieces += Sec->Pieces.size();
+  }
 
-  Builder.finalizeInOrder();
-  this->Size = Builder.getSize();
+  // We use the high bits of hash values to select a shard because
+  // DenseMap uses the low bits.
+  const size_t NumShardBits = 5;
+  const size_t NumShards = 1 << NumShardBits;
+
+  std::vector<SectionPiece *> Leaders(NumPieces);
+  forLoop(0, NumShards, [&](size_t Shard) {
+    DenseMap<CachedHashStringRef, SectionPiece *> Map;
+    for (size_t I = 0, E = Sections.size(); I != E; ++I) {
+      MergeInputSection<ELFT> *Sec = Sections[I];
+      for (size_t J = 0, F = Sec->Pieces.size(); J != F; ++J) {
+        if (!Sec->Pieces[J].Live)
+          continue;
+        CachedHashStringRef Data = Sec->getData(J);
+        if ((Data.hash() >> (32 - NumShardBits)) != Shard)
+          continue;
+        Leaders[Begins[I] + J] =
+            Map.insert({Data, &Sec->Pieces[J]}).first->second;
+      }
+    }
+  });
+
+  // Assign offsets. A leader always precedes the other pieces with the
+  // same contents, so its offset has been assigned when we visit them.
+  uintX_t Off = 0;
+  for (size_t I = 0, E = Sections.size(); I != E; ++I) {
+    MergeInputSection<ELFT> *Sec = Sections[I];
+    for (size_t J = 0, F = Sec->Pieces.size(); J != F; ++J) {
+      SectionPiece &Piece = Sec->Pieces[J];
+      if (!Piece.Live)
+        continue;
+      SectionPiece *Leader = Leaders[Begins[I] + J];
+      if (Leader != &Piece) {
+        Piece.OutputOff = Leader->OutputOff;
+        continue;
+      }
+      StringRef Data = Sec->getData(J).val();
+      Off = alignTo(Off, EntryAlignment);
+      Piece.OutputOff = Off;
+      UniquePieces.push_back({Data, Off});
+      Off += Data.size();
+    }
+  }
+  this->Size = Off;
 }
 
 template <class ELFT> void MergeOutputSection<ELFT>::finalize() {
@@ -115,6 +115,8 @@ public:
   void sortInitFini();
   void sortCtorsDtors();
   void writeTo(uint8_t *Buf) override;
+  void writeFiller(uint8_t *Buf);
+  void writeSection(InputSection<ELFT> *IS);
   void finalize() override;
   void assignOffsets() override;
   Kind getKind() const override { return Regular; }
@@ -147,7 +149,14 @@ private:
   void finalizeTailMerge();
   void finalizeNoTailMerge();
 
+  // Used if tail merging is enabled.
   llvm::StringTableBuilder Builder;
+
+  // Used if tail merging is disabled. Unique pieces and their
+  // output offsets.
+  std::vector<std::pair<StringRef, uintX_t>> UniquePieces;
+
+  uintX_t EntryAlignment;
   std::vector<MergeInputSection<ELFT> *> Sections;
 };
 
@@ -20,6 +20,8 @@
 #include "LinkerScript.h"
 #include "Memory.h"
 #include "Symbols.h"
+#include "Threads.h"
+#include "Trace.h"
 #include "llvm/ADT/STLExtras.h"
 
 using namespace llvm;
@@ -54,6 +56,7 @@ template <class ELFT> static bool isCompatible(InputFile *F) {
 template <class ELFT> void SymbolTable<ELFT>::addFile(InputFile *File) {
   if (!isCompatible<ELFT>(File))
     return;
+  TraceScope Scope("Parse input file", [&] { return toString(File); });
 
   // Binary file
   if (auto *F = dyn_cast<BinaryFile>(File)) {
@@ -101,6 +104,70 @@ template <class ELFT> void SymbolTable<ELFT>::addFile(InputFile *File) {
   F->parse(ComdatGroups);
 }
 
+// Computes hash values of global symbol names of the given object files
+// ahead of symbol resolution.
+//
+// Symbol resolution itself has to be done serially because the result
+// depends on the order in which symbols are added (that's how archive
+// files and weak symbols are handled). But what takes time in that
+// process is mostly reading symbol tables and hashing symbol names,
+// which can be done for each file independently. We do that in
+// parallel, and then count the number of distinct names using a sharded
+// set so that the symbol table doesn't have to grow and rehash many
+// times as symbols are added. The resolution results are the same as
+// the serial path because the same names are inserted in the same order.
+template <class ELFT>
+void SymbolTable<ELFT>::hashSymbols(ArrayRef<InputFile *> Files) {
+  TraceScope Scope("Hash symbols");
+  std::vector<ObjectFile<ELFT> *> Objs;
+  std::vector<ArchiveFile *> Archives;
+  for (InputFile *F : Files) {
+    if (auto *A = dyn_cast<ArchiveFile>(F))
+      Archives.push_back(A);
+    else if (F->EKind == Config->EKind)
+      if (auto *Obj = dyn_cast<ObjectFile<ELFT>>(F))
+        Objs.push_back(Obj);
+  }
+  if (Objs.empty() && Archives.empty())
+    return;
+
+  forEach(Objs.begin(), Objs.end(),
+          [](ObjectFile<ELFT> *F) { F->hashGlobalSymbols(); });
+  forEach(Archives.begin(), Archives.end(),
+          [](ArchiveFile *F) { F->hashSymbols(); });
+
+  // Shard names by their hash values so that each shard can be
+  // deduplicated independently. We use the high bits of hash values
+  // to select a shard because DenseSet uses the low bits. Names are
+  // bucketed in one pass, which is cheap compared to the insertions.
+  const size_t NumShardBits = 5;
+  const size_t NumShards = 1 << NumShardBits;
+  std::vector<CachedHashStringRef> Shards[NumShards];
+  auto Add = [&](ArrayRef<CachedHashStringRef> V) {
+    for (CachedHashStringRef Name : V)
+      Shards[Name.hash() >> (32 - NumShardBits)].push_back(Name);
+  };
+  for (ObjectFile<ELFT> *F : Objs)
+    Add(F->getHashedGlobalNames());
+  for (ArchiveFile *F : Archives)
+    Add(F->getHashedSymbolNames());
+
+  size_t Counts[NumShards];
+  forLoop(0, NumShards, [&](size_t Shard) {
+    DenseSet<CachedHashStringRef> Names;
+    Names.reserve(Shards[Shard].size());
+    for (CachedHashStringRef Name : Shards[Shard])
+      Names.insert(Name);
+    Counts[Shard] = Names.size();
+  });
+
+  size_t NumNames = 0;
+  for (size_t Count : Counts)
+    NumNames += Count;
+  Symtab.reserve(Symtab.size() + NumNames);
+  SymVector.reserve(SymVector.size() + NumNames);
+}
+
 // This function is where all the optimizations of link-time
 // optimization happens. When LTO is in use, some input files are
 // not in native object file format but in the LLVM bitcode format.
@@ -111,6 +178,7 @@ template <class ELFT> void SymbolTable<ELFT>::addFile(InputFile *File) {
 template <class ELFT> void SymbolTable<ELFT>::addCombinedLTOObject() {
   if (BitcodeFiles.empty())
     return;
+  TraceScope Scope("LTO");
 
   // Compile bitcode files and replace bitcode symbols.
   LTO.reset(new BitcodeCompiler);
@@ -178,9 +246,9 @@ static uint8_t getMinVisibility(uint8_t VA, uint8_t VB) {
 
 // Find an existing symbol or create and insert a new one.
 template <class ELFT>
-std::pair<Symbol *, bool> SymbolTable<ELFT>::insert(StringRef Name) {
-  auto P = Symtab.insert(
-      {CachedHashStringRef(Name), SymIndex((int)SymVector.size(), false)});
+std::pair<Symbol *, bool>
+SymbolTable<ELFT>::insert(CachedHashStringRef Name) {
+  auto P = Symtab.insert({Name, SymIndex((int)SymVector.size(), false)});
   SymIndex &V = P.first->second;
   bool IsNew = P.second;
 
@@ -217,8 +285,9 @@ static std::string conflictMsg(SymbolBody *Existing, InputFile *NewFile) {
 // attributes.
 template <class ELFT>
 std::pair<Symbol *, bool>
-SymbolTable<ELFT>::insert(StringRef Name, uint8_t Type, uint8_t Visibility,
-                          bool CanOmitFromDynSym, InputFile *File) {
+SymbolTable<ELFT>::insert(CachedHashStringRef Name, uint8_t Type,
+                          uint8_t Visibility, bool CanOmitFromDynSym,
+                          InputFile *File) {
   bool IsUsedInRegularObj = !File || File->kind() == InputFile::ObjectKind;
   Symbol *S;
   bool WasInserted;
@@ -238,17 +307,18 @@ SymbolTable<ELFT>::insert(StringRef Name, uint8_t Type, uint8_t Visibility,
 }
 
 template <class ELFT> Symbol *SymbolTable<ELFT>::addUndefined(StringRef Name) {
-  return addUndefined(Name, /*IsLocal=*/false, STB_GLOBAL, STV_DEFAULT,
-                      /*Type*/ 0,
+  return addUndefined(CachedHashStringRef(Name), /*IsLocal=*/false, STB_GLOBAL,
+                      STV_DEFAULT, /*Type*/ 0,
                       /*CanOmitFromDynSym*/ false, /*File*/ nullptr);
 }
 
 static uint8_t getVisibility(uint8_t StOther) { return StOther & 3; }
 
 template <class ELFT>
-Symbol *SymbolTable<ELFT>::addUndefined(StringRef Name, bool IsLocal,
-                                        uint8_t Binding, uint8_t StOther,
-                                        uint8_t Type, bool CanOmitFromDynSym,
+Symbol *SymbolTable<ELFT>::addUndefined(CachedHashStringRef Name,
+                                        bool IsLocal, uint8_t Binding,
+                                        uint8_t StOther, uint8_t Type,
+                                        bool CanOmitFromDynSym,
                                         InputFile *File) {
   Symbol *S;
   bool WasInserted;
@@ -256,7 +326,7 @@ Symbol *SymbolTable<ELFT>::addUndefined(StringRef Name, bool IsLocal,
       insert(Name, Type, getVisibility(StOther), CanOmitFromDynSym, File);
   if (WasInserted) {
     S->Binding = Binding;
-    replaceBody<Undefined<ELFT>>(S, Name, IsLocal, StOther, Type, File);
+    replaceBody<Undefined<ELFT>>(S, Name.val(), IsLocal, StOther, Type, File);
     return S;
   }
   if (Binding != STB_WEAK) {
@@ -318,7 +388,7 @@ static int compareDefinedNonCommon(Symbol *S, bool WasInserted, uint8_t Binding,
 }
 
 template <class ELFT>
-Symbol *SymbolTable<ELFT>::addCommon(StringRef N, uint64_t Size,
+Symbol *SymbolTable<ELFT>::addCommon(CachedHashStringRef N, uint64_t Size,
                                      uint64_t Alignment, uint8_t Binding,
                                      uint8_t StOther, uint8_t Type,
                                      InputFile *File) {
@@ -329,7 +399,8 @@ Symbol *SymbolTable<ELFT>::addCommon(StringRef N, uint64_t Size,
   int Cmp = compareDefined(S, WasInserted, Binding);
   if (Cmp > 0) {
     S->Binding = Binding;
-    replaceBody<DefinedCommon>(S, N, Size, Alignment, StOther, Type, File);
+    replaceBody<DefinedCommon>(S, N.val(), Size, Alignment, StOther, Type,
+                               File);
   } else if (Cmp == 0) {
     auto *C = dyn_cast<DefinedCommon>(S->body());
     if (!C) {
@@ -344,7 +415,8 @@ Symbol *SymbolTable<ELFT>::addCommon(StringRef N, uint64_t Size,
 
     Alignment = C->Alignment = std::max(C->Alignment, Alignment);
     if (Size > C->Size)
-      replaceBody<DefinedCommon>(S, N, Size, Alignment, StOther, Type, File);
+      replaceBody<DefinedCommon>(S, N.val(), Size, Alignment, StOther, Type,
+                                 File);
   }
   return S;
 }
@@ -378,8 +450,9 @@ static void reportDuplicate(SymbolBody *Existing,
 }
 
 template <typename ELFT>
-Symbol *SymbolTable<ELFT>::addRegular(StringRef Name, uint8_t StOther,
-                                      uint8_t Type, uintX_t Value, uintX_t Size,
+Symbol *SymbolTable<ELFT>::addRegular(CachedHashStringRef Name,
+                                      uint8_t StOther, uint8_t Type,
+                                      uintX_t Value, uintX_t Size,
                                       uint8_t Binding,
                                       InputSectionBase<ELFT> *Section,
                                       InputFile *File) {
@@ -390,8 +463,8 @@ Symbol *SymbolTable<ELFT>::addRegular(StringRef Name, uint8_t StOther,
   int Cmp = compareDefinedNonCommon<ELFT>(S, WasInserted, Binding,
                                           Section == nullptr, Value);
   if (Cmp > 0)
-    replaceBody<DefinedRegular<ELFT>>(S, Name, /*IsLocal=*/false, StOther, Type,
-                                      Value, Size, Section, File);
+    replaceBody<DefinedRegular<ELFT>>(S, Name.val(), /*IsLocal=*/false, StOther,
+                                      Type, Value, Size, Section, File);
   else if (Cmp == 0)
     reportDuplicate(S->body(), Section, Value);
   return S;
@@ -403,8 +476,9 @@ Symbol *SymbolTable<ELFT>::addSynthetic(StringRef N,
                                         uintX_t Value, uint8_t StOther) {
   Symbol *S;
   bool WasInserted;
-  std::tie(S, WasInserted) = insert(N, STT_NOTYPE, getVisibility(StOther),
-                                    /*CanOmitFromDynSym*/ false, nullptr);
+  std::tie(S, WasInserted) =
+      insert(CachedHashStringRef(N), STT_NOTYPE, getVisibility(StOther),
+             /*CanOmitFromDynSym*/ false, nullptr);
   int Cmp = compareDefinedNonCommon<ELFT>(S, WasInserted, STB_GLOBAL,
                                           /*IsAbsolute*/ false, /*Value*/ 0);
   if (Cmp > 0)
@@ -423,8 +497,8 @@ void SymbolTable<ELFT>::addShared(SharedFile<ELFT> *F, StringRef Name,
   // unchanged.
   Symbol *S;
   bool WasInserted;
-  std::tie(S, WasInserted) =
-      insert(Name, Sym.getType(), STV_DEFAULT, /*CanOmitFromDynSym*/ true, F);
+  std::tie(S, WasInserted) = insert(CachedHashStringRef(Name), Sym.getType(),
+                                    STV_DEFAULT, /*CanOmitFromDynSym*/ true, F);
   // Make sure we preempt DSO symbols with default visibility.
   if (Sym.getVisibility() == STV_DEFAULT) {
     S->ExportDynamic = true;
@@ -445,8 +519,8 @@ Symbol *SymbolTable<ELFT>::addBitcode(StringRef Name, uint8_t Binding,
                                       bool CanOmitFromDynSym, BitcodeFile *F) {
   Symbol *S;
   bool WasInserted;
-  std::tie(S, WasInserted) =
-      insert(Name, Type, getVisibility(StOther), CanOmitFromDynSym, F);
+  std::tie(S, WasInserted) = insert(CachedHashStringRef(Name), Type,
+                                    getVisibility(StOther), CanOmitFromDynSym, F);
   int Cmp = compareDefinedNonCommon<ELFT>(S, WasInserted, Binding,
                                           /*IsAbs*/ false, /*Value*/ 0);
   if (Cmp > 0)
@@ -469,10 +543,10 @@ template <class ELFT> SymbolBody *SymbolTable<ELFT>::find(StringRef Name) {
 
 template <class ELFT>
 void SymbolTable<ELFT>::addLazyArchive(ArchiveFile *F,
-                                       const object::Archive::Symbol Sym) {
+                                       const object::Archive::Symbol Sym,
+                                       CachedHashStringRef Name) {
   Symbol *S;
   bool WasInserted;
-  StringRef Name = Sym.getName();
   std::tie(S, WasInserted) = insert(Name);
   if (WasInserted) {
     replaceBody<LazyArchive>(S, *F, Sym, SymbolBody::UnknownType);
@@ -501,7 +575,7 @@ template <class ELFT>
 void SymbolTable<ELFT>::addLazyObject(StringRef Name, LazyObjectFile &Obj) {
   Symbol *S;
   bool WasInserted;
-  std::tie(S, WasInserted) = insert(Name);
+  std::tie(S, WasInserted) = insert(CachedHashStringRef(Name));
   if (WasInserted) {
     replaceBody<LazyObject>(S, Name, Obj, SymbolBody::UnknownType);
     return;
@@ -41,6 +41,7 @@ template <class ELFT> class SymbolTable {
 public:
   void addFile(InputFile *File);
   void addCombinedLTOObject();
+  void hashSymbols(ArrayRef<InputFile *> Files);
 
   ArrayRef<Symbol *> getSymbols() const { return SymVector; }
   ArrayRef<ObjectFile<ELFT> *> getObjectFiles() const { return ObjectFiles; }
@@ -54,13 +55,20 @@ public:
                                    uint8_t Visibility = llvm::ELF::STV_HIDDEN);
 
   Symbol *addUndefined(StringRef Name);
-  Symbol *addUndefined(StringRef Name, bool IsLocal, uint8_t Binding,
-                       uint8_t StOther, uint8_t Type, bool CanOmitFromDynSym,
-                       InputFile *File);
+  Symbol *addUndefined(llvm::CachedHashStringRef Name, bool IsLocal,
+                       uint8_t Binding, uint8_t StOther, uint8_t Type,
+                       bool CanOmitFromDynSym, InputFile *File);
 
   Symbol *addRegular(StringRef Name, uint8_t StOther, uint8_t Type,
                      uintX_t Value, uintX_t Size, uint8_t Binding,
-                     InputSectionBase<ELFT> *Section, InputFile *File);
+                     InputSectionBase<ELFT> *Section, InputFile *File) {
+    return addRegular(llvm::CachedHashStringRef(Name), StOther, Type, Value,
+                      Size, Binding, Section, File);
+  }
+  Symbol *addRegular(llvm::CachedHashStringRef Name, uint8_t StOther,
+                     uint8_t Type, uintX_t Value, uintX_t Size,
+                     uint8_t Binding, InputSectionBase<ELFT> *Section,
+                     InputFile *File);
 
   Symbol *addSynthetic(StringRef N, const OutputSectionBase *Section,
                        uintX_t Value, uint8_t StOther);
@@ -68,14 +76,15 @@ public:
   void addShared(SharedFile<ELFT> *F, StringRef Name, const Elf_Sym &Sym,
                  const typename ELFT::Verdef *Verdef);
 
-  void addLazyArchive(ArchiveFile *F, const llvm::object::Archive::Symbol S);
+  void addLazyArchive(ArchiveFile *F, const llvm::object::Archive::Symbol S,
+                      llvm::CachedHashStringRef Name);
   void addLazyObject(StringRef Name, LazyObjectFile &Obj);
   Symbol *addBitcode(StringRef Name, uint8_t Binding, uint8_t StOther,
                      uint8_t Type, bool CanOmitFromDynSym, BitcodeFile *File);
 
-  Symbol *addCommon(StringRef N, uint64_t Size, uint64_t Alignment,
-                    uint8_t Binding, uint8_t StOther, uint8_t Type,
-                    InputFile *File);
+  Symbol *addCommon(llvm::CachedHashStringRef N, uint64_t Size,
+                    uint64_t Alignment, uint8_t Binding, uint8_t StOther,
+                    uint8_t Type, InputFile *File);
 
   void scanUndefinedFlags();
   void scanShlibUndefined();
@@ -89,10 +98,10 @@ public:
   std::vector<InputSectionBase<ELFT> *> Sections;
 
 private:
-  std::pair<Symbol *, bool> insert(StringRef Name);
-  std::pair<Symbol *, bool> insert(StringRef Name, uint8_t Type,
-                                   uint8_t Visibility, bool CanOmitFromDynSym,
-                                   InputFile *File);
+  std::pair<Symbol *, bool> insert(llvm::CachedHashStringRef Name);
+  std::pair<Symbol *, bool> insert(llvm::CachedHashStringRef Name,
+                                   uint8_t Type, uint8_t Visibility,
+                                   bool CanOmitFromDynSym, InputFile *File);
 
   std::vector<SymbolBody *> findByVersion(SymbolVersion Ver);
   std::vector<SymbolBody *> findAllByVersion(SymbolVersion Ver);
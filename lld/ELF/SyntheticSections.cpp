@@ -1466,11 +1466,25 @@ GdbIndexSection<ELFT>::GdbIndexSection()
     : SyntheticSection<ELFT>(0, SHT_PROGBITS, 1, ".gdb_index"),
       StringPool(llvm::StringTableBuilder::ELF) {}
 
+// Reading DWARF is the most time-consuming part of creating .gdb_index,
+// so we read .debug_info sections in parallel and then merge the
+// results serially in the input order, so that the output is
+// deterministic.
 template <class ELFT> void GdbIndexSection<ELFT>::parseDebugSections() {
+  std::vector<InputSection<ELFT> *> Sections;
   for (InputSectionBase<ELFT> *S : Symtab<ELFT>::X->Sections)
     if (InputSection<ELFT> *IS = dyn_cast<InputSection<ELFT>>(S))
       if (IS->OutSec && IS->Name == ".debug_info")
-        readDwarf(IS);
+        Sections.push_back(IS);
+
+  std::vector<DebugInfoData> Data(Sections.size());
+  forLoop(0, Sections.size(),
+          [&](size_t I) { Data[I] = readDwarf(Sections[I]); });
+  if (ErrorCount)
+    return;
+
+  for (DebugInfoData &D : Data)
+    addDebugInfo(D);
 }
 
 // Iterative hash function for symbol's name is described in .gdb_index format
@@ -1483,38 +1497,54 @@ static uint32_t hash(StringRef Str) {
   return R;
 }
 
+// Reads a .debug_info section. CU indices in the result are local to
+// the section. This function is called in parallel, so it must not
+// modify the members of this class.
 template <class ELFT>
-void GdbIndexSection<ELFT>::readDwarf(InputSection<ELFT> *I) {
+typename GdbIndexSection<ELFT>::DebugInfoData
+GdbIndexSection<ELFT>::readDwarf(InputSection<ELFT> *I) {
+  DebugInfoData D;
   GdbIndexBuilder<ELFT> Builder(I);
-  if (ErrorCount)
-    return;
+  if (!Builder.isValid())
+    return D;
 
-  size_t CuId = CompilationUnits.size();
-  std::vector<std::pair<uintX_t, uintX_t>> CuList = Builder.readCUList();
-  CompilationUnits.insert(CompilationUnits.end(), CuList.begin(), CuList.end());
+  D.CuList = Builder.readCUList();
+  D.AddressArea = Builder.readAddressArea(0);
+
+  // We compute hash values here rather than in addDebugInfo because
+  // this function runs in parallel.
+  for (std::pair<StringRef, uint8_t> &Pair : Builder.readPubNamesAndTypes())
+    D.Names.push_back({CachedHashStringRef(Pair.first), hash(Pair.first),
+                       Pair.second});
+  return D;
+}
 
-  std::vector<AddressEntry<ELFT>> AddrArea = Builder.readAddressArea(CuId);
-  AddressArea.insert(AddressArea.end(), AddrArea.begin(), AddrArea.end());
+template <class ELFT>
+void GdbIndexSection<ELFT>::addDebugInfo(DebugInfoData &D) {
+  size_t CuId = CompilationUnits.size();
+  CompilationUnits.insert(CompilationUnits.end(), D.CuList.begin(),
+                          D.CuList.end());
 
-  std::vector<std::pair<StringRef, uint8_t>> NamesAndTypes =
-      Builder.readPubNamesAndTypes();
+  for (AddressEntry<ELFT> &E : D.AddressArea) {
+    E.CuIndex += CuId;
+    AddressArea.push_back(E);
+  }
 
-  for (std::pair<StringRef, uint8_t> &Pair : NamesAndTypes) {
-    uint32_t Hash = hash(Pair.first);
-    size_t Offset = StringPool.add(Pair.first);
+  for (GdbPubName &Name : D.Names) {
+    size_t Offset = StringPool.add(Name.Name);
 
     bool IsNew;
     GdbSymbol *Sym;
-    std::tie(IsNew, Sym) = SymbolTable.add(Hash, Offset);
+    std::tie(IsNew, Sym) = SymbolTable.add(Name.Hash, Offset);
     if (IsNew) {
       Sym->CuVectorIndex = CuVectors.size();
-      CuVectors.push_back({{CuId, Pair.second}});
+      CuVectors.push_back({{CuId, Name.Type}});
       continue;
     }
 
     std::vector<std::pair<uint32_t, uint8_t>> &CuVec =
         CuVectors[Sym->CuVectorIndex];
-    CuVec.push_back({CuId, Pair.second});
+    CuVec.push_back({CuId, Name.Type});
   }
 }
 
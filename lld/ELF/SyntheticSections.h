@@ -496,8 +496,16 @@ public:
   std::vector<AddressEntry<ELFT>> AddressArea;
 
 private:
+  // Data extracted from a .debug_info section.
+  struct DebugInfoData {
+    std::vector<std::pair<uintX_t, uintX_t>> CuList;
+    std::vector<AddressEntry<ELFT>> AddressArea;
+    std::vector<GdbPubName> Names;
+  };
+
   void parseDebugSections();
-  void readDwarf(InputSection<ELFT> *I);
+  DebugInfoData readDwarf(InputSection<ELFT> *I);
+  void addDebugInfo(DebugInfoData &D);
 
   uint32_t CuTypesOffset;
   uint32_t SymTabOffset;
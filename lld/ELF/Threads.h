@@ -64,6 +64,7 @@
 #include "lld/Core/Parallel.h"
 #include <algorithm>
 #include <functional>
+#include <vector>
 
 namespace lld {
 namespace elf {
@@ -84,6 +85,45 @@ inline void forLoop(size_t Begin, size_t End, std::function<void(size_t)> Fn) {
       Fn(I);
   }
 }
+
+// Calls Fn on each element of V in parallel. Unlike forEach, which
+// gives each task the same number of elements, this function groups
+// elements into tasks of roughly the same total weight, so that a
+// few heavy elements don't keep one thread busy while the others are
+// idle. Idle threads take the next task from the thread pool.
+template <class T>
+void forEachWeighted(ArrayRef<T> V, std::function<uint64_t(const T &)> Weight,
+                     std::function<void(const T &)> Fn) {
+  if (!Config->Threads) {
+    for (const T &Elem : V)
+      Fn(Elem);
+    return;
+  }
+
+  uint64_t Total = 0;
+  for (const T &Elem : V)
+    Total += Weight(Elem);
+
+  // Create up to about 1024 tasks. This is the same number as what
+  // parallel_for_each uses.
+  uint64_t TaskWeight = std::max<uint64_t>(Total / 1024, 1);
+  std::vector<size_t> Bounds = {0};
+  uint64_t Acc = 0;
+  for (size_t I = 0, E = V.size(); I < E; ++I) {
+    Acc += Weight(V[I]);
+    if (Acc >= TaskWeight) {
+      Bounds.push_back(I + 1);
+      Acc = 0;
+    }
+  }
+  if (Bounds.back() != V.size())
+    Bounds.push_back(V.size());
+
+  parallel_for(size_t(0), Bounds.size() - 1, [&](size_t I) {
+    for (size_t J = Bounds[I], E = Bounds[I + 1]; J < E; ++J)
+      Fn(V[J]);
+  });
+}
 }
 }
 
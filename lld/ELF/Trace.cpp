@@ -0,0 +1,145 @@
+//===- Trace.cpp ----------------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Each TraceScope becomes a "complete" event ("ph":"X") with its start
+// time and duration. The trace is written with LLVM's TraceEventWriter, the
+// same writer that -time-passes-trace uses. In addition to that, we record the
+// malloc heap usage at the end of each scope as a counter event ("ph":"C")
+// so that it is shown as a graph along with the phases. We use the same
+// measure as -time-passes (sys::Process::GetMallocUsage) because LLVM has
+// no portable way to get the resident set size, so memory-mapped input
+// and output files are not included.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Trace.h"
+#include "Config.h"
+#include "Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeTrace.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+using namespace lld;
+using namespace lld::elf;
+
+namespace {
+struct Event {
+  StringRef Name;
+  std::string Detail;
+  uint64_t Start;
+  uint64_t Duration;
+  size_t Tid;
+  size_t MallocUsage;
+};
+} // namespace
+
+static std::mutex Mu;
+static std::vector<Event> Events;
+static std::vector<std::thread::id> ThreadIds;
+static std::chrono::steady_clock::time_point TraceStart;
+static size_t PeakMallocUsage = 0;
+static bool Started = false;
+
+static uint64_t toNanoseconds(std::chrono::steady_clock::duration D) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(D).count();
+}
+
+// Returns a small integer for the current thread. Must be called with
+// Mu held.
+static size_t getTid() {
+  std::thread::id Id = std::this_thread::get_id();
+  auto It = std::find(ThreadIds.begin(), ThreadIds.end(), Id);
+  if (It != ThreadIds.end())
+    return It - ThreadIds.begin();
+  ThreadIds.push_back(Id);
+  return ThreadIds.size() - 1;
+}
+
+TraceScope::TraceScope(StringRef Name)
+    : Enabled(Config->TimeTrace), Name(Name) {
+  if (Enabled)
+    Start = std::chrono::steady_clock::now();
+}
+
+TraceScope::TraceScope(StringRef Name, function_ref<std::string()> Detail)
+    : Enabled(Config->TimeTrace), Name(Name) {
+  if (!Enabled)
+    return;
+  this->Detail = Detail();
+  Start = std::chrono::steady_clock::now();
+}
+
+TraceScope::~TraceScope() {
+  if (!Enabled)
+    return;
+  auto End = std::chrono::steady_clock::now();
+  size_t MallocUsage = sys::Process::GetMallocUsage();
+
+  std::lock_guard<std::mutex> Lock(Mu);
+  PeakMallocUsage = std::max(PeakMallocUsage, MallocUsage);
+  Events.push_back({Name, std::move(Detail), toNanoseconds(Start - TraceStart),
+                    toNanoseconds(End - Start), getTid(), MallocUsage});
+}
+
+void elf::startTrace() {
+  // lld may be used as a library to link more than once in a process,
+  // so discard anything recorded by a previous link.
+  std::lock_guard<std::mutex> Lock(Mu);
+  Events.clear();
+  ThreadIds.clear();
+  PeakMallocUsage = 0;
+  Started = true;
+  TraceStart = std::chrono::steady_clock::now();
+
+  // The main thread is always thread 0.
+  getTid();
+}
+
+void elf::writeTrace() {
+  if (!Config || !Config->TimeTrace || !Started)
+    return;
+  Started = false;
+
+  std::string Path = Config->TimeTraceFile;
+  if (Path.empty())
+    Path = (Config->OutputFile + ".time-trace.json").str();
+
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+  if (EC) {
+    error(EC, "cannot open " + Path);
+    return;
+  }
+
+  std::lock_guard<std::mutex> Lock(Mu);
+  uint64_t Total = toNanoseconds(std::chrono::steady_clock::now() - TraceStart);
+
+  TraceEventWriter Writer(OS);
+  Writer.writeComplete("Total", 0, 0, Total);
+  for (const Event &E : Events) {
+    if (E.Detail.empty())
+      Writer.writeComplete(E.Name, E.Tid, E.Start, E.Duration);
+    else
+      Writer.writeComplete(E.Name, E.Tid, E.Start, E.Duration,
+                           TraceEventArg("detail", E.Detail));
+
+    // Counter events are shown as a graph.
+    if (E.Tid == 0)
+      Writer.writeCounter("Malloc usage", 0, E.Start + E.Duration,
+                          TraceEventArg("bytes", E.MallocUsage));
+  }
+  Writer.finish(TraceEventArg("peakMallocUsage", PeakMallocUsage));
+}
@@ -0,0 +1,54 @@
+//===- Trace.h --------------------------------------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements --time-trace, which writes a JSON file in the
+// Chrome trace event format. The file can be viewed with chrome://tracing
+// to see where the linker spent time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_TRACE_H
+#define LLD_ELF_TRACE_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include <chrono>
+#include <string>
+
+namespace lld {
+namespace elf {
+
+// Records the time between construction and destruction of an object
+// of this class as a trace event if --time-trace is given. Otherwise,
+// it does nothing. This class is thread-safe.
+class TraceScope {
+public:
+  explicit TraceScope(StringRef Name);
+  TraceScope(StringRef Name, llvm::function_ref<std::string()> Detail);
+  ~TraceScope();
+
+private:
+  bool Enabled;
+  StringRef Name;
+  std::string Detail;
+  std::chrono::steady_clock::time_point Start;
+};
+
+// Starts the clock. Must be called before any TraceScope is created.
+void startTrace();
+
+// Writes the recorded events to the trace file. Called when the link
+// finishes, whether or not it succeeded. Only the first call after
+// startTrace() writes the file.
+void writeTrace();
+
+} // namespace elf
+} // namespace lld
+
+#endif
@@ -8,7 +8,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "Writer.h"
+#include "CallGraphSort.h"
 #include "Config.h"
+#include "Incremental.h"
 #include "LinkerScript.h"
 #include "Memory.h"
 #include "OutputSections.h"
@@ -17,6 +19,8 @@
 #include "SymbolTable.h"
 #include "SyntheticSections.h"
 #include "Target.h"
+#include "Threads.h"
+#include "Trace.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/FileOutputBuffer.h"
@@ -73,8 +77,10 @@ private:
   void writeSections();
   void writeSectionsBinary();
   void writeBuildId();
+  uint8_t *getBufferStart();
 
   std::unique_ptr<FileOutputBuffer> Buffer;
+  std::unique_ptr<IncrementalOutput> InPlaceBuffer;
 
   std::vector<OutputSectionBase *> OutputSections;
   OutputSectionFactory<ELFT> Factory;
@@ -231,9 +237,14 @@ template <class ELFT> void Writer<ELFT>::run() {
   if (ErrorCount)
     return;
 
-  if (auto EC = Buffer->commit())
+  if (InPlaceBuffer)
+    InPlaceBuffer->commit();
+  else if (auto EC = Buffer->commit())
     error(EC, "failed to write to the output file");
 
+  if (Config->Incremental && !ErrorCount)
+    saveIncrementalState(FileSize);
+
   // Flush the output streams and exit immediately. A full shutdown
   // is a good test that we are keeping track of all allocated memory,
   // but actually freeing it is a waste of time in a regular linker run.
@@ -760,12 +771,10 @@ template <class ELFT> static void sortCtorsDtors(OutputSectionBase *S) {
     reinterpret_cast<OutputSection<ELFT> *>(S)->sortCtorsDtors();
 }
 
-// Sort input sections using the list provided by --symbol-ordering-file.
+// Build a map from sections to their priorities using the list provided
+// by --symbol-ordering-file.
 template <class ELFT>
-static void sortBySymbolsOrder(ArrayRef<OutputSectionBase *> OutputSections) {
-  if (Config->SymbolOrderingFile.empty())
-    return;
-
+static DenseMap<InputSectionBase<ELFT> *, int> getSymbolsOrder() {
   // Build a map from symbols to their priorities. Symbols that didn't
   // appear in the symbol ordering file have the lowest priority 0.
   // All explicitly mentioned symbols have negative (higher) priorities.
@@ -785,6 +794,20 @@ static void sortBySymbolsOrder(ArrayRef<OutputSectionBase *> OutputSections) {
       Priority = std::min(Priority, SymbolOrder.lookup(D->getName()));
     }
   }
+  return SectionOrder;
+}
+
+// Sort input sections using the list provided by --symbol-ordering-file
+// or the call graph provided by --call-graph-ordering-file.
+template <class ELFT>
+static void sortBySymbolsOrder(ArrayRef<OutputSectionBase *> OutputSections) {
+  DenseMap<InputSectionBase<ELFT> *, int> SectionOrder;
+  if (!Config->SymbolOrderingFile.empty())
+    SectionOrder = getSymbolsOrder<ELFT>();
+  else if (!Config->CallGraphProfile.empty())
+    SectionOrder = computeCallGraphProfileOrder<ELFT>();
+  else
+    return;
 
   // Sort sections by priority.
   for (OutputSectionBase *Base : OutputSections)
@@ -829,6 +852,7 @@ void Writer<ELFT>::addInputSec(InputSectionBase<ELFT> *IS) {
 }
 
 template <class ELFT> void Writer<ELFT>::createSections() {
+  TraceScope Scope("Create output sections");
   for (InputSectionBase<ELFT> *IS : Symtab<ELFT>::X->Sections)
     addInputSec(IS);
 
@@ -971,6 +995,7 @@ static void removeUnusedSyntheticSections(std::vector<OutputSectionBase *> &V) {
 
 // Create output section objects and add them to OutputSections.
 template <class ELFT> void Writer<ELFT>::finalizeSections() {
+  TraceScope Scope("Finalize sections");
   Out<ELFT>::DebugInfo = findSection(".debug_info");
   Out<ELFT>::PreinitArray = findSection(".preinit_array");
   Out<ELFT>::InitArray = findSection(".init_array");
@@ -1002,7 +1027,10 @@ template <class ELFT> void Writer<ELFT>::finalizeSections() {
 
   // Scan relocations. This must be done after every symbol is declared so that
   // we can correctly decide if a dynamic relocation is needed.
-  forEachRelSec(scanRelocations<ELFT>);
+  {
+    TraceScope Scope("Scan relocations");
+    forEachRelSec(scanRelocations<ELFT>);
+  }
 
   // Now that we have defined all possible symbols including linker-
   // synthesized ones. Visit all symbols to give the finishing touches.
@@ -1345,6 +1373,7 @@ template <class ELFT> void Writer<ELFT>::fixHeaders() {
 
 // Assign VAs (addresses at run-time) to output sections.
 template <class ELFT> void Writer<ELFT>::assignAddresses() {
+  TraceScope Scope("Assign addresses");
   uintX_t VA = Config->ImageBase;
   if (AllocateHeader)
     VA += getHeaderSize<ELFT>();
@@ -1558,7 +1587,7 @@ template <class ELFT> void Writer<ELFT>::fixAbsoluteSymbols() {
 }
 
 template <class ELFT> void Writer<ELFT>::writeHeader() {
-  uint8_t *Buf = Buffer->getBufferStart();
+  uint8_t *Buf = getBufferStart();
   memcpy(Buf, "\177ELF", 4);
 
   // Write the ELF header.
@@ -1646,6 +1675,13 @@ static void unlinkAsync(StringRef Path) {
 
 // Open a result file.
 template <class ELFT> void Writer<ELFT>::openFile() {
+  // With --incremental, we may be able to reuse the existing file.
+  if (Config->Incremental) {
+    InPlaceBuffer = openIncrementalOutput<ELFT>(OutputSections, FileSize);
+    if (InPlaceBuffer)
+      return;
+  }
+
   unlinkAsync(Config->OutputFile);
   ErrorOr<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
       FileOutputBuffer::create(Config->OutputFile, FileSize,
@@ -1657,8 +1693,14 @@ template <class ELFT> void Writer<ELFT>::openFile() {
     Buffer = std::move(*BufferOrErr);
 }
 
+template <class ELFT> uint8_t *Writer<ELFT>::getBufferStart() {
+  if (InPlaceBuffer)
+    return InPlaceBuffer->getBufferStart();
+  return Buffer->getBufferStart();
+}
+
 template <class ELFT> void Writer<ELFT>::writeSectionsBinary() {
-  uint8_t *Buf = Buffer->getBufferStart();
+  uint8_t *Buf = getBufferStart();
   for (OutputSectionBase *Sec : OutputSections)
     if (Sec->Flags & SHF_ALLOC)
       Sec->writeTo(Buf + Sec->Offset);
@@ -1666,7 +1708,8 @@ template <class ELFT> void Writer<ELFT>::writeSectionsBinary() {
 
 // Write section contents to a mmap'ed file.
 template <class ELFT> void Writer<ELFT>::writeSections() {
-  uint8_t *Buf = Buffer->getBufferStart();
+  TraceScope Scope("Write sections");
+  uint8_t *Buf = getBufferStart();
 
   // PPC64 needs to process relocations in the .opd section
   // before processing relocations in code-containing sections.
@@ -1678,9 +1721,30 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
 
   OutputSectionBase *EhFrameHdr =
       In<ELFT>::EhFrameHdr ? In<ELFT>::EhFrameHdr->OutSec : nullptr;
-  for (OutputSectionBase *Sec : OutputSections)
-    if (Sec != Out<ELFT>::Opd && Sec != EhFrameHdr)
+
+  // Most of the output consists of input sections of regular output
+  // sections. If we wrote output sections one at a time, one large
+  // output section such as .text would keep one thread busy at the end
+  // of each output section while the others are idle. So we copy and
+  // relocate input sections of all output sections in one parallel loop.
+  std::vector<InputSection<ELFT> *> Sections;
+  for (OutputSectionBase *Sec : OutputSections) {
+    if (Sec == Out<ELFT>::Opd || Sec == EhFrameHdr)
+      continue;
+    if (auto *OS = dyn_cast<OutputSection<ELFT>>(Sec)) {
+      OS->writeFiller(Buf + Sec->Offset);
+      Sections.insert(Sections.end(), OS->Sections.begin(),
+                      OS->Sections.end());
+    } else {
       Sec->writeTo(Buf + Sec->Offset);
+    }
+  }
+
+  forEachWeighted<InputSection<ELFT> *>(
+      Sections, [](InputSection<ELFT> *const &IS) { return IS->getSize(); },
+      [](InputSection<ELFT> *const &IS) {
+        cast<OutputSection<ELFT>>(IS->OutSec)->writeSection(IS);
+      });
 
   // The .eh_frame_hdr depends on .eh_frame section contents, therefore
   // it should be written after .eh_frame is written.
@@ -1689,11 +1753,12 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
 }
 
 template <class ELFT> void Writer<ELFT>::writeBuildId() {
+  TraceScope Scope("Build ID");
   if (!In<ELFT>::BuildId || !In<ELFT>::BuildId->OutSec)
     return;
 
   // Compute a hash of all sections of the output file.
-  uint8_t *Start = Buffer->getBufferStart();
+  uint8_t *Start = getBufferStart();
   uint8_t *End = Start + FileSize;
   In<ELFT>::BuildId->writeBuildId({Start, End});
 }
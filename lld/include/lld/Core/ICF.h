@@ -0,0 +1,256 @@
+//===- lld/Core/ICF.h - Identical Code Folding ------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the linker-independent part of Identical Code Folding
+// which is shared by the ELF and COFF linkers. See ELF/ICF.cpp for the
+// details about the algorithm.
+//
+// A linker derives from ICFBase and provides the following member
+// functions. Section type T must have a `uint32_t Class[2]` member.
+//
+//   // Returns a hash value of the "non-moving" part of S.
+//   uint32_t getHash(T *S);
+//
+//   // Returns true if the "non-moving" parts of A and B are the same.
+//   bool equalsConstant(const T *A, const T *B);
+//
+//   // Returns true if relocations of A and B point to the same
+//   // equivalence classes. Use Class[Current] to read classes.
+//   bool equalsVariable(const T *A, const T *B);
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_CORE_ICF_H
+#define LLD_CORE_ICF_H
+
+#include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
+#include "llvm/ADT/StringRef.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace lld {
+
+template <class Derived, class T> class ICFBase {
+public:
+  // Time spent on each phase of ICF in milliseconds.
+  struct PhaseTime {
+    StringRef Name;
+    double Milliseconds;
+  };
+
+  explicit ICFBase(bool Threads) : Threads(Threads) {}
+
+  ArrayRef<PhaseTime> getPhaseTimes() const { return PhaseTimes; }
+
+protected:
+  // Partitions Sections into equivalence classes. When this function
+  // returns, sections in the same class are contiguous in Sections.
+  void partition();
+
+  void forEachClass(std::function<void(size_t, size_t)> Fn);
+
+  // Runs Fn and records the time it took as phase Name.
+  template <class FnTy> void timePhase(StringRef Name, FnTy Fn);
+
+  // Sections subject to ICF. Derived classes fill this vector.
+  std::vector<T *> Sections;
+
+  // The main loop counter.
+  int Cnt = 0;
+
+  // We have two locations for equivalence classes. On the first iteration
+  // of the main loop, Class[0] has a valid value, and Class[1] contains
+  // garbage. We read equivalence classes from slot 0 and write to slot 1.
+  // So, Class[0] represents the current class, and Class[1] represents
+  // the next class. On each iteration, we switch their roles and use them
+  // alternately.
+  //
+  // Why are we doing this? Recall that other threads may be working on
+  // other equivalence classes in parallel. They may read sections that we
+  // are updating. We cannot update equivalence classes in place because
+  // it breaks the invariance that all possibly-identical sections must be
+  // in the same equivalence class at any moment. In other words, the for
+  // loop to update equivalence classes is not atomic, and that is
+  // observable from other threads. By writing new classes to other
+  // places, we can keep the invariance.
+  //
+  // Below, `Current` has the index of the current class, and `Next` has
+  // the index of the next class. If threading is enabled, they are either
+  // (0, 1) or (1, 0).
+  //
+  // Note on single-thread: if that's the case, they are always (0, 0)
+  // because we can safely read the next class without worrying about race
+  // conditions. Using the same location makes this algorithm converge
+  // faster because it uses results of the same iteration earlier.
+  int Current = 0;
+  int Next = 0;
+
+private:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+  void segregate(size_t Begin, size_t End, bool Constant);
+  size_t findBoundary(size_t Begin, size_t End);
+  void forEachClassRange(size_t Begin, size_t End,
+                         std::function<void(size_t, size_t)> Fn);
+
+  bool Threads;
+
+  // We repeat the main loop while `Repeat` is true.
+  std::atomic<bool> Repeat = {false};
+
+  std::vector<PhaseTime> PhaseTimes;
+};
+
+template <class Derived, class T>
+template <class FnTy>
+void ICFBase<Derived, T>::timePhase(StringRef Name, FnTy Fn) {
+  auto Start = std::chrono::steady_clock::now();
+  Fn();
+  std::chrono::duration<double, std::milli> D =
+      std::chrono::steady_clock::now() - Start;
+  PhaseTimes.push_back({Name, D.count()});
+}
+
+// Split an equivalence class into smaller classes.
+template <class Derived, class T>
+void ICFBase<Derived, T>::segregate(size_t Begin, size_t End, bool Constant) {
+  // This loop rearranges sections in [Begin, End) so that all sections
+  // that are equal in terms of equals{Constant,Variable} are contiguous
+  // in [Begin, End).
+  //
+  // The algorithm is quadratic in the worst case, but that is not an
+  // issue in practice because the number of the distinct sections in
+  // each range is usually very small.
+
+  while (Begin < End) {
+    // Divide [Begin, End) into two. Let Mid be the start index of the
+    // second group.
+    auto Bound = std::stable_partition(
+        Sections.begin() + Begin + 1, Sections.begin() + End, [&](T *S) {
+          if (Constant)
+            return derived().equalsConstant(Sections[Begin], S);
+          return derived().equalsVariable(Sections[Begin], S);
+        });
+    size_t Mid = Bound - Sections.begin();
+
+    // Now we split [Begin, End) into [Begin, Mid) and [Mid, End) by
+    // updating the sections in [Begin, End). We use Mid as an equivalence
+    // class ID because every group ends with a unique index.
+    for (size_t I = Begin; I < Mid; ++I)
+      Sections[I]->Class[Next] = Mid;
+
+    // If we created a group, we need to iterate the main loop again.
+    if (Mid != End)
+      Repeat = true;
+
+    Begin = Mid;
+  }
+}
+
+template <class Derived, class T>
+size_t ICFBase<Derived, T>::findBoundary(size_t Begin, size_t End) {
+  uint32_t Class = Sections[Begin]->Class[Current];
+  for (size_t I = Begin + 1; I < End; ++I)
+    if (Class != Sections[I]->Class[Current])
+      return I;
+  return End;
+}
+
+// Sections in the same equivalence class are contiguous in Sections
+// vector. Therefore, Sections vector can be considered as contiguous
+// groups of sections, grouped by the class.
+//
+// This function calls Fn on every group that starts within [Begin, End).
+// Note that a group must starts in that range but doesn't necessarily
+// have to end before End.
+template <class Derived, class T>
+void ICFBase<Derived, T>::forEachClassRange(
+    size_t Begin, size_t End, std::function<void(size_t, size_t)> Fn) {
+  if (Begin > 0)
+    Begin = findBoundary(Begin - 1, End);
+
+  while (Begin < End) {
+    size_t Mid = findBoundary(Begin, Sections.size());
+    Fn(Begin, Mid);
+    Begin = Mid;
+  }
+}
+
+// Call Fn on each equivalence class.
+template <class Derived, class T>
+void ICFBase<Derived, T>::forEachClass(
+    std::function<void(size_t, size_t)> Fn) {
+  // If threading is disabled or the number of sections are
+  // too small to use threading, call Fn sequentially.
+  if (!Threads || Sections.size() < 1024) {
+    forEachClassRange(0, Sections.size(), Fn);
+    ++Cnt;
+    return;
+  }
+
+  Current = Cnt % 2;
+  Next = (Cnt + 1) % 2;
+
+  // Sections are sorted by their initial hash values, so each shard
+  // covers a distinct range of hash values. Split sections into 256
+  // shards and call Fn in parallel.
+  size_t NumShards = 256;
+  size_t Step = Sections.size() / NumShards;
+  parallel_for(size_t(0), NumShards, [&](size_t I) {
+    forEachClassRange(I * Step, (I + 1) * Step, Fn);
+  });
+  forEachClassRange(Step * NumShards, Sections.size(), Fn);
+  ++Cnt;
+}
+
+template <class Derived, class T> void ICFBase<Derived, T>::partition() {
+  // Initially, we use hash values to partition sections.
+  timePhase("hash", [&] {
+    auto Fn = [&](size_t I) {
+      // Set MSB to 1 to avoid collisions with non-hash IDs.
+      Sections[I]->Class[0] = derived().getHash(Sections[I]) | (1U << 31);
+    };
+    if (Threads)
+      parallel_for(size_t(0), Sections.size(), Fn);
+    else
+      for (size_t I = 0, E = Sections.size(); I < E; ++I)
+        Fn(I);
+  });
+
+  // From now on, sections in Sections vector are ordered so that sections
+  // in the same equivalence class are consecutive in the vector.
+  timePhase("sort", [&] {
+    std::stable_sort(Sections.begin(), Sections.end(), [](T *A, T *B) {
+      return A->Class[0] < B->Class[0];
+    });
+  });
+
+  // Compare static contents and assign unique IDs for each static content.
+  timePhase("constant", [&] {
+    forEachClass(
+        [&](size_t Begin, size_t End) { segregate(Begin, End, true); });
+  });
+
+  // Split groups by comparing relocations until convergence is obtained.
+  timePhase("variable", [&] {
+    do {
+      Repeat = false;
+      forEachClass(
+          [&](size_t Begin, size_t End) { segregate(Begin, End, false); });
+    } while (Repeat);
+  });
+}
+
+} // namespace lld
+
+#endif
@@ -6,6 +6,11 @@
 # RUN: llvm-ar rcs %tar %t2 %t3 %t4
 # RUN: ld.lld %t %tar %t5 -o %tout
 # RUN: llvm-nm %tout | FileCheck %s
+# RUN: ld.lld %t %tar %t5 -o %tout --verbose | \
+# RUN:   FileCheck -check-prefix=STATS %s
+# RUN: ld.lld %t %tar %t5 -o %tout --verbose -no-threads | \
+# RUN:   FileCheck -check-prefix=STATS %s
+# STATS: ar: loaded {{[0-9]+}} of 3 members ({{[0-9]+}} of {{[0-9]+}} bytes)
 # RUN: rm -f %tarthin
 # RUN: llvm-ar --format=gnu rcsT %tarthin %t2 %t3 %t4
 # RUN: ld.lld %t %tarthin %t5 -o %tout
@@ -1,9 +1,12 @@
 // REQUIRES: x86
 
 // Check bad archive error reporting with --whole-archive
-// and without it.
+// and without it, and with and without threads. With threads, archive
+// symbol tables are read in parallel first, and the error must still be
+// reported from the main thread.
 // RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
 // RUN: not ld.lld %t.o %p/Inputs/bad-archive.a -o %t 2>&1 | FileCheck %s
+// RUN: not ld.lld --no-threads %t.o %p/Inputs/bad-archive.a -o %t 2>&1 | FileCheck %s
 // RUN: not ld.lld %t.o --whole-archive %p/Inputs/bad-archive.a -o %t 2>&1 | FileCheck %s
 // CHECK: bad-archive.a: failed to parse archive
 
@@ -0,0 +1,57 @@
+# REQUIRES: x86
+# RUN: llvm-mc -filetype=obj -triple=x86_64-pc-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t.out
+# RUN: llvm-objdump -s %t.out | FileCheck %s --check-prefix=BEFORE
+
+# BEFORE:      Contents of section .foo:
+# BEFORE-NEXT:  201000 11223344 55
+
+## A calls B, C and D (via C) frequently. E calls A rarely, but it is
+## the only caller of A, so A follows E.
+# RUN: echo "A B 100" > %t.call_graph
+# RUN: echo "A C 40" >> %t.call_graph
+# RUN: echo "C D 30" >> %t.call_graph
+# RUN: echo "E A 10" >> %t.call_graph
+# RUN: echo "A A 1000" >> %t.call_graph
+# RUN: echo "A missing 1000" >> %t.call_graph
+# RUN: ld.lld --call-graph-ordering-file %t.call_graph %t.o -o %t2.out
+# RUN: llvm-objdump -s %t2.out | FileCheck %s --check-prefix=AFTER
+
+# AFTER:      Contents of section .foo:
+# AFTER-NEXT:  201000 55112233 44
+
+## --symbol-ordering-file takes precedence.
+# RUN: echo "D" > %t.order
+# RUN: ld.lld --call-graph-ordering-file %t.call_graph \
+# RUN:   --symbol-ordering-file %t.order %t.o -o %t3.out 2>&1 | \
+# RUN:   FileCheck %s --check-prefix=WARN
+# RUN: llvm-objdump -s %t3.out | FileCheck %s --check-prefix=SYMORDER
+
+# WARN: warning: --symbol-ordering-file is given; ignoring --call-graph-ordering-file
+# SYMORDER:      Contents of section .foo:
+# SYMORDER-NEXT:  201000 44112233 55
+
+# RUN: echo "A B x" > %t.bad
+# RUN: not ld.lld --call-graph-ordering-file %t.bad %t.o -o %t4.out 2>&1 | \
+# RUN:   FileCheck %s --check-prefix=ERR
+# ERR: parse error: A B x
+
+.section .foo,"ax",@progbits,unique,1
+A:
+ .byte 0x11
+
+.section .foo,"ax",@progbits,unique,2
+B:
+ .byte 0x22
+
+.section .foo,"ax",@progbits,unique,3
+C:
+ .byte 0x33
+
+.section .foo,"ax",@progbits,unique,4
+D:
+ .byte 0x44
+
+.section .foo,"ax",@progbits,unique,5
+E:
+ .byte 0x55
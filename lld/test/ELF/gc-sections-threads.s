@@ -0,0 +1,56 @@
+# REQUIRES: x86
+
+## Check that the parallel mark phase of --gc-sections gives the same
+## result as the serial one. The input has enough sections to be split
+## into multiple tasks.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld --gc-sections --print-gc-sections -threads %t.o -o %t1 \
+# RUN:   > %t1.txt 2>&1
+# RUN: ld.lld --gc-sections --print-gc-sections -no-threads %t.o -o %t2 \
+# RUN:   > %t2.txt 2>&1
+# RUN: cmp %t1 %t2
+# RUN: cmp %t1.txt %t2.txt
+# RUN: FileCheck %s < %t1.txt
+# RUN: llvm-objdump -t %t1 | FileCheck -check-prefix=SYMS %s
+
+# CHECK-NOT: removing unused section from '.text.f
+# CHECK-NOT: removing unused section from '.text.g
+# CHECK:     removing unused section from '.text.h00'
+# CHECK:     removing unused section from '.text.h99'
+
+# SYMS: f00
+# SYMS: g00
+# SYMS: f99
+# SYMS: g99
+# SYMS-NOT: h00
+
+.globl _start
+_start:
+.irp i,0,1,2,3,4,5,6,7,8,9
+.irp j,0,1,2,3,4,5,6,7,8,9
+  call f\i\j
+.endr
+.endr
+
+.irp i,0,1,2,3,4,5,6,7,8,9
+.irp j,0,1,2,3,4,5,6,7,8,9
+.section .text.f\i\j,"ax",@progbits
+f\i\j:
+  call g\i\j
+
+.section .text.g\i\j,"ax",@progbits
+g\i\j:
+  movq $.Lstr\i\j, %rax
+
+.section .text.h\i\j,"ax",@progbits
+h\i\j:
+  movq $.Ldead\i\j, %rax
+
+.section .rodata.str,"aMS",@progbits,1
+.Lstr\i\j:
+  .asciz "live\i\j"
+.Ldead\i\j:
+  .asciz "dead\i\j"
+.endr
+.endr
@@ -5,6 +5,11 @@
 
 # CHECK: selected .text.f1
 # CHECK:   removed .text.f2
+# CHECK: ICF hash phase took {{.*}} ms
+# CHECK: ICF sort phase took {{.*}} ms
+# CHECK: ICF constant phase took {{.*}} ms
+# CHECK: ICF variable phase took {{.*}} ms
+# CHECK: ICF merge phase took {{.*}} ms
 
 .globl _start, f1, f2
 _start:
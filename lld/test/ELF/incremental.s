@@ -0,0 +1,71 @@
+# REQUIRES: x86
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux -defsym VAL=1 %s -o %t1.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux -defsym VAL=2 %s -o %t2.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux \
+# RUN:   %p/Inputs/incremental.s -o %t3.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux -defsym VAL=1 \
+# RUN:   -defsym GROW=1 %s -o %t4.o
+
+## The command line is part of the layout, so we use the same file name
+## for different versions of the same input file.
+# RUN: rm -f %t.out %t.out.lld-incremental
+# RUN: cp %t1.o %t.o
+# RUN: ld.lld --incremental --verbose %t.o %t3.o -o %t.out | \
+# RUN:   FileCheck -check-prefix=NOSTATE %s
+# NOSTATE: incremental: no previous state found
+
+# RUN: cp %t2.o %t.o
+# RUN: ld.lld %t.o %t3.o -o %t.full
+# RUN: ld.lld --incremental --verbose %t.o %t3.o -o %t.out | \
+# RUN:   FileCheck -check-prefix=UPDATE %s
+# RUN: cmp %t.out %t.full
+# UPDATE: incremental: updating {{.*}}.out in place (1 of 2 files changed)
+
+# RUN: ld.lld --incremental --verbose %t.o %t3.o -o %t.out | \
+# RUN:   FileCheck -check-prefix=NOCHANGE %s
+# RUN: cmp %t.out %t.full
+# NOCHANGE: incremental: updating {{.*}}.out in place (0 of 2 files changed)
+
+# RUN: cp %t4.o %t.o
+# RUN: ld.lld %t.o %t3.o -o %t.full
+# RUN: ld.lld --incremental --verbose %t.o %t3.o -o %t.out | \
+# RUN:   FileCheck -check-prefix=LAYOUT %s
+# RUN: cmp %t.out %t.full
+# LAYOUT: incremental: layout has been changed
+
+# RUN: ld.lld --incremental --verbose %t.o %t3.o -o %t.out --gc-sections | \
+# RUN:   FileCheck -check-prefix=CMDLINE %s
+# CMDLINE: incremental: layout has been changed
+
+## The contents of linker scripts, including fillers, are part of the
+## layout too, so changing a script doesn't leave stale bytes behind.
+# RUN: echo "SECTIONS { .text : { *(.text) } =0x11111111 }" > %t.script
+# RUN: ld.lld --incremental --verbose %t.o %t3.o %t.script -o %t.out \
+# RUN:   > /dev/null
+# RUN: ld.lld --incremental --verbose %t.o %t3.o %t.script -o %t.out | \
+# RUN:   FileCheck -check-prefix=SCRIPTSAME %s
+# SCRIPTSAME: incremental: updating {{.*}}.out in place (0 of 2 files changed)
+# RUN: echo "SECTIONS { .text : { *(.text) } =0x22222222 }" > %t.script
+# RUN: ld.lld %t.o %t3.o %t.script -o %t.full
+# RUN: ld.lld --incremental --verbose %t.o %t3.o %t.script -o %t.out | \
+# RUN:   FileCheck -check-prefix=SCRIPT %s
+# RUN: cmp %t.out %t.full
+# SCRIPT: incremental: layout has been changed
+
+# RUN: not ld.lld --incremental -r %t1.o -o %t.r 2>&1 | \
+# RUN:   FileCheck -check-prefix=RELOCATABLE %s
+# RELOCATABLE: -r and --incremental may not be used together
+
+.globl _start
+_start:
+  call foo
+  movl val, %eax
+
+.ifdef GROW
+  nop
+.endif
+
+.data
+val:
+  .long VAL
@@ -2,6 +2,9 @@
 // RUN: llvm-mc -filetype=obj -triple=x86_64-pc-linux %p/Inputs/resolution.s -o %t2
 // RUN: ld.lld -discard-all %t %t2 -o %t3
 // RUN: llvm-readobj -t %t3 | FileCheck %s
+// RUN: ld.lld -discard-all %t %t2 -o %t4 -threads
+// RUN: ld.lld -discard-all %t %t2 -o %t5 -no-threads
+// RUN: cmp %t4 %t5
 // REQUIRES: x86
 
 // This is an exhaustive test for checking which symbol is kept when two
@@ -0,0 +1,37 @@
+# REQUIRES: x86
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+
+# RUN: rm -f %t.out.time-trace.json
+# RUN: ld.lld --time-trace %t.o -o %t.out
+# RUN: FileCheck %s < %t.out.time-trace.json
+
+# RUN: ld.lld --time-trace-file=%t.json %t.o -o %t.out
+# RUN: FileCheck %s < %t.json
+
+# CHECK:      {"traceEvents":[
+# CHECK-NEXT: {"ph":"X","pid":1,"tid":0,"ts":0.000,"dur":{{[0-9]+\.[0-9]+}},"name":"Total"}
+# CHECK-DAG:  "name":"Read input files"
+# CHECK-DAG:  "name":"Parse input file","args":{"detail":"{{.*}}time-trace.s.tmp.o"}
+# CHECK-DAG:  "name":"Resolve symbols"
+# CHECK-DAG:  "name":"Assign addresses"
+# CHECK-DAG:  "name":"Write sections"
+# CHECK-DAG:  "ph":"C",{{.*}}"name":"Malloc usage","args":{"bytes":{{[0-9]+}}}
+# CHECK:      "otherData":{"peakMallocUsage":{{[0-9]+}}}
+
+## The trace is written for failed links too, both when errors are
+## reported and when the linker exits with a fatal error.
+# RUN: rm -f %t.err.json %t.fatal.json
+# RUN: not ld.lld --time-trace-file=%t.err.json %t.o %t.o -o %t.out
+# RUN: FileCheck -check-prefix=FAIL %s < %t.err.json
+# RUN: not ld.lld --time-trace-file=%t.fatal.json %t.o \
+# RUN:   %p/Inputs/bad-archive.a -o %t.out
+# RUN: FileCheck -check-prefix=FAIL %s < %t.fatal.json
+# FAIL: {"ph":"X","pid":1,"tid":0,"ts":0.000,"dur":{{[0-9]+\.[0-9]+}},"name":"Total"}
+
+# RUN: ld.lld %t.o -o %t2.out
+# RUN: not ls %t2.out.time-trace.json
+
+.globl _start
+_start:
+  nop
@@ -445,6 +445,37 @@ public:
     return (SCEV::NoWrapFlags)(Flags & ~OffFlags);
   }
 
+  /// Counts of the lookups that were answered from, and that missed, the
+  /// caches of ScalarEvolution.
+  struct CacheStatistics {
+    /// The SCEVs of values.
+    uint64_t ValueHits = 0;
+    uint64_t ValueMisses = 0;
+    /// The backedge-taken counts of loops.
+    uint64_t BackedgeTakenHits = 0;
+    uint64_t BackedgeTakenMisses = 0;
+    /// The values of expressions at the scope of a loop.
+    uint64_t ScopeHits = 0;
+    uint64_t ScopeMisses = 0;
+    /// Cache entries evicted to stay within the bound on their number.
+    uint64_t Evictions = 0;
+    /// Instructions treated as unknown because they were reached too deep in
+    /// a query.
+    uint64_t DepthLimited = 0;
+  };
+
+  const CacheStatistics &getCacheStatistics() const { return CacheStats; }
+
+  /// Return the number of bytes allocated for SCEVs and the caches: the
+  /// SCEV allocator, the buckets of the cache maps, and the out-of-line
+  /// storage of the lists of values at scopes and of exits. The predicates of
+  /// predicated exits are counted by their object size only. The uniquing
+  /// table of the SCEVs and the sets of values in ExprValueMap are not
+  /// counted.
+  size_t getCacheMemoryUsage() const;
+
+  void printCacheStatistics(raw_ostream &OS) const;
+
 private:
   /// A CallbackVH to arrange for ScalarEvolution to be notified whenever a
   /// Value is deleted.
@@ -543,6 +574,33 @@ private:
   /// predicate by splitting it into a set of independent predicates.
   bool ProvingSplitPredicate;
 
+  /// The number of calls to getSCEV, getSCEVAtScope and the backedge-taken
+  /// count queries on the stack. These leave placeholders in the caches while
+  /// they compute, so the caches are only trimmed when it is zero.
+  unsigned QueryDepth;
+
+  /// Hit and miss counts of the caches.
+  CacheStatistics CacheStats;
+
+  /// When the caches are bounded, the time each of their entries was last
+  /// used, so that the least recently used ones can be evicted. The clock is
+  /// advanced on every use.
+  uint64_t CacheClock;
+  DenseMap<Value *, uint64_t> ValueLastUse;
+  DenseMap<const Loop *, uint64_t> LoopLastUse;
+  DenseMap<const SCEV *, uint64_t> ScopeLastUse;
+
+  /// Values left unknown by the depth limit. Their SCEVUnknowns are never
+  /// evicted: computed again at a shallower depth, they would become full
+  /// expressions that disagree with the ones already built on top of them.
+  DenseSet<Value *> DepthLimitedValues;
+
+  /// If the caches hold more entries than allowed, evict the least recently
+  /// used half of the entries of ValueExprMap, the backedge-taken counts and
+  /// ValuesAtScopes. The SCEVs themselves are never freed, since clients hold
+  /// on to them.
+  void trimCaches();
+
   /// Information about the number of loop iterations for which a loop exit's
   /// branch condition evaluates to the not-taken path.  This is a temporary
   /// pair of exact and max expressions that are eventually summarized in
@@ -699,6 +757,9 @@ private:
 
     /// Invalidate this result and free associated memory.
     void clear();
+
+    /// Return the number of bytes allocated outside of this object.
+    size_t getMemoryUsage() const;
   };
 
   /// Cache the backedge-taken count of the loops for this function as they
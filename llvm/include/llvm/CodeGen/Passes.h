@@ -151,6 +151,12 @@ namespace llvm {
   ///
   FunctionPass *createBasicRegisterAllocator();
 
+  /// LinearScanRegisterAllocation Pass - This pass allocates live intervals in
+  /// program order without splitting them. It is faster than the greedy
+  /// allocator and spills much less than the fast one.
+  ///
+  FunctionPass *createLinearScanRegisterAllocator();
+
   /// Greedy register allocation pass - This pass implements a global register
   /// allocator for optimized builds.
   ///
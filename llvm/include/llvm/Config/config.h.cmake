@@ -342,6 +342,9 @@
 /* Define if zlib compression is available */
 #cmakedefine01 LLVM_ENABLE_ZLIB
 
+/* Define if StringMap hashes its keys with xxHash */
+#cmakedefine01 LLVM_ENABLE_STRINGMAP_XXHASH
+
 /* Has gcc/MSVC atomic intrinsics */
 #cmakedefine01 LLVM_HAS_ATOMICS
 
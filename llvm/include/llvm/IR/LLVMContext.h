@@ -263,6 +263,10 @@ public:
   /// \brief Access the object which manages optimization bisection for failure
   /// analysis.
   OptBisect &getOptBisect();
+
+  /// \brief Return the number of bytes used by uniqued metadata nodes,
+  /// including their operands, and by the tables that unique them.
+  size_t getUniquedMDNodeMemorySize() const;
 private:
   // Module needs access to the add/removeModule methods.
   friend class Module;
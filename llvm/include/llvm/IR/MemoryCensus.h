@@ -0,0 +1,82 @@
+//===- MemoryCensus.h - Memory used by the IR of a module -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares IRMemoryCensus, which estimates how many bytes the
+// Values of a module use, broken down by kind of Value.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_MEMORYCENSUS_H
+#define LLVM_IR_MEMORYCENSUS_H
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include <cstdint>
+
+namespace llvm {
+
+class GlobalObject;
+class Metadata;
+class Module;
+class raw_ostream;
+class Value;
+
+/// Counts the Values of one or more modules and estimates the memory they
+/// use, by kind of Value (instruction opcode, constant class, etc.).
+///
+/// For each kind, the census reports the number of Values and the bytes
+/// used by the Value objects themselves, by their operands (the Use array of
+/// a User, which is co-allocated with it or hung off it) and by their names.
+/// Constants, inline asm and metadata wrappers are shared by all the modules
+/// of a context and are counted once.
+///
+/// Metadata that the module refers to through named metadata, attachments
+/// and metadata operands is counted by metadata class (MDTuple, DILocation,
+/// MDString, ...) in the same way: the nodes themselves, their operands and
+/// the characters of strings. The tables that unique metadata in the context
+/// are not counted.
+class IRMemoryCensus {
+public:
+  struct Entry {
+    uint64_t Count = 0;
+    uint64_t ObjectBytes = 0;
+    uint64_t OperandBytes = 0;
+    uint64_t NameBytes = 0;
+
+    uint64_t getTotalBytes() const {
+      return ObjectBytes + OperandBytes + NameBytes;
+    }
+  };
+
+  /// Count the globals, arguments, basic blocks and instructions of \p M and
+  /// the constants and metadata they use.
+  void addModule(const Module &M);
+
+  const StringMap<Entry> &getEntries() const { return Entries; }
+
+  /// Returns the sum of the bytes of all entries.
+  uint64_t getTotalBytes() const;
+
+  /// Print the census as a table, largest kinds first.
+  void print(raw_ostream &OS) const;
+
+private:
+  void addValue(const Value &V);
+  void addOperands(const Value &V);
+  void addMetadata(const Metadata &MD);
+  void addAttachments(const GlobalObject &GO);
+
+  StringMap<Entry> Entries;
+  DenseSet<const Value *> SharedValues;
+  DenseSet<const Metadata *> SharedMetadata;
+};
+
+} // end namespace llvm
+
+#endif
@@ -46,6 +46,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManagerInternal.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/TimeTrace.h"
 #include "llvm/Support/TypeName.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/type_traits.h"
@@ -416,6 +417,8 @@ public:
         dbgs() << "Running pass: " << Passes[Idx]->name() << " on "
                << IR.getName() << "\n";
 
+      TimeTraceScope TraceScope(Passes[Idx]->name(),
+                                [&] { return std::string(IR.getName()); });
       PreservedAnalyses PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
 
       // Update the analysis manager as each pass runs and potentially
@@ -812,12 +815,19 @@ private:
 
     // If we don't have a cached result for this function, look up the pass and
     // run it to produce a result, which we then add to the cache.
+    if (isTimeTraceEnabled())
+      recordTimeTraceAnalysisLookup(this->lookUpPass(ID).name(), !Inserted);
+
     if (Inserted) {
       auto &P = this->lookUpPass(ID);
       if (DebugLogging)
         dbgs() << "Running analysis: " << P.name() << "\n";
       AnalysisResultListT &ResultList = AnalysisResultLists[&IR];
-      ResultList.emplace_back(ID, P.run(IR, *this, ExtraArgs...));
+      {
+        TimeTraceScope TraceScope(P.name(),
+                                  [&] { return std::string(IR.getName()); });
+        ResultList.emplace_back(ID, P.run(IR, *this, ExtraArgs...));
+      }
 
       // P.run may have inserted elements into AnalysisResults and invalidated
       // RI.
@@ -31,6 +31,12 @@ typedef std::function<void(unsigned Task, StringRef Path)> AddFileFn;
 /// file callback.
 NativeObjectCache localCache(std::string CacheDirectoryPath, AddFileFn AddFile);
 
+/// Create a local file system cache like localCache, which also records its
+/// entries in an index so that it can be kept under a size limit with
+/// llvm::CacheIndex::prune() without scanning the cache directory.
+NativeObjectCache indexedCache(std::string CacheDirectoryPath,
+                               AddFileFn AddFile);
+
 } // namespace lto
 } // namespace llvm
 
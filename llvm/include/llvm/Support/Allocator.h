@@ -117,8 +117,15 @@ namespace detail {
 void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
                                 size_t TotalMemory);
 
+/// Adds \p Size to the bytes returned by getBumpPtrAllocatorSlabBytes().
+void addBumpPtrAllocatorSlabBytes(size_t Size);
+
 } // end namespace detail
 
+/// Returns the total size of the slabs that all BumpPtrAllocators have
+/// allocated so far, including the slabs they have since freed.
+uint64_t getBumpPtrAllocatorSlabBytes();
+
 /// \brief Allocate memory in an ever growing pool, as if by bump-pointer.
 ///
 /// This isn't strictly a bump-pointer allocator as it uses backing slabs of
@@ -235,6 +242,7 @@ public:
     size_t PaddedSize = Size + Alignment - 1;
     if (PaddedSize > SizeThreshold) {
       void *NewSlab = Allocator.Allocate(PaddedSize, 0);
+      detail::addBumpPtrAllocatorSlabBytes(PaddedSize);
       // We own the new slab and don't want anyone reading anyting other than
       // pieces returned from this method.  So poison the whole slab.
       __asan_poison_memory_region(NewSlab, PaddedSize);
@@ -325,6 +333,7 @@ private:
     size_t AllocatedSlabSize = computeSlabSize(Slabs.size());
 
     void *NewSlab = Allocator.Allocate(AllocatedSlabSize, 0);
+    detail::addBumpPtrAllocatorSlabBytes(AllocatedSlabSize);
     // We own the new slab and don't want anyone reading anything other than
     // pieces returned from this method.  So poison the whole slab.
     __asan_poison_memory_region(NewSlab, AllocatedSlabSize);
@@ -0,0 +1,91 @@
+//===- CacheIndex.h - Size-bounded cache directory with an index -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a cache directory that records the size and the last
+// access time of its entries in an index file, so that it can be kept under a
+// size limit without scanning the directory.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CACHEINDEX_H
+#define LLVM_SUPPORT_CACHEINDEX_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+namespace llvm {
+
+/// A content-addressed cache directory that may be shared by concurrent
+/// processes.
+///
+/// Entries are named after their key, so looking one up opens a single file.
+/// New entries are written to a temporary file in the cache directory and
+/// renamed into place, so readers never see a partially written entry; two
+/// processes that produce the same key produce the same content, so it does
+/// not matter which rename wins.
+///
+/// Every insertion and every hit appends a "<key> <size> <time>" line to the
+/// index file with a single write. prune() compacts the index and evicts the
+/// least recently used entries until the cache fits in the size limit. It is
+/// serialized by a lock file that other processes never wait for: a process
+/// that finds the lock taken leaves the pruning to its owner.
+class CacheIndex {
+public:
+  /// Prepare to use the cache directory \p Path, which must exist.
+  CacheIndex(StringRef Path) : Path(Path) {}
+
+  /// Define the maximum total size of the entries in bytes. A value of 0
+  /// disables size-based pruning.
+  CacheIndex &setMaxSizeBytes(uint64_t Bytes) {
+    MaxSizeBytes = Bytes;
+    return *this;
+  }
+
+  /// Define how long an entry is protected from eviction after it was last
+  /// used, so that a concurrent link can still read an entry that it has just
+  /// looked up.
+  CacheIndex &setMinEntryAge(std::chrono::seconds Age) {
+    MinEntryAge = Age;
+    return *this;
+  }
+
+  /// Returns the path of the entry for \p Key.
+  std::string getEntryPath(StringRef Key) const;
+
+  /// Returns true and records an access if there is an entry for \p Key.
+  bool lookup(StringRef Key) const;
+
+  /// Create a temporary file in the cache directory to write a new entry to.
+  std::error_code createTemporaryEntry(int &ResultFD,
+                                       SmallVectorImpl<char> &ResultPath) const;
+
+  /// Move the temporary file \p TempPath into place as the entry for \p Key
+  /// and record it in the index.
+  std::error_code commit(StringRef TempPath, StringRef Key) const;
+
+  /// Evict the least recently used entries until the cache fits in the
+  /// maximum size. Returns false if pruning is disabled or another process
+  /// is already pruning the cache.
+  bool prune();
+
+private:
+  void record(StringRef Key, uint64_t Size) const;
+
+  std::string Path;
+  uint64_t MaxSizeBytes = 0;
+  std::chrono::seconds MinEntryAge = std::chrono::seconds(600);
+};
+
+} // namespace llvm
+
+#endif
@@ -24,6 +24,7 @@
 #ifndef LLVM_SUPPORT_GENERICDOMTREE_H
 #define LLVM_SUPPORT_GENERICDOMTREE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
@@ -33,6 +34,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <queue>
 
 namespace llvm {
 
@@ -91,6 +93,7 @@ struct PostDominatorTree;
 template <class NodeT> class DomTreeNodeBase {
   NodeT *TheBB;
   DomTreeNodeBase<NodeT> *IDom;
+  unsigned Level;
   std::vector<DomTreeNodeBase<NodeT> *> Children;
   mutable int DFSNumIn, DFSNumOut;
 
@@ -113,8 +116,13 @@ public:
     return Children;
   }
 
+  /// getLevel - Return the depth of this node in the tree: 0 for the root,
+  /// 1 for its children, and so on.
+  unsigned getLevel() const { return Level; }
+
   DomTreeNodeBase(NodeT *BB, DomTreeNodeBase<NodeT> *iDom)
-      : TheBB(BB), IDom(iDom), DFSNumIn(-1), DFSNumOut(-1) {}
+      : TheBB(BB), IDom(iDom), Level(iDom ? iDom->Level + 1 : 0),
+        DFSNumIn(-1), DFSNumOut(-1) {}
 
   std::unique_ptr<DomTreeNodeBase<NodeT>>
   addChild(std::unique_ptr<DomTreeNodeBase<NodeT>> C) {
@@ -157,6 +165,8 @@ public:
       // Switch to new dominator
       IDom = NewIDom;
       IDom->Children.push_back(this);
+
+      updateLevel();
     }
   }
 
@@ -167,6 +177,23 @@ public:
   unsigned getDFSNumOut() const { return DFSNumOut; }
 
 private:
+  // Recompute the levels of this node and of its descendants after its IDom
+  // changed. Subtrees whose root already has the right level are skipped.
+  void updateLevel() {
+    if (Level == IDom->Level + 1)
+      return;
+
+    SmallVector<DomTreeNodeBase<NodeT> *, 64> WorkStack;
+    WorkStack.push_back(this);
+    while (!WorkStack.empty()) {
+      DomTreeNodeBase<NodeT> *Current = WorkStack.pop_back_val();
+      Current->Level = Current->IDom->Level + 1;
+      for (DomTreeNodeBase<NodeT> *C : Current->Children)
+        if (C->Level != Current->Level + 1)
+          WorkStack.push_back(C);
+    }
+  }
+
   // Return true if this node is dominated by other. Use this only if DFS info
   // is valid.
   bool DominatedBy(const DomTreeNodeBase<NodeT> *other) const {
@@ -629,6 +656,130 @@ public:
       this->Split<NodeT *, GraphTraits<NodeT *>>(*this, NewBB);
   }
 
+  /// The kind of a CFG edge change, see applyUpdates.
+  enum UpdateKind { Insert, Delete };
+
+  /// An edge From->To that was inserted into, or deleted from, the CFG.
+  struct UpdateType {
+    UpdateKind Kind;
+    NodeT *From;
+    NodeT *To;
+
+    UpdateType(UpdateKind Kind, NodeT *From, NodeT *To)
+        : Kind(Kind), From(From), To(To) {}
+  };
+
+  /// insertEdge - Update the tree after the edge From->To was inserted into
+  /// the CFG. The CFG must already contain the edge.
+  void insertEdge(NodeT *From, NodeT *To) {
+    applyUpdates(UpdateType(Insert, From, To));
+  }
+
+  /// deleteEdge - Update the tree after the edge From->To was deleted from
+  /// the CFG. The CFG must no longer contain the edge.
+  void deleteEdge(NodeT *From, NodeT *To) {
+    applyUpdates(UpdateType(Delete, From, To));
+  }
+
+  /// applyUpdates - Update the tree after a batch of edge insertions and
+  /// deletions, which the CFG must already reflect. Edges are always given in
+  /// the direction of the CFG, for post-dominator trees too. New blocks need
+  /// not be added to the tree first: inserting an edge to a block the tree
+  /// doesn't know about makes it, and anything else it newly reaches, part of
+  /// the tree. Deleting an edge erases the nodes that become unreachable.
+  ///
+  /// Insertions only visit the nodes whose immediate dominator changes and
+  /// their neighbours, deletions rebuild the subtree of the nearest common
+  /// dominator of the edge's ends. Post-dominator trees, whose roots can
+  /// change with any edit, and large batches are recalculated instead.
+  void applyUpdates(ArrayRef<UpdateType> Updates) {
+    if (Updates.empty())
+      return;
+
+    BatchUpdateInfo BUI;
+    legalizeUpdates(Updates, BUI.Updates);
+    if (BUI.Updates.empty())
+      return;
+
+    NodeT *AnyBlock = BUI.Updates.front().From;
+    // Recalculating is faster than this many incremental updates, whose cost
+    // is roughly proportional to the number of nodes they touch.
+    size_t NumUpdates = BUI.Updates.size();
+    if (this->IsPostDominators ||
+        (NumUpdates > 64 && NumUpdates > DomTreeNodes.size() / 32)) {
+      recalculate(*AnyBlock->getParent());
+      return;
+    }
+
+    // Until an update is applied, the tree is told the CFG doesn't have it.
+    for (const UpdateType &U : BUI.Updates) {
+      BUI.FutureSuccessors[U.From].push_back({U.To, U.Kind});
+      BUI.FuturePredecessors[U.To].push_back({U.From, U.Kind});
+    }
+
+    for (const UpdateType &U : BUI.Updates) {
+      auto &Succs = BUI.FutureSuccessors[U.From];
+      Succs.erase(find(Succs, std::make_pair(U.To, U.Kind)));
+      auto &Preds = BUI.FuturePredecessors[U.To];
+      Preds.erase(find(Preds, std::make_pair(U.From, U.Kind)));
+
+      if (U.Kind == Insert) {
+        insertEdgeImpl(U.From, U.To, BUI);
+      } else if (!deleteEdgeImpl(U.From, U.To, BUI)) {
+        // The tree was recalculated, which took all the updates into account.
+        return;
+      }
+    }
+  }
+
+  /// verify - Check that the tree is internally consistent, and that it is
+  /// the tree that recalculating it from the CFG gives. If it isn't, print
+  /// the differences to errs() and return false.
+  bool verify() const {
+    bool Valid = true;
+    for (const auto &Entry : DomTreeNodes) {
+      const DomTreeNodeBase<NodeT> *TN = Entry.second.get();
+      if (!TN)
+        continue;
+      const DomTreeNodeBase<NodeT> *IDom = TN->getIDom();
+      if (!IDom) {
+        if (TN != RootNode) {
+          errs() << "Node without an immediate dominator: " << TN;
+          Valid = false;
+        }
+        continue;
+      }
+      if (TN->getLevel() != IDom->getLevel() + 1) {
+        errs() << "Node level " << TN->getLevel() << " isn't one more than "
+               << "the level of its immediate dominator: " << TN;
+        Valid = false;
+      }
+      if (find(IDom->Children, TN) == IDom->Children.end()) {
+        errs() << "Node missing from its immediate dominator's children: "
+               << TN;
+        Valid = false;
+      }
+    }
+
+    // Find the function the tree was computed for.
+    NodeT *AnyBlock = RootNode ? RootNode->getBlock() : nullptr;
+    if (!AnyBlock && !this->Roots.empty())
+      AnyBlock = this->Roots.front();
+    if (!AnyBlock)
+      return Valid;
+
+    DominatorTreeBase<NodeT> OtherDT(this->IsPostDominators);
+    OtherDT.recalculate(*AnyBlock->getParent());
+    if (compare(OtherDT)) {
+      errs() << "Tree differs from the one computed from scratch:\n";
+      print(errs());
+      errs() << "Computed from scratch:\n";
+      OtherDT.print(errs());
+      Valid = false;
+    }
+    return Valid;
+  }
+
   /// print - Convert to human readable form
   ///
   void print(raw_ostream &o) const {
@@ -681,6 +832,319 @@ protected:
 
   void addRoot(NodeT *BB) { this->Roots.push_back(BB); }
 
+  // State of a batch of updates being applied: the pending updates are
+  // already in the CFG but must be hidden from, or in the case of deletions
+  // shown to, the update algorithms until their turn comes.
+  struct BatchUpdateInfo {
+    SmallVector<UpdateType, 4> Updates;
+    SmallDenseMap<NodeT *, SmallVector<std::pair<NodeT *, UpdateKind>, 2>, 4>
+        FutureSuccessors;
+    SmallDenseMap<NodeT *, SmallVector<std::pair<NodeT *, UpdateKind>, 2>, 4>
+        FuturePredecessors;
+  };
+
+  // Drop the updates that cancel out or that don't change the CFG's edge
+  // set, e.g. deleting one of two switch cases with the same destination.
+  static void legalizeUpdates(ArrayRef<UpdateType> Updates,
+                              SmallVectorImpl<UpdateType> &Result) {
+    SmallDenseMap<std::pair<NodeT *, NodeT *>, int, 4> Operations;
+    SmallVector<std::pair<NodeT *, NodeT *>, 4> Edges;
+    for (const UpdateType &U : Updates) {
+      auto Edge = std::make_pair(U.From, U.To);
+      auto Ins = Operations.insert({Edge, 0});
+      if (Ins.second)
+        Edges.push_back(Edge);
+      Ins.first->second += U.Kind == Insert ? 1 : -1;
+    }
+
+    for (const auto &Edge : Edges) {
+      int Op = Operations[Edge];
+      if (Op == 0)
+        continue;
+      assert((Op == 1 || Op == -1) && "Edge inserted or deleted twice");
+      bool InCFG = is_contained(getSuccessors(Edge.first), Edge.second);
+      if (Op > 0) {
+        assert(InCFG && "Inserted edge isn't in the CFG");
+        Result.push_back(UpdateType(Insert, Edge.first, Edge.second));
+      } else if (!InCFG) {
+        Result.push_back(UpdateType(Delete, Edge.first, Edge.second));
+      }
+    }
+  }
+
+  static SmallVector<NodeT *, 8> getSuccessors(NodeT *N) {
+    typedef GraphTraits<NodeT *> Traits;
+    return SmallVector<NodeT *, 8>(Traits::child_begin(N),
+                                   Traits::child_end(N));
+  }
+
+  static SmallVector<NodeT *, 8> getPredecessors(NodeT *N) {
+    typedef GraphTraits<Inverse<NodeT *>> InvTraits;
+    return SmallVector<NodeT *, 8>(InvTraits::child_begin(N),
+                                   InvTraits::child_end(N));
+  }
+
+  // Return the successors (predecessors if Inverse) of N in the CFG as the
+  // tree currently sees it, see BatchUpdateInfo.
+  static SmallVector<NodeT *, 8> getChildren(NodeT *N,
+                                             const BatchUpdateInfo &BUI,
+                                             bool Inverse) {
+    SmallVector<NodeT *, 8> Children =
+        Inverse ? getPredecessors(N) : getSuccessors(N);
+    auto &Future = Inverse ? BUI.FuturePredecessors : BUI.FutureSuccessors;
+    auto It = Future.find(N);
+    if (It == Future.end())
+      return Children;
+
+    for (const auto &Pending : It->second) {
+      if (Pending.second == Insert)
+        Children.erase(std::remove(Children.begin(), Children.end(),
+                                   Pending.first),
+                       Children.end());
+      else
+        Children.push_back(Pending.first);
+    }
+    return Children;
+  }
+
+  static DomTreeNodeBase<NodeT> *
+  findNearestCommonDominatorNode(DomTreeNodeBase<NodeT> *A,
+                                 DomTreeNodeBase<NodeT> *B) {
+    while (A != B) {
+      if (A->getLevel() < B->getLevel())
+        std::swap(A, B);
+      A = A->getIDom();
+    }
+    return A;
+  }
+
+  // Compute the immediate dominators of the nodes reachable from Entry
+  // through nodes for which InRegion is true, which must only be enterable
+  // through Entry. Return the visited nodes in reverse post-order and set
+  // IDoms for all but Entry.
+  template <typename RegionFn>
+  static void calculateRegion(NodeT *Entry, RegionFn InRegion,
+                              const BatchUpdateInfo &BUI,
+                              SmallVectorImpl<NodeT *> &RPO,
+                              DenseMap<NodeT *, NodeT *> &IDoms) {
+    // Number the nodes in post-order.
+    DenseMap<NodeT *, unsigned> PostNum;
+    SmallVector<std::pair<NodeT *, SmallVector<NodeT *, 8>>, 32> WorkStack;
+    PostNum[Entry] = 0;
+    WorkStack.push_back({Entry, getChildren(Entry, BUI, false)});
+    while (!WorkStack.empty()) {
+      auto &Succs = WorkStack.back().second;
+      if (Succs.empty()) {
+        NodeT *N = WorkStack.back().first;
+        PostNum[N] = RPO.size();
+        RPO.push_back(N);
+        WorkStack.pop_back();
+        continue;
+      }
+      NodeT *Succ = Succs.pop_back_val();
+      if (!InRegion(Succ) || !PostNum.insert({Succ, 0}).second)
+        continue;
+      WorkStack.push_back({Succ, getChildren(Succ, BUI, false)});
+    }
+    std::reverse(RPO.begin(), RPO.end());
+
+    // The iterative algorithm of Cooper, Harvey and Kennedy: the regions are
+    // small compared to whole functions, and in reverse post-order it
+    // converges in a couple of iterations.
+    auto Intersect = [&](NodeT *A, NodeT *B) {
+      while (A != B) {
+        while (PostNum[A] < PostNum[B])
+          A = IDoms[A];
+        while (PostNum[B] < PostNum[A])
+          B = IDoms[B];
+      }
+      return A;
+    };
+
+    IDoms[Entry] = Entry;
+    bool Changed = true;
+    while (Changed) {
+      Changed = false;
+      for (NodeT *N : make_range(std::next(RPO.begin()), RPO.end())) {
+        NodeT *NewIDom = nullptr;
+        for (NodeT *Pred : getChildren(N, BUI, true)) {
+          if (!IDoms.count(Pred) || !PostNum.count(Pred))
+            continue;
+          NewIDom = NewIDom ? Intersect(Pred, NewIDom) : Pred;
+        }
+        NodeT *&IDom = IDoms[N];
+        if (IDom != NewIDom) {
+          IDom = NewIDom;
+          Changed = true;
+        }
+      }
+    }
+    IDoms.erase(Entry);
+  }
+
+  void insertEdgeImpl(NodeT *From, NodeT *To, const BatchUpdateInfo &BUI) {
+    DomTreeNodeBase<NodeT> *FromTN = getNode(From);
+    // An edge out of an unreachable block changes nothing.
+    if (!FromTN)
+      return;
+
+    DFSInfoValid = false;
+    if (DomTreeNodeBase<NodeT> *ToTN = getNode(To))
+      insertReachable(FromTN, ToTN, BUI);
+    else
+      insertUnreachable(FromTN, To, BUI);
+  }
+
+  // Insert an edge between two reachable nodes with the depth-based search
+  // algorithm of Georgiadis et al., "An Experimental Study of Dynamic
+  // Dominators": the nodes whose immediate dominator changes become children
+  // of the nearest common dominator of From and To, and they are found by
+  // visiting the successors of To in decreasing level order.
+  void insertReachable(DomTreeNodeBase<NodeT> *FromTN,
+                       DomTreeNodeBase<NodeT> *ToTN,
+                       const BatchUpdateInfo &BUI) {
+    DomTreeNodeBase<NodeT> *NCD = findNearestCommonDominatorNode(FromTN, ToTN);
+    if (NCD == ToTN || NCD == ToTN->getIDom())
+      return;
+
+    const unsigned NCDLevel = NCD->getLevel();
+    std::priority_queue<std::pair<unsigned, DomTreeNodeBase<NodeT> *>> Bucket;
+    SmallPtrSet<DomTreeNodeBase<NodeT> *, 8> Affected, Visited;
+    SmallVector<DomTreeNodeBase<NodeT> *, 8> AffectedQueue;
+    SmallVector<DomTreeNodeBase<NodeT> *, 8> WorkStack;
+
+    Affected.insert(ToTN);
+    Bucket.push({ToTN->getLevel(), ToTN});
+    while (!Bucket.empty()) {
+      DomTreeNodeBase<NodeT> *Current = Bucket.top().second;
+      Bucket.pop();
+      AffectedQueue.push_back(Current);
+      Visited.insert(Current);
+
+      // Nodes deeper than Current are reachable from it without going through
+      // NCD but aren't affected themselves; their successors may be.
+      const unsigned CurrentLevel = Current->getLevel();
+      WorkStack.push_back(Current);
+      while (!WorkStack.empty()) {
+        DomTreeNodeBase<NodeT> *TN = WorkStack.pop_back_val();
+        for (NodeT *Succ : getChildren(TN->getBlock(), BUI, false)) {
+          DomTreeNodeBase<NodeT> *SuccTN = getNode(Succ);
+          assert(SuccTN && "Unreachable successor of a reachable node");
+          const unsigned SuccLevel = SuccTN->getLevel();
+          if (SuccLevel > CurrentLevel) {
+            if (Visited.insert(SuccTN).second)
+              WorkStack.push_back(SuccTN);
+          } else if (SuccLevel > NCDLevel + 1 &&
+                     Affected.insert(SuccTN).second) {
+            Bucket.push({SuccLevel, SuccTN});
+          }
+        }
+      }
+    }
+
+    for (DomTreeNodeBase<NodeT> *TN : AffectedQueue)
+      TN->setIDom(NCD);
+  }
+
+  // Insert an edge from a reachable node to an unreachable one: compute the
+  // dominators of the newly reachable region, hang it below From, then insert
+  // the edges from the region to the nodes that were already reachable.
+  void insertUnreachable(DomTreeNodeBase<NodeT> *FromTN, NodeT *To,
+                         const BatchUpdateInfo &BUI) {
+    SmallVector<NodeT *, 16> RPO;
+    DenseMap<NodeT *, NodeT *> IDoms;
+    calculateRegion(To, [&](NodeT *N) { return !getNode(N); }, BUI, RPO,
+                    IDoms);
+
+    for (NodeT *N : RPO) {
+      DomTreeNodeBase<NodeT> *IDomNode = N == To ? FromTN : getNode(IDoms[N]);
+      DomTreeNodes[N] = IDomNode->addChild(
+          llvm::make_unique<DomTreeNodeBase<NodeT>>(N, IDomNode));
+    }
+
+    SmallVector<std::pair<NodeT *, NodeT *>, 8> EdgesToReachable;
+    for (NodeT *N : RPO)
+      for (NodeT *Succ : getChildren(N, BUI, false))
+        if (!IDoms.count(Succ) && Succ != To)
+          EdgesToReachable.push_back({N, Succ});
+    for (const auto &Edge : EdgesToReachable)
+      insertReachable(getNode(Edge.first), getNode(Edge.second), BUI);
+  }
+
+  // Delete an edge by rebuilding the subtree of the nearest common dominator
+  // of From and To, the only nodes affected while To stays reachable. The
+  // nodes that become unreachable lose their outgoing edges too, so the
+  // subtree must also contain the nodes those lead to. If that is the whole
+  // tree, recalculate it from the CFG instead and return false.
+  bool deleteEdgeImpl(NodeT *From, NodeT *To, const BatchUpdateInfo &BUI) {
+    DomTreeNodeBase<NodeT> *FromTN = getNode(From);
+    DomTreeNodeBase<NodeT> *ToTN = getNode(To);
+    if (!FromTN || !ToTN)
+      return true;
+
+    // Deleting an edge to a dominator only removes paths that have a shorter
+    // version without it.
+    DomTreeNodeBase<NodeT> *Top = findNearestCommonDominatorNode(FromTN, ToTN);
+    if (Top == ToTN)
+      return true;
+
+    DFSInfoValid = false;
+    SmallVector<DomTreeNodeBase<NodeT> *, 32> Subtree;
+    SmallPtrSet<DomTreeNodeBase<NodeT> *, 32> InSubtree;
+    SmallVector<NodeT *, 32> RPO;
+    DenseMap<NodeT *, NodeT *> IDoms;
+    while (true) {
+      if (!Top->getIDom()) {
+        recalculate(*From->getParent());
+        return false;
+      }
+
+      // The old subtree, breadth-first. Any path from Top to one of its nodes
+      // stays within levels below Top's, so that is where to search for the
+      // nodes that are still reachable.
+      Subtree.clear();
+      Subtree.push_back(Top);
+      for (unsigned I = 0; I != Subtree.size(); ++I)
+        Subtree.append(Subtree[I]->begin(), Subtree[I]->end());
+      InSubtree.clear();
+      InSubtree.insert(Subtree.begin(), Subtree.end());
+
+      const unsigned TopLevel = Top->getLevel();
+      auto InRegion = [&](NodeT *N) {
+        DomTreeNodeBase<NodeT> *TN = getNode(N);
+        return TN && TN->getLevel() > TopLevel;
+      };
+      RPO.clear();
+      IDoms.clear();
+      calculateRegion(Top->getBlock(), InRegion, BUI, RPO, IDoms);
+
+      DomTreeNodeBase<NodeT> *NewTop = Top;
+      for (DomTreeNodeBase<NodeT> *TN : Subtree) {
+        if (TN == Top || IDoms.count(TN->getBlock()))
+          continue;
+        for (NodeT *Succ : getChildren(TN->getBlock(), BUI, false)) {
+          DomTreeNodeBase<NodeT> *SuccTN = getNode(Succ);
+          if (SuccTN && !InSubtree.count(SuccTN))
+            NewTop = findNearestCommonDominatorNode(NewTop, SuccTN);
+        }
+      }
+      if (NewTop == Top)
+        break;
+      Top = NewTop;
+    }
+
+    for (NodeT *N : make_range(std::next(RPO.begin()), RPO.end()))
+      getNode(N)->setIDom(getNode(IDoms[N]));
+
+    // Nodes that weren't visited are now unreachable, and only have
+    // unreachable children left. Erase them bottom-up.
+    for (DomTreeNodeBase<NodeT> *TN : make_range(Subtree.rbegin(),
+                                                 Subtree.rend()))
+      if (TN != Top && !IDoms.count(TN->getBlock()))
+        eraseNode(TN->getBlock());
+    return true;
+  }
+
 public:
   /// updateDFSNumbers - Assign In and Out numbers to the nodes while walking
   /// dominator tree in dfs order.
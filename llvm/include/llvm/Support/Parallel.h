@@ -0,0 +1,254 @@
+//===- llvm/Support/Parallel.h - Parallel algorithms ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a work-stealing task scheduler and parallel algorithms
+// built on top of it.
+//
+// All users in a process share one set of worker threads. Each worker has
+// its own task queue; it runs tasks from the back of its own queue and
+// steals tasks from the front of other workers' queues when its queue is
+// empty. A thread waiting for a TaskGroup runs the tasks of that group
+// that no thread has started yet, and then sleeps until the others have
+// finished. It never runs tasks of other groups, so it doesn't get stuck
+// behind unrelated work, and parallel algorithms can be nested without
+// deadlocks or creating more threads than the thread budget.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_PARALLEL_H
+#define LLVM_SUPPORT_PARALLEL_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace llvm {
+namespace parallel {
+
+/// Sets the maximum number of threads, including the calling thread, that
+/// the parallel algorithms in this file use. This must be called before
+/// the first task is spawned; later calls have no effect. The default is
+/// the number of hardware threads.
+void setThreadBudget(unsigned ThreadCount);
+
+/// Returns the current thread budget.
+unsigned getThreadBudget();
+
+namespace detail {
+/// Adds a task to the shared executor. If the calling thread is a worker,
+/// the task is added to the worker's own queue.
+void spawn(std::function<void()> Fn);
+
+/// A task of a TaskGroup. It is run by whichever thread claims it first:
+/// a worker that takes it from a queue or the thread waiting for the
+/// group.
+struct GroupTask;
+} // namespace detail
+
+/// Allows launching a number of tasks and waiting for them to finish
+/// either explicitly via sync() or implicitly on destruction. While
+/// waiting, the calling thread runs the group's tasks that haven't been
+/// started by a worker yet.
+class TaskGroup {
+  // The number of tasks that haven't finished, and the tasks that may
+  // not have been started yet. Guarded by Mu.
+  size_t Pending = 0;
+  std::vector<std::shared_ptr<detail::GroupTask>> Unstarted;
+  std::mutex Mu;
+
+  // Signaled when a task is added or the last task finishes.
+  std::condition_variable Cond;
+
+  friend struct detail::GroupTask;
+
+public:
+  ~TaskGroup() { sync(); }
+
+  void spawn(std::function<void()> Fn);
+  void sync();
+};
+
+} // namespace parallel
+
+#if !LLVM_ENABLE_THREADS
+template <class RandomAccessIterator, class Comp>
+void parallel_sort(
+    RandomAccessIterator Start, RandomAccessIterator End,
+    const Comp &Compare = std::less<
+        typename std::iterator_traits<RandomAccessIterator>::value_type>()) {
+  std::sort(Start, End, Compare);
+}
+#else
+namespace parallel {
+namespace detail {
+const ptrdiff_t MinParallelSize = 1024;
+
+/// Inclusive median.
+template <class RandomAccessIterator, class Comp>
+RandomAccessIterator medianOf3(RandomAccessIterator Start,
+                               RandomAccessIterator End, const Comp &Compare) {
+  RandomAccessIterator Mid = Start + (std::distance(Start, End) / 2);
+  if (Compare(*Start, *(End - 1))) {
+    if (Compare(*Mid, *(End - 1)))
+      return Compare(*Start, *Mid) ? Mid : Start;
+    return End - 1;
+  }
+  if (Compare(*Mid, *Start))
+    return Compare(*(End - 1), *Mid) ? Mid : End - 1;
+  return Start;
+}
+
+template <class RandomAccessIterator, class Comp>
+void parallel_quick_sort(RandomAccessIterator Start, RandomAccessIterator End,
+                         const Comp &Compare, TaskGroup &TG, size_t Depth) {
+  // Do a sequential sort for small inputs.
+  if (std::distance(Start, End) < MinParallelSize || Depth == 0) {
+    std::sort(Start, End, Compare);
+    return;
+  }
+
+  // Partition.
+  auto Pivot = medianOf3(Start, End, Compare);
+  // Move Pivot to End.
+  std::swap(*(End - 1), *Pivot);
+  Pivot = std::partition(Start, End - 1, [&Compare, End](decltype(*Start) V) {
+    return Compare(V, *(End - 1));
+  });
+  // Move Pivot to middle of partition.
+  std::swap(*Pivot, *(End - 1));
+
+  // Recurse.
+  TG.spawn([=, &Compare, &TG] {
+    parallel_quick_sort(Start, Pivot, Compare, TG, Depth - 1);
+  });
+  parallel_quick_sort(Pivot + 1, End, Compare, TG, Depth - 1);
+}
+} // namespace detail
+} // namespace parallel
+
+template <class RandomAccessIterator, class Comp>
+void parallel_sort(
+    RandomAccessIterator Start, RandomAccessIterator End,
+    const Comp &Compare = std::less<
+        typename std::iterator_traits<RandomAccessIterator>::value_type>()) {
+  parallel::TaskGroup TG;
+  parallel::detail::parallel_quick_sort(
+      Start, End, Compare, TG, Log2_64(std::distance(Start, End)) + 1);
+}
+#endif
+
+template <class T> void parallel_sort(T *Start, T *End) {
+  parallel_sort(Start, End, std::less<T>());
+}
+
+#if !LLVM_ENABLE_THREADS
+template <class IterTy, class FuncTy>
+void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
+  std::for_each(Begin, End, Fn);
+}
+
+template <class IndexTy, class FuncTy>
+void parallel_for(IndexTy Begin, IndexTy End, FuncTy Fn) {
+  for (IndexTy I = Begin; I != End; ++I)
+    Fn(I);
+}
+
+template <class IterTy, class T, class ReduceFuncTy, class TransformFuncTy>
+T parallel_transform_reduce(IterTy Begin, IterTy End, T Init,
+                            ReduceFuncTy Reduce, TransformFuncTy Transform) {
+  for (IterTy I = Begin; I != End; ++I)
+    Init = Reduce(std::move(Init), Transform(*I));
+  return Init;
+}
+#else
+template <class IterTy, class FuncTy>
+void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
+  // TaskGroup has a relatively high overhead, so we want to reduce
+  // the number of spawn() calls. We'll create up to 1024 tasks here.
+  // (Note that 1024 is an arbitrary number. This code probably needs
+  // improving to take the number of available cores into account.)
+  ptrdiff_t TaskSize = std::distance(Begin, End) / 1024;
+  if (TaskSize == 0)
+    TaskSize = 1;
+
+  parallel::TaskGroup TG;
+  while (TaskSize < std::distance(Begin, End)) {
+    TG.spawn([=, &Fn] { std::for_each(Begin, Begin + TaskSize, Fn); });
+    Begin += TaskSize;
+  }
+  std::for_each(Begin, End, Fn);
+}
+
+template <class IndexTy, class FuncTy>
+void parallel_for(IndexTy Begin, IndexTy End, FuncTy Fn) {
+  ptrdiff_t TaskSize = (End - Begin) / 1024;
+  if (TaskSize == 0)
+    TaskSize = 1;
+
+  parallel::TaskGroup TG;
+  IndexTy I = Begin;
+  for (; I + TaskSize < End; I += TaskSize) {
+    TG.spawn([=, &Fn] {
+      for (IndexTy J = I, E = I + TaskSize; J != E; ++J)
+        Fn(J);
+    });
+  }
+  for (IndexTy J = I; J < End; ++J)
+    Fn(J);
+}
+
+/// Applies Transform to each element in [Begin, End) and combines the
+/// results with Reduce. Init must be an identity value of Reduce because
+/// it is used as the initial value of each task. Reduce must be
+/// associative. The results of tasks are combined in order, so the
+/// result doesn't depend on scheduling.
+template <class IterTy, class T, class ReduceFuncTy, class TransformFuncTy>
+T parallel_transform_reduce(IterTy Begin, IterTy End, T Init,
+                            ReduceFuncTy Reduce, TransformFuncTy Transform) {
+  size_t NumInputs = std::distance(Begin, End);
+  if (NumInputs == 0)
+    return Init;
+
+  // Create up to 1024 tasks, as parallel_for_each does.
+  size_t NumTasks = std::min<size_t>(1024, NumInputs);
+  std::vector<T> Results(NumTasks, Init);
+  {
+    parallel::TaskGroup TG;
+    size_t TaskSize = NumInputs / NumTasks;
+    size_t Remainder = NumInputs % NumTasks;
+    IterTy TBegin = Begin;
+    for (size_t I = 0; I < NumTasks; ++I) {
+      IterTy TEnd = TBegin + TaskSize + (I < Remainder ? 1 : 0);
+      TG.spawn([=, &Reduce, &Transform, &Results] {
+        T R = Init;
+        for (IterTy J = TBegin; J != TEnd; ++J)
+          R = Reduce(std::move(R), Transform(*J));
+        Results[I] = std::move(R);
+      });
+      TBegin = TEnd;
+    }
+  }
+
+  for (T &R : Results)
+    Init = Reduce(std::move(Init), std::move(R));
+  return Init;
+}
+#endif
+
+} // namespace llvm
+
+#endif // LLVM_SUPPORT_PARALLEL_H
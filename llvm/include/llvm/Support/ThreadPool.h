@@ -62,8 +62,9 @@ public:
   using PackagedTaskTy = std::packaged_task<bool(bool)>;
 #endif
 
-  /// Construct a pool with the number of core available on the system (or
-  /// whatever the value returned by std::thread::hardware_concurrency() is).
+  /// Construct a pool with as many threads as the process-wide thread
+  /// budget (see parallel::getThreadBudget()), which defaults to the
+  /// number of hardware threads.
   ThreadPool();
 
   /// Construct a pool of \p ThreadCount threads
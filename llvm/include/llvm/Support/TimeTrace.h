@@ -0,0 +1,116 @@
+//===- llvm/Support/TimeTrace.h - Chrome trace of compile time --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// With -time-passes-trace=<file>, the pass managers record when each pass
+// starts and stops on each unit of IR, and how much memory BumpPtrAllocators
+// allocated meanwhile, on any thread. The new pass manager also counts how
+// often analysis results are found in its cache. The trace is written to
+// <file> in the Chrome trace event format when llvm_shutdown() is called, and
+// can be loaded in chrome://tracing.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMETRACE_H
+#define LLVM_SUPPORT_TIMETRACE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/None.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace llvm {
+
+class raw_ostream;
+
+/// Returns true if a time trace is being recorded.
+bool isTimeTraceEnabled();
+
+/// Records that an analysis result was requested, and whether it was found
+/// in the cache of the analysis manager.
+void recordTimeTraceAnalysisLookup(StringRef AnalysisName, bool Cached);
+
+/// Writes the events recorded so far to \p OS, in the Chrome trace event
+/// format.
+void writeTimeTrace(raw_ostream &OS);
+
+/// An argument of a trace event, which is either a string or a number.
+struct TraceEventArg {
+  TraceEventArg(StringRef Key, StringRef Value)
+      : Key(Key), Value(Value), IsString(true) {}
+  TraceEventArg(StringRef Key, uint64_t Value)
+      : Key(Key), Value(std::to_string(Value)), IsString(false) {}
+
+  StringRef Key;
+  std::string Value;
+  bool IsString;
+};
+
+/// Writes events in the Chrome trace event format, for -time-passes-trace
+/// and for tools that record their own traces. Times are given in
+/// nanoseconds since the start of the trace and written in microseconds.
+class TraceEventWriter {
+public:
+  explicit TraceEventWriter(raw_ostream &OS);
+
+  /// Writes a complete event ("ph":"X") of \p DurationNs starting at
+  /// \p StartNs.
+  void writeComplete(StringRef Name, unsigned ThreadID, uint64_t StartNs,
+                     uint64_t DurationNs, ArrayRef<TraceEventArg> Args = None);
+
+  /// Writes a counter event ("ph":"C"). chrome://tracing shows the values of
+  /// \p Args over time as a graph.
+  void writeCounter(StringRef Name, unsigned ThreadID, uint64_t TimeNs,
+                    ArrayRef<TraceEventArg> Args);
+
+  /// Ends the list of events, followed by \p OtherData, which describes the
+  /// trace as a whole, if it is not empty.
+  void finish(ArrayRef<TraceEventArg> OtherData = None);
+
+private:
+  void beginEvent(StringRef Phase, unsigned ThreadID, uint64_t TimeNs);
+  void writeObject(StringRef Key, ArrayRef<TraceEventArg> Members);
+
+  raw_ostream &OS;
+  bool First = true;
+};
+
+/// Records an event spanning the lifetime of this object, if a time trace is
+/// being recorded.
+///
+/// \p Name is the name of the event, such as the name of a pass, and
+/// \p Detail describes what it ran on, such as the name of a function.
+class TimeTraceScope {
+public:
+  TimeTraceScope(StringRef Name, StringRef Detail);
+
+  /// Calls \p Detail only if a time trace is being recorded, for details that
+  /// are expensive to compute.
+  TimeTraceScope(StringRef Name, function_ref<std::string()> Detail);
+
+  ~TimeTraceScope();
+
+private:
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+  void begin(StringRef Name, std::string Detail);
+
+  bool Enabled;
+  std::string Name;
+  std::string Detail;
+  std::chrono::steady_clock::time_point Start;
+  uint64_t StartAllocatedBytes;
+};
+
+} // end namespace llvm
+
+#endif
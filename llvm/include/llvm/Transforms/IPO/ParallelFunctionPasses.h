@@ -0,0 +1,46 @@
+//===- ParallelFunctionPasses.h - Run function passes in parallel -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a function that runs a function pass pipeline on
+// independent functions of a module concurrently.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_IPO_PARALLELFUNCTIONPASSES_H
+#define LLVM_TRANSFORMS_IPO_PARALLELFUNCTIONPASSES_H
+
+#include <functional>
+
+namespace llvm {
+
+class Module;
+
+/// Runs a function pass pipeline on the function definitions of \p M using
+/// up to \p NumThreads threads.
+///
+/// An LLVMContext can only be used by one thread at a time, so the module is
+/// split into partitions, each of which owns the bodies of a contiguous range
+/// of functions and has declarations of the others. Each partition is moved
+/// into its own LLVMContext, and \p RunPipeline is called for each partition
+/// on a thread of the llvm::parallel executor. \p RunPipeline must only run
+/// function passes, that is, it must not change anything in the partition
+/// other than the bodies of function definitions, except for adding new
+/// declarations and global variables.
+///
+/// The optimized function bodies are copied back into \p M in module order,
+/// so the result does not depend on the number of threads or on scheduling.
+/// If the module cannot be split (e.g. because it takes the address of a
+/// basic block) or \p NumThreads is 1, \p RunPipeline is called on \p M
+/// directly.
+void runFunctionPassesInParallel(Module &M, unsigned NumThreads,
+                                 std::function<void(Module &)> RunPipeline);
+
+} // End llvm namespace
+
+#endif
@@ -27,6 +27,10 @@ class StringRef;
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
+/// With -split-module-balance-cost, the partitions are balanced by the
+/// estimated cost of generating code for them, and functions that call each
+/// other are placed in the same partition where that keeps them balanced.
+///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
 ///
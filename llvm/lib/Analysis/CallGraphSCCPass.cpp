@@ -26,6 +26,7 @@
 #include "llvm/IR/OptBisect.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/TimeTrace.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
@@ -122,6 +123,13 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 
     {
       TimeRegion PassTimer(getPassTimer(CGSP));
+      TimeTraceScope TraceScope(CGSP->getPassName(), [&] {
+        std::string Names;
+        for (CallGraphNode *CGN : CurSCC)
+          if (Function *F = CGN->getFunction())
+            Names += (Names.empty() ? "" : ", ") + F->getName().str();
+        return Names;
+      });
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
@@ -93,6 +93,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include <algorithm>
+#include <limits>
 using namespace llvm;
 
 #define DEBUG_TYPE "scalar-evolution"
@@ -105,6 +106,14 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumCacheHits,
+          "Number of SCEV queries answered from the cache");
+STATISTIC(NumCacheMisses,
+          "Number of SCEV queries that had to be computed");
+STATISTIC(NumCacheEvictions,
+          "Number of SCEV cache entries evicted to bound the cache size");
+STATISTIC(NumDepthLimited,
+          "Number of instructions left unknown by the SCEV depth limit");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -132,6 +141,23 @@ static cl::opt<unsigned>
                     cl::desc("Maximum depth of recursive compare complexity"),
                     cl::init(32));
 
+static cl::opt<unsigned> MaxCacheEntries(
+    "scalar-evolution-max-cache-entries", cl::Hidden,
+    cl::desc("Maximum number of values, loops and expressions to cache "
+             "results for before evicting the least recently used ones "
+             "(0 = unlimited)"),
+    cl::init(0));
+
+static cl::opt<unsigned> MaxValueDepth(
+    "scalar-evolution-max-value-depth", cl::Hidden,
+    cl::desc("Maximum depth of nested queries at which instructions are "
+             "still analyzed rather than treated as unknown (0 = unlimited)"),
+    cl::init(0));
+
+static cl::opt<bool> PrintCacheStats(
+    "scalar-evolution-print-cache-stats", cl::Hidden,
+    cl::desc("Print cache statistics with the ScalarEvolution analysis"));
+
 //===----------------------------------------------------------------------===//
 //                           SCEV class definitions
 //===----------------------------------------------------------------------===//
@@ -3458,6 +3484,7 @@ void ScalarEvolution::eraseValueFromMap(Value *V) {
         SV->remove({V, Offset});
     }
     ValueExprMap.erase(V);
+    DepthLimitedValues.erase(V);
   }
 }
 
@@ -3466,9 +3493,22 @@ void ScalarEvolution::eraseValueFromMap(Value *V) {
 const SCEV *ScalarEvolution::getSCEV(Value *V) {
   assert(isSCEVable(V->getType()) && "Value is not SCEVable!");
 
+  if (MaxCacheEntries && QueryDepth == 0)
+    trimCaches();
+  SaveAndRestore<unsigned> Depth(QueryDepth, QueryDepth + 1);
+
   const SCEV *S = getExistingSCEV(V);
-  if (S == nullptr) {
-    S = createSCEV(V);
+  if (S) {
+    ++CacheStats.ValueHits;
+  } else {
+    ++CacheStats.ValueMisses;
+    if (MaxValueDepth && QueryDepth > MaxValueDepth && isa<Instruction>(V)) {
+      ++CacheStats.DepthLimited;
+      DepthLimitedValues.insert(V);
+      S = getUnknown(V);
+    } else {
+      S = createSCEV(V);
+    }
     // During PHI resolution, it is possible to create two SCEVs for the same
     // V, so it is needed to double check whether V->S is inserted into
     // ValueExprMap before insert S->{V, 0} into ExprValueMap.
@@ -3492,6 +3532,8 @@ const SCEV *ScalarEvolution::getSCEV(Value *V) {
         ExprValueMap[Stripped].insert({V, Offset});
     }
   }
+  if (MaxCacheEntries && !DepthLimitedValues.count(V))
+    ValueLastUse[V] = ++CacheClock;
   return S;
 }
 
@@ -5460,6 +5502,10 @@ PushLoopPHIs(const Loop *L, SmallVectorImpl<Instruction *> &Worklist) {
 
 const ScalarEvolution::BackedgeTakenInfo &
 ScalarEvolution::getPredicatedBackedgeTakenInfo(const Loop *L) {
+  if (MaxCacheEntries && QueryDepth == 0)
+    trimCaches();
+  SaveAndRestore<unsigned> Depth(QueryDepth, QueryDepth + 1);
+
   auto &BTI = getBackedgeTakenInfo(L);
   if (BTI.hasFullInfo())
     return BTI;
@@ -5477,6 +5523,13 @@ ScalarEvolution::getPredicatedBackedgeTakenInfo(const Loop *L) {
 
 const ScalarEvolution::BackedgeTakenInfo &
 ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
+  if (MaxCacheEntries) {
+    if (QueryDepth == 0)
+      trimCaches();
+    LoopLastUse[L] = ++CacheClock;
+  }
+  SaveAndRestore<unsigned> Depth(QueryDepth, QueryDepth + 1);
+
   // Initially insert an invalid entry for this loop. If the insertion
   // succeeds, proceed to actually compute a backedge-taken count and
   // update the value. The temporary CouldNotCompute value tells SCEV
@@ -5484,8 +5537,11 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // backedge-taken count, which could result in infinite recursion.
   std::pair<DenseMap<const Loop *, BackedgeTakenInfo>::iterator, bool> Pair =
       BackedgeTakenCounts.insert({L, BackedgeTakenInfo()});
-  if (!Pair.second)
+  if (!Pair.second) {
+    ++CacheStats.BackedgeTakenHits;
     return Pair.first->second;
+  }
+  ++CacheStats.BackedgeTakenMisses;
 
   // computeBackedgeTakenCount may allocate memory for its result. Inserting it
   // into the BackedgeTakenCounts map transfers ownership. Otherwise, the result
@@ -5730,6 +5786,16 @@ void ScalarEvolution::BackedgeTakenInfo::clear() {
   ExitNotTaken.clear();
 }
 
+size_t ScalarEvolution::BackedgeTakenInfo::getMemoryUsage() const {
+  size_t Size = 0;
+  if (ExitNotTaken.capacity() > 1)
+    Size += ExitNotTaken.capacity_in_bytes();
+  for (auto &ENT : ExitNotTaken)
+    if (ENT.Predicate)
+      Size += sizeof(SCEVUnionPredicate);
+  return Size;
+}
+
 /// Compute the number of times the backedge of the specified loop will execute.
 ScalarEvolution::BackedgeTakenInfo
 ScalarEvolution::computeBackedgeTakenCount(const Loop *L,
@@ -6688,13 +6754,23 @@ const SCEV *ScalarEvolution::computeExitCountExhaustively(const Loop *L,
 }
 
 const SCEV *ScalarEvolution::getSCEVAtScope(const SCEV *V, const Loop *L) {
+  if (MaxCacheEntries) {
+    if (QueryDepth == 0)
+      trimCaches();
+    ScopeLastUse[V] = ++CacheClock;
+  }
+  SaveAndRestore<unsigned> Depth(QueryDepth, QueryDepth + 1);
+
   SmallVector<std::pair<const Loop *, const SCEV *>, 2> &Values =
       ValuesAtScopes[V];
   // Check to see if we've folded this expression at this loop before.
   for (auto &LS : Values)
-    if (LS.first == L)
+    if (LS.first == L) {
+      ++CacheStats.ScopeHits;
       return LS.second ? LS.second : V;
+    }
 
+  ++CacheStats.ScopeMisses;
   Values.emplace_back(L, nullptr);
 
   // Otherwise compute it.
@@ -9486,8 +9562,8 @@ ScalarEvolution::ScalarEvolution(Function &F, TargetLibraryInfo &TLI,
     : F(F), TLI(TLI), AC(AC), DT(DT), LI(LI),
       CouldNotCompute(new SCEVCouldNotCompute()),
       WalkingBEDominatingConds(false), ProvingSplitPredicate(false),
-      ValuesAtScopes(64), LoopDispositions(64), BlockDispositions(64),
-      FirstUnknown(nullptr) {
+      QueryDepth(0), CacheClock(0), ValuesAtScopes(64), LoopDispositions(64),
+      BlockDispositions(64), FirstUnknown(nullptr) {
 
   // To use guards for proving predicates, we need to scan every instruction in
   // relevant basic blocks, and not just terminators.  Doing this is a waste of
@@ -9510,6 +9586,11 @@ ScalarEvolution::ScalarEvolution(ScalarEvolution &&Arg)
       ValueExprMap(std::move(Arg.ValueExprMap)),
       PendingLoopPredicates(std::move(Arg.PendingLoopPredicates)),
       WalkingBEDominatingConds(false), ProvingSplitPredicate(false),
+      QueryDepth(0), CacheStats(Arg.CacheStats), CacheClock(Arg.CacheClock),
+      ValueLastUse(std::move(Arg.ValueLastUse)),
+      LoopLastUse(std::move(Arg.LoopLastUse)),
+      ScopeLastUse(std::move(Arg.ScopeLastUse)),
+      DepthLimitedValues(std::move(Arg.DepthLimitedValues)),
       BackedgeTakenCounts(std::move(Arg.BackedgeTakenCounts)),
       PredicatedBackedgeTakenCounts(
           std::move(Arg.PredicatedBackedgeTakenCounts)),
@@ -9526,6 +9607,7 @@ ScalarEvolution::ScalarEvolution(ScalarEvolution &&Arg)
       SCEVAllocator(std::move(Arg.SCEVAllocator)),
       FirstUnknown(Arg.FirstUnknown) {
   Arg.FirstUnknown = nullptr;
+  Arg.CacheStats = CacheStatistics();
 }
 
 ScalarEvolution::~ScalarEvolution() {
@@ -9552,6 +9634,115 @@ ScalarEvolution::~ScalarEvolution() {
   assert(PendingLoopPredicates.empty() && "isImpliedCond garbage");
   assert(!WalkingBEDominatingConds && "isLoopBackedgeGuardedByCond garbage!");
   assert(!ProvingSplitPredicate && "ProvingSplitPredicate garbage!");
+  assert(QueryDepth == 0 && "QueryDepth garbage!");
+
+  NumCacheHits += CacheStats.ValueHits + CacheStats.BackedgeTakenHits +
+                  CacheStats.ScopeHits;
+  NumCacheMisses += CacheStats.ValueMisses + CacheStats.BackedgeTakenMisses +
+                    CacheStats.ScopeMisses;
+  NumCacheEvictions += CacheStats.Evictions;
+  NumDepthLimited += CacheStats.DepthLimited;
+}
+
+void ScalarEvolution::trimCaches() {
+  size_t NumEntries =
+      ValueLastUse.size() + LoopLastUse.size() + ScopeLastUse.size();
+  if (NumEntries <= MaxCacheEntries)
+    return;
+
+  // Find the time of the oldest use to keep: the entries of the most recently
+  // used half of the bound stay. Uses are all at different times.
+  size_t NumKept = MaxCacheEntries / 2;
+  uint64_t OldestKept = std::numeric_limits<uint64_t>::max();
+  if (NumKept) {
+    std::vector<uint64_t> LastUses;
+    LastUses.reserve(NumEntries);
+    for (const auto &Entry : ValueLastUse)
+      LastUses.push_back(Entry.second);
+    for (const auto &Entry : LoopLastUse)
+      LastUses.push_back(Entry.second);
+    for (const auto &Entry : ScopeLastUse)
+      LastUses.push_back(Entry.second);
+    auto Nth = LastUses.end() - NumKept;
+    std::nth_element(LastUses.begin(), Nth, LastUses.end());
+    OldestKept = *Nth;
+  }
+
+  // The entries might already have been dropped by forgetValue and friends,
+  // only count the ones that are still there.
+  for (auto I = ValueLastUse.begin(), E = ValueLastUse.end(); I != E;) {
+    auto Entry = I++;
+    if (Entry->second >= OldestKept)
+      continue;
+    // A value left unknown by the depth limit keeps its SCEV.
+    if (!DepthLimitedValues.count(Entry->first) &&
+        ValueExprMap.find_as(Entry->first) != ValueExprMap.end()) {
+      eraseValueFromMap(Entry->first);
+      ++CacheStats.Evictions;
+    }
+    ValueLastUse.erase(Entry);
+  }
+
+  for (auto I = LoopLastUse.begin(), E = LoopLastUse.end(); I != E;) {
+    auto Entry = I++;
+    if (Entry->second >= OldestKept)
+      continue;
+    for (auto *Map : {&BackedgeTakenCounts, &PredicatedBackedgeTakenCounts}) {
+      auto BTCPos = Map->find(Entry->first);
+      if (BTCPos != Map->end()) {
+        BTCPos->second.clear();
+        Map->erase(BTCPos);
+        ++CacheStats.Evictions;
+      }
+    }
+    LoopLastUse.erase(Entry);
+  }
+
+  for (auto I = ScopeLastUse.begin(), E = ScopeLastUse.end(); I != E;) {
+    auto Entry = I++;
+    if (Entry->second >= OldestKept)
+      continue;
+    if (ValuesAtScopes.erase(Entry->first))
+      ++CacheStats.Evictions;
+    ScopeLastUse.erase(Entry);
+  }
+}
+
+size_t ScalarEvolution::getCacheMemoryUsage() const {
+  size_t Size = 0;
+  for (auto &Entry : ValuesAtScopes)
+    if (Entry.second.capacity() > 2)
+      Size += Entry.second.capacity_in_bytes();
+  for (auto &Entry : BackedgeTakenCounts)
+    Size += Entry.second.getMemoryUsage();
+  for (auto &Entry : PredicatedBackedgeTakenCounts)
+    Size += Entry.second.getMemoryUsage();
+
+  return Size + SCEVAllocator.getTotalMemory() + HasRecMap.getMemorySize() +
+         ExprValueMap.getMemorySize() + ValueExprMap.getMemorySize() +
+         BackedgeTakenCounts.getMemorySize() +
+         PredicatedBackedgeTakenCounts.getMemorySize() +
+         ConstantEvolutionLoopExitValue.getMemorySize() +
+         ValuesAtScopes.getMemorySize() + LoopDispositions.getMemorySize() +
+         BlockDispositions.getMemorySize() + UnsignedRanges.getMemorySize() +
+         SignedRanges.getMemorySize() + ValueLastUse.getMemorySize() +
+         LoopLastUse.getMemorySize() + ScopeLastUse.getMemorySize() +
+         DepthLimitedValues.getMemorySize();
+}
+
+void ScalarEvolution::printCacheStatistics(raw_ostream &OS) const {
+  OS << "Cache statistics for: ";
+  F.printAsOperand(OS, /*PrintType=*/false);
+  OS << "\n";
+  OS << "  values: " << CacheStats.ValueHits << " hits, "
+     << CacheStats.ValueMisses << " misses\n";
+  OS << "  backedge-taken counts: " << CacheStats.BackedgeTakenHits
+     << " hits, " << CacheStats.BackedgeTakenMisses << " misses\n";
+  OS << "  values at scopes: " << CacheStats.ScopeHits << " hits, "
+     << CacheStats.ScopeMisses << " misses\n";
+  OS << "  evictions: " << CacheStats.Evictions << "\n";
+  OS << "  depth-limited values: " << CacheStats.DepthLimited << "\n";
+  OS << "  bytes: " << getCacheMemoryUsage() << "\n";
 }
 
 bool ScalarEvolution::hasLoopInvariantBackedgeTakenCount(const Loop *L) {
@@ -9707,6 +9898,9 @@ void ScalarEvolution::print(raw_ostream &OS) const {
   OS << "\n";
   for (Loop *I : LI)
     PrintLoopInfo(OS, &SE, I);
+
+  if (PrintCacheStats)
+    printCacheStatistics(OS);
 }
 
 ScalarEvolution::LoopDisposition
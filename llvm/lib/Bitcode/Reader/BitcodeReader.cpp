@@ -3090,6 +3090,7 @@ Error BitcodeReader::parseBitcodeInto(Module *M, bool ShouldLazyLoadMetadata,
                                       bool IsImporting) {
   TheModule = M;
   MDLoader = MetadataLoader(Stream, *M, ValueList, IsImporting,
+                            ShouldLazyLoadMetadata,
                             [&](unsigned ID) { return getTypeByID(ID); });
   return parseModule(0, ShouldLazyLoadMetadata);
 }
@@ -3197,6 +3198,19 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
     switch (BitCode) {
     default: // Default behavior: reject
       return error("Invalid value");
+    case bitc::FUNC_CODE_METADATA_REFS: { // METADATA_REFS: [n x md# delta]
+      // Load the module-level metadata used by this function in one pass
+      // instead of one record at a time as the body refers to them.
+      SmallVector<unsigned, 64> IDs;
+      unsigned ID = 0;
+      for (uint64_t Delta : Record) {
+        ID += Delta;
+        IDs.push_back(ID);
+      }
+      MDLoader->prefetchMetadata(IDs);
+      continue;
+    }
+
     case bitc::FUNC_CODE_DECLAREBLOCKS: {   // DECLAREBLOCKS: [nblocks]
       if (Record.size() < 1 || Record[0] == 0)
         return error("Invalid record");
@@ -93,6 +93,7 @@ using namespace llvm;
 STATISTIC(NumMDStringLoaded, "Number of MDStrings loaded");
 STATISTIC(NumMDNodeTemporary, "Number of MDNode::Temporary created");
 STATISTIC(NumMDRecordLoaded, "Number of Metadata records loaded");
+STATISTIC(NumMDPrefetched, "Number of Metadata records prefetched");
 
 /// Flag whether we need to import full type definitions for ThinLTO.
 /// Currently needed for Darwin and LLDB.
@@ -103,7 +104,7 @@ static cl::opt<bool> ImportFullTypeDefinitions(
 static cl::opt<bool> DisableLazyLoading(
     "disable-ondemand-mds-loading", cl::init(false), cl::Hidden,
     cl::desc("Force disable the lazy-loading on-demand of metadata when "
-             "loading bitcode for importing."));
+             "loading bitcode for importing or lazy materialization."));
 
 namespace {
 
@@ -452,6 +453,10 @@ class MetadataLoader::MetadataLoaderImpl {
   /// True if metadata is being parsed for a module being ThinLTO imported.
   bool IsImporting = false;
 
+  /// True if the module is materialized lazily and the module-level
+  /// metadata should be loaded on demand, too.
+  bool ShouldLazyLoadMetadata = false;
+
   Error parseOneMetadata(SmallVectorImpl<uint64_t> &Record, unsigned Code,
                          PlaceholderQueue &Placeholders, StringRef Blob,
                          unsigned &NextMetadataNo);
@@ -477,22 +482,38 @@ public:
   MetadataLoaderImpl(BitstreamCursor &Stream, Module &TheModule,
                      BitcodeReaderValueList &ValueList,
                      std::function<Type *(unsigned)> getTypeByID,
-                     bool IsImporting)
+                     bool IsImporting, bool ShouldLazyLoadMetadata)
       : MetadataList(TheModule.getContext()), ValueList(ValueList),
         Stream(Stream), Context(TheModule.getContext()), TheModule(TheModule),
-        getTypeByID(getTypeByID), IsImporting(IsImporting) {}
+        getTypeByID(getTypeByID), IsImporting(IsImporting),
+        ShouldLazyLoadMetadata(ShouldLazyLoadMetadata) {}
 
   Error parseMetadata(bool ModuleLevel);
 
   bool hasFwdRefs() const { return MetadataList.hasFwdRefs(); }
-  Metadata *getMetadataFwdRef(unsigned Idx) {
-    return MetadataList.getMetadataFwdRef(Idx);
+
+  Metadata *getMetadataFwdRef(unsigned ID) {
+    if (ID < MDStringRef.size())
+      return lazyLoadOneMDString(ID);
+    if (Metadata *MD = MetadataList.lookup(ID))
+      return MD;
+    // If the module-level metadata is lazy-loaded, load the record now
+    // instead of creating a forward reference that nobody would resolve.
+    if (ID < MDStringRef.size() + GlobalMetadataBitPosIndex.size()) {
+      PlaceholderQueue Placeholders;
+      lazyLoadOneMetadata(ID, Placeholders);
+      resolveForwardRefsAndPlaceholders(Placeholders);
+      return MetadataList.lookup(ID);
+    }
+    return MetadataList.getMetadataFwdRef(ID);
   }
 
-  MDNode *getMDNodeFwdRefOrNull(unsigned Idx) {
-    return MetadataList.getMDNodeFwdRefOrNull(Idx);
+  MDNode *getMDNodeFwdRefOrNull(unsigned ID) {
+    return dyn_cast_or_null<MDNode>(getMetadataFwdRef(ID));
   }
 
+  void prefetchMetadata(ArrayRef<unsigned> IDs);
+
   DISubprogram *lookupSubprogramForFunction(Function *F) {
     return FunctionsWithSPs.lookup(F);
   }
@@ -699,8 +720,8 @@ Error MetadataLoader::MetadataLoaderImpl::parseMetadata(bool ModuleLevel) {
 
   // We lazy-load module-level metadata: we build an index for each record, and
   // then load individual record as needed, starting with the named metadata.
-  if (ModuleLevel && IsImporting && MetadataList.empty() &&
-      !DisableLazyLoading) {
+  if (ModuleLevel && (IsImporting || ShouldLazyLoadMetadata) &&
+      MetadataList.empty() && !DisableLazyLoading) {
     auto SuccessOrErr = lazyLoadModuleMetadataBlock();
     if (!SuccessOrErr)
       return SuccessOrErr.takeError();
@@ -785,6 +806,29 @@ void MetadataLoader::MetadataLoaderImpl::lazyLoadOneMetadata(
     report_fatal_error("Can't lazyload MD");
 }
 
+void MetadataLoader::MetadataLoaderImpl::prefetchMetadata(
+    ArrayRef<unsigned> IDs) {
+  if (GlobalMetadataBitPosIndex.empty())
+    return;
+
+  // The index is sorted by bit position, so loading the records in the order
+  // of their IDs reads the metadata block front to back.
+  PlaceholderQueue Placeholders;
+  for (unsigned ID : IDs) {
+    if (ID < MDStringRef.size() ||
+        ID >= MDStringRef.size() + GlobalMetadataBitPosIndex.size())
+      continue;
+    if (Metadata *MD = MetadataList.lookup(ID)) {
+      auto *N = dyn_cast<MDNode>(MD);
+      if (!N || !N->isTemporary())
+        continue;
+    }
+    ++NumMDPrefetched;
+    lazyLoadOneMetadata(ID, Placeholders);
+  }
+  resolveForwardRefsAndPlaceholders(Placeholders);
+}
+
 /// Ensure that all forward-references and placeholders are resolved.
 /// Iteratively lazy-loading metadata on-demand if needed.
 void MetadataLoader::MetadataLoaderImpl::resolveForwardRefsAndPlaceholders(
@@ -1701,10 +1745,11 @@ MetadataLoader::MetadataLoader(MetadataLoader &&RHS)
 MetadataLoader::~MetadataLoader() = default;
 MetadataLoader::MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                                BitcodeReaderValueList &ValueList,
-                               bool IsImporting,
+                               bool IsImporting, bool ShouldLazyLoadMetadata,
                                std::function<Type *(unsigned)> getTypeByID)
-    : Pimpl(llvm::make_unique<MetadataLoaderImpl>(Stream, TheModule, ValueList,
-                                                  getTypeByID, IsImporting)) {}
+    : Pimpl(llvm::make_unique<MetadataLoaderImpl>(
+          Stream, TheModule, ValueList, getTypeByID, IsImporting,
+          ShouldLazyLoadMetadata)) {}
 
 Error MetadataLoader::parseMetadata(bool ModuleLevel) {
   return Pimpl->parseMetadata(ModuleLevel);
@@ -1722,6 +1767,10 @@ MDNode *MetadataLoader::getMDNodeFwdRefOrNull(unsigned Idx) {
   return Pimpl->getMDNodeFwdRefOrNull(Idx);
 }
 
+void MetadataLoader::prefetchMetadata(ArrayRef<unsigned> IDs) {
+  Pimpl->prefetchMetadata(IDs);
+}
+
 DISubprogram *MetadataLoader::lookupSubprogramForFunction(Function *F) {
   return Pimpl->lookupSubprogramForFunction(F);
 }
@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_BITCODE_READER_METADATALOADER_H
 #define LLVM_LIB_BITCODE_READER_METADATALOADER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Error.h"
 
@@ -42,6 +43,7 @@ public:
   ~MetadataLoader();
   MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                  BitcodeReaderValueList &ValueList, bool IsImporting,
+                 bool ShouldLazyLoadMetadata,
                  std::function<Type *(unsigned)> getTypeByID);
   MetadataLoader &operator=(MetadataLoader &&);
   MetadataLoader(MetadataLoader &&);
@@ -67,6 +69,11 @@ public:
 
   MDNode *getMDNodeFwdRefOrNull(unsigned Idx);
 
+  /// Load the given module-level metadata if they are being lazy-loaded and
+  /// haven't been loaded yet. \p IDs must be sorted, so that the records are
+  /// read in the order they appear in the stream.
+  void prefetchMetadata(ArrayRef<unsigned> IDs);
+
   /// Return the DISubprogra metadata for a Function if any, null otherwise.
   DISubprogram *lookupSubprogramForFunction(Function *F);
 
@@ -119,6 +119,15 @@ class ModuleBitcodeWriter : public BitcodeWriterBase {
   /// Tracks the last value id recorded in the GUIDToValueMap.
   unsigned GlobalValueId;
 
+  /// The number of module-level MDStrings and of all module-level metadata.
+  /// Set by writeModuleMetadata.
+  unsigned NumModuleMDStrings = 0;
+  unsigned NumModuleMDs = 0;
+
+  /// True if the module metadata block has an index, in which case each
+  /// function block lists the module-level metadata it refers to.
+  bool HasMetadataIndex = false;
+
 public:
   /// Constructs a ModuleBitcodeWriter object for the given Module,
   /// writing to the provided \p Buffer.
@@ -234,6 +243,7 @@ private:
                             std::vector<uint64_t> *IndexPos = nullptr);
   void writeModuleMetadata();
   void writeFunctionMetadata(const Function &F);
+  void writeFunctionMetadataRefs(const Function &F);
   void writeFunctionMetadataAttachment(const Function &F);
   void writeGlobalVariableMetadataAttachment(const GlobalVariable &GV);
   void pushGlobalMetadataAttachment(SmallVectorImpl<uint64_t> &Record,
@@ -1932,9 +1942,13 @@ void ModuleBitcodeWriter::writeModuleMetadata() {
   // Emit MDStrings together upfront.
   writeMetadataStrings(VE.getMDStrings(), Record);
 
+  NumModuleMDStrings = VE.getMDStrings().size();
+  NumModuleMDs = NumModuleMDStrings + VE.getNonMDStrings().size();
+  HasMetadataIndex = VE.getNonMDStrings().size() > IndexThreshold;
+
   // We only emit an index for the metadata record if we have more than a given
   // (naive) threshold of metadatas, otherwise it is not worth it.
-  if (VE.getNonMDStrings().size() > IndexThreshold) {
+  if (HasMetadataIndex) {
     // Write a placeholder value in for the offset of the metadata index,
     // which is written after the records, so that it can include
     // the offset of each entry. The placeholder offset will be
@@ -1955,7 +1969,7 @@ void ModuleBitcodeWriter::writeModuleMetadata() {
   // Write all the records
   writeMetadataRecords(VE.getNonMDStrings(), Record, &MDAbbrevs, &IndexPos);
 
-  if (VE.getNonMDStrings().size() > IndexThreshold) {
+  if (HasMetadataIndex) {
     // Now that we have emitted all the records we will emit the index. But
     // first
     // backpatch the forward reference so that the reader can skip the records
@@ -2018,6 +2032,60 @@ void ModuleBitcodeWriter::pushGlobalMetadataAttachment(
   }
 }
 
+/// Write the IDs of the module-level metadata that the function refers to
+/// directly, so that a reader that loads metadata lazily can load all of
+/// them in one pass over the metadata index before parsing the body.
+void ModuleBitcodeWriter::writeFunctionMetadataRefs(const Function &F) {
+  if (!HasMetadataIndex)
+    return;
+
+  SmallVector<unsigned, 64> IDs;
+  auto AddRef = [&](const Metadata *MD) {
+    unsigned ID = VE.getMetadataOrNullID(MD);
+    // IDs are 1-based. Skip null, strings and function-local metadata.
+    if (ID > NumModuleMDStrings && ID <= NumModuleMDs)
+      IDs.push_back(ID - 1);
+  };
+
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  F.getAllMetadata(MDs);
+  for (const auto &I : MDs)
+    AddRef(I.second);
+
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB) {
+      MDs.clear();
+      I.getAllMetadataOtherThanDebugLoc(MDs);
+      for (const auto &MD : MDs)
+        AddRef(MD.second);
+
+      if (const DILocation *DL = I.getDebugLoc()) {
+        AddRef(DL->getScope());
+        if (const DILocation *IA = DL->getInlinedAt())
+          AddRef(IA);
+      }
+
+      for (const Use &Op : I.operands())
+        if (auto *MAV = dyn_cast<MetadataAsValue>(&Op))
+          if (!isa<LocalAsMetadata>(MAV->getMetadata()))
+            AddRef(MAV->getMetadata());
+    }
+
+  if (IDs.empty())
+    return;
+
+  // Delta encode the sorted IDs.
+  std::sort(IDs.begin(), IDs.end());
+  IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
+  SmallVector<uint64_t, 64> Record;
+  unsigned Prev = 0;
+  for (unsigned ID : IDs) {
+    Record.push_back(ID - Prev);
+    Prev = ID;
+  }
+  Stream.EmitRecord(bitc::FUNC_CODE_METADATA_REFS, Record);
+}
+
 void ModuleBitcodeWriter::writeFunctionMetadataAttachment(const Function &F) {
   Stream.EnterSubblock(bitc::METADATA_ATTACHMENT_ID, 3);
 
@@ -3053,6 +3121,8 @@ void ModuleBitcodeWriter::writeFunction(
   Stream.EmitRecord(bitc::FUNC_CODE_DECLAREBLOCKS, Vals);
   Vals.clear();
 
+  writeFunctionMetadataRefs(F);
+
   // If there are function-local constants, emit them now.
   unsigned CstStart, CstEnd;
   VE.getFunctionConstantRange(CstStart, CstEnd);
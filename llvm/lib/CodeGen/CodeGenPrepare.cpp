@@ -21,6 +21,7 @@
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include "llvm/Analysis/ProfileSummaryInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
@@ -79,6 +80,7 @@ STATISTIC(NumDbgValueMoved, "Number of debug value instructions moved");
 STATISTIC(NumSelectsExpanded, "Number of selects turned into branches");
 STATISTIC(NumAndCmpsMoved, "Number of and/cmp's pushed into branches");
 STATISTIC(NumStoreExtractExposed, "Number of store(extractelement) exposed");
+STATISTIC(NumOversizedBlocksSplit, "Number of oversized blocks split");
 
 static cl::opt<bool> DisableBranchOpts(
   "disable-cgp-branch-opts", cl::Hidden, cl::init(false),
@@ -135,6 +137,11 @@ static cl::opt<bool> ForceSplitStore(
     "force-split-store", cl::Hidden, cl::init(false),
     cl::desc("Force store splitting no matter what the target query says."));
 
+static cl::opt<unsigned> MaxBlockSize(
+    "cgp-max-block-size", cl::Hidden, cl::init(10000),
+    cl::desc("Split blocks with more instructions than this, to bound the "
+             "size of the SelectionDAG built for each block (0 = no limit)"));
+
 namespace {
 typedef SmallPtrSet<Instruction *, 16> SetOfInstrs;
 typedef PointerIntPair<Type *, 1, bool> TypeIsSExt;
@@ -222,6 +229,7 @@ class TypePromotionTransaction;
                         unsigned CreatedInstCost);
     bool splitBranchCondition(Function &F);
     bool simplifyOffsetableRelocate(Instruction &I);
+    bool splitOversizedBlocks(Function &F);
   };
 }
 
@@ -363,9 +371,96 @@ bool CodeGenPrepare::runOnFunction(Function &F) {
       EverMadeChange |= simplifyOffsetableRelocate(*I);
   }
 
+  // Do this last, so that none of the transformations above merge the pieces
+  // back together.
+  EverMadeChange |= splitOversizedBlocks(F);
+
   return EverMadeChange;
 }
 
+/// Returns the number of instructions in \p BB, not counting debug info
+/// intrinsics, so that -g doesn't change where blocks are split.
+static unsigned getNonDebugSize(const BasicBlock &BB) {
+  return count_if(BB, [](const Instruction &I) {
+    return !isa<DbgInfoIntrinsic>(I);
+  });
+}
+
+/// Split blocks that have more than MaxBlockSize instructions into pieces of
+/// about MaxBlockSize instructions each. SelectionDAG building, combining and
+/// scheduling all work on one block at a time and some of their algorithms
+/// are quadratic in the size of the block, so a huge block, as produced by
+/// fully unrolling or inlining straight-line code, can dominate compile time.
+bool CodeGenPrepare::splitOversizedBlocks(Function &F) {
+  if (!MaxBlockSize)
+    return false;
+
+  SmallVector<BasicBlock *, 4> Oversized;
+  for (BasicBlock &BB : F)
+    if (BB.size() > MaxBlockSize && getNonDebugSize(BB) > MaxBlockSize)
+      Oversized.push_back(&BB);
+  if (Oversized.empty())
+    return false;
+
+  OptimizationRemarkEmitter ORE(&F);
+  bool MadeChange = false;
+  for (BasicBlock *BB : Oversized) {
+    // Token values can't be live across blocks.
+    if (any_of(*BB, [](const Instruction &I) {
+          return I.getType()->isTokenTy();
+        }))
+      continue;
+
+    // Keep the static allocas and llvm.localescape in the entry block.
+    BasicBlock::iterator Start = BB->getFirstInsertionPt();
+    if (BB == &F.getEntryBlock())
+      for (auto I = Start, E = BB->end(); I != E; ++I)
+        if (isa<AllocaInst>(I) ||
+            match(&*I, m_Intrinsic<Intrinsic::localescape>()))
+          Start = std::next(I);
+
+    unsigned OrigSize = getNonDebugSize(*BB);
+    unsigned NumPieces = 1;
+    unsigned Count = 0;
+    BasicBlock *Piece = BB;
+    for (BasicBlock::iterator I = Start, E = Piece->end(); I != E;) {
+      Instruction *Inst = &*I++;
+      if (isa<DbgInfoIntrinsic>(Inst) || ++Count < MaxBlockSize)
+        continue;
+      // Don't leave a block with just a terminator behind, and keep a musttail
+      // call together with its return. Debug info intrinsics before the next
+      // instruction go into the next piece.
+      BasicBlock::iterator Next = I;
+      while (Next != E && isa<DbgInfoIntrinsic>(Next))
+        ++Next;
+      if (Next == E || isa<TerminatorInst>(Next))
+        break;
+      if (auto *CI = dyn_cast<CallInst>(Inst))
+        if (CI->isMustTailCall())
+          continue;
+      Piece = Piece->splitBasicBlock(I, BB->getName() + ".split");
+      E = Piece->end();
+      Count = 0;
+      ++NumPieces;
+    }
+    if (NumPieces == 1)
+      continue;
+
+    ++NumOversizedBlocksSplit;
+    MadeChange = true;
+    DebugLoc DL;
+    for (const Instruction &I : *BB)
+      if ((DL = I.getDebugLoc()))
+        break;
+    ORE.emit(OptimizationRemarkAnalysis(DEBUG_TYPE, "SplitOversizedBlock", DL,
+                                        BB)
+             << "split a block of " << ore::NV("Instructions", OrigSize)
+             << " instructions into " << ore::NV("Blocks", NumPieces)
+             << " blocks to limit the size of the SelectionDAG");
+  }
+  return MadeChange;
+}
+
 /// Merge basic blocks which are connected by a single edge, where one of the
 /// basic blocks has a single successor pointing to the other basic block,
 /// which has a single predecessor.
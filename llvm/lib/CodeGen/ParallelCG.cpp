@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LLVMContext.h"
@@ -21,6 +22,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
 
@@ -50,6 +52,13 @@ std::unique_ptr<Module> llvm::splitCodeGen(
     return M;
   }
 
+  // With -time-passes, report how long the code generation of each partition
+  // took. The timers are printed when the group is destroyed, after all of
+  // the threads have been joined.
+  TimerGroup PartitionTimers("split-codegen",
+                             "Parallel Code Generation Timing");
+  std::vector<std::unique_ptr<Timer>> Timers;
+
   // Create ThreadPool in nested scope so that threads will be joined
   // on destruction.
   {
@@ -74,10 +83,19 @@ std::unique_ptr<Module> llvm::splitCodeGen(
             BCOSs[ThreadCount]->flush();
           }
 
+          Timer *T = nullptr;
+          if (TimePassesIsEnabled) {
+            std::string Name = "partition " + utostr(ThreadCount);
+            Timers.push_back(
+                llvm::make_unique<Timer>(Name, Name, PartitionTimers));
+            T = Timers.back().get();
+          }
+
           llvm::raw_pwrite_stream *ThreadOS = OSs[ThreadCount++];
           // Enqueue the task
           CodegenThreadPool.async(
-              [TMFactory, FileType, ThreadOS](const SmallString<0> &BC) {
+              [TMFactory, FileType, ThreadOS, T](const SmallString<0> &BC) {
+                TimeRegion Region(T);
                 LLVMContext Ctx;
                 Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
                     MemoryBufferRef(StringRef(BC.data(), BC.size()),
@@ -0,0 +1,343 @@
+//===-- RegAllocLinearScan.cpp - Linear Scan Register Allocator -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the RALinearScan function pass, a linear scan register
+// allocator built on the basic regalloc framework. It sits between the fast
+// allocator and the greedy allocator: it allocates live intervals in program
+// order and never splits them, but it uses global liveness and spill weights
+// to decide what to spill, and gives evicted intervals a second chance.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/Passes.h"
+#include "AllocationOrder.h"
+#include "LiveDebugVariables.h"
+#include "RegAllocBase.h"
+#include "Spiller.h"
+#include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/CodeGen/CalcSpillWeights.h"
+#include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/CodeGen/LiveRangeEdit.h"
+#include "llvm/CodeGen/LiveRegMatrix.h"
+#include "llvm/CodeGen/LiveStackAnalysis.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/RegAllocRegistry.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include "llvm/PassAnalysisSupport.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+#include <queue>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "regalloc"
+
+STATISTIC(NumEvicted, "Number of interferences evicted");
+STATISTIC(NumBudgetExhausted,
+          "Number of functions that exhausted the interference budget");
+
+static cl::opt<unsigned> InterferenceBudget(
+    "linearscan-interference-budget", cl::Hidden, cl::init(100000),
+    cl::desc("Number of interference queries the linear scan allocator makes "
+             "in a function before it stops evicting for spillable intervals "
+             "and only spills them"));
+
+static RegisterRegAlloc linearScanRegAlloc("linearscan",
+                                           "linear scan register allocator",
+                                           createLinearScanRegisterAllocator);
+
+namespace {
+  /// Orders live intervals by start point, the earliest first.
+  struct CompStartPoint {
+    bool operator()(LiveInterval *A, LiveInterval *B) const {
+      if (A->beginIndex() != B->beginIndex())
+        return B->beginIndex() < A->beginIndex();
+      return A->reg > B->reg;
+    }
+  };
+}
+
+namespace {
+/// RALinearScan allocates live virtual registers in the order they start.
+///
+/// When no register is free, it evicts the cheapest set of interferences
+/// whose spill weights are all below that of the current interval, and puts
+/// them back in the queue so they can take another register. An interval that
+/// has already been evicted once is spilled rather than evicted again, and the
+/// number of interference queries per function is bounded, so allocation
+/// takes time roughly linear in the number of intervals and registers.
+class RALinearScan : public MachineFunctionPass, public RegAllocBase {
+  // context
+  MachineFunction *MF;
+
+  // state
+  std::unique_ptr<Spiller> SpillerInstance;
+  std::priority_queue<LiveInterval *, std::vector<LiveInterval *>,
+                      CompStartPoint> Queue;
+
+  /// Virtual registers that were evicted once.
+  SmallSet<unsigned, 32> Evicted;
+
+  /// Interference queries left before eviction is disabled.
+  unsigned QueriesLeft;
+  bool BudgetExhausted;
+
+public:
+  RALinearScan();
+
+  /// Return the pass name.
+  StringRef getPassName() const override {
+    return "Linear Scan Register Allocator";
+  }
+
+  /// RALinearScan analysis usage.
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  void releaseMemory() override;
+
+  Spiller &spiller() override { return *SpillerInstance; }
+
+  void enqueue(LiveInterval *LI) override { Queue.push(LI); }
+
+  LiveInterval *dequeue() override {
+    if (Queue.empty())
+      return nullptr;
+    LiveInterval *LI = Queue.top();
+    Queue.pop();
+    return LI;
+  }
+
+  unsigned selectOrSplit(LiveInterval &VirtReg,
+                         SmallVectorImpl<unsigned> &SplitVRegs) override;
+
+  /// Perform register allocation.
+  bool runOnMachineFunction(MachineFunction &mf) override;
+
+  MachineFunctionProperties getRequiredProperties() const override {
+    return MachineFunctionProperties().set(
+        MachineFunctionProperties::Property::NoPHIs);
+  }
+
+  static char ID;
+
+private:
+  bool consumeQuery();
+  bool getEvictionCost(LiveInterval &VirtReg, unsigned PhysReg, float &Cost);
+  void evictInterferences(LiveInterval &VirtReg, unsigned PhysReg,
+                          SmallVectorImpl<unsigned> &SplitVRegs);
+};
+
+char RALinearScan::ID = 0;
+
+} // end anonymous namespace
+
+RALinearScan::RALinearScan() : MachineFunctionPass(ID) {
+  initializeLiveDebugVariablesPass(*PassRegistry::getPassRegistry());
+  initializeLiveIntervalsPass(*PassRegistry::getPassRegistry());
+  initializeSlotIndexesPass(*PassRegistry::getPassRegistry());
+  initializeRegisterCoalescerPass(*PassRegistry::getPassRegistry());
+  initializeMachineSchedulerPass(*PassRegistry::getPassRegistry());
+  initializeLiveStacksPass(*PassRegistry::getPassRegistry());
+  initializeMachineDominatorTreePass(*PassRegistry::getPassRegistry());
+  initializeMachineLoopInfoPass(*PassRegistry::getPassRegistry());
+  initializeVirtRegMapPass(*PassRegistry::getPassRegistry());
+  initializeLiveRegMatrixPass(*PassRegistry::getPassRegistry());
+}
+
+void RALinearScan::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesCFG();
+  AU.addRequired<AAResultsWrapperPass>();
+  AU.addPreserved<AAResultsWrapperPass>();
+  AU.addRequired<LiveIntervals>();
+  AU.addPreserved<LiveIntervals>();
+  AU.addPreserved<SlotIndexes>();
+  AU.addRequired<LiveDebugVariables>();
+  AU.addPreserved<LiveDebugVariables>();
+  AU.addRequired<LiveStacks>();
+  AU.addPreserved<LiveStacks>();
+  AU.addRequired<MachineBlockFrequencyInfo>();
+  AU.addPreserved<MachineBlockFrequencyInfo>();
+  AU.addRequiredID(MachineDominatorsID);
+  AU.addPreservedID(MachineDominatorsID);
+  AU.addRequired<MachineLoopInfo>();
+  AU.addPreserved<MachineLoopInfo>();
+  AU.addRequired<VirtRegMap>();
+  AU.addPreserved<VirtRegMap>();
+  AU.addRequired<LiveRegMatrix>();
+  AU.addPreserved<LiveRegMatrix>();
+  MachineFunctionPass::getAnalysisUsage(AU);
+}
+
+void RALinearScan::releaseMemory() {
+  SpillerInstance.reset();
+  Evicted.clear();
+}
+
+/// Uses up one interference query of the budget of the function. Returns
+/// false if the budget is exhausted.
+bool RALinearScan::consumeQuery() {
+  if (QueriesLeft) {
+    --QueriesLeft;
+    return true;
+  }
+  if (!BudgetExhausted) {
+    DEBUG(dbgs() << "Interference budget exhausted in " << MF->getName()
+                 << '\n');
+    ++NumBudgetExhausted;
+    BudgetExhausted = true;
+  }
+  return false;
+}
+
+/// Computes in \p Cost the largest spill weight of the live virtual registers
+/// assigned to \p PhysReg or its aliases that interfere with \p VirtReg.
+/// Returns false if they cannot all be evicted.
+///
+/// An unspillable VirtReg, such as the interval of a reload, has nowhere else
+/// to go, so like RABasic it may evict regardless of the query budget and of
+/// whether the interferences were evicted before. That still terminates
+/// because an unspillable interval only evicts lighter, spillable ones.
+bool RALinearScan::getEvictionCost(LiveInterval &VirtReg, unsigned PhysReg,
+                                   float &Cost) {
+  bool MustEvict = !VirtReg.isSpillable();
+  Cost = 0;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    if (!consumeQuery() && !MustEvict)
+      return false;
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    Q.collectInterferingVRegs();
+    if (Q.seenUnspillableVReg())
+      return false;
+    for (LiveInterval *Intf : Q.interferingVRegs()) {
+      if (!Intf->isSpillable() || Intf->weight >= VirtReg.weight ||
+          (Evicted.count(Intf->reg) && !MustEvict))
+        return false;
+      Cost = std::max(Cost, Intf->weight);
+    }
+  }
+  return true;
+}
+
+/// Unassigns the live virtual registers that interfere with \p VirtReg in
+/// \p PhysReg, and returns them in \p SplitVRegs to be queued again.
+void RALinearScan::evictInterferences(LiveInterval &VirtReg, unsigned PhysReg,
+                                      SmallVectorImpl<unsigned> &SplitVRegs) {
+  // Collect all the interferences before unassigning any of them; the queries
+  // were already run by getEvictionCost.
+  SmallVector<LiveInterval *, 8> Intfs;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    Q.collectInterferingVRegs();
+    Intfs.append(Q.interferingVRegs().begin(), Q.interferingVRegs().end());
+  }
+
+  for (LiveInterval *Intf : Intfs) {
+    // Skip duplicates.
+    if (!VRM->hasPhys(Intf->reg))
+      continue;
+    DEBUG(dbgs() << "evicting " << PrintReg(Intf->reg, TRI) << " from "
+                 << TRI->getName(PhysReg) << '\n');
+    Matrix->unassign(*Intf);
+    Evicted.insert(Intf->reg);
+    SplitVRegs.push_back(Intf->reg);
+    ++NumEvicted;
+  }
+}
+
+unsigned RALinearScan::selectOrSplit(LiveInterval &VirtReg,
+                                     SmallVectorImpl<unsigned> &SplitVRegs) {
+  SmallVector<unsigned, 8> PhysRegSpillCands;
+
+  // Take the first free register in allocation order; hints come first.
+  AllocationOrder Order(VirtReg.reg, *VRM, RegClassInfo, Matrix);
+  while (unsigned PhysReg = Order.next()) {
+    consumeQuery();
+    switch (Matrix->checkInterference(VirtReg, PhysReg)) {
+    case LiveRegMatrix::IK_Free:
+      return PhysReg;
+
+    case LiveRegMatrix::IK_VirtReg:
+      // Only virtual registers in the way, we may be able to evict them.
+      PhysRegSpillCands.push_back(PhysReg);
+      continue;
+
+    default:
+      // RegMask or RegUnit interference.
+      continue;
+    }
+  }
+
+  // Evict the cheapest interferences, if they are cheaper than VirtReg.
+  unsigned BestPhysReg = 0;
+  float BestCost = 0;
+  for (unsigned PhysReg : PhysRegSpillCands) {
+    float Cost;
+    if (!getEvictionCost(VirtReg, PhysReg, Cost))
+      continue;
+    if (!BestPhysReg || Cost < BestCost) {
+      BestPhysReg = PhysReg;
+      BestCost = Cost;
+    }
+  }
+  if (BestPhysReg) {
+    evictInterferences(VirtReg, BestPhysReg, SplitVRegs);
+    assert(!Matrix->checkInterference(VirtReg, BestPhysReg) &&
+           "Interference after eviction.");
+    return BestPhysReg;
+  }
+
+  // Nothing can be evicted, so spill VirtReg.
+  DEBUG(dbgs() << "spilling: " << VirtReg << '\n');
+  if (!VirtReg.isSpillable())
+    return ~0u;
+  LiveRangeEdit LRE(&VirtReg, SplitVRegs, *MF, *LIS, VRM, nullptr, &DeadRemats);
+  spiller().spill(LRE);
+
+  // The live virtual register requesting allocation was spilled, so tell
+  // the caller not to allocate anything during this round.
+  return 0;
+}
+
+bool RALinearScan::runOnMachineFunction(MachineFunction &mf) {
+  DEBUG(dbgs() << "********** LINEAR SCAN REGISTER ALLOCATION **********\n"
+               << "********** Function: " << mf.getName() << '\n');
+
+  MF = &mf;
+  QueriesLeft = InterferenceBudget;
+  BudgetExhausted = false;
+  RegAllocBase::init(getAnalysis<VirtRegMap>(),
+                     getAnalysis<LiveIntervals>(),
+                     getAnalysis<LiveRegMatrix>());
+
+  calculateSpillWeightsAndHints(*LIS, *MF, VRM,
+                                getAnalysis<MachineLoopInfo>(),
+                                getAnalysis<MachineBlockFrequencyInfo>());
+
+  SpillerInstance.reset(createInlineSpiller(*this, *MF, *VRM));
+
+  allocatePhysRegs();
+  postOptimization();
+
+  // Diagnostic output before rewriting
+  DEBUG(dbgs() << "Post alloc VirtRegMap:\n" << *VRM << "\n");
+
+  releaseMemory();
+  return true;
+}
+
+FunctionPass *llvm::createLinearScanRegisterAllocator() {
+  return new RALinearScan();
+}
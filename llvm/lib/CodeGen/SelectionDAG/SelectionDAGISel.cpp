@@ -20,6 +20,7 @@
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/EHPersonalities.h"
+#include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/FastISel.h"
 #include "llvm/CodeGen/FunctionLoweringInfo.h"
@@ -70,6 +71,8 @@ STATISTIC(NumFastIselBlocks, "Number of blocks selected entirely by fast isel");
 STATISTIC(NumDAGBlocks, "Number of blocks selected using DAG");
 STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
 STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
+STATISTIC(NumDAGSizeFallbacks,
+          "Number of DAGs too big to be combined and scheduled at -O1 or up");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
 
@@ -179,6 +182,11 @@ static cl::opt<int> EnableFastISelAbort(
              "abort for argument lowering, and 3 will never fallback "
              "to SelectionDAG."));
 
+static cl::opt<unsigned> DAGSizeFallbackThreshold(
+    "dag-size-fallback-threshold", cl::Hidden, cl::init(100000),
+    cl::desc("Combine and schedule a SelectionDAG with more nodes than this "
+             "as at -O0 (0 = no limit)"));
+
 static cl::opt<bool>
 UseMBPI("use-mbpi",
         cl::desc("use Machine Branch Probability Info"),
@@ -749,6 +757,27 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   DEBUG(dbgs() << "Initial selection DAG: BB#" << BlockNumber
         << " '" << BlockName << "'\n"; CurDAG->dump());
 
+  // The DAG combiner and the list schedulers take superlinear time on huge
+  // DAGs. Fall back to the cheaper -O0 combines and scheduler for those, so
+  // that a single block can't blow up the compile time of the whole module.
+  CodeGenOpt::Level DAGOptLevel = OptLevel;
+  unsigned NumNodes = CurDAG->allnodes_size();
+  if (OptLevel != CodeGenOpt::None && DAGSizeFallbackThreshold &&
+      NumNodes > DAGSizeFallbackThreshold) {
+    ++NumDAGSizeFallbacks;
+    DAGOptLevel = CodeGenOpt::None;
+    const BasicBlock *BB = FuncInfo->MBB->getBasicBlock();
+    OptimizationRemarkAnalysis R(DEBUG_TYPE, "DAGSizeFallback",
+                                 BB->getFirstNonPHI()->getDebugLoc(),
+                                 const_cast<BasicBlock *>(BB));
+    R << "selection DAG of " << ore::NV("Nodes", NumNodes)
+      << " nodes is larger than the limit of "
+      << ore::NV("Limit", unsigned(DAGSizeFallbackThreshold))
+      << ", combining and scheduling it as at -O0";
+    MF->getFunction()->getContext().diagnose(R);
+  }
+  OptLevelChanger OLC(*this, DAGOptLevel);
+
   if (ViewDAGCombine1 && MatchFilterBB)
     CurDAG->viewGraph("dag-combine1 input for " + BlockName);
 
@@ -287,3 +287,7 @@ void LLVMContext::setDiscardValueNames(bool Discard) {
 OptBisect &LLVMContext::getOptBisect() {
   return pImpl->getOptBisect();
 }
+
+size_t LLVMContext::getUniquedMDNodeMemorySize() const {
+  return pImpl->getUniquedMDNodeMemorySize();
+}
@@ -251,3 +251,11 @@ static ManagedStatic<OptBisect> OptBisector;
 OptBisect &LLVMContextImpl::getOptBisect() {
   return *OptBisector;
 }
+
+size_t LLVMContextImpl::getUniquedMDNodeMemorySize() const {
+  size_t Size = 0;
+#define HANDLE_MDNODE_LEAF_UNIQUABLE(CLASS)                                    \
+  Size += CLASS##s.getMemorySize() + CLASS##s.getNodeMemorySize();
+#include "llvm/IR/Metadata.def"
+  return Size;
+}
@@ -1013,6 +1013,178 @@ template <class NodeTy> struct MDNodeInfo {
 #define HANDLE_MDNODE_LEAF(CLASS) typedef MDNodeInfo<CLASS> CLASS##Info;
 #include "llvm/IR/Metadata.def"
 
+/// \brief Uniquing store for MDNode subclasses.
+///
+/// This is an open-addressed hash set like DenseSet, except that each bucket
+/// caches the hash of its node. Computing the hash of a debug info node means
+/// hashing all of its fields, so growing the table doesn't recompute any
+/// hashes, and a probe only compares the fields of a node whose hash matches.
+template <class NodeTy> class MDNodeUniquingSet {
+  typedef MDNodeInfo<NodeTy> InfoT;
+
+  struct BucketT {
+    NodeTy *Node;
+    unsigned Hash;
+  };
+
+  BucketT *Buckets = nullptr;
+  unsigned NumBuckets = 0;
+  unsigned NumEntries = 0;
+  unsigned NumTombstones = 0;
+
+  static bool isLive(const BucketT &B) {
+    return B.Node != InfoT::getEmptyKey() &&
+           B.Node != InfoT::getTombstoneKey();
+  }
+
+  /// Returns the bucket that holds a node equal to \p Key, or the bucket
+  /// where such a node should be inserted if there is none.
+  template <class LookupKeyT>
+  BucketT *findBucket(const LookupKeyT &Key, unsigned Hash) const {
+    BucketT *FoundTombstone = nullptr;
+    unsigned BucketNo = Hash & (NumBuckets - 1);
+    unsigned ProbeAmt = 1;
+    while (true) {
+      BucketT *B = Buckets + BucketNo;
+      if (B->Node == InfoT::getEmptyKey())
+        return FoundTombstone ? FoundTombstone : B;
+      if (B->Node == InfoT::getTombstoneKey()) {
+        if (!FoundTombstone)
+          FoundTombstone = B;
+      } else if (B->Hash == Hash && InfoT::isEqual(Key, B->Node)) {
+        return B;
+      }
+      BucketNo = (BucketNo + ProbeAmt++) & (NumBuckets - 1);
+    }
+  }
+
+  void grow(unsigned AtLeast) {
+    BucketT *OldBuckets = Buckets;
+    unsigned OldNumBuckets = NumBuckets;
+    NumBuckets = NextPowerOf2(std::max(AtLeast, 64u) - 1);
+    Buckets =
+        static_cast<BucketT *>(operator new(sizeof(BucketT) * NumBuckets));
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      Buckets[I].Node = InfoT::getEmptyKey();
+    NumTombstones = 0;
+
+    // Reinsert using the cached hashes. The nodes are known to be distinct,
+    // so each one goes in the first free bucket of its probe sequence.
+    for (BucketT *B = OldBuckets, *E = OldBuckets + OldNumBuckets; B != E;
+         ++B) {
+      if (!isLive(*B))
+        continue;
+      unsigned BucketNo = B->Hash & (NumBuckets - 1);
+      unsigned ProbeAmt = 1;
+      while (Buckets[BucketNo].Node != InfoT::getEmptyKey())
+        BucketNo = (BucketNo + ProbeAmt++) & (NumBuckets - 1);
+      Buckets[BucketNo] = *B;
+    }
+    operator delete(OldBuckets);
+  }
+
+public:
+  MDNodeUniquingSet() = default;
+  MDNodeUniquingSet(const MDNodeUniquingSet &) = delete;
+  MDNodeUniquingSet &operator=(const MDNodeUniquingSet &) = delete;
+  ~MDNodeUniquingSet() { operator delete(Buckets); }
+
+  class iterator
+      : public std::iterator<std::forward_iterator_tag, NodeTy *> {
+    const BucketT *Ptr, *End;
+
+    void skipEmpty() {
+      while (Ptr != End && !isLive(*Ptr))
+        ++Ptr;
+    }
+
+  public:
+    iterator(const BucketT *Ptr, const BucketT *End) : Ptr(Ptr), End(End) {
+      skipEmpty();
+    }
+    NodeTy *operator*() const { return Ptr->Node; }
+    iterator &operator++() {
+      ++Ptr;
+      skipEmpty();
+      return *this;
+    }
+    bool operator==(const iterator &RHS) const { return Ptr == RHS.Ptr; }
+    bool operator!=(const iterator &RHS) const { return Ptr != RHS.Ptr; }
+  };
+
+  iterator begin() const { return iterator(Buckets, Buckets + NumBuckets); }
+  iterator end() const {
+    return iterator(Buckets + NumBuckets, Buckets + NumBuckets);
+  }
+  unsigned size() const { return NumEntries; }
+  bool empty() const { return NumEntries == 0; }
+
+  /// Returns the node equal to \p Key, or null if there is none.
+  NodeTy *lookup(const typename InfoT::KeyTy &Key) const {
+    if (!NumEntries)
+      return nullptr;
+    BucketT *B = findBucket(Key, InfoT::getHashValue(Key));
+    return isLive(*B) ? B->Node : nullptr;
+  }
+
+  /// Inserts \p N unless an equal node is already in the set. Returns the
+  /// node that is in the set afterwards.
+  NodeTy *insert(NodeTy *N) {
+    // Keep at least a quarter of the buckets empty and an eighth free of
+    // tombstones, so that probe sequences stay short.
+    if ((NumEntries + 1) * 4 >= NumBuckets * 3)
+      grow(NumBuckets * 2);
+    else if (NumBuckets - (NumEntries + NumTombstones + 1) <= NumBuckets / 8)
+      grow(NumBuckets);
+
+    // Compare keys as a lookup does. Comparing nodes only checks whether they
+    // are ODR-equal declarations.
+    typename InfoT::KeyTy Key(N);
+    unsigned Hash = InfoT::getHashValue(Key);
+    BucketT *B = findBucket(Key, Hash);
+    if (isLive(*B))
+      return B->Node;
+    if (B->Node == InfoT::getTombstoneKey())
+      --NumTombstones;
+    B->Node = N;
+    B->Hash = Hash;
+    ++NumEntries;
+    return N;
+  }
+
+  /// Removes \p N from the set. Returns false if it wasn't in the set.
+  bool erase(NodeTy *N) {
+    if (!NumEntries)
+      return false;
+    unsigned Hash = InfoT::getHashValue(N);
+    unsigned BucketNo = Hash & (NumBuckets - 1);
+    unsigned ProbeAmt = 1;
+    while (Buckets[BucketNo].Node != N) {
+      if (Buckets[BucketNo].Node == InfoT::getEmptyKey())
+        return false;
+      BucketNo = (BucketNo + ProbeAmt++) & (NumBuckets - 1);
+    }
+    Buckets[BucketNo].Node = InfoT::getTombstoneKey();
+    --NumEntries;
+    ++NumTombstones;
+    return true;
+  }
+
+  /// Returns the number of bytes allocated for the table itself.
+  size_t getMemorySize() const { return NumBuckets * sizeof(BucketT); }
+
+  /// Returns the number of bytes allocated for the nodes in the set,
+  /// including their operands.
+  size_t getNodeMemorySize() const {
+    size_t Size = 0;
+    for (NodeTy *N : *this)
+      Size += sizeof(NodeTy) +
+              alignTo(N->getNumOperands() * sizeof(MDOperand),
+                      alignof(uint64_t));
+    return Size;
+  }
+};
+
 /// \brief Map-like storage for metadata attachments.
 class MDAttachmentMap {
   SmallVector<std::pair<unsigned, TrackingMDNodeRef>, 2> Attachments;
@@ -1114,7 +1286,7 @@ public:
   DenseMap<const Value*, ValueName*> ValueNames;
 
 #define HANDLE_MDNODE_LEAF_UNIQUABLE(CLASS)                                    \
-  DenseSet<CLASS *, CLASS##Info> CLASS##s;
+  MDNodeUniquingSet<CLASS> CLASS##s;
 #include "llvm/IR/Metadata.def"
 
   // Optional map for looking up composite types by identifier.
@@ -1232,6 +1404,10 @@ public:
   /// \brief Access the object which manages optimization bisection for failure
   /// analysis.
   OptBisect &getOptBisect();
+
+  /// Returns the number of bytes used by uniqued metadata nodes and by the
+  /// tables that unique them.
+  size_t getUniquedMDNodeMemorySize() const;
 };
 
 }
@@ -0,0 +1,281 @@
+//===- MemoryCensus.cpp - Memory used by the IR of a module ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements IRMemoryCensus.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/MemoryCensus.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalIFunc.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+
+static StringRef getKindName(const Value &V) {
+  if (auto *I = dyn_cast<Instruction>(&V))
+    return I->getOpcodeName();
+  switch (V.getValueID()) {
+  case Value::ArgumentVal:
+    return "Argument";
+  case Value::BasicBlockVal:
+    return "BasicBlock";
+#define HANDLE_GLOBAL_VALUE(NAME)                                              \
+  case Value::NAME##Val:                                                       \
+    return #NAME;
+#define HANDLE_CONSTANT(NAME)                                                  \
+  case Value::NAME##Val:                                                       \
+    return #NAME;
+#define HANDLE_METADATA_VALUE(NAME)                                            \
+  case Value::NAME##Val:                                                       \
+    return #NAME;
+#define HANDLE_INLINE_ASM_VALUE(NAME)                                          \
+  case Value::NAME##Val:                                                       \
+    return #NAME;
+#include "llvm/IR/Value.def"
+  default:
+    return "<other>";
+  }
+}
+
+/// Returns the size of the object of \p V, not counting its operands.
+static size_t getObjectSize(const Value &V) {
+  if (auto *I = dyn_cast<Instruction>(&V)) {
+    switch (I->getOpcode()) {
+#define HANDLE_INST(N, OPC, CLASS)                                             \
+  case Instruction::OPC:                                                       \
+    return sizeof(CLASS);
+#include "llvm/IR/Instruction.def"
+    default:
+      return sizeof(Instruction);
+    }
+  }
+  switch (V.getValueID()) {
+  case Value::ArgumentVal:
+    return sizeof(Argument);
+  case Value::BasicBlockVal:
+    return sizeof(BasicBlock);
+#define HANDLE_GLOBAL_VALUE(NAME)                                              \
+  case Value::NAME##Val:                                                       \
+    return sizeof(NAME);
+#define HANDLE_CONSTANT(NAME)                                                  \
+  case Value::NAME##Val:                                                       \
+    return sizeof(NAME);
+#define HANDLE_METADATA_VALUE(NAME)                                            \
+  case Value::NAME##Val:                                                       \
+    return sizeof(NAME);
+#define HANDLE_INLINE_ASM_VALUE(NAME)                                          \
+  case Value::NAME##Val:                                                       \
+    return sizeof(NAME);
+#include "llvm/IR/Value.def"
+  default:
+    return sizeof(Value);
+  }
+}
+
+static StringRef getKindName(const Metadata &MD) {
+  switch (MD.getMetadataID()) {
+#define HANDLE_METADATA_LEAF(CLASS)                                            \
+  case Metadata::CLASS##Kind:                                                  \
+    return #CLASS;
+#include "llvm/IR/Metadata.def"
+  default:
+    return "<other metadata>";
+  }
+}
+
+/// Returns the size of the object of \p MD, not counting its operands.
+static size_t getObjectSize(const Metadata &MD) {
+  // The characters of an MDString are in its entry of the string map of the
+  // context.
+  if (auto *S = dyn_cast<MDString>(&MD))
+    return sizeof(StringMapEntry<MDString>) + S->getLength() + 1;
+  switch (MD.getMetadataID()) {
+#define HANDLE_METADATA_LEAF(CLASS)                                            \
+  case Metadata::CLASS##Kind:                                                  \
+    return sizeof(CLASS);
+#include "llvm/IR/Metadata.def"
+  default:
+    return sizeof(Metadata);
+  }
+}
+
+/// Constants, inline asm and metadata wrappers are uniqued in the context
+/// rather than owned by a module.
+static bool isShared(const Value &V) {
+  return (isa<Constant>(V) && !isa<GlobalValue>(V)) || isa<InlineAsm>(V) ||
+         isa<MetadataAsValue>(V);
+}
+
+void IRMemoryCensus::addValue(const Value &V) {
+  Entry &E = Entries[getKindName(V)];
+  ++E.Count;
+  E.ObjectBytes += getObjectSize(V);
+  if (auto *CDS = dyn_cast<ConstantDataSequential>(&V))
+    E.ObjectBytes += CDS->getRawDataValues().size();
+  if (auto *U = dyn_cast<User>(&V))
+    E.OperandBytes += U->getNumOperands() * sizeof(Use);
+  // A PHI node keeps its incoming blocks next to its operands.
+  if (auto *PN = dyn_cast<PHINode>(&V))
+    E.OperandBytes += PN->getNumIncomingValues() * sizeof(BasicBlock *);
+  if (V.hasName())
+    E.NameBytes += sizeof(ValueName) + V.getName().size() + 1;
+}
+
+void IRMemoryCensus::addMetadata(const Metadata &MD) {
+  if (!SharedMetadata.insert(&MD).second)
+    return;
+  SmallVector<const Metadata *, 16> Worklist;
+  Worklist.push_back(&MD);
+  while (!Worklist.empty()) {
+    const Metadata *Cur = Worklist.pop_back_val();
+    Entry &E = Entries[getKindName(*Cur)];
+    ++E.Count;
+    E.ObjectBytes += getObjectSize(*Cur);
+
+    if (auto *VAM = dyn_cast<ValueAsMetadata>(Cur)) {
+      const Value *V = VAM->getValue();
+      if (isShared(*V) && SharedValues.insert(V).second) {
+        addValue(*V);
+        addOperands(*V);
+      }
+      continue;
+    }
+
+    // The operands of a node are allocated in front of it.
+    auto *N = dyn_cast<MDNode>(Cur);
+    if (!N)
+      continue;
+    E.OperandBytes += N->getNumOperands() * sizeof(MDOperand);
+    for (const MDOperand &Op : N->operands())
+      if (Op && SharedMetadata.insert(Op.get()).second)
+        Worklist.push_back(Op.get());
+  }
+}
+
+void IRMemoryCensus::addAttachments(const GlobalObject &GO) {
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  GO.getAllMetadata(MDs);
+  for (auto &MD : MDs)
+    addMetadata(*MD.second);
+}
+
+void IRMemoryCensus::addOperands(const Value &V) {
+  // Constant expressions can be deeply nested, so use a worklist.
+  SmallVector<const User *, 16> Worklist;
+  if (auto *U = dyn_cast<User>(&V))
+    Worklist.push_back(U);
+  while (!Worklist.empty()) {
+    const User *U = Worklist.pop_back_val();
+    for (const Use &OpU : U->operands()) {
+      const Value *Op = OpU.get();
+      if (!Op || !isShared(*Op) || !SharedValues.insert(Op).second)
+        continue;
+      addValue(*Op);
+      if (auto *MAV = dyn_cast<MetadataAsValue>(Op))
+        addMetadata(*MAV->getMetadata());
+      if (auto *OpUser = dyn_cast<User>(Op))
+        Worklist.push_back(OpUser);
+    }
+  }
+}
+
+void IRMemoryCensus::addModule(const Module &M) {
+  for (const NamedMDNode &NMD : M.named_metadata())
+    for (const MDNode *N : NMD.operands())
+      addMetadata(*N);
+  for (const GlobalVariable &GV : M.globals()) {
+    addValue(GV);
+    addOperands(GV);
+    addAttachments(GV);
+  }
+  for (const GlobalAlias &GA : M.aliases()) {
+    addValue(GA);
+    addOperands(GA);
+  }
+  for (const GlobalIFunc &GI : M.ifuncs()) {
+    addValue(GI);
+    addOperands(GI);
+  }
+  for (const Function &F : M) {
+    addValue(F);
+    addOperands(F);
+    addAttachments(F);
+    for (const Argument &A : F.args())
+      addValue(A);
+    for (const BasicBlock &BB : F) {
+      addValue(BB);
+      for (const Instruction &I : BB) {
+        addValue(I);
+        addOperands(I);
+        SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+        I.getAllMetadata(MDs);
+        for (auto &MD : MDs)
+          addMetadata(*MD.second);
+      }
+    }
+  }
+}
+
+uint64_t IRMemoryCensus::getTotalBytes() const {
+  uint64_t Total = 0;
+  for (auto &E : Entries)
+    Total += E.second.getTotalBytes();
+  return Total;
+}
+
+void IRMemoryCensus::print(raw_ostream &OS) const {
+  std::vector<const StringMapEntry<Entry> *> Sorted;
+  for (auto &E : Entries)
+    Sorted.push_back(&E);
+  std::sort(Sorted.begin(), Sorted.end(),
+            [](const StringMapEntry<Entry> *A, const StringMapEntry<Entry> *B) {
+              if (A->second.getTotalBytes() != B->second.getTotalBytes())
+                return A->second.getTotalBytes() > B->second.getTotalBytes();
+              return A->getKey() < B->getKey();
+            });
+
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                          ... IR Memory Census ...\n"
+     << "===" << std::string(73, '-') << "===\n\n";
+  OS << "     Count   Object bytes  Operand bytes   Name bytes    Total bytes"
+        "  Kind\n";
+  Entry Total;
+  for (auto *E : Sorted) {
+    const Entry &C = E->second;
+    OS << format("%10llu %14llu %14llu %12llu %14llu  ",
+                 (unsigned long long)C.Count,
+                 (unsigned long long)C.ObjectBytes,
+                 (unsigned long long)C.OperandBytes,
+                 (unsigned long long)C.NameBytes,
+                 (unsigned long long)C.getTotalBytes())
+       << E->getKey() << '\n';
+    Total.Count += C.Count;
+    Total.ObjectBytes += C.ObjectBytes;
+    Total.OperandBytes += C.OperandBytes;
+    Total.NameBytes += C.NameBytes;
+  }
+  OS << format("%10llu %14llu %14llu %12llu %14llu  ",
+               (unsigned long long)Total.Count,
+               (unsigned long long)Total.ObjectBytes,
+               (unsigned long long)Total.OperandBytes,
+               (unsigned long long)Total.NameBytes,
+               (unsigned long long)Total.getTotalBytes())
+     << "Total\n\n";
+  OS.flush();
+}
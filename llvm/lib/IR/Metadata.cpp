@@ -718,13 +718,9 @@ void MDNode::deleteAsSubclass() {
   }
 }
 
-template <class T, class InfoT>
-static T *uniquifyImpl(T *N, DenseSet<T *, InfoT> &Store) {
-  if (T *U = getUniqued(Store, N))
-    return U;
-
-  Store.insert(N);
-  return N;
+template <class T>
+static T *uniquifyImpl(T *N, MDNodeUniquingSet<T> &Store) {
+  return Store.insert(N);
 }
 
 template <class NodeTy> struct MDNode::HasCachedHash {
@@ -14,16 +14,15 @@
 #ifndef LLVM_IR_METADATAIMPL_H
 #define LLVM_IR_METADATAIMPL_H
 
-#include "llvm/ADT/DenseSet.h"
+#include "LLVMContextImpl.h"
 #include "llvm/IR/Metadata.h"
 
 namespace llvm {
 
-template <class T, class InfoT>
-static T *getUniqued(DenseSet<T *, InfoT> &Store,
-                     const typename InfoT::KeyTy &Key) {
-  auto I = Store.find_as(Key);
-  return I == Store.end() ? nullptr : *I;
+template <class T>
+static T *getUniqued(MDNodeUniquingSet<T> &Store,
+                     const typename MDNodeInfo<T>::KeyTy &Key) {
+  return Store.lookup(Key);
 }
 
 template <class T> T *MDNode::storeImpl(T *N, StorageType Storage) {
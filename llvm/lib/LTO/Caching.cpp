@@ -13,6 +13,7 @@
 
 #include "llvm/LTO/Caching.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CacheIndex.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -97,3 +98,59 @@ NativeObjectCache lto::localCache(std::string CacheDirectoryPath,
     };
   };
 }
+
+NativeObjectCache lto::indexedCache(std::string CacheDirectoryPath,
+                                    AddFileFn AddFile) {
+  return [=](unsigned Task, StringRef Key) -> AddStreamFn {
+    CacheIndex Index(CacheDirectoryPath);
+    std::string EntryPath = Index.getEntryPath(Key);
+    if (Index.lookup(Key)) {
+      AddFile(Task, EntryPath);
+      return AddStreamFn();
+    }
+
+    // This native object stream is responsible for commiting the resulting
+    // file to the cache and calling AddFile to add it to the link.
+    struct CacheStream : NativeObjectStream {
+      AddFileFn AddFile;
+      CacheIndex Index;
+      std::string TempFilename;
+      std::string Key;
+      std::string EntryPath;
+      unsigned Task;
+
+      CacheStream(std::unique_ptr<raw_pwrite_stream> OS, AddFileFn AddFile,
+                  CacheIndex Index, std::string TempFilename,
+                  std::string Key, std::string EntryPath, unsigned Task)
+          : NativeObjectStream(std::move(OS)), AddFile(AddFile), Index(Index),
+            TempFilename(TempFilename), Key(Key), EntryPath(EntryPath),
+            Task(Task) {}
+
+      ~CacheStream() {
+        // Make sure the file is closed before committing it.
+        OS.reset();
+        if (std::error_code EC = Index.commit(TempFilename, Key))
+          report_fatal_error(Twine("Failed to commit cache entry '") +
+                             EntryPath + "': " + EC.message() + "\n");
+        AddFile(Task, EntryPath);
+      }
+    };
+
+    std::string KeyStr = Key.str();
+    return [=](size_t Task) -> std::unique_ptr<NativeObjectStream> {
+      // Write to a temporary in the cache directory, which is renamed into
+      // place atomically once it is complete.
+      int TempFD;
+      SmallString<64> TempFilename;
+      std::error_code EC = Index.createTemporaryEntry(TempFD, TempFilename);
+      if (EC) {
+        errs() << "Error: " << EC.message() << "\n";
+        report_fatal_error("ThinLTO: Can't get a temporary file");
+      }
+
+      return llvm::make_unique<CacheStream>(
+          llvm::make_unique<raw_fd_ostream>(TempFD, /* ShouldClose */ true),
+          AddFile, Index, TempFilename.str(), KeyStr, EntryPath, Task);
+    };
+  };
+}
@@ -31,6 +31,7 @@
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
@@ -628,12 +629,45 @@ public:
   virtual Error wait() = 0;
 };
 
+/// Estimate the work of the ThinLTO backend for a module by the instruction
+/// counts of the functions it defines and imports.
+static uint64_t
+estimateBackendCost(const GVSummaryMapTy &DefinedGlobals,
+                    const FunctionImporter::ImportMapTy &ImportList,
+                    ModuleSummaryIndex &CombinedIndex) {
+  uint64_t Cost = 0;
+  for (auto &Def : DefinedGlobals)
+    if (auto *FS = dyn_cast<FunctionSummary>(Def.second))
+      Cost += FS->instCount();
+  for (auto &ImportsFromModule : ImportList)
+    for (auto &Import : ImportsFromModule.second)
+      if (auto *FS = dyn_cast_or_null<FunctionSummary>(
+              CombinedIndex.findSummaryInModule(Import.first,
+                                                ImportsFromModule.first())))
+        Cost += FS->instCount();
+  return Cost;
+}
+
 namespace {
 class InProcessThinBackend : public ThinBackendProc {
   ThreadPool BackendThreadPool;
   AddStreamFn AddStream;
   NativeObjectCache Cache;
 
+  /// A backend job that has been started but not yet submitted to the
+  /// thread pool.
+  struct BackendJob {
+    uint64_t Cost;
+    StringRef ModulePath;
+    std::function<Error()> Run;
+  };
+  std::vector<BackendJob> Jobs;
+
+  // Per-module backend timers, reported with -time-passes. The group must
+  // outlive the timers so that it can print them.
+  TimerGroup BackendTimers;
+  std::vector<std::unique_ptr<Timer>> ModuleTimers;
+
   Optional<Error> Err;
   std::mutex ErrMu;
 
@@ -645,7 +679,8 @@ public:
       AddStreamFn AddStream, NativeObjectCache Cache)
       : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
         BackendThreadPool(ThinLTOParallelismLevel),
-        AddStream(std::move(AddStream)), Cache(std::move(Cache)) {}
+        AddStream(std::move(AddStream)), Cache(std::move(Cache)),
+        BackendTimers("thinlto-backend", "ThinLTO Backend Timing") {}
 
   Error runThinLTOBackendThread(
       AddStreamFn AddStream, NativeObjectCache Cache, unsigned Task,
@@ -694,33 +729,53 @@ public:
     assert(ModuleToDefinedGVSummaries.count(ModulePath));
     const GVSummaryMapTy &DefinedGlobals =
         ModuleToDefinedGVSummaries.find(ModulePath)->second;
-    BackendThreadPool.async(
-        [=](BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
-            const FunctionImporter::ImportMapTy &ImportList,
-            const FunctionImporter::ExportSetTy &ExportList,
-            const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>
-                &ResolvedODR,
-            const GVSummaryMapTy &DefinedGlobals,
-            MapVector<StringRef, BitcodeModule> &ModuleMap) {
-          Error E = runThinLTOBackendThread(
-              AddStream, Cache, Task, BM, CombinedIndex, ImportList,
-              ExportList, ResolvedODR, DefinedGlobals, ModuleMap);
-          if (E) {
-            std::unique_lock<std::mutex> L(ErrMu);
-            if (Err)
-              Err = joinErrors(std::move(*Err), std::move(E));
-            else
-              Err = std::move(E);
-          }
-        },
-        BM, std::ref(CombinedIndex), std::ref(ImportList),
-        std::ref(ExportList), std::ref(ResolvedODR), std::ref(DefinedGlobals),
-        std::ref(ModuleMap));
+    uint64_t Cost =
+        estimateBackendCost(DefinedGlobals, ImportList, CombinedIndex);
+    Jobs.push_back(
+        {Cost, ModulePath,
+         std::bind(&InProcessThinBackend::runThinLTOBackendThread, this,
+                   AddStream, Cache, Task, BM, std::ref(CombinedIndex),
+                   std::ref(ImportList), std::ref(ExportList),
+                   std::ref(ResolvedODR), std::ref(DefinedGlobals),
+                   std::ref(ModuleMap))});
     return Error::success();
   }
 
   Error wait() override {
+    // Submit the most expensive backends first. In module order, a large
+    // module near the end would keep one thread busy long after the others
+    // have run out of work. Task numbers are unaffected, so the output does
+    // not depend on the schedule.
+    std::stable_sort(Jobs.begin(), Jobs.end(),
+                     [](const BackendJob &A, const BackendJob &B) {
+                       return A.Cost > B.Cost;
+                     });
+    for (BackendJob &Job : Jobs) {
+      DEBUG(dbgs() << "Starting ThinLTO backend for " << Job.ModulePath
+                   << " (estimated cost " << Job.Cost << ")\n");
+      Timer *T = nullptr;
+      if (TimePassesIsEnabled) {
+        ModuleTimers.push_back(llvm::make_unique<Timer>(
+            Job.ModulePath, Job.ModulePath, BackendTimers));
+        T = ModuleTimers.back().get();
+      }
+      BackendThreadPool.async([this, &Job, T]() {
+        if (T)
+          T->startTimer();
+        Error E = Job.Run();
+        if (T)
+          T->stopTimer();
+        if (E) {
+          std::unique_lock<std::mutex> L(ErrMu);
+          if (Err)
+            Err = joinErrors(std::move(*Err), std::move(E));
+          else
+            Err = std::move(E);
+        }
+      });
+    }
     BackendThreadPool.wait();
+    Jobs.clear();
     if (Err)
       return std::move(*Err);
     else
@@ -13,9 +13,14 @@
 
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
 
 namespace llvm {
 
+static std::atomic<uint64_t> BumpPtrAllocatorSlabBytes(0);
+
+uint64_t getBumpPtrAllocatorSlabBytes() { return BumpPtrAllocatorSlabBytes; }
+
 namespace detail {
 
 void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
@@ -27,6 +32,10 @@ void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
          << " (includes alignment, etc)\n";
 }
 
+void addBumpPtrAllocatorSlabBytes(size_t Size) {
+  BumpPtrAllocatorSlabBytes += Size;
+}
+
 } // End namespace detail.
 
 void PrintRecyclerStats(size_t Size,
@@ -0,0 +1,262 @@
+//===-CacheIndex.cpp - Size-bounded cache directory with an index ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a cache directory that is kept under a size limit by
+// evicting the least recently used entries recorded in an index file.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CacheIndex.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+#define DEBUG_TYPE "cache-index"
+
+using namespace llvm;
+
+/// A lock file older than this was left behind by a pruner that crashed.
+static const std::chrono::hours StaleLockAge(1);
+
+static SmallString<128> getCachePath(StringRef Dir, StringRef Name) {
+  SmallString<128> Result(Dir);
+  sys::path::append(Result, Name);
+  return Result;
+}
+
+/// Append \p Records to the index file with a single write, so that records
+/// appended concurrently by other processes are not interleaved with them.
+static void appendToIndex(StringRef IndexPath, StringRef Records) {
+  int FD;
+  if (sys::fs::openFileForWrite(IndexPath, FD, sys::fs::F_Append))
+    return;
+  raw_fd_ostream OS(FD, /*shouldClose=*/true, /*unbuffered=*/true);
+  OS << Records;
+  // A failure only loses the record, which the next access writes again.
+  OS.clear_error();
+}
+
+static void formatRecord(raw_ostream &OS, StringRef Key, uint64_t Size,
+                         int64_t Time) {
+  OS << Key << ' ' << Size << ' ' << Time << '\n';
+}
+
+std::string CacheIndex::getEntryPath(StringRef Key) const {
+  return getCachePath(Path, "llvmcache-" + Key.str()).str();
+}
+
+void CacheIndex::record(StringRef Key, uint64_t Size) const {
+  SmallString<128> Record;
+  raw_svector_ostream OS(Record);
+  formatRecord(OS, Key, Size, sys::toTimeT(std::chrono::system_clock::now()));
+  appendToIndex(getCachePath(Path, "llvmcache.index"), Record);
+}
+
+bool CacheIndex::lookup(StringRef Key) const {
+  std::string EntryPath = getEntryPath(Key);
+  int FD;
+  if (sys::fs::openFileForRead(EntryPath, FD))
+    return false;
+
+  sys::fs::file_status Status;
+  std::error_code EC = sys::fs::status(FD, Status);
+  // prune() checks the modification time before evicting an entry, which
+  // protects this entry while the caller reads it even if the record below
+  // has not been seen by a concurrent pruner yet.
+  sys::fs::setLastModificationAndAccessTime(FD,
+                                            std::chrono::system_clock::now());
+  sys::Process::SafelyCloseFileDescriptor(FD);
+
+  // A pruner that moved the entry aside before it was touched above removes
+  // it, so the entry is only usable if it is still in place.
+  if (!sys::fs::exists(EntryPath))
+    return false;
+  if (!EC)
+    record(Key, Status.getSize());
+  return true;
+}
+
+std::error_code
+CacheIndex::createTemporaryEntry(int &ResultFD,
+                                 SmallVectorImpl<char> &ResultPath) const {
+  // Creating the file in the cache directory guarantees that commit() can
+  // rename it into place atomically.
+  return sys::fs::createUniqueFile(getCachePath(Path, "llvmcache-tmp-%%%%%%"),
+                                   ResultFD, ResultPath);
+}
+
+std::error_code CacheIndex::commit(StringRef TempPath,
+                                   StringRef Key) const {
+  std::string EntryPath = getEntryPath(Key);
+  if (std::error_code EC = sys::fs::rename(TempPath, EntryPath)) {
+    sys::fs::remove(TempPath);
+    return EC;
+  }
+  uint64_t Size;
+  if (!sys::fs::file_size(EntryPath, Size))
+    record(Key, Size);
+  return std::error_code();
+}
+
+namespace {
+struct IndexRecord {
+  uint64_t Size;
+  int64_t Time;
+  bool Evicted;
+};
+} // end anonymous namespace
+
+/// Parse the records in \p Buffer into \p Records. When a key has several
+/// records, the most recent access wins.
+static void parseIndex(StringRef Buffer, StringMap<IndexRecord> &Records) {
+  while (!Buffer.empty()) {
+    StringRef Line;
+    std::tie(Line, Buffer) = Buffer.split('\n');
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, ' ');
+    uint64_t Size;
+    int64_t Time;
+    // Skip records that a crash left incomplete.
+    if (Fields.size() != 3 || Fields[0].empty() ||
+        Fields[1].getAsInteger(10, Size) || Fields[2].getAsInteger(10, Time))
+      continue;
+    auto Insert = Records.insert({Fields[0], IndexRecord{Size, Time, false}});
+    if (!Insert.second && Insert.first->second.Time <= Time)
+      Insert.first->second = IndexRecord{Size, Time, false};
+  }
+}
+
+bool CacheIndex::prune() {
+  using namespace std::chrono;
+
+  if (MaxSizeBytes == 0)
+    return false;
+
+  // Only one process prunes at a time; the others carry on with their links.
+  SmallString<128> LockPath = getCachePath(Path, "llvmcache.index.lock");
+  int LockFD;
+  if (std::error_code EC =
+          sys::fs::openFileForWrite(LockPath, LockFD, sys::fs::F_Excl)) {
+    sys::fs::file_status Status;
+    if (EC != errc::file_exists || sys::fs::status(LockPath, Status) ||
+        system_clock::now() - Status.getLastModificationTime() < StaleLockAge)
+      return false;
+    DEBUG(dbgs() << "Removing stale lock " << LockPath << "\n");
+    sys::fs::remove(LockPath);
+    if (sys::fs::openFileForWrite(LockPath, LockFD, sys::fs::F_Excl))
+      return false;
+  }
+  sys::Process::SafelyCloseFileDescriptor(LockFD);
+
+  // Move the index aside, so that the records that other processes append
+  // from now on go to a new index. The old index may still be there if a
+  // pruner crashed, in which case its records are read first.
+  SmallString<128> IndexPath = getCachePath(Path, "llvmcache.index");
+  SmallString<128> OldIndexPath = getCachePath(Path, "llvmcache.index.old");
+  StringMap<IndexRecord> Records;
+  if (auto BufOrErr = MemoryBuffer::getFile(OldIndexPath))
+    parseIndex((*BufOrErr)->getBuffer(), Records);
+  // A process that opened the index before the rename may still append to
+  // the old one. Only complete records are read here; the rest is read again
+  // before the old index is removed.
+  bool Renamed = !sys::fs::rename(IndexPath, OldIndexPath);
+  size_t OldIndexSize = 0;
+  if (Renamed)
+    if (auto BufOrErr = MemoryBuffer::getFile(OldIndexPath)) {
+      StringRef Buffer = (*BufOrErr)->getBuffer();
+      OldIndexSize = Buffer.rfind('\n') + 1;
+      parseIndex(Buffer.take_front(OldIndexSize), Records);
+    }
+
+  std::vector<StringMapEntry<IndexRecord> *> Entries;
+  uint64_t TotalSize = 0;
+  for (auto &Entry : Records) {
+    Entries.push_back(&Entry);
+    TotalSize += Entry.second.Size;
+  }
+  std::sort(Entries.begin(), Entries.end(),
+            [](const StringMapEntry<IndexRecord> *A,
+               const StringMapEntry<IndexRecord> *B) {
+              if (A->second.Time != B->second.Time)
+                return A->second.Time < B->second.Time;
+              return A->getKey() < B->getKey();
+            });
+
+  // Evict the least recently used entries.
+  const auto CurrentTime = system_clock::now();
+  for (auto *Entry : Entries) {
+    if (TotalSize <= MaxSizeBytes)
+      break;
+    IndexRecord &R = Entry->second;
+    std::string EntryPath = getEntryPath(Entry->getKey());
+    sys::fs::file_status Status;
+    if (std::error_code EC = sys::fs::status(EntryPath, Status)) {
+      if (EC == errc::no_such_file_or_directory) {
+        R.Evicted = true;
+        TotalSize -= R.Size;
+      }
+      continue;
+    }
+    if (CurrentTime - Status.getLastModificationTime() < MinEntryAge)
+      continue;
+    // A lookup() may touch the entry at any time, so move it aside and check
+    // its age again before removing it. A lookup() that touches it too late
+    // finds it moved and reports a miss.
+    std::string EvictPath = EntryPath + ".evict";
+    if (std::error_code EC = sys::fs::rename(EntryPath, EvictPath)) {
+      if (EC == errc::no_such_file_or_directory) {
+        R.Evicted = true;
+        TotalSize -= R.Size;
+      }
+      continue;
+    }
+    if (sys::fs::status(EvictPath, Status) ||
+        CurrentTime - Status.getLastModificationTime() < MinEntryAge) {
+      sys::fs::rename(EvictPath, EntryPath);
+      continue;
+    }
+    DEBUG(dbgs() << "Evict " << EntryPath << "\n");
+    if (sys::fs::remove(EvictPath)) {
+      sys::fs::rename(EvictPath, EntryPath);
+      continue;
+    }
+    R.Evicted = true;
+    TotalSize -= R.Size;
+  }
+
+  // Write one record for each remaining entry to the new index, followed by
+  // the records that other processes appended to the old index after it was
+  // read. Those are newer than the compacted ones, so they take precedence.
+  std::string Compacted;
+  raw_string_ostream OS(Compacted);
+  for (auto *Entry : Entries)
+    if (!Entry->second.Evicted)
+      formatRecord(OS, Entry->getKey(), Entry->second.Size,
+                   Entry->second.Time);
+  if (Renamed)
+    if (auto BufOrErr = MemoryBuffer::getFile(OldIndexPath)) {
+      StringRef Tail = (*BufOrErr)->getBuffer().drop_front(OldIndexSize);
+      OS << Tail.take_front(Tail.rfind('\n') + 1);
+    }
+  OS.flush();
+  if (!Compacted.empty())
+    appendToIndex(IndexPath, Compacted);
+
+  sys::fs::remove(OldIndexPath);
+  sys::fs::remove(LockPath);
+  return true;
+}
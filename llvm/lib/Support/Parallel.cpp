@@ -0,0 +1,244 @@
+//===- llvm/Support/Parallel.cpp - Parallel algorithms --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the work-stealing executor used by the parallel
+// algorithms in Parallel.h.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Parallel.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/ManagedStatic.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace llvm;
+using namespace llvm::parallel;
+
+static std::atomic<unsigned> ThreadBudget{0};
+
+void parallel::setThreadBudget(unsigned ThreadCount) {
+  ThreadBudget = std::max(ThreadCount, 1U);
+}
+
+unsigned parallel::getThreadBudget() {
+#if LLVM_ENABLE_THREADS
+  if (unsigned N = ThreadBudget)
+    return N;
+  return std::max(std::thread::hardware_concurrency(), 1U);
+#else
+  return 1;
+#endif
+}
+
+#if LLVM_ENABLE_THREADS
+
+namespace {
+// A queue of tasks. The owner thread pushes and pops tasks at the back,
+// and other threads steal tasks from the front. Older tasks tend to be
+// larger because parallel algorithms split work recursively, so stealing
+// from the front moves large chunks of work to idle threads.
+struct TaskQueue {
+  std::mutex Mu;
+  std::deque<std::function<void()>> Tasks;
+};
+
+class Executor {
+public:
+  Executor();
+  ~Executor();
+
+  void add(std::function<void()> Fn);
+
+private:
+  bool runPendingTask();
+  bool pop(std::function<void()> &Fn);
+  void work(unsigned Index);
+
+  // Queues[0] is shared by threads that are not workers (e.g. the main
+  // thread). Queues[I] for I > 0 belongs to worker I.
+  std::vector<std::unique_ptr<TaskQueue>> Queues;
+  std::vector<std::thread> Threads;
+
+  // The number of tasks in all queues.
+  std::atomic<size_t> NumPending{0};
+
+  // Idle workers sleep on this condition variable.
+  std::mutex SleepMu;
+  std::condition_variable SleepCond;
+  std::atomic<unsigned> NumSleeping{0};
+  bool Stop = false;
+};
+} // namespace
+
+// The index of the queue that belongs to the current thread.
+static LLVM_THREAD_LOCAL unsigned QueueIndex = 0;
+
+// The calling thread participates in the work while it waits for a task
+// group, so we create one thread less than the budget.
+Executor::Executor() {
+  unsigned ThreadCount = getThreadBudget();
+  for (unsigned I = 0; I < ThreadCount; ++I)
+    Queues.push_back(llvm::make_unique<TaskQueue>());
+  for (unsigned I = 1; I < ThreadCount; ++I)
+    Threads.emplace_back([=] { work(I); });
+}
+
+Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> Lock(SleepMu);
+    Stop = true;
+  }
+  SleepCond.notify_all();
+  for (std::thread &T : Threads)
+    T.join();
+}
+
+void Executor::add(std::function<void()> Fn) {
+  // Increment the counter first so that it never becomes negative.
+  ++NumPending;
+  {
+    TaskQueue &Q = *Queues[QueueIndex];
+    std::lock_guard<std::mutex> Lock(Q.Mu);
+    Q.Tasks.push_back(std::move(Fn));
+  }
+
+  // A worker increments NumSleeping before it checks NumPending, so
+  // either the worker sees the new task or we see the sleeping worker.
+  if (NumSleeping > 0) {
+    std::lock_guard<std::mutex> Lock(SleepMu);
+    SleepCond.notify_one();
+  }
+}
+
+bool Executor::pop(std::function<void()> &Fn) {
+  // Try the thread's own queue first.
+  {
+    TaskQueue &Q = *Queues[QueueIndex];
+    std::lock_guard<std::mutex> Lock(Q.Mu);
+    if (!Q.Tasks.empty()) {
+      Fn = std::move(Q.Tasks.back());
+      Q.Tasks.pop_back();
+      return true;
+    }
+  }
+
+  // Steal a task from someone else.
+  for (size_t I = 1, E = Queues.size(); I < E; ++I) {
+    TaskQueue &Q = *Queues[(QueueIndex + I) % E];
+    std::lock_guard<std::mutex> Lock(Q.Mu);
+    if (!Q.Tasks.empty()) {
+      Fn = std::move(Q.Tasks.front());
+      Q.Tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Executor::runPendingTask() {
+  if (NumPending == 0)
+    return false;
+  std::function<void()> Fn;
+  if (!pop(Fn))
+    return false;
+  --NumPending;
+  Fn();
+  return true;
+}
+
+void Executor::work(unsigned Index) {
+  QueueIndex = Index;
+  for (;;) {
+    if (runPendingTask())
+      continue;
+
+    std::unique_lock<std::mutex> Lock(SleepMu);
+    ++NumSleeping;
+    SleepCond.wait(Lock, [&] { return Stop || NumPending > 0; });
+    --NumSleeping;
+    if (Stop)
+      return;
+  }
+}
+
+static ManagedStatic<Executor> DefaultExecutor;
+
+void parallel::detail::spawn(std::function<void()> Fn) {
+  DefaultExecutor->add(std::move(Fn));
+}
+
+struct parallel::detail::GroupTask {
+  GroupTask(TaskGroup &TG, std::function<void()> Fn)
+      : TG(TG), Fn(std::move(Fn)) {}
+
+  // Runs the task unless another thread has already claimed it. Once
+  // the last task of a group has finished, the group may be destroyed,
+  // so a task that lost the race must not touch TG.
+  void run() {
+    if (Claimed.exchange(true))
+      return;
+    Fn();
+    std::lock_guard<std::mutex> Lock(TG.Mu);
+    if (--TG.Pending == 0)
+      TG.Cond.notify_all();
+  }
+
+  TaskGroup &TG;
+  std::function<void()> Fn;
+  std::atomic<bool> Claimed{false};
+};
+
+void TaskGroup::spawn(std::function<void()> Fn) {
+  auto T = std::make_shared<detail::GroupTask>(*this, std::move(Fn));
+  {
+    std::lock_guard<std::mutex> Lock(Mu);
+    ++Pending;
+    Unstarted.push_back(T);
+    Cond.notify_all();
+  }
+  detail::spawn([T] { T->run(); });
+}
+
+// Runs the tasks of this group that no worker has started, and then
+// sleeps until the ones started by workers have finished. Tasks that are
+// running may spawn more tasks into this group, which wakes us up to run
+// them too.
+void TaskGroup::sync() {
+  std::unique_lock<std::mutex> Lock(Mu);
+  for (;;) {
+    if (!Unstarted.empty()) {
+      std::shared_ptr<detail::GroupTask> T = std::move(Unstarted.back());
+      Unstarted.pop_back();
+      Lock.unlock();
+      T->run();
+      Lock.lock();
+      continue;
+    }
+    if (Pending == 0)
+      return;
+    Cond.wait(Lock);
+  }
+}
+
+#else
+
+void parallel::detail::spawn(std::function<void()> Fn) { Fn(); }
+
+void TaskGroup::spawn(std::function<void()> Fn) { Fn(); }
+
+void TaskGroup::sync() {}
+
+#endif
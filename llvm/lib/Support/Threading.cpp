@@ -17,7 +17,9 @@
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/thread.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace llvm;
@@ -122,8 +124,10 @@ unsigned llvm::heavyweight_hardware_concurrency() {
 #if !LLVM_ENABLE_THREADS
   return 1;
 #endif
+  // Don't exceed the process-wide thread budget if one has been set.
+  unsigned Budget = parallel::getThreadBudget();
   int NumPhysical = sys::getHostNumPhysicalCores();
   if (NumPhysical == -1)
-    return thread::hardware_concurrency();
-  return NumPhysical;
+    return std::min(thread::hardware_concurrency(), Budget);
+  return std::min(unsigned(NumPhysical), Budget);
 }
@@ -0,0 +1,275 @@
+//===- TimeTrace.cpp - Chrome trace of compile time -----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the time trace written by -time-passes-trace.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeTrace.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> TimeTraceFile(
+    "time-passes-trace", cl::value_desc("filename"),
+    cl::desc("Write a Chrome trace of the time spent in each pass, and of the "
+             "memory it allocated, to the given file on exit"));
+
+namespace {
+
+struct TraceEvent {
+  std::string Name;
+  std::string Detail;
+  uint64_t StartNs;
+  uint64_t DurationNs;
+  uint64_t AllocatedBytes;
+  unsigned ThreadID;
+};
+
+struct AnalysisLookups {
+  uint64_t Hits = 0;
+  uint64_t Misses = 0;
+};
+
+/// Collects the events of all threads. The trace is written when the
+/// recorder is destroyed by llvm_shutdown().
+class TimeTraceRecorder {
+public:
+  TimeTraceRecorder()
+      : Path(TimeTraceFile), Start(std::chrono::steady_clock::now()) {}
+  ~TimeTraceRecorder();
+
+  uint64_t getNanoseconds(std::chrono::steady_clock::time_point T) const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(T - Start)
+        .count();
+  }
+
+  void addEvent(TraceEvent E);
+  void addAnalysisLookup(StringRef Name, bool Cached);
+  void write(raw_ostream &OS);
+
+private:
+  unsigned getThreadID();
+
+  std::string Path;
+  std::chrono::steady_clock::time_point Start;
+  std::mutex Mutex;
+  std::vector<TraceEvent> Events;
+  std::map<std::thread::id, unsigned> ThreadIDs;
+  StringMap<AnalysisLookups> Lookups;
+};
+
+} // end anonymous namespace
+
+static ManagedStatic<TimeTraceRecorder> Recorder;
+
+TimeTraceRecorder::~TimeTraceRecorder() {
+  if (Path.empty())
+    return;
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << "Error opening time trace file '" << Path
+           << "': " << EC.message() << '\n';
+    return;
+  }
+  write(OS);
+}
+
+unsigned TimeTraceRecorder::getThreadID() {
+  auto Inserted =
+      ThreadIDs.insert(std::make_pair(std::this_thread::get_id(), 0u));
+  if (Inserted.second)
+    Inserted.first->second = ThreadIDs.size() - 1;
+  return Inserted.first->second;
+}
+
+void TimeTraceRecorder::addEvent(TraceEvent E) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  E.ThreadID = getThreadID();
+  Events.push_back(std::move(E));
+}
+
+void TimeTraceRecorder::addAnalysisLookup(StringRef Name, bool Cached) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  AnalysisLookups &L = Lookups[Name];
+  if (Cached)
+    ++L.Hits;
+  else
+    ++L.Misses;
+}
+
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+static void writeMicroseconds(raw_ostream &OS, uint64_t Ns) {
+  OS << Ns / 1000 << '.' << format("%03u", unsigned(Ns % 1000));
+}
+
+TraceEventWriter::TraceEventWriter(raw_ostream &OS) : OS(OS) {
+  OS << "{\"traceEvents\":[\n";
+}
+
+void TraceEventWriter::beginEvent(StringRef Phase, unsigned ThreadID,
+                                  uint64_t TimeNs) {
+  OS << (First ? "" : ",\n") << "{\"ph\":\"" << Phase
+     << "\",\"pid\":1,\"tid\":" << ThreadID << ",\"ts\":";
+  writeMicroseconds(OS, TimeNs);
+  First = false;
+}
+
+void TraceEventWriter::writeObject(StringRef Key,
+                                   ArrayRef<TraceEventArg> Members) {
+  writeJSONString(OS, Key);
+  OS << ":{";
+  for (const TraceEventArg &Member : Members) {
+    if (&Member != Members.begin())
+      OS << ',';
+    writeJSONString(OS, Member.Key);
+    OS << ':';
+    if (Member.IsString)
+      writeJSONString(OS, Member.Value);
+    else
+      OS << Member.Value;
+  }
+  OS << '}';
+}
+
+void TraceEventWriter::writeComplete(StringRef Name, unsigned ThreadID,
+                                     uint64_t StartNs, uint64_t DurationNs,
+                                     ArrayRef<TraceEventArg> Args) {
+  beginEvent("X", ThreadID, StartNs);
+  OS << ",\"dur\":";
+  writeMicroseconds(OS, DurationNs);
+  OS << ",\"name\":";
+  writeJSONString(OS, Name);
+  if (!Args.empty()) {
+    OS << ',';
+    writeObject("args", Args);
+  }
+  OS << '}';
+}
+
+void TraceEventWriter::writeCounter(StringRef Name, unsigned ThreadID,
+                                    uint64_t TimeNs,
+                                    ArrayRef<TraceEventArg> Args) {
+  beginEvent("C", ThreadID, TimeNs);
+  OS << ",\"name\":";
+  writeJSONString(OS, Name);
+  if (!Args.empty()) {
+    OS << ',';
+    writeObject("args", Args);
+  }
+  OS << '}';
+}
+
+void TraceEventWriter::finish(ArrayRef<TraceEventArg> OtherData) {
+  OS << "\n]";
+  if (!OtherData.empty()) {
+    OS << ",\n";
+    writeObject("otherData", OtherData);
+  }
+  OS << "}\n";
+}
+
+void TimeTraceRecorder::write(raw_ostream &OS) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  uint64_t EndNs = getNanoseconds(std::chrono::steady_clock::now());
+
+  TraceEventWriter Writer(OS);
+  for (const TraceEvent &E : Events)
+    Writer.writeComplete(E.Name, E.ThreadID, E.StartNs, E.DurationNs,
+                         {TraceEventArg("detail", E.Detail),
+                          TraceEventArg("allocated bytes", E.AllocatedBytes)});
+
+  // The analysis cache counters are reported once, at the end of the trace,
+  // in the order of the analysis names.
+  std::vector<const StringMapEntry<AnalysisLookups> *> SortedLookups;
+  for (const auto &L : Lookups)
+    SortedLookups.push_back(&L);
+  std::sort(SortedLookups.begin(), SortedLookups.end(),
+            [](const StringMapEntry<AnalysisLookups> *A,
+               const StringMapEntry<AnalysisLookups> *B) {
+              return A->getKey() < B->getKey();
+            });
+  for (const auto *L : SortedLookups)
+    Writer.writeCounter(L->getKey(), 0, EndNs,
+                        {TraceEventArg("hits", L->second.Hits),
+                         TraceEventArg("misses", L->second.Misses)});
+  Writer.finish();
+}
+
+bool llvm::isTimeTraceEnabled() { return !TimeTraceFile.empty(); }
+
+void llvm::recordTimeTraceAnalysisLookup(StringRef AnalysisName,
+                                         bool Cached) {
+  if (isTimeTraceEnabled())
+    Recorder->addAnalysisLookup(AnalysisName, Cached);
+}
+
+void llvm::writeTimeTrace(raw_ostream &OS) { Recorder->write(OS); }
+
+TimeTraceScope::TimeTraceScope(StringRef Name, StringRef Detail)
+    : Enabled(isTimeTraceEnabled()) {
+  if (Enabled)
+    begin(Name, Detail);
+}
+
+TimeTraceScope::TimeTraceScope(StringRef Name,
+                               function_ref<std::string()> Detail)
+    : Enabled(isTimeTraceEnabled()) {
+  if (Enabled)
+    begin(Name, Detail());
+}
+
+void TimeTraceScope::begin(StringRef Name, std::string Detail) {
+  // Create the recorder before taking the start time, so that the first event
+  // does not start before the trace.
+  (void)*Recorder;
+  this->Name = Name;
+  this->Detail = std::move(Detail);
+  StartAllocatedBytes = getBumpPtrAllocatorSlabBytes();
+  Start = std::chrono::steady_clock::now();
+}
+
+TimeTraceScope::~TimeTraceScope() {
+  if (!Enabled)
+    return;
+  auto End = std::chrono::steady_clock::now();
+  TraceEvent E;
+  E.Name = std::move(Name);
+  E.Detail = std::move(Detail);
+  E.StartNs = Recorder->getNanoseconds(Start);
+  E.DurationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     End - Start).count();
+  E.AllocatedBytes = getBumpPtrAllocatorSlabBytes() - StartAllocatedBytes;
+  E.ThreadID = 0;
+  Recorder->addEvent(std::move(E));
+}
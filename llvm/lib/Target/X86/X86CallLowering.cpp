@@ -14,9 +14,18 @@
 //===----------------------------------------------------------------------===//
 
 #include "X86CallLowering.h"
+#include "X86CallingConv.h"
 #include "X86ISelLowering.h"
 #include "X86InstrInfo.h"
+#include "X86Subtarget.h"
+#include "llvm/CodeGen/Analysis.h"
+#include "llvm/CodeGen/CallingConvLower.h"
 #include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Target/TargetRegisterInfo.h"
 
 using namespace llvm;
 
@@ -24,23 +33,315 @@ using namespace llvm;
 #error "This shouldn't be built without GISel"
 #endif
 
+#include "X86GenCallingConv.inc"
+
 X86CallLowering::X86CallLowering(const X86TargetLowering &TLI)
     : CallLowering(&TLI) {}
 
-bool X86CallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
-                                  const Value *Val, unsigned VReg) const {
-  // TODO: handle functions returning non-void values.
-  if (Val)
+/// Returns whether the arguments and return values of \p F, or of the calls
+/// it makes, can be lowered: handleAssignments uses the calling convention of
+/// the function for both.
+static bool isSupportedCallingConv(const Function &F,
+                                   const X86Subtarget &STI) {
+  return STI.is64Bit() && !STI.isTarget64BitILP32() && !STI.isTargetWin64() &&
+         F.getCallingConv() == CallingConv::C;
+}
+
+namespace {
+struct IncomingValueHandler : public CallLowering::ValueHandler {
+  IncomingValueHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI)
+      : ValueHandler(MIRBuilder, MRI) {}
+
+  unsigned getStackAddress(uint64_t Size, int64_t Offset,
+                           MachinePointerInfo &MPO) override {
+    auto &MFI = MIRBuilder.getMF().getFrameInfo();
+    int FI = MFI.CreateFixedObject(Size, Offset, true);
+    MPO = MachinePointerInfo::getFixedStack(MIRBuilder.getMF(), FI);
+    unsigned AddrReg = MRI.createGenericVirtualRegister(LLT::pointer(0, 64));
+    MIRBuilder.buildFrameIndex(AddrReg, FI);
+    return AddrReg;
+  }
+
+  void assignValueToReg(unsigned ValVReg, unsigned PhysReg,
+                        CCValAssign &VA) override {
+    markPhysRegUsed(PhysReg);
+    if (VA.getLocVT().getSizeInBits() == VA.getValVT().getSizeInBits()) {
+      MIRBuilder.buildCopy(ValVReg, PhysReg);
+      return;
+    }
+    // Promoted values fill the whole location register.
+    unsigned LocReg = MRI.createGenericVirtualRegister(LLT{VA.getLocVT()});
+    MIRBuilder.buildCopy(LocReg, PhysReg);
+    MIRBuilder.buildTrunc(ValVReg, LocReg);
+  }
+
+  void assignValueToAddress(unsigned ValVReg, unsigned Addr, uint64_t Size,
+                            MachinePointerInfo &MPO, CCValAssign &VA) override {
+    auto MMO = MIRBuilder.getMF().getMachineMemOperand(
+        MPO, MachineMemOperand::MOLoad | MachineMemOperand::MOInvariant, Size,
+        0);
+    MIRBuilder.buildLoad(ValVReg, Addr, *MMO);
+  }
+
+  /// How the physical register gets marked varies between formal
+  /// parameters (it's a basic-block live-in), and a call instruction
+  /// (it's an implicit-def of the CALL).
+  virtual void markPhysRegUsed(unsigned PhysReg) = 0;
+};
+
+struct FormalArgHandler : public IncomingValueHandler {
+  FormalArgHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI)
+      : IncomingValueHandler(MIRBuilder, MRI) {}
+
+  void markPhysRegUsed(unsigned PhysReg) override {
+    MIRBuilder.getMBB().addLiveIn(PhysReg);
+  }
+};
+
+struct CallReturnHandler : public IncomingValueHandler {
+  CallReturnHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI,
+                    MachineInstrBuilder MIB)
+      : IncomingValueHandler(MIRBuilder, MRI), MIB(MIB) {}
+
+  void markPhysRegUsed(unsigned PhysReg) override {
+    MIB.addDef(PhysReg, RegState::Implicit);
+  }
+
+  MachineInstrBuilder MIB;
+};
+
+struct OutgoingValueHandler : public CallLowering::ValueHandler {
+  OutgoingValueHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI,
+                       MachineInstrBuilder MIB)
+      : ValueHandler(MIRBuilder, MRI), MIB(MIB), StackSize(0) {}
+
+  unsigned getStackAddress(uint64_t Size, int64_t Offset,
+                           MachinePointerInfo &MPO) override {
+    LLT p0 = LLT::pointer(0, 64);
+    LLT s64 = LLT::scalar(64);
+    unsigned SPReg = MRI.createGenericVirtualRegister(p0);
+    MIRBuilder.buildCopy(SPReg, X86::RSP);
+
+    unsigned OffsetReg = MRI.createGenericVirtualRegister(s64);
+    MIRBuilder.buildConstant(OffsetReg, Offset);
+
+    unsigned AddrReg = MRI.createGenericVirtualRegister(p0);
+    MIRBuilder.buildGEP(AddrReg, SPReg, OffsetReg);
+
+    MPO = MachinePointerInfo::getStack(MIRBuilder.getMF(), Offset);
+    StackSize = std::max(StackSize, Offset + Size);
+    return AddrReg;
+  }
+
+  void assignValueToReg(unsigned ValVReg, unsigned PhysReg,
+                        CCValAssign &VA) override {
+    MIB.addUse(PhysReg, RegState::Implicit);
+    unsigned ExtReg;
+    if (VA.getLocInfo() == CCValAssign::AExt &&
+        VA.getLocVT().getSizeInBits() != VA.getValVT().getSizeInBits()) {
+      // The copy to the location register must not change the size.
+      ExtReg = MRI.createGenericVirtualRegister(LLT{VA.getLocVT()});
+      MIRBuilder.buildAnyExt(ExtReg, ValVReg);
+    } else
+      ExtReg = extendRegister(ValVReg, VA);
+    MIRBuilder.buildCopy(PhysReg, ExtReg);
+  }
+
+  void assignValueToAddress(unsigned ValVReg, unsigned Addr, uint64_t Size,
+                            MachinePointerInfo &MPO, CCValAssign &VA) override {
+    auto MMO = MIRBuilder.getMF().getMachineMemOperand(
+        MPO, MachineMemOperand::MOStore, Size, 0);
+    MIRBuilder.buildStore(ValVReg, Addr, *MMO);
+  }
+
+  MachineInstrBuilder MIB;
+
+  /// Size of the outgoing arguments passed on the stack.
+  uint64_t StackSize;
+};
+} // end anonymous namespace
+
+bool X86CallLowering::splitToValueTypes(const ArgInfo &OrigArg,
+                                        SmallVectorImpl<ArgInfo> &SplitArgs,
+                                        const DataLayout &DL) const {
+  const ISD::ArgFlagsTy &Flags = OrigArg.Flags;
+  if (Flags.isByVal() || Flags.isInAlloca() || Flags.isNest() ||
+      Flags.isSRet() || Flags.isInReg() || Flags.isSwiftSelf() ||
+      Flags.isSwiftError())
     return false;
 
-  MIRBuilder.buildInstr(X86::RET).addImm(0);
+  const X86TargetLowering &TLI = *getTLI<X86TargetLowering>();
+  SmallVector<EVT, 4> SplitVTs;
+  ComputeValueVTs(TLI, DL, OrigArg.Ty, SplitVTs);
+
+  // FIXME: Support aggregates, vectors, and values that don't fit in a single
+  // register.
+  if (SplitVTs.size() != 1)
+    return false;
+  EVT VT = SplitVTs[0];
+  if (!(VT.isScalarInteger() && VT.getSizeInBits() <= 64) && VT != MVT::f32 &&
+      VT != MVT::f64)
+    return false;
 
+  // Replace the original type, e.g. a pointer by the integer it is passed as.
+  Type *Ty = VT.getTypeForEVT(OrigArg.Ty->getContext());
+  SplitArgs.emplace_back(OrigArg.Reg, Ty, OrigArg.Flags);
   return true;
 }
 
+bool X86CallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
+                                  const Value *Val, unsigned VReg) const {
+  auto MIB = MIRBuilder.buildInstrNoInsert(X86::RET).addImm(0);
+  assert(((Val && VReg) || (!Val && !VReg)) && "Return value without a vreg");
+  bool Success = true;
+  if (VReg) {
+    MachineFunction &MF = MIRBuilder.getMF();
+    const Function &F = *MF.getFunction();
+    if (!isSupportedCallingConv(F, MF.getSubtarget<X86Subtarget>()))
+      return false;
+
+    MachineRegisterInfo &MRI = MF.getRegInfo();
+    auto &DL = F.getParent()->getDataLayout();
+
+    ArgInfo OrigArg{VReg, Val->getType()};
+    setArgFlags(OrigArg, AttributeSet::ReturnIndex, DL, F);
+
+    SmallVector<ArgInfo, 1> SplitArgs;
+    OutgoingValueHandler Handler(MIRBuilder, MRI, MIB);
+    Success = splitToValueTypes(OrigArg, SplitArgs, DL) &&
+              handleAssignments(MIRBuilder, RetCC_X86, SplitArgs, Handler);
+  }
+
+  MIRBuilder.insertInstr(MIB);
+  return Success;
+}
+
 bool X86CallLowering::lowerFormalArguments(MachineIRBuilder &MIRBuilder,
                                            const Function &F,
                                            ArrayRef<unsigned> VRegs) const {
-  // TODO: handle functions with one or more arguments.
-  return F.arg_empty();
+  if (F.arg_empty())
+    return true;
+
+  MachineFunction &MF = MIRBuilder.getMF();
+  if (F.isVarArg() ||
+      !isSupportedCallingConv(F, MF.getSubtarget<X86Subtarget>()))
+    return false;
+
+  MachineBasicBlock &MBB = MIRBuilder.getMBB();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  auto &DL = F.getParent()->getDataLayout();
+
+  SmallVector<ArgInfo, 8> SplitArgs;
+  unsigned i = 0;
+  for (auto &Arg : F.getArgumentList()) {
+    ArgInfo OrigArg{VRegs[i], Arg.getType()};
+    setArgFlags(OrigArg, i + 1, DL, F);
+    if (!splitToValueTypes(OrigArg, SplitArgs, DL))
+      return false;
+    ++i;
+  }
+
+  if (!MBB.empty())
+    MIRBuilder.setInstr(*MBB.begin());
+
+  FormalArgHandler Handler(MIRBuilder, MRI);
+  if (!handleAssignments(MIRBuilder, CC_X86, SplitArgs, Handler))
+    return false;
+
+  // Move back to the end of the basic block.
+  MIRBuilder.setMBB(MBB);
+
+  return true;
+}
+
+bool X86CallLowering::lowerCall(MachineIRBuilder &MIRBuilder,
+                                const CallInst &CI, unsigned ResReg,
+                                ArrayRef<unsigned> ArgRegs,
+                                std::function<unsigned()> GetCalleeReg) const {
+  // Variadic calls pass the number of vector registers they use in AL, which
+  // the generic interface doesn't tell.
+  if (CI.getFunctionType()->isVarArg() ||
+      CI.getCallingConv() != CallingConv::C)
+    return false;
+  return CallLowering::lowerCall(MIRBuilder, CI, ResReg, ArgRegs,
+                                 GetCalleeReg);
+}
+
+bool X86CallLowering::lowerCall(MachineIRBuilder &MIRBuilder,
+                                const MachineOperand &Callee,
+                                const ArgInfo &OrigRet,
+                                ArrayRef<ArgInfo> OrigArgs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  const Function &F = *MF.getFunction();
+  const X86Subtarget &STI = MF.getSubtarget<X86Subtarget>();
+  if (!isSupportedCallingConv(F, STI))
+    return false;
+
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  auto &DL = F.getParent()->getDataLayout();
+
+  SmallVector<ArgInfo, 8> SplitArgs;
+  for (auto &OrigArg : OrigArgs)
+    if (!splitToValueTypes(OrigArg, SplitArgs, DL))
+      return false;
+
+  // Direct calls go through the PLT when the callee may be preempted.
+  MachineOperand CalleeOp = Callee;
+  if (CalleeOp.isGlobal()) {
+    unsigned char OpFlags =
+        STI.classifyGlobalFunctionReference(CalleeOp.getGlobal());
+    if (OpFlags != X86II::MO_NO_FLAG && OpFlags != X86II::MO_PLT)
+      return false;
+    CalleeOp.setTargetFlags(OpFlags);
+  }
+
+  // The size of the outgoing arguments is patched in once they are lowered.
+  auto CallSeqStart =
+      MIRBuilder.buildInstr(X86::ADJCALLSTACKDOWN64).addImm(0).addImm(0);
+
+  // Create a temporarily-floating call instruction so we can add the implicit
+  // uses of arg registers.
+  auto MIB = MIRBuilder.buildInstrNoInsert(
+      CalleeOp.isReg() ? X86::CALL64r : X86::CALL64pcrel32);
+  MIB.addOperand(CalleeOp);
+
+  // Tell the call which registers are clobbered.
+  const TargetRegisterInfo *TRI = STI.getRegisterInfo();
+  MIB.addRegMask(TRI->getCallPreservedMask(MF, F.getCallingConv()));
+
+  // Do the actual argument marshalling.
+  OutgoingValueHandler Handler(MIRBuilder, MRI, MIB);
+  if (!handleAssignments(MIRBuilder, CC_X86, SplitArgs, Handler))
+    return false;
+  CallSeqStart->getOperand(0).setImm(Handler.StackSize);
+
+  // Now we can add the actual call instruction to the correct basic block.
+  MIRBuilder.insertInstr(MIB);
+
+  // If Callee is a reg, since it is used by a target specific
+  // instruction, it must have a register class matching the
+  // constraint of that instruction.
+  if (CalleeOp.isReg())
+    MIB->getOperand(0).setReg(constrainOperandRegClass(
+        MF, *TRI, MRI, *STI.getInstrInfo(), *STI.getRegBankInfo(), *MIB,
+        MIB->getDesc(), CalleeOp.getReg(), 0));
+
+  MIRBuilder.buildInstr(X86::ADJCALLSTACKUP64)
+      .addImm(Handler.StackSize)
+      .addImm(0);
+
+  // Finally we can copy the returned value back into its virtual-register. In
+  // symmetry with the arguments, the physical register must be an
+  // implicit-define of the call instruction.
+  if (OrigRet.Reg) {
+    SplitArgs.clear();
+    if (!splitToValueTypes(OrigRet, SplitArgs, DL))
+      return false;
+
+    CallReturnHandler RetHandler(MIRBuilder, MRI, MIB);
+    if (!handleAssignments(MIRBuilder, RetCC_X86, SplitArgs, RetHandler))
+      return false;
+  }
+
+  return true;
 }
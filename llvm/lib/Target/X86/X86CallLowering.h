@@ -20,11 +20,15 @@
 
 namespace llvm {
 
+class DataLayout;
 class Function;
 class MachineIRBuilder;
 class X86TargetLowering;
 class Value;
 
+/// Lowers arguments, returns and calls of the C calling convention of the
+/// x86-64 System V ABI. Anything else, such as aggregates, variadic functions
+/// or byval arguments, is left to SelectionDAG.
 class X86CallLowering : public CallLowering {
 public:
   X86CallLowering(const X86TargetLowering &TLI);
@@ -34,6 +38,22 @@ public:
 
   bool lowerFormalArguments(MachineIRBuilder &MIRBuilder, const Function &F,
                             ArrayRef<unsigned> VRegs) const override;
+
+  bool lowerCall(MachineIRBuilder &MIRBuilder, const MachineOperand &Callee,
+                 const ArgInfo &OrigRet,
+                 ArrayRef<ArgInfo> OrigArgs) const override;
+
+  bool lowerCall(MachineIRBuilder &MIRBuilder, const CallInst &CI,
+                 unsigned ResReg, ArrayRef<unsigned> ArgRegs,
+                 std::function<unsigned()> GetCalleeReg) const override;
+
+private:
+  /// Append to \p SplitArgs the argument \p OrigArg with its IR type replaced
+  /// by the type of the single register it is passed in. Returns false if the
+  /// argument needs several registers or a special treatment.
+  bool splitToValueTypes(const ArgInfo &OrigArg,
+                         SmallVectorImpl<ArgInfo> &SplitArgs,
+                         const DataLayout &DL) const;
 };
 } // End of namespace llvm;
 #endif
@@ -0,0 +1,899 @@
+//===- X86InstructionSelector.cpp --------------------------------*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the targeting of the InstructionSelector class for
+/// X86.
+/// \todo This should be generated by TableGen.
+//===----------------------------------------------------------------------===//
+
+#include "X86InstructionSelector.h"
+#include "X86InstrBuilder.h"
+#include "X86InstrInfo.h"
+#include "X86RegisterBankInfo.h"
+#include "X86RegisterInfo.h"
+#include "X86Subtarget.h"
+#include "X86TargetMachine.h"
+#include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Type.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "x86-isel"
+
+using namespace llvm;
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "You shouldn't build this"
+#endif
+
+#include "X86GenGlobalISel.inc"
+
+X86InstructionSelector::X86InstructionSelector(const X86TargetMachine &TM,
+                                               const X86Subtarget &STI,
+                                               const X86RegisterBankInfo &RBI)
+    : InstructionSelector(), TM(TM), STI(STI), TII(*STI.getInstrInfo()),
+      TRI(*STI.getRegisterInfo()), RBI(RBI) {}
+
+// FIXME: This should be target-independent, inferred from the types declared
+// for each class in the bank.
+static const TargetRegisterClass *
+getRegClassForTypeOnBank(LLT Ty, const RegisterBank &RB) {
+  if (RB.getID() == X86::GPRRegBankID) {
+    if (Ty.getSizeInBits() <= 8)
+      return &X86::GR8RegClass;
+    if (Ty.getSizeInBits() == 16)
+      return &X86::GR16RegClass;
+    if (Ty.getSizeInBits() == 32)
+      return &X86::GR32RegClass;
+    if (Ty.getSizeInBits() == 64)
+      return &X86::GR64RegClass;
+    return nullptr;
+  }
+
+  if (RB.getID() == X86::VECRRegBankID) {
+    if (Ty.getSizeInBits() == 32)
+      return &X86::FR32RegClass;
+    if (Ty.getSizeInBits() == 64)
+      return &X86::FR64RegClass;
+    if (Ty.getSizeInBits() == 128)
+      return &X86::VR128RegClass;
+    return nullptr;
+  }
+
+  return nullptr;
+}
+
+/// Returns the register class matching the type and bank of the generic
+/// virtual register \p Reg, or nullptr if there is none.
+static const TargetRegisterClass *
+getRegClassForReg(unsigned Reg, const MachineRegisterInfo &MRI,
+                  const TargetRegisterInfo &TRI, const RegisterBankInfo &RBI) {
+  const RegisterBank *RB = RBI.getRegBank(Reg, MRI, TRI);
+  if (!RB)
+    return nullptr;
+  return getRegClassForTypeOnBank(MRI.getType(Reg), *RB);
+}
+
+/// Returns the index of the sub-register of a GPR that \p RC is the class of.
+static unsigned getSubRegIndex(const TargetRegisterClass *RC) {
+  if (RC == &X86::GR8RegClass)
+    return X86::sub_8bit;
+  if (RC == &X86::GR16RegClass)
+    return X86::sub_16bit;
+  if (RC == &X86::GR32RegClass)
+    return X86::sub_32bit;
+  return 0;
+}
+
+static std::pair<X86::CondCode, bool>
+getX86ConditionCode(CmpInst::Predicate Predicate) {
+  X86::CondCode CC = X86::COND_INVALID;
+  bool NeedSwap = false;
+  switch (Predicate) {
+  default: break;
+  // Floating-point Predicates
+  case CmpInst::FCMP_UEQ: CC = X86::COND_E;       break;
+  case CmpInst::FCMP_OLT: NeedSwap = true;        LLVM_FALLTHROUGH;
+  case CmpInst::FCMP_OGT: CC = X86::COND_A;       break;
+  case CmpInst::FCMP_OLE: NeedSwap = true;        LLVM_FALLTHROUGH;
+  case CmpInst::FCMP_OGE: CC = X86::COND_AE;      break;
+  case CmpInst::FCMP_UGT: NeedSwap = true;        LLVM_FALLTHROUGH;
+  case CmpInst::FCMP_ULT: CC = X86::COND_B;       break;
+  case CmpInst::FCMP_UGE: NeedSwap = true;        LLVM_FALLTHROUGH;
+  case CmpInst::FCMP_ULE: CC = X86::COND_BE;      break;
+  case CmpInst::FCMP_ONE: CC = X86::COND_NE;      break;
+  case CmpInst::FCMP_UNO: CC = X86::COND_P;       break;
+  case CmpInst::FCMP_ORD: CC = X86::COND_NP;      break;
+
+  // Integer Predicates
+  case CmpInst::ICMP_EQ:  CC = X86::COND_E;       break;
+  case CmpInst::ICMP_NE:  CC = X86::COND_NE;      break;
+  case CmpInst::ICMP_UGT: CC = X86::COND_A;       break;
+  case CmpInst::ICMP_UGE: CC = X86::COND_AE;      break;
+  case CmpInst::ICMP_ULT: CC = X86::COND_B;       break;
+  case CmpInst::ICMP_ULE: CC = X86::COND_BE;      break;
+  case CmpInst::ICMP_SGT: CC = X86::COND_G;       break;
+  case CmpInst::ICMP_SGE: CC = X86::COND_GE;      break;
+  case CmpInst::ICMP_SLT: CC = X86::COND_L;       break;
+  case CmpInst::ICMP_SLE: CC = X86::COND_LE;      break;
+  }
+
+  return std::make_pair(CC, NeedSwap);
+}
+
+/// Select the load or store opcode for a value of \p Size bits on the bank
+/// \p RegBankID, or return 0 if there is none.
+static unsigned selectLoadStoreOp(bool IsLoad, unsigned RegBankID,
+                                  unsigned Size, bool HasAVX) {
+  if (RegBankID == X86::GPRRegBankID) {
+    switch (Size) {
+    case 8:
+      return IsLoad ? X86::MOV8rm : X86::MOV8mr;
+    case 16:
+      return IsLoad ? X86::MOV16rm : X86::MOV16mr;
+    case 32:
+      return IsLoad ? X86::MOV32rm : X86::MOV32mr;
+    case 64:
+      return IsLoad ? X86::MOV64rm : X86::MOV64mr;
+    }
+    return 0;
+  }
+
+  if (RegBankID == X86::VECRRegBankID) {
+    switch (Size) {
+    case 32:
+      if (IsLoad)
+        return HasAVX ? X86::VMOVSSrm : X86::MOVSSrm;
+      return HasAVX ? X86::VMOVSSmr : X86::MOVSSmr;
+    case 64:
+      if (IsLoad)
+        return HasAVX ? X86::VMOVSDrm : X86::MOVSDrm;
+      return HasAVX ? X86::VMOVSDmr : X86::MOVSDmr;
+    }
+  }
+  return 0;
+}
+
+/// Select the opcode extending a GPR of \p SrcSize bits to \p DstSize bits,
+/// or return 0 if there is no single instruction for it.
+static unsigned selectExtOp(bool IsSigned, unsigned DstSize,
+                            unsigned SrcSize) {
+  switch (SrcSize) {
+  case 8:
+    if (DstSize == 16)
+      return IsSigned ? X86::MOVSX16rr8 : X86::MOVZX16rr8;
+    if (DstSize == 32)
+      return IsSigned ? X86::MOVSX32rr8 : X86::MOVZX32rr8;
+    if (DstSize == 64)
+      return IsSigned ? X86::MOVSX64rr8 : X86::MOVZX64rr8;
+    return 0;
+  case 16:
+    if (DstSize == 32)
+      return IsSigned ? X86::MOVSX32rr16 : X86::MOVZX32rr16;
+    if (DstSize == 64)
+      return IsSigned ? X86::MOVSX64rr16 : X86::MOVZX64rr16;
+    return 0;
+  case 32:
+    // Zero-extensions from 32 bits are implicit in 32-bit moves.
+    if (DstSize == 64 && IsSigned)
+      return X86::MOVSX64rr32;
+    return 0;
+  }
+  return 0;
+}
+
+bool X86InstructionSelector::selectCopy(MachineInstr &I,
+                                        MachineRegisterInfo &MRI) const {
+  unsigned DstReg = I.getOperand(0).getReg();
+  if (TargetRegisterInfo::isPhysicalRegister(DstReg)) {
+    assert(I.isCopy() && "Generic operators do not allow physical registers");
+    return true;
+  }
+
+  // No need to constrain SrcReg. It will get constrained when
+  // we hit another of its use or its defs.
+  // Copies do not have constraints.
+  const TargetRegisterClass *RC = getRegClassForReg(DstReg, MRI, TRI, RBI);
+  if (!RC || !RBI.constrainGenericRegister(DstReg, *RC, MRI)) {
+    DEBUG(dbgs() << "Failed to constrain " << TII.getName(I.getOpcode())
+                 << " operand\n");
+    return false;
+  }
+  I.setDesc(TII.get(X86::COPY));
+  return true;
+}
+
+bool X86InstructionSelector::select(MachineInstr &I) const {
+  assert(I.getParent() && "Instruction should be in a basic block!");
+  assert(I.getParent()->getParent() && "Instruction should be in a function!");
+
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineFunction &MF = *MBB.getParent();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+
+  unsigned Opcode = I.getOpcode();
+  if (!isPreISelGenericOpcode(Opcode)) {
+    // Certain non-generic instructions also need some special handling.
+
+    if (Opcode == TargetOpcode::PHI || Opcode == TargetOpcode::IMPLICIT_DEF) {
+      const unsigned DefReg = I.getOperand(0).getReg();
+      if (TargetRegisterInfo::isPhysicalRegister(DefReg) ||
+          MRI.getRegClassOrRegBank(DefReg)
+              .dyn_cast<const TargetRegisterClass *>())
+        return true;
+
+      const TargetRegisterClass *DefRC =
+          getRegClassForReg(DefReg, MRI, TRI, RBI);
+      if (!DefRC) {
+        DEBUG(dbgs() << "PHI operand has unexpected size/bank\n");
+        return false;
+      }
+      return RBI.constrainGenericRegister(DefReg, *DefRC, MRI);
+    }
+
+    if (I.isCopy())
+      return selectCopy(I, MRI);
+
+    return true;
+  }
+
+  if (I.getNumOperands() != I.getNumExplicitOperands()) {
+    DEBUG(dbgs() << "Generic instruction has unexpected implicit operands\n");
+    return false;
+  }
+
+  if (selectImpl(I))
+    return true;
+
+  const DebugLoc &DL = I.getDebugLoc();
+
+  switch (Opcode) {
+  case TargetOpcode::G_CONSTANT:
+    return selectConstant(I, MRI);
+  case TargetOpcode::G_FCONSTANT:
+    return selectFConstant(I, MRI);
+  case TargetOpcode::G_GLOBAL_VALUE:
+    return selectGlobalValue(I, MRI);
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_STORE:
+    return selectLoadStore(I, MRI);
+  case TargetOpcode::G_TRUNC:
+    return selectTrunc(I, MRI);
+  case TargetOpcode::G_ZEXT:
+  case TargetOpcode::G_SEXT:
+  case TargetOpcode::G_ANYEXT:
+    return selectExt(I, MRI);
+  case TargetOpcode::G_ICMP:
+  case TargetOpcode::G_FCMP:
+    return selectCmp(I, MRI);
+  case TargetOpcode::G_SELECT:
+    return selectSelect(I, MRI);
+  case TargetOpcode::G_SHL:
+  case TargetOpcode::G_LSHR:
+  case TargetOpcode::G_ASHR:
+    return selectShift(I, MRI);
+  case TargetOpcode::G_SDIV:
+  case TargetOpcode::G_UDIV:
+  case TargetOpcode::G_SREM:
+  case TargetOpcode::G_UREM:
+    return selectDivRem(I, MRI);
+  case TargetOpcode::G_SITOFP:
+  case TargetOpcode::G_UITOFP:
+  case TargetOpcode::G_FPTOSI:
+  case TargetOpcode::G_FPTOUI:
+  case TargetOpcode::G_FPEXT:
+  case TargetOpcode::G_FPTRUNC:
+    return selectFPConv(I, MRI);
+
+  case TargetOpcode::G_PTRTOINT:
+  case TargetOpcode::G_INTTOPTR:
+  case TargetOpcode::G_BITCAST:
+    // The operands are on the same bank and have the same size, anything
+    // else was turned into a cross-bank copy by RegBankSelect.
+    if (RBI.getRegBank(I.getOperand(0).getReg(), MRI, TRI) !=
+        RBI.getRegBank(I.getOperand(1).getReg(), MRI, TRI))
+      return false;
+    return selectCopy(I, MRI);
+
+  case TargetOpcode::G_FRAME_INDEX:
+    // The frame index is the base of the address, as in addFrameReference.
+    I.setDesc(TII.get(X86::LEA64r));
+    MachineInstrBuilder(MF, &I).addImm(1).addReg(0).addImm(0).addReg(0);
+    return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
+
+  case TargetOpcode::G_GEP: {
+    MachineInstr &LEA =
+        *BuildMI(MBB, I, DL, TII.get(X86::LEA64r), I.getOperand(0).getReg())
+             .addReg(I.getOperand(1).getReg())
+             .addImm(1)
+             .addReg(I.getOperand(2).getReg())
+             .addImm(0)
+             .addReg(0);
+    I.eraseFromParent();
+    return constrainSelectedInstRegOperands(LEA, TII, TRI, RBI);
+  }
+
+  case TargetOpcode::G_BRCOND: {
+    const unsigned CondReg = I.getOperand(0).getReg();
+    MachineBasicBlock *DestMBB = I.getOperand(1).getMBB();
+
+    // Only the low bit of the condition is defined.
+    MachineInstr &Test = *BuildMI(MBB, I, DL, TII.get(X86::TEST8ri))
+                              .addReg(CondReg)
+                              .addImm(1);
+    BuildMI(MBB, I, DL, TII.get(X86::JNE_1)).addMBB(DestMBB);
+    I.eraseFromParent();
+    return constrainSelectedInstRegOperands(Test, TII, TRI, RBI);
+  }
+
+  default:
+    return false;
+  }
+}
+
+bool X86InstructionSelector::selectConstant(MachineInstr &I,
+                                            MachineRegisterInfo &MRI) const {
+  const unsigned DstReg = I.getOperand(0).getReg();
+  if (RBI.getRegBank(DstReg, MRI, TRI)->getID() != X86::GPRRegBankID)
+    return false;
+
+  int64_t Val;
+  const MachineOperand &ValOp = I.getOperand(1);
+  if (ValOp.isCImm())
+    Val = ValOp.getCImm()->getSExtValue();
+  else if (ValOp.isImm())
+    Val = ValOp.getImm();
+  else
+    return false;
+
+  unsigned Opc;
+  switch (MRI.getType(DstReg).getSizeInBits()) {
+  case 8:
+    Opc = X86::MOV8ri;
+    break;
+  case 16:
+    Opc = X86::MOV16ri;
+    break;
+  case 32:
+    Opc = X86::MOV32ri;
+    break;
+  case 64:
+    // A sign-extended 32-bit immediate has a shorter encoding.
+    Opc = isInt<32>(Val) ? X86::MOV64ri32 : X86::MOV64ri;
+    break;
+  default:
+    return false;
+  }
+
+  I.setDesc(TII.get(Opc));
+  I.getOperand(1).ChangeToImmediate(Val);
+  return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectFConstant(MachineInstr &I,
+                                             MachineRegisterInfo &MRI) const {
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned Size = MRI.getType(DstReg).getSizeInBits();
+  if (Size != 32 && Size != 64)
+    return false;
+
+  // Materialize the bits in a GPR and move them to the XMM register, rather
+  // than loading them from the constant pool.
+  int64_t Val =
+      I.getOperand(1).getFPImm()->getValueAPF().bitcastToAPInt().getSExtValue();
+  unsigned Opc;
+  const TargetRegisterClass *GPRC, *FPRC;
+  if (Size == 32) {
+    Opc = X86::MOV32ri;
+    GPRC = &X86::GR32RegClass;
+    FPRC = &X86::FR32RegClass;
+  } else {
+    Opc = isInt<32>(Val) ? X86::MOV64ri32 : X86::MOV64ri;
+    GPRC = &X86::GR64RegClass;
+    FPRC = &X86::FR64RegClass;
+  }
+
+  if (!RBI.constrainGenericRegister(DstReg, *FPRC, MRI))
+    return false;
+
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  unsigned BitsReg = MRI.createVirtualRegister(GPRC);
+  BuildMI(MBB, I, DL, TII.get(Opc), BitsReg).addImm(Val);
+  BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), DstReg).addReg(BitsReg);
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectGlobalValue(MachineInstr &I,
+                                               MachineRegisterInfo &MRI) const {
+  const GlobalValue *GV = I.getOperand(1).getGlobal();
+  if (GV->isThreadLocal() || TM.getCodeModel() != CodeModel::Small)
+    return false;
+
+  // Address the global relative to RIP, or load its address from the GOT.
+  unsigned char OpFlags = STI.classifyGlobalReference(GV);
+  unsigned Opc;
+  if (OpFlags == X86II::MO_NO_FLAG)
+    Opc = X86::LEA64r;
+  else if (OpFlags == X86II::MO_GOTPCREL)
+    Opc = X86::MOV64rm;
+  else
+    return false;
+
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineFunction &MF = *MBB.getParent();
+  MachineInstrBuilder MIB =
+      BuildMI(MBB, I, I.getDebugLoc(), TII.get(Opc), I.getOperand(0).getReg())
+          .addReg(X86::RIP)
+          .addImm(1)
+          .addReg(0)
+          .addGlobalAddress(GV, 0, OpFlags)
+          .addReg(0);
+  if (Opc == X86::MOV64rm)
+    MIB.addMemOperand(MF.getMachineMemOperand(
+        MachinePointerInfo::getGOT(MF),
+        MachineMemOperand::MOLoad | MachineMemOperand::MODereferenceable |
+            MachineMemOperand::MOInvariant,
+        8, 8));
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(*MIB, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectLoadStore(MachineInstr &I,
+                                             MachineRegisterInfo &MRI) const {
+  const bool IsLoad = I.getOpcode() == TargetOpcode::G_LOAD;
+  const unsigned ValReg = I.getOperand(0).getReg();
+  const unsigned PtrReg = I.getOperand(1).getReg();
+
+  if (!I.hasOneMemOperand() || (*I.memoperands_begin())->isAtomic()) {
+    DEBUG(dbgs() << "Atomic load/store not supported yet\n");
+    return false;
+  }
+
+  const RegisterBank &RB = *RBI.getRegBank(ValReg, MRI, TRI);
+  const unsigned Opc =
+      selectLoadStoreOp(IsLoad, RB.getID(), MRI.getType(ValReg).getSizeInBits(),
+                        STI.hasAVX());
+  if (!Opc)
+    return false;
+
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineInstrBuilder MIB =
+      IsLoad ? BuildMI(MBB, I, I.getDebugLoc(), TII.get(Opc), ValReg)
+             : BuildMI(MBB, I, I.getDebugLoc(), TII.get(Opc));
+  addDirectMem(MIB, PtrReg);
+  if (!IsLoad)
+    MIB.addReg(ValReg);
+  MIB.addMemOperand(*I.memoperands_begin());
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(*MIB, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectTrunc(MachineInstr &I,
+                                         MachineRegisterInfo &MRI) const {
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned SrcReg = I.getOperand(1).getReg();
+  const TargetRegisterClass *DstRC = getRegClassForReg(DstReg, MRI, TRI, RBI);
+  const TargetRegisterClass *SrcRC = getRegClassForReg(SrcReg, MRI, TRI, RBI);
+  if (!DstRC || !SrcRC ||
+      RBI.getRegBank(DstReg, MRI, TRI)->getID() != X86::GPRRegBankID ||
+      RBI.getRegBank(SrcReg, MRI, TRI)->getID() != X86::GPRRegBankID)
+    return false;
+
+  // A truncation is a copy of the low sub-register.
+  unsigned SubIdx = 0;
+  if (DstRC != SrcRC) {
+    SubIdx = getSubRegIndex(DstRC);
+    SrcRC = TRI.getSubClassWithSubReg(SrcRC, SubIdx);
+  }
+
+  if (!SrcRC || !RBI.constrainGenericRegister(SrcReg, *SrcRC, MRI) ||
+      !RBI.constrainGenericRegister(DstReg, *DstRC, MRI))
+    return false;
+
+  I.getOperand(1).setSubReg(SubIdx);
+  I.setDesc(TII.get(X86::COPY));
+  return true;
+}
+
+unsigned X86InstructionSelector::emitZExt32To64(MachineInstr &I,
+                                                MachineRegisterInfo &MRI,
+                                                unsigned Reg) const {
+  // A 32-bit move clears the upper half of the 64-bit register.
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  unsigned Reg32 = MRI.createVirtualRegister(&X86::GR32RegClass);
+  BuildMI(MBB, I, DL, TII.get(X86::MOV32rr), Reg32).addReg(Reg);
+  unsigned Reg64 = MRI.createVirtualRegister(&X86::GR64RegClass);
+  BuildMI(MBB, I, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Reg64)
+      .addImm(0)
+      .addReg(Reg32)
+      .addImm(X86::sub_32bit);
+  return Reg64;
+}
+
+bool X86InstructionSelector::selectExt(MachineInstr &I,
+                                       MachineRegisterInfo &MRI) const {
+  const unsigned Opcode = I.getOpcode();
+  const unsigned DstReg = I.getOperand(0).getReg();
+  unsigned SrcReg = I.getOperand(1).getReg();
+  const TargetRegisterClass *DstRC = getRegClassForReg(DstReg, MRI, TRI, RBI);
+  const TargetRegisterClass *SrcRC = getRegClassForReg(SrcReg, MRI, TRI, RBI);
+  if (!DstRC || !SrcRC ||
+      RBI.getRegBank(DstReg, MRI, TRI)->getID() != X86::GPRRegBankID ||
+      RBI.getRegBank(SrcReg, MRI, TRI)->getID() != X86::GPRRegBankID)
+    return false;
+
+  if (!RBI.constrainGenericRegister(SrcReg, *SrcRC, MRI) ||
+      !RBI.constrainGenericRegister(DstReg, *DstRC, MRI))
+    return false;
+
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  unsigned DstSize = MRI.getType(DstReg).getSizeInBits();
+  unsigned SrcSize = MRI.getType(SrcReg).getSizeInBits();
+
+  if (Opcode == TargetOpcode::G_ANYEXT) {
+    // The high bits are undefined: insert the value in an undefined register.
+    if (DstRC == SrcRC) {
+      I.setDesc(TII.get(X86::COPY));
+      return true;
+    }
+    unsigned UndefReg = MRI.createVirtualRegister(DstRC);
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::IMPLICIT_DEF), UndefReg);
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::INSERT_SUBREG), DstReg)
+        .addReg(UndefReg)
+        .addReg(SrcReg)
+        .addImm(getSubRegIndex(SrcRC));
+    I.eraseFromParent();
+    return true;
+  }
+
+  const bool IsSigned = Opcode == TargetOpcode::G_SEXT;
+  if (SrcSize == 1) {
+    // Only the low bit of an s1 is defined: clear the others, and for a
+    // sign-extension, negate the result to replicate the low bit.
+    unsigned MaskedReg = MRI.createVirtualRegister(&X86::GR8RegClass);
+    BuildMI(MBB, I, DL, TII.get(X86::AND8ri), MaskedReg)
+        .addReg(SrcReg)
+        .addImm(1);
+    SrcReg = MaskedReg;
+    if (IsSigned) {
+      unsigned NegReg = MRI.createVirtualRegister(&X86::GR8RegClass);
+      BuildMI(MBB, I, DL, TII.get(X86::NEG8r), NegReg).addReg(SrcReg);
+      SrcReg = NegReg;
+    }
+    SrcSize = 8;
+  }
+
+  if (DstSize == SrcSize) {
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), DstReg).addReg(SrcReg);
+  } else if (unsigned Opc = selectExtOp(IsSigned, DstSize, SrcSize)) {
+    BuildMI(MBB, I, DL, TII.get(Opc), DstReg).addReg(SrcReg);
+  } else if (!IsSigned && SrcSize == 32 && DstSize == 64) {
+    unsigned Reg64 = emitZExt32To64(I, MRI, SrcReg);
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), DstReg).addReg(Reg64);
+  } else {
+    return false;
+  }
+
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectCmp(MachineInstr &I,
+                                       MachineRegisterInfo &MRI) const {
+  const bool IsFP = I.getOpcode() == TargetOpcode::G_FCMP;
+  const unsigned DstReg = I.getOperand(0).getReg();
+  auto Pred = static_cast<CmpInst::Predicate>(I.getOperand(1).getPredicate());
+  unsigned LHS = I.getOperand(2).getReg();
+  unsigned RHS = I.getOperand(3).getReg();
+  const unsigned Size = MRI.getType(LHS).getSizeInBits();
+
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+
+  if (Pred == CmpInst::FCMP_FALSE || Pred == CmpInst::FCMP_TRUE) {
+    MachineInstr &Mov = *BuildMI(MBB, I, DL, TII.get(X86::MOV8ri), DstReg)
+                             .addImm(Pred == CmpInst::FCMP_TRUE);
+    I.eraseFromParent();
+    return constrainSelectedInstRegOperands(Mov, TII, TRI, RBI);
+  }
+
+  unsigned CmpOpc;
+  if (IsFP) {
+    if (Size == 32)
+      CmpOpc = STI.hasAVX() ? X86::VUCOMISSrr : X86::UCOMISSrr;
+    else if (Size == 64)
+      CmpOpc = STI.hasAVX() ? X86::VUCOMISDrr : X86::UCOMISDrr;
+    else
+      return false;
+  } else {
+    switch (Size) {
+    case 8:
+      CmpOpc = X86::CMP8rr;
+      break;
+    case 16:
+      CmpOpc = X86::CMP16rr;
+      break;
+    case 32:
+      CmpOpc = X86::CMP32rr;
+      break;
+    case 64:
+      CmpOpc = X86::CMP64rr;
+      break;
+    default:
+      return false;
+    }
+  }
+
+  // FCMP_OEQ and FCMP_UNE cannot be checked with a single instruction.
+  static const uint16_t SETFOpcTable[2][3] = {
+    { X86::SETEr,  X86::SETNPr, X86::AND8rr },
+    { X86::SETNEr, X86::SETPr,  X86::OR8rr  }
+  };
+  const uint16_t *SETFOpc = nullptr;
+  switch (Pred) {
+  default: break;
+  case CmpInst::FCMP_OEQ: SETFOpc = &SETFOpcTable[0][0]; break;
+  case CmpInst::FCMP_UNE: SETFOpc = &SETFOpcTable[1][0]; break;
+  }
+
+  X86::CondCode CC = X86::COND_INVALID;
+  if (!SETFOpc) {
+    bool SwapArgs;
+    std::tie(CC, SwapArgs) = getX86ConditionCode(Pred);
+    if (CC == X86::COND_INVALID)
+      return false;
+    if (SwapArgs)
+      std::swap(LHS, RHS);
+  }
+
+  MachineInstr &Cmp =
+      *BuildMI(MBB, I, DL, TII.get(CmpOpc)).addReg(LHS).addReg(RHS);
+  if (!constrainSelectedInstRegOperands(Cmp, TII, TRI, RBI))
+    return false;
+
+  MachineInstr *Set;
+  if (SETFOpc) {
+    unsigned FlagReg1 = MRI.createVirtualRegister(&X86::GR8RegClass);
+    unsigned FlagReg2 = MRI.createVirtualRegister(&X86::GR8RegClass);
+    BuildMI(MBB, I, DL, TII.get(SETFOpc[0]), FlagReg1);
+    BuildMI(MBB, I, DL, TII.get(SETFOpc[1]), FlagReg2);
+    Set = BuildMI(MBB, I, DL, TII.get(SETFOpc[2]), DstReg)
+              .addReg(FlagReg1)
+              .addReg(FlagReg2);
+  } else {
+    Set = BuildMI(MBB, I, DL, TII.get(X86::getSETFromCond(CC)), DstReg);
+  }
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(*Set, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectSelect(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  const unsigned DstReg = I.getOperand(0).getReg();
+  if (RBI.getRegBank(DstReg, MRI, TRI)->getID() != X86::GPRRegBankID)
+    return false;
+
+  const unsigned Size = MRI.getType(DstReg).getSizeInBits();
+  if (Size != 16 && Size != 32 && Size != 64)
+    return false;
+
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  MachineInstr &Test = *BuildMI(MBB, I, DL, TII.get(X86::TEST8ri))
+                            .addReg(I.getOperand(1).getReg())
+                            .addImm(1);
+  if (!constrainSelectedInstRegOperands(Test, TII, TRI, RBI))
+    return false;
+
+  // The CMOV overwrites the false value when the condition is set.
+  MachineInstr &CMov =
+      *BuildMI(MBB, I, DL, TII.get(X86::getCMovFromCond(X86::COND_NE,
+                                                          Size / 8)),
+               DstReg)
+           .addReg(I.getOperand(3).getReg())
+           .addReg(I.getOperand(2).getReg());
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(CMov, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectShift(MachineInstr &I,
+                                         MachineRegisterInfo &MRI) const {
+  static const uint16_t OpcTable[3][4] = {
+    { X86::SHL8rCL, X86::SHL16rCL, X86::SHL32rCL, X86::SHL64rCL },
+    { X86::SHR8rCL, X86::SHR16rCL, X86::SHR32rCL, X86::SHR64rCL },
+    { X86::SAR8rCL, X86::SAR16rCL, X86::SAR32rCL, X86::SAR64rCL }
+  };
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned AmtReg = I.getOperand(2).getReg();
+  const TargetRegisterClass *AmtRC = getRegClassForReg(AmtReg, MRI, TRI, RBI);
+  if (!AmtRC || !RBI.constrainGenericRegister(AmtReg, *AmtRC, MRI))
+    return false;
+
+  unsigned SizeIdx;
+  switch (MRI.getType(DstReg).getSizeInBits()) {
+  case 8: SizeIdx = 0; break;
+  case 16: SizeIdx = 1; break;
+  case 32: SizeIdx = 2; break;
+  case 64: SizeIdx = 3; break;
+  default: return false;
+  }
+
+  unsigned KindIdx;
+  switch (I.getOpcode()) {
+  default: llvm_unreachable("Unexpected shift");
+  case TargetOpcode::G_SHL: KindIdx = 0; break;
+  case TargetOpcode::G_LSHR: KindIdx = 1; break;
+  case TargetOpcode::G_ASHR: KindIdx = 2; break;
+  }
+
+  // The amount is taken from CL.
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), X86::CL)
+      .addReg(AmtReg, 0, SizeIdx ? X86::sub_8bit : 0);
+  MachineInstr &Shift =
+      *BuildMI(MBB, I, DL, TII.get(OpcTable[KindIdx][SizeIdx]), DstReg)
+           .addReg(I.getOperand(1).getReg());
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(Shift, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectDivRem(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  const unsigned Opcode = I.getOpcode();
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned Size = MRI.getType(DstReg).getSizeInBits();
+  if (Size != 32 && Size != 64)
+    return false;
+
+  const bool Is64 = Size == 64;
+  const bool IsSigned =
+      Opcode == TargetOpcode::G_SDIV || Opcode == TargetOpcode::G_SREM;
+  const bool IsRem =
+      Opcode == TargetOpcode::G_SREM || Opcode == TargetOpcode::G_UREM;
+  const unsigned LowReg = Is64 ? X86::RAX : X86::EAX;
+  const unsigned HighReg = Is64 ? X86::RDX : X86::EDX;
+  const TargetRegisterClass *RC =
+      Is64 ? &X86::GR64RegClass : &X86::GR32RegClass;
+
+  if (!RBI.constrainGenericRegister(DstReg, *RC, MRI))
+    return false;
+
+  // The dividend is in EDX:EAX, the quotient ends up in EAX and the
+  // remainder in EDX.
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), LowReg)
+      .addReg(I.getOperand(1).getReg());
+  if (IsSigned) {
+    BuildMI(MBB, I, DL, TII.get(Is64 ? X86::CQO : X86::CDQ));
+  } else {
+    unsigned ZeroReg = MRI.createVirtualRegister(&X86::GR32RegClass);
+    BuildMI(MBB, I, DL, TII.get(X86::MOV32r0), ZeroReg);
+    if (Is64) {
+      unsigned Zero64Reg = MRI.createVirtualRegister(&X86::GR64RegClass);
+      BuildMI(MBB, I, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Zero64Reg)
+          .addImm(0)
+          .addReg(ZeroReg)
+          .addImm(X86::sub_32bit);
+      ZeroReg = Zero64Reg;
+    }
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), HighReg).addReg(ZeroReg);
+  }
+
+  unsigned DivOpc = IsSigned ? (Is64 ? X86::IDIV64r : X86::IDIV32r)
+                             : (Is64 ? X86::DIV64r : X86::DIV32r);
+  MachineInstr &Div = *BuildMI(MBB, I, DL, TII.get(DivOpc))
+                           .addReg(I.getOperand(2).getReg());
+  BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), DstReg)
+      .addReg(IsRem ? HighReg : LowReg);
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(Div, TII, TRI, RBI);
+}
+
+bool X86InstructionSelector::selectFPConv(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  const unsigned Opcode = I.getOpcode();
+  const unsigned DstReg = I.getOperand(0).getReg();
+  unsigned SrcReg = I.getOperand(1).getReg();
+  const unsigned DstSize = MRI.getType(DstReg).getSizeInBits();
+  unsigned SrcSize = MRI.getType(SrcReg).getSizeInBits();
+  const bool HasAVX = STI.hasAVX();
+
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  MachineInstr *Conv;
+
+  switch (Opcode) {
+  default:
+    llvm_unreachable("Unexpected conversion");
+  case TargetOpcode::G_SITOFP:
+  case TargetOpcode::G_UITOFP: {
+    if (Opcode == TargetOpcode::G_UITOFP) {
+      // Convert the zero-extended value as a signed 64-bit integer.
+      if (SrcSize != 32 ||
+          !RBI.constrainGenericRegister(SrcReg, X86::GR32RegClass, MRI))
+        return false;
+      SrcReg = emitZExt32To64(I, MRI, SrcReg);
+      SrcSize = 64;
+    }
+
+    static const uint16_t OpcTable[2][2][2] = {
+      { { X86::CVTSI2SSrr, X86::CVTSI2SS64rr },
+        { X86::CVTSI2SDrr, X86::CVTSI2SD64rr } },
+      { { X86::VCVTSI2SSrr, X86::VCVTSI2SS64rr },
+        { X86::VCVTSI2SDrr, X86::VCVTSI2SD64rr } }
+    };
+    unsigned Opc = OpcTable[HasAVX][DstSize == 64][SrcSize == 64];
+    MachineInstrBuilder MIB = BuildMI(MBB, I, DL, TII.get(Opc), DstReg);
+    if (HasAVX) {
+      // The upper elements come from an undefined register.
+      unsigned UndefReg = MRI.createVirtualRegister(
+          DstSize == 64 ? &X86::FR64RegClass : &X86::FR32RegClass);
+      BuildMI(MBB, *MIB, DL, TII.get(TargetOpcode::IMPLICIT_DEF), UndefReg);
+      MIB.addReg(UndefReg);
+    }
+    Conv = MIB.addReg(SrcReg);
+    break;
+  }
+  case TargetOpcode::G_FPTOSI:
+  case TargetOpcode::G_FPTOUI: {
+    static const uint16_t OpcTable[2][2][2] = {
+      { { X86::CVTTSS2SIrr, X86::CVTTSS2SI64rr },
+        { X86::CVTTSD2SIrr, X86::CVTTSD2SI64rr } },
+      { { X86::VCVTTSS2SIrr, X86::VCVTTSS2SI64rr },
+        { X86::VCVTTSD2SIrr, X86::VCVTTSD2SI64rr } }
+    };
+    if (Opcode == TargetOpcode::G_FPTOUI) {
+      // Convert to a signed 64-bit integer and keep the low half.
+      if (DstSize != 32 ||
+          !RBI.constrainGenericRegister(DstReg, X86::GR32RegClass, MRI))
+        return false;
+      unsigned Reg64 = MRI.createVirtualRegister(&X86::GR64RegClass);
+      Conv = BuildMI(MBB, I, DL,
+                     TII.get(OpcTable[HasAVX][SrcSize == 64][/*64-bit*/ 1]),
+                     Reg64)
+                 .addReg(SrcReg);
+      BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), DstReg)
+          .addReg(Reg64, 0, X86::sub_32bit);
+      break;
+    }
+    Conv = BuildMI(MBB, I, DL,
+                   TII.get(OpcTable[HasAVX][SrcSize == 64][DstSize == 64]),
+                   DstReg)
+               .addReg(SrcReg);
+    break;
+  }
+  case TargetOpcode::G_FPEXT:
+  case TargetOpcode::G_FPTRUNC: {
+    bool IsExt = Opcode == TargetOpcode::G_FPEXT;
+    unsigned Opc = HasAVX ? (IsExt ? X86::VCVTSS2SDrr : X86::VCVTSD2SSrr)
+                          : (IsExt ? X86::CVTSS2SDrr : X86::CVTSD2SSrr);
+    MachineInstrBuilder MIB = BuildMI(MBB, I, DL, TII.get(Opc), DstReg);
+    // The AVX forms take the upper elements from their first source.
+    if (HasAVX)
+      MIB.addReg(SrcReg);
+    Conv = MIB.addReg(SrcReg);
+    break;
+  }
+  }
+
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(*Conv, TII, TRI, RBI);
+}
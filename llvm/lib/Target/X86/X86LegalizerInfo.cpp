@@ -0,0 +1,197 @@
+//===- X86LegalizerInfo.cpp --------------------------------------*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the targeting of the Machinelegalizer class for X86.
+/// \todo This should be generated by TableGen.
+//===----------------------------------------------------------------------===//
+
+#include "X86LegalizerInfo.h"
+#include "X86Subtarget.h"
+#include "llvm/CodeGen/ValueTypes.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Type.h"
+#include "llvm/Target/TargetOpcodes.h"
+
+using namespace llvm;
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "You shouldn't build this"
+#endif
+
+X86LegalizerInfo::X86LegalizerInfo(const X86Subtarget &STI) {
+  using namespace TargetOpcode;
+  const LLT p0 = LLT::pointer(0, 64);
+  const LLT s1 = LLT::scalar(1);
+  const LLT s8 = LLT::scalar(8);
+  const LLT s16 = LLT::scalar(16);
+  const LLT s32 = LLT::scalar(32);
+  const LLT s64 = LLT::scalar(64);
+
+  for (auto BinOp : {G_ADD, G_SUB, G_AND, G_OR, G_XOR}) {
+    for (auto Ty : {s8, s16, s32, s64})
+      setAction({BinOp, Ty}, Legal);
+
+    setAction({BinOp, s1}, WidenScalar);
+  }
+
+  // There is no two-address 8-bit multiply.
+  for (auto Ty : {s16, s32, s64})
+    setAction({G_MUL, Ty}, Legal);
+
+  for (auto Ty : {s1, s8})
+    setAction({G_MUL, Ty}, WidenScalar);
+
+  for (auto BinOp : {G_SHL, G_LSHR, G_ASHR}) {
+    for (auto Ty : {s8, s16, s32, s64})
+      setAction({BinOp, Ty}, Legal);
+
+    setAction({BinOp, s1}, WidenScalar);
+  }
+
+  for (auto BinOp : {G_SDIV, G_UDIV, G_SREM, G_UREM}) {
+    for (auto Ty : {s32, s64})
+      setAction({BinOp, Ty}, Legal);
+
+    for (auto Ty : {s1, s8, s16})
+      setAction({BinOp, Ty}, WidenScalar);
+  }
+
+  setAction({G_GEP, p0}, Legal);
+  setAction({G_GEP, 1, s64}, Legal);
+
+  for (auto Ty : {s1, s8, s16, s32})
+    setAction({G_GEP, 1, Ty}, WidenScalar);
+
+  for (auto MemOp : {G_LOAD, G_STORE}) {
+    for (auto Ty : {s8, s16, s32, s64, p0})
+      setAction({MemOp, Ty}, Legal);
+
+    setAction({MemOp, s1}, WidenScalar);
+
+    // And everything's fine in addrspace 0.
+    setAction({MemOp, 1, p0}, Legal);
+  }
+
+  // Constants
+  for (auto Ty : {s8, s16, s32, s64, p0})
+    setAction({G_CONSTANT, Ty}, Legal);
+
+  setAction({G_CONSTANT, s1}, WidenScalar);
+
+  setAction({G_ICMP, s1}, Legal);
+
+  for (auto Ty : {s8, s16, s32, s64, p0})
+    setAction({G_ICMP, 1, Ty}, Legal);
+
+  setAction({G_ICMP, 1, s1}, WidenScalar);
+
+  // Extensions
+  for (auto Ty : {s8, s16, s32, s64}) {
+    setAction({G_ZEXT, Ty}, Legal);
+    setAction({G_SEXT, Ty}, Legal);
+    setAction({G_ANYEXT, Ty}, Legal);
+  }
+
+  for (auto Ty : {s1, s8, s16, s32}) {
+    setAction({G_ZEXT, 1, Ty}, Legal);
+    setAction({G_SEXT, 1, Ty}, Legal);
+    setAction({G_ANYEXT, 1, Ty}, Legal);
+  }
+
+  // Truncations
+  for (auto Ty : {s1, s8, s16, s32})
+    setAction({G_TRUNC, Ty}, Legal);
+
+  for (auto Ty : {s8, s16, s32, s64})
+    setAction({G_TRUNC, 1, Ty}, Legal);
+
+  // Control-flow
+  setAction({G_BRCOND, s1}, Legal);
+
+  // Select, with a CMOV: there is no 8-bit one.
+  for (auto Ty : {s16, s32, s64, p0})
+    setAction({G_SELECT, Ty}, Legal);
+
+  for (auto Ty : {s1, s8})
+    setAction({G_SELECT, Ty}, WidenScalar);
+
+  setAction({G_SELECT, 1, s1}, Legal);
+
+  // Pointer-handling
+  setAction({G_FRAME_INDEX, p0}, Legal);
+  setAction({G_GLOBAL_VALUE, p0}, Legal);
+
+  setAction({G_PTRTOINT, 0, s64}, Legal);
+  setAction({G_PTRTOINT, 1, p0}, Legal);
+
+  setAction({G_INTTOPTR, 0, p0}, Legal);
+  setAction({G_INTTOPTR, 1, s64}, Legal);
+
+  // Floating-point operations live in XMM registers: without SSE they are
+  // left illegal, so that the function falls back to SelectionDAG rather
+  // than needing x87 stack registers.
+  SmallVector<LLT, 2> FPTys;
+  if (STI.hasSSE1())
+    FPTys.push_back(s32);
+  if (STI.hasSSE2())
+    FPTys.push_back(s64);
+
+  for (auto Ty : FPTys) {
+    for (auto BinOp : {G_FADD, G_FSUB, G_FMUL, G_FDIV})
+      setAction({BinOp, Ty}, Legal);
+
+    setAction({G_FREM, Ty}, Libcall);
+    setAction({G_FCONSTANT, Ty}, Legal);
+
+    setAction({G_FCMP, 1, Ty}, Legal);
+
+    // Casts between integers and floating-point values of the same size are
+    // just copies across register banks.
+    setAction({G_BITCAST, 0, Ty}, Legal);
+    setAction({G_BITCAST, 1, Ty}, Legal);
+  }
+
+  if (!FPTys.empty())
+    setAction({G_FCMP, s1}, Legal);
+
+  if (STI.hasSSE2()) {
+    setAction({G_FPEXT, s64}, Legal);
+    setAction({G_FPEXT, 1, s32}, Legal);
+
+    setAction({G_FPTRUNC, s32}, Legal);
+    setAction({G_FPTRUNC, 1, s64}, Legal);
+  }
+
+  // Conversions. The unsigned ones are done with the signed conversions of
+  // the next wider integer type, so only 32-bit unsigned values are legal.
+  for (auto Ty : FPTys) {
+    setAction({G_SITOFP, 0, Ty}, Legal);
+    setAction({G_UITOFP, 0, Ty}, Legal);
+    setAction({G_FPTOSI, 1, Ty}, Legal);
+    setAction({G_FPTOUI, 1, Ty}, Legal);
+  }
+
+  if (!FPTys.empty()) {
+    for (auto Ty : {s32, s64}) {
+      setAction({G_SITOFP, 1, Ty}, Legal);
+      setAction({G_FPTOSI, 0, Ty}, Legal);
+    }
+    setAction({G_UITOFP, 1, s32}, Legal);
+    setAction({G_FPTOUI, 0, s32}, Legal);
+
+    for (auto Ty : {s1, s8, s16}) {
+      setAction({G_SITOFP, 1, Ty}, WidenScalar);
+      setAction({G_UITOFP, 1, Ty}, WidenScalar);
+      setAction({G_FPTOSI, 0, Ty}, WidenScalar);
+      setAction({G_FPTOUI, 0, Ty}, WidenScalar);
+    }
+  }
+
+  computeTables();
+}
@@ -0,0 +1,209 @@
+//===- X86RegisterBankInfo.cpp -----------------------------------*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the targeting of the RegisterBankInfo class for X86.
+/// \todo This should be generated by TableGen.
+//===----------------------------------------------------------------------===//
+
+#include "X86RegisterBankInfo.h"
+#include "X86InstrInfo.h" // For XXXRegClassID.
+#include "llvm/CodeGen/GlobalISel/RegisterBank.h"
+#include "llvm/CodeGen/LowLevelType.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+using namespace llvm;
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "You shouldn't build this"
+#endif
+
+namespace llvm {
+namespace X86 {
+RegisterBank GPRRegBank;
+RegisterBank VECRRegBank;
+
+RegisterBank *RegBanks[] = {&GPRRegBank, &VECRRegBank};
+} // End X86 namespace.
+} // End llvm namespace.
+
+X86RegisterBankInfo::X86RegisterBankInfo(const TargetRegisterInfo &TRI)
+    : RegisterBankInfo(X86::RegBanks, X86::NumRegisterBanks) {
+  static bool AlreadyInit = false;
+  // We have only one set of register banks, whatever the subtarget
+  // is. Therefore, the initialization of the RegBanks table should be
+  // done only once.
+  if (AlreadyInit)
+    return;
+  AlreadyInit = true;
+
+  // The GPR register bank is fully defined by all the registers in
+  // GR64 + its subclasses and sub-registers.
+  createRegisterBank(X86::GPRRegBankID, "GPR");
+  addRegBankCoverage(X86::GPRRegBankID, X86::GR64RegClassID, TRI);
+  const RegisterBank &RBGPR = getRegBank(X86::GPRRegBankID);
+  (void)RBGPR;
+  assert(&X86::GPRRegBank == &RBGPR && "The order in RegBanks is messed up");
+  assert(RBGPR.covers(*TRI.getRegClass(X86::GR8RegClassID)) &&
+         "Subclass not added?");
+  assert(RBGPR.getSize() == 64 && "GPRs should hold up to 64-bit");
+
+  // The VECR register bank is fully defined by all the registers in
+  // VR512 + its subclasses and sub-registers, which includes the scalar
+  // floating-point classes.
+  createRegisterBank(X86::VECRRegBankID, "VECR");
+  addRegBankCoverage(X86::VECRRegBankID, X86::VR512RegClassID, TRI);
+  const RegisterBank &RBVECR = getRegBank(X86::VECRRegBankID);
+  (void)RBVECR;
+  assert(&X86::VECRRegBank == &RBVECR &&
+         "The order in RegBanks is messed up");
+  assert(RBVECR.covers(*TRI.getRegClass(X86::FR32RegClassID)) &&
+         "Subclass not added?");
+  assert(RBVECR.getSize() == 512 && "VECRs should hold up to 512-bit");
+}
+
+unsigned X86RegisterBankInfo::copyCost(const RegisterBank &A,
+                                       const RegisterBank &B,
+                                       unsigned Size) const {
+  // Copies between GPRs and XMM registers need a MOVD or MOVQ.
+  // FIXME: This should be deduced from the scheduling model.
+  if (&A != &B)
+    return 5;
+  return RegisterBankInfo::copyCost(A, B, Size);
+}
+
+const RegisterBank &X86RegisterBankInfo::getRegBankFromRegClass(
+    const TargetRegisterClass &RC) const {
+  if (X86::GPRRegBank.covers(RC))
+    return getRegBank(X86::GPRRegBankID);
+  if (X86::VECRRegBank.covers(RC))
+    return getRegBank(X86::VECRRegBankID);
+  llvm_unreachable("Unsupported register kind");
+}
+
+/// Returns whether opcode \p Opc is a pre-isel generic floating-point opcode,
+/// having only floating-point operands.
+static bool isPreISelGenericFloatingPointOpcode(unsigned Opc) {
+  switch (Opc) {
+  case TargetOpcode::G_FADD:
+  case TargetOpcode::G_FSUB:
+  case TargetOpcode::G_FMUL:
+  case TargetOpcode::G_FDIV:
+  case TargetOpcode::G_FCONSTANT:
+  case TargetOpcode::G_FPEXT:
+  case TargetOpcode::G_FPTRUNC:
+    return true;
+  }
+  return false;
+}
+
+/// Returns whether \p MI reads its operand \p Reg as a floating-point value.
+static bool isFloatingPointUse(const MachineInstr &MI, unsigned Reg) {
+  switch (MI.getOpcode()) {
+  case TargetOpcode::G_FCMP:
+  case TargetOpcode::G_FPTOSI:
+  case TargetOpcode::G_FPTOUI:
+    return true;
+  case TargetOpcode::COPY: {
+    // Returning a value in an XMM register.
+    unsigned DstReg = MI.getOperand(0).getReg();
+    return TargetRegisterInfo::isPhysicalRegister(DstReg) &&
+           X86::VR128XRegClass.contains(DstReg);
+  }
+  default:
+    return isPreISelGenericFloatingPointOpcode(MI.getOpcode());
+  }
+}
+
+RegisterBankInfo::InstructionMapping X86RegisterBankInfo::getMappingFromBanks(
+    const MachineInstr &MI, ArrayRef<const RegisterBank *> OpRegBanks) const {
+  const MachineRegisterInfo &MRI = MI.getParent()->getParent()->getRegInfo();
+  unsigned NumOperands = MI.getNumOperands();
+  assert(OpRegBanks.size() == NumOperands && "One bank per operand");
+
+  SmallVector<const ValueMapping *, 8> OpdsMapping(NumOperands);
+  for (unsigned Idx = 0; Idx != NumOperands; ++Idx) {
+    if (!OpRegBanks[Idx])
+      continue;
+    unsigned Size = MRI.getType(MI.getOperand(Idx).getReg()).getSizeInBits();
+    OpdsMapping[Idx] = &getValueMapping(0, Size, *OpRegBanks[Idx]);
+  }
+  return InstructionMapping{DefaultMappingID, /*Cost*/ 1,
+                            getOperandsMapping(OpdsMapping), NumOperands};
+}
+
+RegisterBankInfo::InstructionMapping
+X86RegisterBankInfo::getInstrMapping(const MachineInstr &MI) const {
+  const unsigned Opc = MI.getOpcode();
+  const MachineFunction &MF = *MI.getParent()->getParent();
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+
+  // Try the default logic for non-generic instructions that are either copies
+  // or already have some operands assigned to banks.
+  if (!isPreISelGenericOpcode(Opc)) {
+    RegisterBankInfo::InstructionMapping Mapping = getInstrMappingImpl(MI);
+    if (Mapping.isValid())
+      return Mapping;
+  }
+
+  const RegisterBank *GPR = &X86::GPRRegBank;
+  const RegisterBank *VECR = &X86::VECRRegBank;
+
+  // As a top-level guess, vectors go in VECRs, scalars and pointers in GPRs.
+  // For floating-point instructions, scalars go in VECRs.
+  unsigned NumOperands = MI.getNumOperands();
+  SmallVector<const RegisterBank *, 4> OpRegBanks(NumOperands);
+  for (unsigned Idx = 0; Idx != NumOperands; ++Idx) {
+    const MachineOperand &MO = MI.getOperand(Idx);
+    if (!MO.isReg() || !MO.getReg())
+      continue;
+    LLT Ty = MRI.getType(MO.getReg());
+    if (Ty.isVector() || isPreISelGenericFloatingPointOpcode(Opc))
+      OpRegBanks[Idx] = VECR;
+    else
+      OpRegBanks[Idx] = GPR;
+  }
+
+  // Some instructions have mixed GPR and VECR operands, or operands whose
+  // type doesn't tell whether they are floating-point: fine-tune the
+  // computed mapping.
+  switch (Opc) {
+  case TargetOpcode::G_SITOFP:
+  case TargetOpcode::G_UITOFP:
+    OpRegBanks[0] = VECR;
+    break;
+  case TargetOpcode::G_FPTOSI:
+  case TargetOpcode::G_FPTOUI:
+    OpRegBanks[1] = VECR;
+    break;
+  case TargetOpcode::G_FCMP:
+    OpRegBanks[2] = OpRegBanks[3] = VECR;
+    break;
+  case TargetOpcode::G_LOAD: {
+    // Load floating-point values straight into a VECR.
+    unsigned Reg = MI.getOperand(0).getReg();
+    for (const MachineInstr &UseMI : MRI.use_instructions(Reg))
+      if (isFloatingPointUse(UseMI, Reg)) {
+        OpRegBanks[0] = VECR;
+        break;
+      }
+    break;
+  }
+  case TargetOpcode::G_STORE: {
+    // Store a value from the bank it was assigned to, if any.
+    const TargetRegisterInfo &TRI = *MRI.getTargetRegisterInfo();
+    if (const RegisterBank *RB =
+            getRegBank(MI.getOperand(0).getReg(), MRI, TRI))
+      OpRegBanks[0] = RB;
+    break;
+  }
+  }
+
+  return getMappingFromBanks(MI, OpRegBanks);
+}
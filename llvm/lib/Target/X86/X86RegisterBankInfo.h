@@ -0,0 +1,59 @@
+//===- X86RegisterBankInfo ---------------------------------------*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file declares the targeting of the RegisterBankInfo class for X86.
+/// \todo This should be generated by TableGen.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_X86_X86REGISTERBANKINFO_H
+#define LLVM_LIB_TARGET_X86_X86REGISTERBANKINFO_H
+
+#include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
+
+namespace llvm {
+
+class TargetRegisterInfo;
+
+namespace X86 {
+enum {
+  GPRRegBankID = 0,  /// General Purpose Registers: AL, AX, EAX, RAX, ...
+  VECRRegBankID = 1, /// Floating Point/Vector Registers: XMM, YMM, ZMM.
+  NumRegisterBanks
+};
+
+extern RegisterBank GPRRegBank;
+extern RegisterBank VECRRegBank;
+} // End X86 namespace.
+
+/// This class provides the information for the target register banks.
+///
+/// Integers and pointers live in GPRs, floating-point values and vectors in
+/// VECRs. The value mappings are built on demand rather than read from static
+/// tables.
+class X86RegisterBankInfo final : public RegisterBankInfo {
+  /// Get an instruction mapping where the register operands map to the
+  /// register banks in \p OpRegBanks, nullptr standing for non-register
+  /// operands.
+  InstructionMapping
+  getMappingFromBanks(const MachineInstr &MI,
+                      ArrayRef<const RegisterBank *> OpRegBanks) const;
+
+public:
+  X86RegisterBankInfo(const TargetRegisterInfo &TRI);
+
+  unsigned copyCost(const RegisterBank &A, const RegisterBank &B,
+                    unsigned Size) const override;
+
+  const RegisterBank &
+  getRegBankFromRegClass(const TargetRegisterClass &RC) const override;
+
+  InstructionMapping getInstrMapping(const MachineInstr &MI) const override;
+};
+} // End llvm namespace.
+#endif
@@ -0,0 +1,517 @@
+//===- ParallelFunctionPasses.cpp - Run function passes in parallel -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Types, constants and metadata are uniqued in the LLVMContext, and use lists
+// of globals are shared between all functions, so function passes cannot run
+// on two functions of one module at the same time. Instead of making the
+// context thread-safe, we stage the work the same way splitCodeGen does:
+//
+//  1. Split the function definitions into contiguous ranges of roughly equal
+//     size and write the module to bitcode once.
+//  2. On a worker thread for each range, read the bitcode lazily into a
+//     fresh LLVMContext, materialize the bodies of the functions in the
+//     range only, turn the other definitions into declarations and run the
+//     pipeline.
+//  3. Read the optimized partitions back into the original context in
+//     partition order and replace the bodies of the original functions.
+//
+// Identified struct types of a partition are renamed with a per-partition
+// prefix before the partition is written, so that they can be matched with
+// the original types by name when the partition is read back. A context
+// can't free types, so the matched copies stay in the original context,
+// unnamed and unused; since the other bodies are never materialized, a
+// partition only has the types that its own functions and the module-level
+// values use. Distinct metadata of a partition, such as compile units and
+// subprograms, is mapped back to the original nodes rather than copied.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/ParallelFunctionPasses.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/TypeFinder.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace llvm;
+
+static std::string getTypePrefix(size_t Part) {
+  return "__pfp" + std::to_string(Part) + ".";
+}
+
+/// Returns true if the functions of \p M can be optimized in separate
+/// partitions.
+static bool canSplit(const Module &M) {
+  // A blockaddress refers to a block of another function, which we can't
+  // map across partitions.
+  for (const Function &F : M)
+    for (const BasicBlock &BB : F)
+      if (BB.hasAddressTaken())
+        return false;
+
+  // Unnamed identified structs can't be matched by name.
+  TypeFinder StructTypes;
+  StructTypes.run(M, false);
+  for (StructType *STy : StructTypes)
+    if (!STy->hasName())
+      return false;
+  return true;
+}
+
+/// Splits the function definitions of \p M into at most \p NumParts
+/// contiguous ranges of roughly equal instruction count. Each range is a
+/// half-open interval of indices into the function list.
+static std::vector<std::pair<size_t, size_t>>
+splitFunctions(const Module &M, unsigned NumParts) {
+  std::vector<size_t> Sizes;
+  size_t Total = 0;
+  for (const Function &F : M) {
+    size_t Size = 0;
+    for (const BasicBlock &BB : F)
+      Size += BB.size();
+    Sizes.push_back(Size);
+    Total += Size;
+  }
+
+  std::vector<std::pair<size_t, size_t>> Ranges;
+  size_t Begin = 0;
+  size_t Acc = 0;
+  for (size_t I = 0, E = Sizes.size(); I != E; ++I) {
+    Acc += Sizes[I];
+    if (Ranges.size() + 1 < NumParts &&
+        Acc * NumParts >= Total * (Ranges.size() + 1)) {
+      Ranges.push_back({Begin, I + 1});
+      Begin = I + 1;
+    }
+  }
+  if (Begin != Sizes.size())
+    Ranges.push_back({Begin, Sizes.size()});
+  return Ranges;
+}
+
+namespace {
+/// Maps types of a partition to the types of the original module.
+class PartitionTypeMapper : public ValueMapTypeRemapper {
+public:
+  DenseMap<Type *, Type *> Map;
+
+  Type *remapType(Type *Ty) override;
+};
+} // end anonymous namespace
+
+Type *PartitionTypeMapper::remapType(Type *Ty) {
+  auto It = Map.find(Ty);
+  if (It != Map.end())
+    return It->second;
+
+  // Identified structs that have no counterpart are new types and map to
+  // themselves. So do types that don't contain other types.
+  Type *Result = Ty;
+  auto *STy = dyn_cast<StructType>(Ty);
+  if (Ty->getNumContainedTypes() != 0 && !(STy && !STy->isLiteral())) {
+    SmallVector<Type *, 4> Elts;
+    bool Changed = false;
+    for (Type *Elt : Ty->subtypes()) {
+      Elts.push_back(remapType(Elt));
+      Changed |= Elts.back() != Elt;
+    }
+
+    if (Changed) {
+      switch (Ty->getTypeID()) {
+      case Type::PointerTyID:
+        Result = PointerType::get(Elts[0], Ty->getPointerAddressSpace());
+        break;
+      case Type::ArrayTyID:
+        Result = ArrayType::get(Elts[0], Ty->getArrayNumElements());
+        break;
+      case Type::VectorTyID:
+        Result = VectorType::get(Elts[0], Ty->getVectorNumElements());
+        break;
+      case Type::FunctionTyID:
+        Result = FunctionType::get(Elts[0], makeArrayRef(Elts).slice(1),
+                                   cast<FunctionType>(Ty)->isVarArg());
+        break;
+      case Type::StructTyID:
+        Result = StructType::get(Ty->getContext(), Elts, STy->isPacked());
+        break;
+      default:
+        llvm_unreachable("unexpected derived type");
+      }
+    }
+  }
+  Map[Ty] = Result;
+  return Result;
+}
+
+/// Returns true if the elements of \p STy map to the elements of \p Orig.
+static bool isMappedLayout(StructType *STy, StructType *Orig,
+                           PartitionTypeMapper &TypeMapper) {
+  if (STy->isOpaque() || Orig->isOpaque())
+    return STy->isOpaque() == Orig->isOpaque();
+  if (STy->isPacked() != Orig->isPacked() ||
+      STy->getNumElements() != Orig->getNumElements())
+    return false;
+  for (unsigned I = 0, E = STy->getNumElements(); I != E; ++I)
+    if (TypeMapper.remapType(STy->getElementType(I)) != Orig->getElementType(I))
+      return false;
+  return true;
+}
+
+/// Matches the identified struct types of partition \p Part with the types of
+/// the original module and sets up \p TypeMapper accordingly.
+static void mapTypes(Module &Part, size_t PartIndex,
+                     PartitionTypeMapper &TypeMapper,
+                     std::vector<StructType *> &Matched) {
+  std::string Prefix = getTypePrefix(PartIndex);
+  TypeFinder StructTypes;
+  StructTypes.run(Part, true);
+  std::vector<std::pair<StructType *, StructType *>> Candidates;
+  std::vector<StructType *> Unmatched;
+  for (StructType *STy : StructTypes) {
+    StringRef Name = STy->getName();
+    if (!Name.startswith(Prefix))
+      continue;
+    StructType *Orig = Part.getTypeByName(Name.substr(Prefix.size()));
+    if (Orig && Orig != STy)
+      Candidates.push_back({STy, Orig});
+    else
+      Unmatched.push_back(STy);
+  }
+
+  // A type matches its namesake if its elements map to the elements of the
+  // original type, assuming that the other candidates match as well. Drop
+  // the candidates that don't until the remaining ones are consistent.
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    TypeMapper.Map.clear();
+    for (auto &C : Candidates)
+      TypeMapper.Map[C.first] = C.second;
+    auto It = std::remove_if(
+        Candidates.begin(), Candidates.end(),
+        [&](const std::pair<StructType *, StructType *> &C) {
+          return !isMappedLayout(C.first, C.second, TypeMapper);
+        });
+    for (auto I = It, E = Candidates.end(); I != E; ++I)
+      Unmatched.push_back(I->first);
+    Changed = It != Candidates.end();
+    Candidates.erase(It, Candidates.end());
+  }
+  for (auto &C : Candidates)
+    Matched.push_back(C.first);
+
+  // Types created or changed by the pipeline get back their original name,
+  // which is uniqued if necessary.
+  for (StructType *STy : Unmatched)
+    STy->setName(STy->getName().substr(Prefix.size()));
+}
+
+/// Maps the distinct nodes reachable from \p PartMD, the partition's copy of
+/// \p Orig, back to the corresponding nodes reachable from \p Orig. The value
+/// mapper then remaps the uniqued nodes that refer to them to the originals
+/// as well, so that merging a partition doesn't duplicate compile units,
+/// subprograms and other module-level metadata.
+static void mapDistinctMetadata(MDNode *Orig, MDNode *PartMD,
+                                ValueToValueMapTy &VMap,
+                                SmallPtrSetImpl<MDNode *> &Visited) {
+  SmallVector<std::pair<MDNode *, MDNode *>, 16> Worklist;
+  Worklist.push_back({Orig, PartMD});
+  while (!Worklist.empty()) {
+    MDNode *O, *N;
+    std::tie(O, N) = Worklist.pop_back_val();
+    // An identical node only refers to original nodes.
+    if (O == N || O->getMetadataID() != N->getMetadataID() ||
+        O->isDistinct() != N->isDistinct() ||
+        O->getNumOperands() != N->getNumOperands() ||
+        !Visited.insert(N).second)
+      continue;
+    if (N->isDistinct())
+      VMap.MD()[N].reset(O);
+    for (unsigned I = 0, E = O->getNumOperands(); I != E; ++I)
+      if (auto *OpO = dyn_cast_or_null<MDNode>(O->getOperand(I)))
+        if (auto *OpN = dyn_cast_or_null<MDNode>(N->getOperand(I)))
+          Worklist.push_back({OpO, OpN});
+  }
+}
+
+/// Maps the metadata attachments of \p PartGO back to those of \p Orig.
+static void mapAttachedMetadata(GlobalObject &Orig, GlobalObject &PartGO,
+                                ValueToValueMapTy &VMap,
+                                SmallPtrSetImpl<MDNode *> &Visited) {
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs, PartMDs;
+  Orig.getAllMetadata(MDs);
+  PartGO.getAllMetadata(PartMDs);
+  if (MDs.size() != PartMDs.size())
+    return;
+  for (size_t I = 0, E = MDs.size(); I != E; ++I)
+    if (MDs[I].first == PartMDs[I].first)
+      mapDistinctMetadata(MDs[I].second, PartMDs[I].second, VMap, Visited);
+}
+
+/// Copies the optimized function bodies of \p Part into \p M.
+static void mergePartition(Module &M, Module &Part, size_t PartIndex,
+                           std::pair<size_t, size_t> Range,
+                           ArrayRef<GlobalVariable *> Globals,
+                           ArrayRef<Function *> Functions,
+                           ArrayRef<GlobalAlias *> Aliases,
+                           ArrayRef<GlobalIFunc *> IFuncs) {
+  PartitionTypeMapper TypeMapper;
+  std::vector<StructType *> Matched;
+  mapTypes(Part, PartIndex, TypeMapper, Matched);
+
+  ValueToValueMapTy VMap;
+
+  // Globals that existed before the pipeline ran are in the same order as
+  // in the original module. Anything after them was added by the pipeline.
+  std::vector<GlobalVariable *> NewGlobals;
+  size_t I = 0;
+  for (GlobalVariable &GV : Part.globals()) {
+    if (I < Globals.size()) {
+      GlobalVariable *Orig = Globals[I++];
+      assert(Orig->getName() == GV.getName() && "global list changed");
+      VMap[&GV] = Orig;
+      // InstCombine may raise the alignment of a global.
+      if (GV.getAlignment() > Orig->getAlignment())
+        Orig->setAlignment(GV.getAlignment());
+      continue;
+    }
+
+    if (!GV.hasLocalLinkage())
+      if (GlobalVariable *Existing = M.getGlobalVariable(GV.getName())) {
+        VMap[&GV] = Existing;
+        continue;
+      }
+
+    auto *NewGV = new GlobalVariable(
+        M, TypeMapper.remapType(GV.getValueType()), GV.isConstant(),
+        GV.getLinkage(), nullptr, GV.getName(), nullptr,
+        GV.getThreadLocalMode(), GV.getType()->getAddressSpace(),
+        GV.isExternallyInitialized());
+    NewGV->copyAttributesFrom(&GV);
+    if (const Comdat *C = GV.getComdat())
+      NewGV->setComdat(M.getOrInsertComdat(C->getName()));
+    VMap[&GV] = NewGV;
+    NewGlobals.push_back(&GV);
+  }
+
+  std::vector<Function *> NewBodies;
+  I = 0;
+  for (Function &F : Part) {
+    if (I < Functions.size()) {
+      Function *Orig = Functions[I++];
+      assert(Orig->getName() == F.getName() && "function list changed");
+      VMap[&F] = Orig;
+      continue;
+    }
+
+    // Typically a declaration of an intrinsic or a library function.
+    if (!F.hasLocalLinkage())
+      if (Function *Existing = M.getFunction(F.getName())) {
+        VMap[&F] = Existing;
+        continue;
+      }
+
+    auto *FTy = cast<FunctionType>(TypeMapper.remapType(F.getFunctionType()));
+    Function *NewF = Function::Create(FTy, F.getLinkage(), F.getName(), &M);
+    NewF->copyAttributesFrom(&F);
+    VMap[&F] = NewF;
+    if (!F.isDeclaration())
+      NewBodies.push_back(&F);
+  }
+
+  I = 0;
+  for (GlobalAlias &GA : Part.aliases())
+    VMap[&GA] = Aliases[I++];
+  I = 0;
+  for (GlobalIFunc &GI : Part.ifuncs())
+    VMap[&GI] = IFuncs[I++];
+
+  // Module-level metadata of the partition is a copy of the metadata of M.
+  SmallPtrSet<MDNode *, 32> VisitedMD;
+  for (NamedMDNode &PartNMD : Part.named_metadata()) {
+    NamedMDNode *NMD = M.getNamedMetadata(PartNMD.getName());
+    if (!NMD || NMD->getNumOperands() != PartNMD.getNumOperands())
+      continue;
+    for (unsigned J = 0, E = NMD->getNumOperands(); J != E; ++J)
+      mapDistinctMetadata(NMD->getOperand(J), PartNMD.getOperand(J), VMap,
+                          VisitedMD);
+  }
+  I = 0;
+  for (GlobalVariable &GV : Part.globals()) {
+    if (I == Globals.size())
+      break;
+    mapAttachedMetadata(*Globals[I++], GV, VMap, VisitedMD);
+  }
+  I = 0;
+  for (Function &F : Part) {
+    if (I == Functions.size())
+      break;
+    if (!F.isDeclaration())
+      mapAttachedMetadata(*Functions[I], F, VMap, VisitedMD);
+    ++I;
+  }
+
+  for (GlobalVariable *GV : NewGlobals)
+    if (GV->hasInitializer())
+      cast<GlobalVariable>(VMap[GV])->setInitializer(
+          MapValue(GV->getInitializer(), VMap, RF_None, &TypeMapper));
+
+  auto CloneBody = [&](Function &Src, Function *Dst) {
+    // copyAttributesFrom copies the partition's comdat and prefix and
+    // prologue data, which refer to values of the partition's module.
+    GlobalValue::LinkageTypes Linkage = Dst->getLinkage();
+    Comdat *C = Dst->getComdat();
+    Constant *Prefix = Dst->hasPrefixData() ? Dst->getPrefixData() : nullptr;
+    Constant *Prologue =
+        Dst->hasPrologueData() ? Dst->getPrologueData() : nullptr;
+
+    Dst->deleteBody();
+    auto DstArg = Dst->arg_begin();
+    for (Argument &Arg : Src.args())
+      VMap[&Arg] = &*DstArg++;
+
+    SmallVector<ReturnInst *, 8> Returns;
+    CloneFunctionInto(Dst, &Src, VMap, /*ModuleLevelChanges=*/true, Returns,
+                      "", nullptr, &TypeMapper);
+
+    Dst->setLinkage(Linkage);
+    Dst->setComdat(C);
+    Dst->setPrefixData(Prefix);
+    Dst->setPrologueData(Prologue);
+  };
+
+  I = 0;
+  for (Function &F : Part) {
+    if (I >= Range.first && I < Range.second && !F.isDeclaration())
+      CloneBody(F, Functions[I]);
+    if (++I == Functions.size())
+      break;
+  }
+  for (Function *F : NewBodies)
+    CloneBody(*F, cast<Function>(VMap[F]));
+
+  // Free the names of matched types so that the prefixes can be reused by
+  // the next call.
+  for (StructType *STy : Matched)
+    STy->setName("");
+}
+
+void llvm::runFunctionPassesInParallel(
+    Module &M, unsigned NumThreads, std::function<void(Module &)> RunPipeline) {
+  if (NumThreads <= 1 || !canSplit(M)) {
+    RunPipeline(M);
+    return;
+  }
+
+  std::vector<std::pair<size_t, size_t>> Ranges =
+      splitFunctions(M, NumThreads);
+  if (Ranges.size() <= 1) {
+    RunPipeline(M);
+    return;
+  }
+
+  std::vector<GlobalVariable *> Globals;
+  std::vector<Function *> Functions;
+  std::vector<GlobalAlias *> Aliases;
+  std::vector<GlobalIFunc *> IFuncs;
+  for (GlobalVariable &GV : M.globals())
+    Globals.push_back(&GV);
+  for (Function &F : M)
+    Functions.push_back(&F);
+  for (GlobalAlias &GA : M.aliases())
+    Aliases.push_back(&GA);
+  for (GlobalIFunc &GI : M.ifuncs())
+    IFuncs.push_back(&GI);
+
+  // Aliases and ifuncs must refer to definitions, so every partition keeps
+  // the bodies of their targets. They are only copied back from the
+  // partition that owns them.
+  SmallPtrSet<const GlobalValue *, 8> Shared;
+  for (GlobalAlias &GA : M.aliases())
+    if (const GlobalObject *Base = GA.getBaseObject())
+      Shared.insert(Base);
+  for (GlobalIFunc &GI : M.ifuncs())
+    if (const GlobalObject *Resolver = GI.getBaseObject())
+      Shared.insert(Resolver);
+
+  // Write M once. Each worker reads it lazily into its own context and only
+  // materializes the bodies that it needs, so staging a partition costs
+  // about as much as its functions rather than as much as the whole module.
+  SmallString<0> Input;
+  {
+    raw_svector_ostream OS(Input);
+    WriteBitcodeToFile(&M, OS);
+  }
+  MemoryBufferRef InputBuffer(StringRef(Input.data(), Input.size()),
+                              "<partition>");
+
+  std::vector<SmallString<0>> Buffers(Ranges.size());
+  parallel_for(size_t(0), Ranges.size(), [&](size_t P) {
+    LLVMContext Ctx;
+    Expected<std::unique_ptr<Module>> MOrErr =
+        getLazyBitcodeModule(InputBuffer, Ctx);
+    if (!MOrErr)
+      report_fatal_error("Failed to read bitcode");
+    Module &Part = **MOrErr;
+
+    // Like CloneModule, turn the definitions of other partitions into
+    // external declarations, which can't be in a comdat.
+    size_t I = 0;
+    for (Function &F : Part) {
+      const Function *Orig = Functions[I];
+      bool Owned = I >= Ranges[P].first && I < Ranges[P].second;
+      ++I;
+      if (Owned || Shared.count(Orig) || F.isDeclaration())
+        continue;
+      F.deleteBody();
+      F.setComdat(nullptr);
+    }
+    if (Error Err = Part.materializeAll()) {
+      consumeError(std::move(Err));
+      report_fatal_error("Failed to read bitcode");
+    }
+
+    RunPipeline(Part);
+
+    TypeFinder StructTypes;
+    StructTypes.run(Part, true);
+    std::string Prefix = getTypePrefix(P);
+    for (StructType *STy : StructTypes)
+      STy->setName(Prefix + STy->getName().str());
+
+    Buffers[P].clear();
+    raw_svector_ostream OS(Buffers[P]);
+    WriteBitcodeToFile(&Part, OS);
+  });
+
+  for (size_t P = 0, E = Ranges.size(); P != E; ++P) {
+    Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(StringRef(Buffers[P].data(), Buffers[P].size()),
+                        "<partition>"),
+        M.getContext());
+    if (!MOrErr)
+      report_fatal_error("Failed to read bitcode");
+    mergePartition(M, **MOrErr, P, Ranges[P], Globals, Functions, Aliases,
+                   IFuncs);
+  }
+}
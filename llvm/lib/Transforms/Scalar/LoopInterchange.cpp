@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
@@ -435,6 +436,8 @@ struct LoopInterchange : public FunctionPass {
     AU.addRequired<DependenceAnalysisWrapperPass>();
     AU.addRequiredID(LoopSimplifyID);
     AU.addRequiredID(LCSSAID);
+
+    AU.addPreserved<DominatorTreeWrapperPass>();
   }
 
   bool runOnFunction(Function &F) override {
@@ -555,7 +558,6 @@ struct LoopInterchange : public FunctionPass {
 
       // Update the DependencyMatrix
       interChangeDependencies(DependencyMatrix, i, i - 1);
-      DT->recalculate(F);
 #ifdef DUMP_DEP_MATRICIES
       DEBUG(dbgs() << "Dependence after interchange\n");
       printDepMatrix(DependencyMatrix);
@@ -1071,11 +1073,20 @@ void LoopInterchangeTransform::splitInnerLoopHeader() {
   BasicBlock *InnerLoopPreHeader = InnerLoop->getLoopPreheader();
   if (InnerLoopHasReduction) {
     // FIXME: Check if the induction PHI will always be the first PHI.
+    // SplitBlock would keep all the PHIs in the header, so split by hand.
     BasicBlock *New = InnerLoopHeader->splitBasicBlock(
         ++(InnerLoopHeader->begin()), InnerLoopHeader->getName() + ".split");
     if (LI)
       if (Loop *L = LI->getLoopFor(InnerLoopHeader))
         L->addBasicBlockToLoop(New, *LI);
+    if (DT)
+      if (DomTreeNode *HeaderNode = DT->getNode(InnerLoopHeader)) {
+        std::vector<DomTreeNode *> Children(HeaderNode->begin(),
+                                            HeaderNode->end());
+        DomTreeNode *NewNode = DT->addNewBlock(New, InnerLoopHeader);
+        for (DomTreeNode *Child : Children)
+          DT->changeImmediateDominator(Child, NewNode);
+      }
 
     // Adjust Reduction PHI's in the block.
     SmallVector<PHINode *, 8> PHIVec;
@@ -1160,6 +1171,17 @@ bool LoopInterchangeTransform::adjustLoopBranches() {
   if (!InnerLoopHeaderSuccessor)
     return false;
 
+  // Remember the successors of the blocks whose branches are rewritten below,
+  // so that the dominator tree can be updated with just the changed edges.
+  SmallSetVector<BasicBlock *, 8> ChangedBBs;
+  for (BasicBlock *BB :
+       {OuterLoopPredecessor, OuterLoopHeader, InnerLoopHeader,
+        InnerLoopLatchPredecessor, InnerLoopLatch, OuterLoopLatch})
+    ChangedBBs.insert(BB);
+  SmallVector<SmallSetVector<BasicBlock *, 2>, 8> OldSuccs;
+  for (BasicBlock *BB : ChangedBBs)
+    OldSuccs.emplace_back(succ_begin(BB), succ_end(BB));
+
   // Adjust Loop Preheader and headers
 
   unsigned NumSucc = OuterLoopPredecessorBI->getNumSuccessors();
@@ -1226,6 +1248,21 @@ bool LoopInterchangeTransform::adjustLoopBranches() {
     OuterLoopLatchBI->setSuccessor(1, InnerLoopLatch);
   }
 
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 16> DTUpdates;
+    for (unsigned I = 0, E = ChangedBBs.size(); I != E; ++I) {
+      BasicBlock *BB = ChangedBBs[I];
+      SmallSetVector<BasicBlock *, 2> NewSuccs(succ_begin(BB), succ_end(BB));
+      for (BasicBlock *Succ : OldSuccs[I])
+        if (!NewSuccs.count(Succ))
+          DTUpdates.push_back({DominatorTree::Delete, BB, Succ});
+      for (BasicBlock *Succ : NewSuccs)
+        if (!OldSuccs[I].count(Succ))
+          DTUpdates.push_back({DominatorTree::Insert, BB, Succ});
+    }
+    DT->applyUpdates(DTUpdates);
+  }
+
   return true;
 }
 void LoopInterchangeTransform::adjustLoopPreheaders() {
@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/UnrollLoop.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
@@ -405,6 +406,15 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
 
   std::vector<BasicBlock*> UnrolledLoopBlocks = L->getBlocks();
 
+  // After partial unrolling, the dominator tree is updated with the edges that
+  // changed once all the branches are in place, so remember where the loop
+  // blocks branched to.
+  bool UpdateDTEdges = DT && !CompletelyUnroll;
+  std::vector<SmallSetVector<BasicBlock *, 2>> OrigSuccessors;
+  if (UpdateDTEdges)
+    for (BasicBlock *BB : UnrolledLoopBlocks)
+      OrigSuccessors.emplace_back(succ_begin(BB), succ_end(BB));
+
   // Loop Unrolling might create new loops. While we do preserve LoopInfo, we
   // might break loop-simplified form for these loops (as they, e.g., would
   // share the same exit blocks). We'll keep track of loops for which we can
@@ -498,7 +508,7 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
       // dedicated entry block (copy of the header block), this header's copy
       // dominates all copied blocks. That means, dominance relations in the
       // copied body are the same as in the original body.
-      if (DT) {
+      if (DT && !UpdateDTEdges) {
         if (*BB == Header)
           DT->addNewBlock(New, Latches[It - 1]);
         else {
@@ -604,7 +614,7 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
   // the previous idom. This is equivalent to the nearest common dominator of
   // the previous idom and the first latch, which dominates all copies of the
   // previous idom.
-  if (DT && Count > 1) {
+  if (DT && !UpdateDTEdges && Count > 1) {
     for (auto *BB : OriginalLoopBlocks) {
       auto *BBDomNode = DT->getNode(BB);
       SmallVector<BasicBlock *, 16> ChildrenToUpdate;
@@ -619,6 +629,23 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
     }
   }
 
+  if (UpdateDTEdges) {
+    SmallVector<DominatorTree::UpdateType, 16> DTUpdates;
+    unsigned NumOrigBlocks = OrigSuccessors.size();
+    for (unsigned I = 0, E = UnrolledLoopBlocks.size(); I != E; ++I) {
+      BasicBlock *BB = UnrolledLoopBlocks[I];
+      SmallSetVector<BasicBlock *, 2> Succs(succ_begin(BB), succ_end(BB));
+      if (I < NumOrigBlocks)
+        for (BasicBlock *Succ : OrigSuccessors[I])
+          if (!Succs.count(Succ))
+            DTUpdates.push_back({DominatorTree::Delete, BB, Succ});
+      for (BasicBlock *Succ : Succs)
+        if (I >= NumOrigBlocks || !OrigSuccessors[I].count(Succ))
+          DTUpdates.push_back({DominatorTree::Insert, BB, Succ});
+    }
+    DT->applyUpdates(DTUpdates);
+  }
+
   // Merge adjacent basic blocks, if possible.
   SmallPtrSet<Loop *, 4> ForgottenLoops;
   for (BasicBlock *Latch : Latches) {
@@ -636,11 +663,7 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool Force,
     }
   }
 
-  // FIXME: We only preserve DT info for complete unrolling now. Incrementally
-  // updating domtree after partial loop unrolling should also be easy.
-  if (DT && !CompletelyUnroll)
-    DT->recalculate(*L->getHeader()->getParent());
-  else if (DT)
+  if (DT)
     DEBUG(DT->verifyDomTree());
 
   // Simplify any new induction variables in the partially unrolled loop.
@@ -20,12 +20,14 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalObject.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
@@ -34,6 +36,11 @@
 
 using namespace llvm;
 
+static cl::opt<bool> BalanceByCost(
+    "split-module-balance-cost", cl::Hidden, cl::init(false),
+    cl::desc("Balance module partitions by estimated code generation cost and "
+             "keep functions that call each other in the same partition"));
+
 namespace {
 typedef EquivalenceClasses<const GlobalValue *> ClusterMapType;
 typedef DenseMap<const Comdat *, const GlobalValue *> ComdatMembersType;
@@ -73,6 +80,131 @@ static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
   }
 }
 
+// Returns the estimated cost of generating code for the definition of GV.
+static uint64_t getCodeGenCost(const GlobalValue &GV) {
+  uint64_t Cost = 1;
+  if (auto *F = dyn_cast<Function>(&GV))
+    for (const BasicBlock &BB : *F)
+      Cost += BB.size();
+  return Cost;
+}
+
+// Assigns every defined global value to one of N partitions, keeping each
+// cluster of GVtoClusterMap together.
+//
+// Clusters are first merged along direct call edges, heaviest edges first, as
+// long as the merged cluster costs no more than half of an evenly balanced
+// partition. This keeps most callers next to their callees, which lets the
+// code generator see both sides of a call, without making any cluster too
+// large to balance. The clusters are then assigned largest-first to the least
+// loaded partition.
+static void assignClustersByCost(Module *M, ClusterMapType &GVtoClusterMap,
+                                 ClusterIDMapType &ClusterIDMap, unsigned N) {
+  SmallVector<const GlobalValue *, 64> Defs;
+  auto addDef = [&](const GlobalValue &GV) {
+    if (GV.isDeclaration())
+      return;
+    GVtoClusterMap.insert(&GV);
+    Defs.push_back(&GV);
+  };
+  for (const Function &F : *M)
+    addDef(F);
+  for (const GlobalVariable &GV : M->globals())
+    addDef(GV);
+  for (const GlobalAlias &GA : M->aliases())
+    addDef(GA);
+  for (const GlobalIFunc &GI : M->ifuncs())
+    addDef(GI);
+
+  DenseMap<const GlobalValue *, uint64_t> ClusterCost;
+  uint64_t TotalCost = 0;
+  for (const GlobalValue *GV : Defs) {
+    uint64_t Cost = getCodeGenCost(*GV);
+    ClusterCost[GVtoClusterMap.getLeaderValue(GV)] += Cost;
+    TotalCost += Cost;
+  }
+
+  // Count the direct calls between each pair of defined functions.
+  MapVector<std::pair<const GlobalValue *, const GlobalValue *>, unsigned>
+      CallEdges;
+  for (const Function &F : *M)
+    for (const BasicBlock &BB : F)
+      for (const Instruction &I : BB) {
+        ImmutableCallSite CS(&I);
+        if (!CS)
+          continue;
+        const Function *Callee = CS.getCalledFunction();
+        if (!Callee || Callee == &F || Callee->isDeclaration())
+          continue;
+        ++CallEdges[std::make_pair(&F, Callee)];
+      }
+
+  typedef std::pair<std::pair<const GlobalValue *, const GlobalValue *>,
+                    unsigned>
+      EdgeType;
+  std::vector<EdgeType> Edges(CallEdges.begin(), CallEdges.end());
+  std::stable_sort(Edges.begin(), Edges.end(),
+                   [](const EdgeType &A, const EdgeType &B) {
+                     return A.second > B.second;
+                   });
+
+  uint64_t MaxClusterCost = std::max<uint64_t>(TotalCost / (2 * N), 1);
+  for (const EdgeType &E : Edges) {
+    const GlobalValue *L1 = GVtoClusterMap.getLeaderValue(E.first.first);
+    const GlobalValue *L2 = GVtoClusterMap.getLeaderValue(E.first.second);
+    if (L1 == L2)
+      continue;
+    uint64_t Cost = ClusterCost[L1] + ClusterCost[L2];
+    if (Cost > MaxClusterCost)
+      continue;
+    ClusterCost.erase(L1);
+    ClusterCost.erase(L2);
+    ClusterCost[*GVtoClusterMap.unionSets(L1, L2)] = Cost;
+  }
+
+  // Collect the clusters in module order so that the result is deterministic,
+  // then sort them by decreasing cost.
+  typedef std::pair<uint64_t, const GlobalValue *> SortType;
+  std::vector<SortType> Clusters;
+  SmallPtrSet<const GlobalValue *, 32> Leaders;
+  for (const GlobalValue *GV : Defs) {
+    const GlobalValue *Leader = GVtoClusterMap.getLeaderValue(GV);
+    if (Leaders.insert(Leader).second)
+      Clusters.push_back(std::make_pair(ClusterCost[Leader], Leader));
+  }
+  std::stable_sort(Clusters.begin(), Clusters.end(),
+                   [](const SortType &A, const SortType &B) {
+                     return A.first > B.first;
+                   });
+
+  // Pop the least loaded partition first, and the lowest numbered one on ties.
+  typedef std::pair<uint64_t, unsigned> PartitionType;
+  std::priority_queue<PartitionType, std::vector<PartitionType>,
+                      std::greater<PartitionType>>
+      Partitions;
+  for (unsigned I = 0; I < N; ++I)
+    Partitions.push(std::make_pair(0, I));
+
+  for (const SortType &C : Clusters) {
+    PartitionType P = Partitions.top();
+    Partitions.pop();
+    DEBUG(dbgs() << "Partition[" << P.second << "] cost(" << C.first
+                 << ") ----> " << C.second->getName() << "\n");
+    for (ClusterMapType::member_iterator MI =
+             GVtoClusterMap.findLeader(C.second);
+         MI != GVtoClusterMap.member_end(); ++MI)
+      ClusterIDMap[*MI] = P.second;
+    P.first += C.first;
+    Partitions.push(P);
+  }
+
+  DEBUG({
+    for (; !Partitions.empty(); Partitions.pop())
+      dbgs() << "Partition[" << Partitions.top().second << "] total cost("
+             << Partitions.top().first << ")\n";
+  });
+}
+
 // Find partitions for module in the way that no locals need to be
 // globalized.
 // Try to balance pack those partitions into N files since this roughly equals
@@ -129,6 +261,12 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   std::for_each(M->global_begin(), M->global_end(), recordGVSet);
   std::for_each(M->alias_begin(), M->alias_end(), recordGVSet);
 
+  if (BalanceByCost) {
+    std::for_each(M->ifunc_begin(), M->ifunc_end(), recordGVSet);
+    assignClustersByCost(M, GVtoClusterMap, ClusterIDMap, N);
+    return;
+  }
+
   // Assigned all GVs to merged clusters while balancing number of objects in
   // each.
   auto CompareClusters = [](const std::pair<unsigned, unsigned> &a,
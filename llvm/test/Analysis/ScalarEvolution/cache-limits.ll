@@ -0,0 +1,68 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s --check-prefix=CHECK --check-prefix=FULL
+; RUN: opt < %s -analyze -scalar-evolution -scalar-evolution-max-value-depth=4 \
+; RUN:   -scalar-evolution-print-cache-stats | FileCheck %s --check-prefix=DEPTH
+; RUN: opt < %s -analyze -scalar-evolution -scalar-evolution-max-value-depth=4 \
+; RUN:   -scalar-evolution-max-cache-entries=2 \
+; RUN:   -scalar-evolution-print-cache-stats | FileCheck %s --check-prefix=DEPTH
+; RUN: opt < %s -analyze -scalar-evolution -scalar-evolution-max-cache-entries=2 \
+; RUN:   -scalar-evolution-print-cache-stats \
+; RUN:   | FileCheck %s --check-prefix=CHECK --check-prefix=FULL --check-prefix=BOUNDED
+
+; %r is printed first and analyzed through the whole chain of shifts. With a
+; depth limit, the shifts deeper than the limit are left unknown, and stay
+; unknown when the caches are trimmed. With a bound on the caches the results
+; don't change, entries are just evicted and computed again.
+
+; CHECK-LABEL: Classifying expressions for: @deep
+; FULL: %r = shl i32 %c5, 1
+; FULL-NEXT: -->  (64 * %x)
+; FULL: %c2 = shl i32 %c1, 1
+; FULL-NEXT: -->  (4 * %x)
+
+; DEPTH: %r = shl i32 %c5, 1
+; DEPTH-NEXT: -->  (16 * %c2)
+; DEPTH: %c2 = shl i32 %c1, 1
+; DEPTH-NEXT: -->  %c2
+; DEPTH: Cache statistics for: @deep
+; DEPTH: depth-limited values: 1
+
+define i32 @deep(i32 %x) {
+entry:
+  br label %chain
+
+use:
+  %r = shl i32 %c5, 1
+  ret i32 %r
+
+chain:
+  %c1 = shl i32 %x, 1
+  %c2 = shl i32 %c1, 1
+  %c3 = shl i32 %c2, 1
+  %c4 = shl i32 %c3, 1
+  %c5 = shl i32 %c4, 1
+  br label %use
+}
+
+; CHECK-LABEL: Classifying expressions for: @count
+; CHECK: Loop %loop: backedge-taken count is (-1 + (1 smax %n))
+; BOUNDED: Cache statistics for: @count
+; BOUNDED-NEXT: values: {{[0-9]+}} hits, {{[0-9]+}} misses
+; BOUNDED-NEXT: backedge-taken counts: {{[0-9]+}} hits, {{[1-9][0-9]*}} misses
+; BOUNDED-NEXT: values at scopes: {{[0-9]+}} hits, {{[0-9]+}} misses
+; BOUNDED-NEXT: evictions: {{[1-9][0-9]*}}
+; BOUNDED-NEXT: depth-limited values: 0
+; BOUNDED-NEXT: bytes: {{[1-9][0-9]*}}
+
+define void @count(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add nuw nsw i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,63 @@
+; RUN: llvm-as -bitcode-mdindex-threshold=0 < %s -o %t.bc
+; RUN: llvm-bcanalyzer -dump %t.bc | FileCheck %s -check-prefix=BC
+; RUN: llvm-dis < %t.bc | FileCheck %s
+; RUN: llvm-dis -disable-ondemand-mds-loading < %t.bc | FileCheck %s
+; RUN: llvm-extract -func=load_b %t.bc -S -o - | FileCheck %s -check-prefix=EXTRACT
+
+; Without an index in the metadata block, there is nothing to prefetch.
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=NOREFS
+
+; Each function block lists the module-level metadata that the function
+; refers to, so that a lazy reader can load them in one pass.
+; BC:      <FUNCTION_BLOCK
+; BC-NEXT:   <DECLAREBLOCKS op0=1/>
+; BC-NEXT:   <METADATA_REFS op0=
+; BC:      <FUNCTION_BLOCK
+; BC-NEXT:   <DECLAREBLOCKS op0=1/>
+; BC-NEXT:   <METADATA_REFS op0=
+
+; NOREFS-NOT: METADATA_REFS
+
+; CHECK-LABEL: define i32 @load_a(i32* %p)
+; CHECK: load i32, i32* %p, align 4, !dbg ![[LOCA:[0-9]+]], !tbaa ![[TBAA:[0-9]+]]
+; CHECK-LABEL: define i32 @load_b(i32* %p)
+; CHECK: load i32, i32* %p, align 4, !dbg ![[LOCB:[0-9]+]], !tbaa ![[TBAA]]
+; CHECK-DAG: ![[TBAA]] = !{![[INT:[0-9]+]], ![[INT]], i64 0}
+; CHECK-DAG: ![[LOCA]] = !DILocation(line: 2,
+; CHECK-DAG: ![[LOCB]] = !DILocation(line: 6,
+
+; EXTRACT-NOT: define i32 @load_a
+; EXTRACT: define i32 @load_b(i32* %p) !dbg ![[SP:[0-9]+]]
+; EXTRACT: load i32, i32* %p, align 4, !dbg ![[LOC:[0-9]+]], !tbaa ![[TBAA:[0-9]+]]
+; EXTRACT-DAG: ![[SP]] = distinct !DISubprogram(name: "load_b"
+; EXTRACT-DAG: ![[LOC]] = !DILocation(line: 6, column: 3, scope: ![[SP]])
+; EXTRACT-DAG: ![[TBAA]] = !{![[INT:[0-9]+]], ![[INT]], i64 0}
+; EXTRACT-DAG: ![[INT]] = !{!"int", ![[CHAR:[0-9]+]], i64 0}
+
+define i32 @load_a(i32* %p) !dbg !6 {
+  %v = load i32, i32* %p, align 4, !dbg !9, !tbaa !10
+  ret i32 %v, !dbg !9
+}
+
+define i32 @load_b(i32* %p) !dbg !14 {
+  %v = load i32, i32* %p, align 4, !dbg !15, !tbaa !10
+  ret i32 %v, !dbg !15
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "t.c", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !DISubroutineType(types: !2)
+!6 = distinct !DISubprogram(name: "load_a", scope: !1, file: !1, line: 1, type: !5, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, variables: !2)
+!9 = !DILocation(line: 2, column: 3, scope: !6)
+!10 = !{!11, !11, i64 0}
+!11 = !{!"int", !12, i64 0}
+!12 = !{!"omnipotent char", !13, i64 0}
+!13 = !{!"Simple C/C++ TBAA"}
+!14 = distinct !DISubprogram(name: "load_b", scope: !1, file: !1, line: 5, type: !5, isLocal: false, isDefinition: true, scopeLine: 5, isOptimized: true, unit: !0, variables: !2)
+!15 = !DILocation(line: 6, column: 3, scope: !14)
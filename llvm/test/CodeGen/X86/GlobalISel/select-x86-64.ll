@@ -0,0 +1,163 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -O0 -global-isel -global-isel-abort=1 -verify-machineinstrs %s -o - | FileCheck %s
+; RUN: llc -mtriple=x86_64-linux-gnu -mattr=+avx -O0 -global-isel -global-isel-abort=1 -verify-machineinstrs %s -o - | FileCheck %s --check-prefix=AVX
+
+; Check that common -O0 code is selected by GlobalISel end to end, without
+; falling back to SelectionDAG.
+
+; CHECK-LABEL: add_i32:
+; CHECK: addl
+define i32 @add_i32(i32 %a, i32 %b) {
+  %res = add i32 %a, %b
+  ret i32 %res
+}
+
+; CHECK-LABEL: mul_i8:
+; CHECK: imulw
+define i8 @mul_i8(i8 %a, i8 %b) {
+  %res = mul i8 %a, %b
+  ret i8 %res
+}
+
+; CHECK-LABEL: sdiv_i32:
+; CHECK: cltd
+; CHECK: idivl
+define i32 @sdiv_i32(i32 %a, i32 %b) {
+  %res = sdiv i32 %a, %b
+  ret i32 %res
+}
+
+; CHECK-LABEL: urem_i64:
+; CHECK: divq
+; CHECK: movq %rdx,
+define i64 @urem_i64(i64 %a, i64 %b) {
+  %res = urem i64 %a, %b
+  ret i64 %res
+}
+
+; CHECK-LABEL: shl_i32:
+; CHECK: shll %cl,
+define i32 @shl_i32(i32 %a, i32 %b) {
+  %res = shl i32 %a, %b
+  ret i32 %res
+}
+
+; CHECK-LABEL: zext_i1:
+; CHECK: andb $1,
+; CHECK: movzbl
+define i32 @zext_i1(i1 %a) {
+  %res = zext i1 %a to i32
+  ret i32 %res
+}
+
+; CHECK-LABEL: sext_i16:
+; CHECK: movswq
+define i64 @sext_i16(i16 %a) {
+  %res = sext i16 %a to i64
+  ret i64 %res
+}
+
+; CHECK-LABEL: icmp_select:
+; CHECK: cmpl
+; CHECK: setl
+; CHECK: testb $1,
+; CHECK: cmovnel
+define i32 @icmp_select(i32 %a, i32 %b) {
+  %c = icmp slt i32 %a, %b
+  %res = select i1 %c, i32 %a, i32 %b
+  ret i32 %res
+}
+
+; CHECK-LABEL: brcond:
+; CHECK: cmpq
+; CHECK: sete
+; CHECK: testb $1,
+; CHECK: jne
+define i64 @brcond(i64 %a, i64 %b) {
+  %c = icmp eq i64 %a, %b
+  br i1 %c, label %true, label %false
+true:
+  ret i64 %a
+false:
+  ret i64 %b
+}
+
+@var = global i32 0
+
+; CHECK-LABEL: load_store_global:
+; CHECK: leaq var(%rip),
+; CHECK: movl (
+; CHECK: movl {{.*}}, (
+define void @load_store_global(i32 %a) {
+  %old = load i32, i32* @var
+  %new = add i32 %old, %a
+  store i32 %new, i32* @var
+  ret void
+}
+
+; CHECK-LABEL: alloca_gep:
+; CHECK: leaq {{.*}}(%rsp),
+define i32 @alloca_gep(i64 %idx) {
+  %buf = alloca [4 x i32]
+  %addr = getelementptr [4 x i32], [4 x i32]* %buf, i64 0, i64 %idx
+  store i32 42, i32* %addr
+  %res = load i32, i32* %addr
+  ret i32 %res
+}
+
+declare i32 @callee(i32, double)
+
+; CHECK-LABEL: call:
+; CHECK: callq callee
+define i32 @call(i32 %a, double %b) {
+  %res = call i32 @callee(i32 %a, double %b)
+  ret i32 %res
+}
+
+; CHECK-LABEL: fadd_f64:
+; CHECK: addsd
+; AVX-LABEL: fadd_f64:
+; AVX: vaddsd
+define double @fadd_f64(double %a, double %b) {
+  %res = fadd double %a, %b
+  ret double %res
+}
+
+; CHECK-LABEL: fcmp_oeq:
+; CHECK: ucomiss
+; CHECK: sete
+; CHECK: setnp
+; CHECK: andb
+define i1 @fcmp_oeq(float %a, float %b) {
+  %res = fcmp oeq float %a, %b
+  ret i1 %res
+}
+
+; CHECK-LABEL: sitofp_i32:
+; CHECK: cvtsi2sdl
+; AVX-LABEL: sitofp_i32:
+; AVX: vcvtsi2sdl
+define double @sitofp_i32(i32 %a) {
+  %res = sitofp i32 %a to double
+  ret double %res
+}
+
+; CHECK-LABEL: uitofp_i32:
+; CHECK: cvtsi2ssq
+define float @uitofp_i32(i32 %a) {
+  %res = uitofp i32 %a to float
+  ret float %res
+}
+
+; CHECK-LABEL: fptosi_f32:
+; CHECK: cvttss2si
+define i16 @fptosi_f32(float %a) {
+  %res = fptosi float %a to i16
+  ret i16 %res
+}
+
+; CHECK-LABEL: fpext:
+; CHECK: cvtss2sd
+define double @fpext(float %a) {
+  %res = fpext float %a to double
+  ret double %res
+}
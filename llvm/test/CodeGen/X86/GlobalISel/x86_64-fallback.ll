@@ -0,0 +1,36 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -O0 -global-isel -global-isel-abort=2 %s -o %t.out 2> %t.err
+; RUN: FileCheck %s --check-prefix=FALLBACK-WITH-REPORT-OUT < %t.out
+; RUN: FileCheck %s --check-prefix=FALLBACK-WITH-REPORT-ERR < %t.err
+; This file checks that the x86-64 fallback path to SelectionDAG works. Like
+; the AArch64 version, it must be updated to exercise something GlobalISel
+; doesn't handle yet.
+
+; Varargs calls need %al set to the number of vector registers used.
+; FALLBACK-WITH-REPORT-ERR: warning: Instruction selection used fallback path for varargs_call
+; FALLBACK-WITH-REPORT-OUT-LABEL: varargs_call:
+; FALLBACK-WITH-REPORT-OUT: movb $1, %al
+; FALLBACK-WITH-REPORT-OUT: callq printf
+@fmt = global [4 x i8] c"%f\0A\00"
+declare i32 @printf(i8*, ...)
+define void @varargs_call(double %d) {
+  %fmt = getelementptr [4 x i8], [4 x i8]* @fmt, i64 0, i64 0
+  call i32 (i8*, ...) @printf(i8* %fmt, double %d)
+  ret void
+}
+
+; i128 isn't a legal type.
+; FALLBACK-WITH-REPORT-ERR: warning: Instruction selection used fallback path for add_i128
+; FALLBACK-WITH-REPORT-OUT-LABEL: add_i128:
+; FALLBACK-WITH-REPORT-OUT: adcq
+define i128 @add_i128(i128 %a, i128 %b) {
+  %res = add i128 %a, %b
+  ret i128 %res
+}
+
+; Functions that are handled don't produce a warning.
+; FALLBACK-WITH-REPORT-ERR-NOT: fallback path for add_i64
+; FALLBACK-WITH-REPORT-OUT-LABEL: add_i64:
+define i64 @add_i64(i64 %a, i64 %b) {
+  %res = add i64 %a, %b
+  ret i64 %res
+}
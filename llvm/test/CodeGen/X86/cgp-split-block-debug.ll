@@ -0,0 +1,67 @@
+; Debug info intrinsics don't count towards -cgp-max-block-size, so blocks are
+; split at the same instructions with and without them.
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -cgp-max-block-size=4 \
+; RUN:   -stop-after=codegenprepare -o - | FileCheck %s
+; RUN: opt -strip-debug < %s | llc -mtriple=x86_64-unknown-unknown \
+; RUN:   -cgp-max-block-size=4 -stop-after=codegenprepare -o - | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -cgp-max-block-size=4 \
+; RUN:   -pass-remarks-analysis=codegenprepare -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=REMARK
+; RUN: opt -strip-debug < %s | llc -mtriple=x86_64-unknown-unknown \
+; RUN:   -cgp-max-block-size=4 -pass-remarks-analysis=codegenprepare \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=REMARK
+
+; CHECK-LABEL: define i32 @f(
+; CHECK:       %a3 = add i32 %a2, %x
+; CHECK-NEXT:  br label %entry.split
+; CHECK:     entry.split:
+; CHECK-NOT:   br
+; CHECK:       %a4 = mul i32 %a3, %y
+; CHECK:       %a7 = add i32 %a6, %x
+; CHECK-NEXT:  br label %entry.split1
+; CHECK:     entry.split1:
+; CHECK-NOT:   br
+; CHECK:       %a8 = add i32 %a7, %y
+; CHECK-NOT:   br
+; CHECK:       ret i32 %a8
+; REMARK: remark: {{.*}}split a block of 10 instructions into 3 blocks
+
+define i32 @f(i32 %x, i32 %y) !dbg !4 {
+entry:
+  %a0 = add i32 %x, %y, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a0, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a1 = mul i32 %a0, %y, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a1, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a2 = xor i32 %a1, %x, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a2, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a3 = add i32 %a2, %x, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a3, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a4 = mul i32 %a3, %y, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a4, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a5 = xor i32 %a4, %y, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a5, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a6 = sub i32 %a5, %x, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a6, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a7 = add i32 %a6, %x, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a7, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  %a8 = add i32 %a7, %y, !dbg !9
+  call void @llvm.dbg.value(metadata i32 %a8, i64 0, metadata !8, metadata !DIExpression()), !dbg !9
+  ret i32 %a8, !dbg !9
+}
+
+declare void @llvm.dbg.value(metadata, i64, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, emissionKind: FullDebug)
+!1 = !DIFile(filename: "t.c", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = distinct !DISubprogram(name: "f", scope: !1, file: !1, line: 1, type: !5, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, variables: !7)
+!5 = !DISubroutineType(types: !6)
+!6 = !{null}
+!7 = !{!8}
+!8 = !DILocalVariable(name: "a", scope: !4, file: !1, line: 1, type: !10)
+!9 = !DILocation(line: 1, column: 1, scope: !4)
+!10 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
@@ -0,0 +1,50 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -cgp-max-block-size=4 \
+; RUN:   -stop-after=codegenprepare -o - | FileCheck %s --check-prefix=SPLIT
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -cgp-max-block-size=4 \
+; RUN:   -pass-remarks-analysis=codegenprepare -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=SPLIT-REMARK
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -dag-size-fallback-threshold=10 \
+; RUN:   | FileCheck %s --check-prefix=FALLBACK
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -dag-size-fallback-threshold=10 \
+; RUN:   -pass-remarks-analysis=isel -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=FALLBACK-REMARK
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -O0 \
+; RUN:   -dag-size-fallback-threshold=10 -pass-remarks-analysis=isel \
+; RUN:   -o /dev/null 2>&1 | count 0
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown \
+; RUN:   -pass-remarks-analysis='codegenprepare|isel' -o /dev/null 2>&1 \
+; RUN:   | count 0
+
+; Blocks with more than -cgp-max-block-size instructions are split before
+; instruction selection.
+; SPLIT-LABEL: define i32 @f(
+; SPLIT:       %a3 = add i32 %a2, %x
+; SPLIT-NEXT:  br label %entry.split
+; SPLIT:     entry.split:
+; SPLIT-NEXT:  %a4 = mul i32 %a3, %y
+; SPLIT:       %a7 = add i32 %a6, %x
+; SPLIT-NEXT:  br label %entry.split1
+; SPLIT:     entry.split1:
+; SPLIT-NEXT:  %a8 = add i32 %a7, %y
+; SPLIT-NEXT:  ret i32 %a8
+; SPLIT-REMARK: remark: {{.*}}split a block of 10 instructions into 3 blocks
+
+; DAGs with more than -dag-size-fallback-threshold nodes are combined and
+; scheduled as at -O0.
+; FALLBACK-LABEL: f:
+; FALLBACK:       retq
+; FALLBACK-REMARK: remark: {{.*}}selection DAG of {{[0-9]+}} nodes is larger than the limit of 10, combining and scheduling it as at -O0
+
+define i32 @f(i32 %x, i32 %y) {
+entry:
+  %a0 = add i32 %x, %y
+  %a1 = mul i32 %a0, %y
+  %a2 = xor i32 %a1, %x
+  %a3 = add i32 %a2, %x
+  %a4 = mul i32 %a3, %y
+  %a5 = xor i32 %a4, %y
+  %a6 = sub i32 %a5, %x
+  %a7 = add i32 %a6, %x
+  %a8 = add i32 %a7, %y
+  ret i32 %a8
+}
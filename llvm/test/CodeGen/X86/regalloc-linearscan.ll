@@ -0,0 +1,147 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -regalloc=linearscan \
+; RUN:     -verify-machineinstrs | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -regalloc=linearscan \
+; RUN:     -linearscan-interference-budget=0 -verify-machineinstrs \
+; RUN:   | FileCheck %s
+
+; CHECK-LABEL: add:
+; CHECK: leal (%rdi,%rsi), %eax
+; CHECK-NEXT: retq
+define i32 @add(i32 %a, i32 %b) {
+  %c = add i32 %a, %b
+  ret i32 %c
+}
+
+; More values are live across the call than there are callee-saved
+; registers, so some of them must be spilled.
+; CHECK-LABEL: pressure:
+; CHECK: Spill
+; CHECK: callq g
+; CHECK: Reload
+; CHECK: retq
+declare void @g()
+
+define void @pressure(i64* %p, i64* %q) {
+  %p1 = getelementptr i64, i64* %p, i64 1
+  %p2 = getelementptr i64, i64* %p, i64 2
+  %p3 = getelementptr i64, i64* %p, i64 3
+  %p4 = getelementptr i64, i64* %p, i64 4
+  %p5 = getelementptr i64, i64* %p, i64 5
+  %p6 = getelementptr i64, i64* %p, i64 6
+  %p7 = getelementptr i64, i64* %p, i64 7
+  %v0 = load volatile i64, i64* %p
+  %v1 = load volatile i64, i64* %p1
+  %v2 = load volatile i64, i64* %p2
+  %v3 = load volatile i64, i64* %p3
+  %v4 = load volatile i64, i64* %p4
+  %v5 = load volatile i64, i64* %p5
+  %v6 = load volatile i64, i64* %p6
+  %v7 = load volatile i64, i64* %p7
+  call void @g()
+  %q1 = getelementptr i64, i64* %q, i64 1
+  %q2 = getelementptr i64, i64* %q, i64 2
+  %q3 = getelementptr i64, i64* %q, i64 3
+  %q4 = getelementptr i64, i64* %q, i64 4
+  %q5 = getelementptr i64, i64* %q, i64 5
+  %q6 = getelementptr i64, i64* %q, i64 6
+  %q7 = getelementptr i64, i64* %q, i64 7
+  store volatile i64 %v0, i64* %q
+  store volatile i64 %v1, i64* %q1
+  store volatile i64 %v2, i64* %q2
+  store volatile i64 %v3, i64* %q3
+  store volatile i64 %v4, i64* %q4
+  store volatile i64 %v5, i64* %q5
+  store volatile i64 %v6, i64* %q6
+  store volatile i64 %v7, i64* %q7
+  ret void
+}
+
+; Twenty values are live at once, and each of them must be in a register to be
+; stored. The reloads of the spilled values are unspillable, so they have to
+; evict other intervals, also ones that were evicted before and also once the
+; interference budget is exhausted.
+; CHECK-LABEL: reload_pressure:
+; CHECK: Spill
+; CHECK: Reload
+; CHECK: retq
+define void @reload_pressure(i64* %p, i64* %q) {
+  %v0 = load volatile i64, i64* %p
+  %p1 = getelementptr i64, i64* %p, i64 1
+  %v1 = load volatile i64, i64* %p1
+  %p2 = getelementptr i64, i64* %p, i64 2
+  %v2 = load volatile i64, i64* %p2
+  %p3 = getelementptr i64, i64* %p, i64 3
+  %v3 = load volatile i64, i64* %p3
+  %p4 = getelementptr i64, i64* %p, i64 4
+  %v4 = load volatile i64, i64* %p4
+  %p5 = getelementptr i64, i64* %p, i64 5
+  %v5 = load volatile i64, i64* %p5
+  %p6 = getelementptr i64, i64* %p, i64 6
+  %v6 = load volatile i64, i64* %p6
+  %p7 = getelementptr i64, i64* %p, i64 7
+  %v7 = load volatile i64, i64* %p7
+  %p8 = getelementptr i64, i64* %p, i64 8
+  %v8 = load volatile i64, i64* %p8
+  %p9 = getelementptr i64, i64* %p, i64 9
+  %v9 = load volatile i64, i64* %p9
+  %p10 = getelementptr i64, i64* %p, i64 10
+  %v10 = load volatile i64, i64* %p10
+  %p11 = getelementptr i64, i64* %p, i64 11
+  %v11 = load volatile i64, i64* %p11
+  %p12 = getelementptr i64, i64* %p, i64 12
+  %v12 = load volatile i64, i64* %p12
+  %p13 = getelementptr i64, i64* %p, i64 13
+  %v13 = load volatile i64, i64* %p13
+  %p14 = getelementptr i64, i64* %p, i64 14
+  %v14 = load volatile i64, i64* %p14
+  %p15 = getelementptr i64, i64* %p, i64 15
+  %v15 = load volatile i64, i64* %p15
+  %p16 = getelementptr i64, i64* %p, i64 16
+  %v16 = load volatile i64, i64* %p16
+  %p17 = getelementptr i64, i64* %p, i64 17
+  %v17 = load volatile i64, i64* %p17
+  %p18 = getelementptr i64, i64* %p, i64 18
+  %v18 = load volatile i64, i64* %p18
+  %p19 = getelementptr i64, i64* %p, i64 19
+  %v19 = load volatile i64, i64* %p19
+  %q19 = getelementptr i64, i64* %q, i64 19
+  store volatile i64 %v19, i64* %q19
+  %q18 = getelementptr i64, i64* %q, i64 18
+  store volatile i64 %v18, i64* %q18
+  %q17 = getelementptr i64, i64* %q, i64 17
+  store volatile i64 %v17, i64* %q17
+  %q16 = getelementptr i64, i64* %q, i64 16
+  store volatile i64 %v16, i64* %q16
+  %q15 = getelementptr i64, i64* %q, i64 15
+  store volatile i64 %v15, i64* %q15
+  %q14 = getelementptr i64, i64* %q, i64 14
+  store volatile i64 %v14, i64* %q14
+  %q13 = getelementptr i64, i64* %q, i64 13
+  store volatile i64 %v13, i64* %q13
+  %q12 = getelementptr i64, i64* %q, i64 12
+  store volatile i64 %v12, i64* %q12
+  %q11 = getelementptr i64, i64* %q, i64 11
+  store volatile i64 %v11, i64* %q11
+  %q10 = getelementptr i64, i64* %q, i64 10
+  store volatile i64 %v10, i64* %q10
+  %q9 = getelementptr i64, i64* %q, i64 9
+  store volatile i64 %v9, i64* %q9
+  %q8 = getelementptr i64, i64* %q, i64 8
+  store volatile i64 %v8, i64* %q8
+  %q7 = getelementptr i64, i64* %q, i64 7
+  store volatile i64 %v7, i64* %q7
+  %q6 = getelementptr i64, i64* %q, i64 6
+  store volatile i64 %v6, i64* %q6
+  %q5 = getelementptr i64, i64* %q, i64 5
+  store volatile i64 %v5, i64* %q5
+  %q4 = getelementptr i64, i64* %q, i64 4
+  store volatile i64 %v4, i64* %q4
+  %q3 = getelementptr i64, i64* %q, i64 3
+  store volatile i64 %v3, i64* %q3
+  %q2 = getelementptr i64, i64* %q, i64 2
+  store volatile i64 %v2, i64* %q2
+  %q1 = getelementptr i64, i64* %q, i64 1
+  store volatile i64 %v1, i64* %q1
+  store volatile i64 %v0, i64* %q
+  ret void
+}
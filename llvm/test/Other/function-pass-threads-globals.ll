@@ -0,0 +1,118 @@
+; Check that -function-pass-threads handles comdats, aliases and debug info
+; the same way as a serial run, and doesn't duplicate module-level metadata.
+
+; RUN: opt -S -O2 < %s > %t.serial.ll
+; RUN: opt -S -O2 -function-pass-threads=4 < %s > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: grep "distinct !DICompileUnit(" %t.parallel.ll | count 1
+; RUN: grep "distinct !DIGlobalVariable(" %t.parallel.ll | count 1
+; RUN: grep "distinct !DISubprogram(" %t.parallel.ll | count 2
+
+; RUN: opt -S -passes='function(sroa,instcombine,simplify-cfg)' < %s \
+; RUN:   > %t.serial.newpm.ll
+; RUN: opt -S -passes='function(sroa,instcombine,simplify-cfg)' \
+; RUN:   -function-pass-threads=4 < %s > %t.parallel.newpm.ll
+; RUN: diff %t.serial.newpm.ll %t.parallel.newpm.ll
+; RUN: FileCheck %s < %t.parallel.newpm.ll
+; RUN: grep "distinct !DICompileUnit(" %t.parallel.newpm.ll | count 1
+; RUN: grep "distinct !DIGlobalVariable(" %t.parallel.newpm.ll | count 1
+; RUN: grep "distinct !DISubprogram(" %t.parallel.newpm.ll | count 2
+
+$inline_sum = comdat any
+
+; CHECK: @counter = global i32 0, align 4, !dbg
+@counter = global i32 0, align 4, !dbg !8
+
+; CHECK: @sum_alias = alias i32 (i32, i32), i32 (i32, i32)* @sum
+@sum_alias = alias i32 (i32, i32), i32 (i32, i32)* @sum
+
+; CHECK-LABEL: define linkonce_odr i32 @inline_sum(i32 %a, i32 %b) comdat
+define linkonce_odr i32 @inline_sum(i32 %a, i32 %b) comdat {
+entry:
+  %p = alloca i32
+  store i32 %a, i32* %p
+  %0 = load i32, i32* %p
+  %add = add i32 %0, %b
+  ret i32 %add
+}
+
+; CHECK-LABEL: define internal i32 @sum(i32 %a, i32 %b)
+; CHECK-SAME: !dbg
+; CHECK-NOT: alloca
+; CHECK: call void @llvm.dbg.value(metadata i32 %a
+define internal i32 @sum(i32 %a, i32 %b) !dbg !12 {
+entry:
+  %a.addr = alloca i32
+  store i32 %a, i32* %a.addr
+  call void @llvm.dbg.declare(metadata i32* %a.addr, metadata !16, metadata !DIExpression()), !dbg !17
+  %0 = load i32, i32* %a.addr, !dbg !17
+  %add = add i32 %0, %b, !dbg !17
+  ret i32 %add, !dbg !17
+}
+
+; CHECK-LABEL: define void @bump()
+; CHECK-SAME: !dbg
+define void @bump() !dbg !18 {
+entry:
+  %0 = load i32, i32* @counter, !dbg !19
+  %1 = add i32 %0, 1, !dbg !19
+  %2 = add i32 %1, 1, !dbg !19
+  store i32 %2, i32* @counter, !dbg !19
+  ret void, !dbg !19
+}
+
+; CHECK-LABEL: define i32 @select_max(
+; CHECK: select
+define i32 @select_max(i32 %a, i32 %b) {
+entry:
+  %cmp = icmp sgt i32 %a, %b
+  br i1 %cmp, label %then, label %else
+
+then:
+  br label %end
+
+else:
+  br label %end
+
+end:
+  %r = phi i32 [ %a, %then ], [ %b, %else ]
+  ret i32 %r
+}
+
+; InstCombine calls the aliasee directly.
+; CHECK-LABEL: define i32 @caller(
+; CHECK: call i32 @sum(
+; CHECK: call i32 @inline_sum(
+define i32 @caller(i32 %a) {
+entry:
+  %s = call i32 @sum_alias(i32 %a, i32 %a)
+  %t = call i32 @inline_sum(i32 %s, i32 1)
+  %m = call i32 @select_max(i32 %t, i32 7)
+  call void @bump()
+  ret i32 %m
+}
+
+declare void @llvm.dbg.declare(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!5, !6}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, emissionKind: FullDebug, enums: !2, retainedTypes: !2, globals: !7)
+!1 = !DIFile(filename: "t.c", directory: "/tmp")
+!2 = !{}
+!5 = !{i32 2, !"Dwarf Version", i32 4}
+!6 = !{i32 2, !"Debug Info Version", i32 3}
+!7 = !{!8}
+!8 = !DIGlobalVariableExpression(var: !9)
+!9 = distinct !DIGlobalVariable(name: "counter", scope: !0, file: !1, line: 1, type: !10, isLocal: false, isDefinition: true)
+!10 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!11 = !{!10, !10, !10}
+!12 = distinct !DISubprogram(name: "sum", scope: !1, file: !1, line: 2, type: !13, isLocal: true, isDefinition: true, scopeLine: 2, isOptimized: true, unit: !0, variables: !14)
+!13 = !DISubroutineType(types: !11)
+!14 = !{!16}
+!16 = !DILocalVariable(name: "a", arg: 1, scope: !12, file: !1, line: 2, type: !10)
+!17 = !DILocation(line: 2, column: 1, scope: !12)
+!18 = distinct !DISubprogram(name: "bump", scope: !1, file: !1, line: 3, type: !20, isLocal: false, isDefinition: true, scopeLine: 3, isOptimized: true, unit: !0, variables: !2)
+!19 = !DILocation(line: 3, column: 1, scope: !18)
+!20 = !DISubroutineType(types: !21)
+!21 = !{null}
@@ -0,0 +1,109 @@
+; Check that running function passes on multiple threads gives the same result
+; as running them on one thread.
+
+; RUN: opt -S -O2 < %s > %t.serial.ll
+; RUN: opt -S -O2 -function-pass-threads=4 < %s > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+
+; RUN: opt -S -passes='function(sroa,instcombine,simplify-cfg)' < %s \
+; RUN:   > %t.serial.newpm.ll
+; RUN: opt -S -passes='function(sroa,instcombine,simplify-cfg)' \
+; RUN:   -function-pass-threads=4 < %s > %t.parallel.newpm.ll
+; RUN: diff %t.serial.newpm.ll %t.parallel.newpm.ll
+; RUN: FileCheck %s < %t.parallel.newpm.ll
+
+; RUN: not opt -S -passes='globaldce' -function-pass-threads=4 < %s 2>&1 \
+; RUN:   | FileCheck --check-prefix=ERR %s
+; ERR: -function-pass-threads requires a pass pipeline of the form 'function(...)'
+
+%struct.pair = type { i32, i32 }
+%struct.node = type { %struct.node*, i32 }
+
+@counter = global i32 0, align 1
+@msg = private unnamed_addr constant [6 x i8] c"hello\00"
+
+declare i32 @puts(i8*)
+
+; CHECK-LABEL: define i32 @sum_pair(
+; CHECK-NOT: alloca
+; CHECK: ret i32
+define i32 @sum_pair(i32 %a, i32 %b) {
+entry:
+  %p = alloca %struct.pair
+  %x = getelementptr %struct.pair, %struct.pair* %p, i32 0, i32 0
+  %y = getelementptr %struct.pair, %struct.pair* %p, i32 0, i32 1
+  store i32 %a, i32* %x
+  store i32 %b, i32* %y
+  %0 = load i32, i32* %x
+  %1 = load i32, i32* %y
+  %add = add i32 %0, %1
+  ret i32 %add
+}
+
+; CHECK-LABEL: define i32 @length(
+define i32 @length(%struct.node* %n) {
+entry:
+  br label %loop
+
+loop:
+  %cur = phi %struct.node* [ %n, %entry ], [ %next, %body ]
+  %len = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %done = icmp eq %struct.node* %cur, null
+  br i1 %done, label %exit, label %body
+
+body:
+  %inc = add i32 %len, 1
+  %nextp = getelementptr %struct.node, %struct.node* %cur, i32 0, i32 0
+  %next = load %struct.node*, %struct.node** %nextp
+  br label %loop
+
+exit:
+  ret i32 %len
+}
+
+; CHECK-LABEL: define void @bump(
+; CHECK: load i32, i32* @counter
+define void @bump() {
+entry:
+  %0 = load i32, i32* @counter
+  %1 = add i32 %0, 1
+  %2 = add i32 %1, 1
+  store i32 %2, i32* @counter
+  ret void
+}
+
+; CHECK-LABEL: define i32 @greet(
+; CHECK: call i32 @puts(
+define i32 @greet() {
+entry:
+  %s = getelementptr [6 x i8], [6 x i8]* @msg, i32 0, i32 0
+  %r = call i32 @puts(i8* %s)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @select_max(
+; CHECK: select
+define i32 @select_max(i32 %a, i32 %b) {
+entry:
+  %cmp = icmp sgt i32 %a, %b
+  br i1 %cmp, label %then, label %else
+
+then:
+  br label %end
+
+else:
+  br label %end
+
+end:
+  %r = phi i32 [ %a, %then ], [ %b, %else ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @caller(
+define i32 @caller(i32 %a) {
+entry:
+  %s = call i32 @sum_pair(i32 %a, i32 %a)
+  %m = call i32 @select_max(i32 %s, i32 7)
+  call void @bump()
+  ret i32 %m
+}
@@ -0,0 +1,38 @@
+; RUN: opt -disable-output -print-memory-census < %s 2>&1 | FileCheck %s
+; RUN: opt -disable-output -passes=verify -print-memory-census < %s 2>&1 \
+; RUN:   | FileCheck %s
+
+; CHECK: ... IR Memory Census ...
+; CHECK: Count   Object bytes  Operand bytes   Name bytes    Total bytes  Kind
+; CHECK-DAG: {{^ +2 +[0-9]+ +0 +[1-9][0-9]* +[0-9]+  Argument$}}
+; CHECK-DAG: {{^ +3 +[0-9]+ +0 +[1-9][0-9]* +[0-9]+  BasicBlock$}}
+; CHECK-DAG: {{^ +2 +[0-9]+ +0 +0 +[0-9]+  ConstantInt$}}
+; CHECK-DAG: {{^ +1 +[0-9]+ +[1-9][0-9]* +[1-9][0-9]* +[0-9]+  phi$}}
+; CHECK-DAG: {{^ +2 +[0-9]+ +[1-9][0-9]* +[1-9][0-9]* +[0-9]+  add$}}
+; CHECK-DAG: {{^ +1 +[0-9]+ +[0-9]+ +[1-9][0-9]* +[0-9]+  Function$}}
+; CHECK-DAG: {{^ +1 +[0-9]+ +[0-9]+ +[1-9][0-9]* +[0-9]+  GlobalVariable$}}
+; CHECK-DAG: {{^ +2 +[0-9]+ +[1-9][0-9]* +0 +[0-9]+  MDTuple$}}
+; CHECK-DAG: {{^ +1 +[1-9][0-9]* +0 +0 +[0-9]+  MDString$}}
+; CHECK-DAG: {{^ +1 +[1-9][0-9]* +0 +0 +[0-9]+  ConstantAsMetadata$}}
+; CHECK: {{^ +[0-9]+ +[0-9]+ +[0-9]+ +[0-9]+ +[0-9]+  Total$}}
+
+@counter = global i32 7
+
+define i32 @f(i32 %a, i1 %c) {
+entry:
+  br i1 %c, label %then, label %exit
+
+then:
+  %x = add i32 %a, 1, !annotation !1
+  br label %exit
+
+exit:
+  %p = phi i32 [ %x, %then ], [ %a, %entry ]
+  %r = add i32 %p, 1
+  ret i32 %r
+}
+
+!named = !{!0}
+
+!0 = !{!"census", i32 1}
+!1 = !{!0}
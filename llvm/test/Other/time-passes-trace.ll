@@ -0,0 +1,27 @@
+; RUN: opt -instcombine -time-passes-trace=%t.legacy.json -disable-output %s
+; RUN: FileCheck --check-prefix=LEGACY --input-file=%t.legacy.json %s
+; RUN: opt -passes=instcombine -time-passes-trace=%t.new.json \
+; RUN:     -disable-output %s
+; RUN: FileCheck --check-prefix=NEW --input-file=%t.new.json %s
+
+; LEGACY: {"traceEvents":[
+; LEGACY-DAG: {"ph":"X","pid":1,"tid":0,"ts":{{[0-9]+\.[0-9]+}},"dur":{{[0-9]+\.[0-9]+}},"name":"Combine redundant instructions","args":{"detail":"foo","allocated bytes":{{[0-9]+}}}}
+; LEGACY-DAG: "name":"Combine redundant instructions","args":{"detail":"bar"
+; LEGACY: ]}
+
+; NEW: {"traceEvents":[
+; NEW-DAG: "name":"InstCombinePass","args":{"detail":"foo"
+; NEW-DAG: "name":"InstCombinePass","args":{"detail":"bar"
+; NEW-DAG: "name":"DominatorTreeAnalysis","args":{"detail":"foo"
+; NEW-DAG: {"ph":"C","pid":1,"tid":0,"ts":{{[0-9]+\.[0-9]+}},"name":"DominatorTreeAnalysis","args":{"hits":{{[0-9]+}},"misses":2}}
+; NEW: ]}
+
+define i32 @foo(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
+
+define i32 @bar(i32 %x) {
+  %a = mul i32 %x, 1
+  ret i32 %a
+}
@@ -0,0 +1,44 @@
+; REQUIRES: asserts
+; RUN: opt -module-summary %s -o %t.bc
+; RUN: opt -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; Backends are started in decreasing order of the instruction counts in the
+; summaries, rather than in module order, and -time-passes reports the time
+; spent in the backend for each module.
+; RUN: llvm-lto2 -o %t.o %t2.bc %t.bc -thinlto-threads=1 \
+; RUN:  -debug-only=lto -time-passes \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx \
+; RUN:  -r=%t.bc,_g,plx \
+; RUN:  -r=%t.bc,_other,plx 2>&1 | FileCheck %s
+
+; CHECK: Starting ThinLTO backend for {{.*}}backend-schedule.ll.tmp.bc (estimated cost {{[0-9]+}})
+; CHECK: Starting ThinLTO backend for {{.*}}backend-schedule.ll.tmp2.bc (estimated cost {{[0-9]+}})
+; CHECK: ThinLTO Backend Timing
+; CHECK-DAG: backend-schedule.ll.tmp.bc
+; CHECK-DAG: backend-schedule.ll.tmp2.bc
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+@g = global i32 0
+
+define void @globalfunc() {
+entry:
+  %0 = load i32, i32* @g
+  %1 = add i32 %0, 1
+  %2 = mul i32 %1, 3
+  %3 = xor i32 %2, 5
+  store i32 %3, i32* @g
+  ret void
+}
+
+define i32 @other(i32 %a) {
+entry:
+  %0 = mul i32 %a, %a
+  %1 = add i32 %0, %a
+  %2 = shl i32 %1, 2
+  %3 = sub i32 %2, %a
+  ret i32 %3
+}
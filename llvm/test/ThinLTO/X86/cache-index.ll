@@ -0,0 +1,36 @@
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; With a size limit, llvm-lto2 records the cache entries in an index.
+; RUN: rm -Rf %t.cache && mkdir %t.cache
+; RUN: llvm-lto2 -o %t.o %t2.bc  %t.bc -cache-dir %t.cache \
+; RUN:  -cache-max-size-bytes=1 \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache | FileCheck %s
+; RUN: cat %t.cache/llvmcache.index | count 2
+
+; The entries were just used, so they survive pruning, and a second link
+; hits them.
+; RUN: llvm-lto2 -o %t.o %t2.bc  %t.bc -cache-dir %t.cache \
+; RUN:  -cache-max-size-bytes=1 \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache | FileCheck %s
+; RUN: cat %t.cache/llvmcache.index | count 2
+
+; CHECK: llvmcache-
+; CHECK: llvmcache-
+; CHECK-NOT: llvmcache-tmp
+; CHECK: llvmcache.index
+; CHECK-NOT: llvmcache.index.
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() #0 {
+entry:
+  ret void
+}
@@ -0,0 +1,56 @@
+; REQUIRES: asserts
+; RUN: opt < %s -basicaa -loop-interchange -verify-dom-info \
+; RUN:   -debug-only=loop-interchange -S -o /dev/null 2>&1 | FileCheck %s
+;; The dominator tree is updated with the edges each interchange changes, and
+;; is preserved. The second pair of loops is checked for legality with the tree
+;; left by the first interchange.
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@A = common global [100 x [100 x [100 x i32]]] zeroinitializer
+
+;;  for(int i=0;i<100;i++)
+;;    for(int j=0;j<100;j++)
+;;      for(int k=0;k<100;k++)
+;;        A[k][j][i] = A[k][j][i]+1;
+
+; CHECK: Processing Inner Loop Id = 2 and OuterLoopId = 1
+; CHECK: Loops interchanged
+; CHECK: Processing Inner Loop Id = 1 and OuterLoopId = 0
+
+define void @interchange_nest() {
+entry:
+  br label %for.i.header
+
+for.i.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.i.latch ]
+  br label %for.j.header
+
+for.j.header:
+  %j = phi i64 [ 0, %for.i.header ], [ %j.next, %for.j.latch ]
+  br label %for.k
+
+for.k:
+  %k = phi i64 [ 0, %for.j.header ], [ %k.next, %for.k ]
+  %arrayidx = getelementptr inbounds [100 x [100 x [100 x i32]]], [100 x [100 x [100 x i32]]]* @A, i64 0, i64 %k, i64 %j, i64 %i
+  %0 = load i32, i32* %arrayidx
+  %add = add nsw i32 %0, 1
+  store i32 %add, i32* %arrayidx
+  %k.next = add nuw nsw i64 %k, 1
+  %exitcond.k = icmp eq i64 %k.next, 100
+  br i1 %exitcond.k, label %for.j.latch, label %for.k
+
+for.j.latch:
+  %j.next = add nuw nsw i64 %j, 1
+  %exitcond.j = icmp eq i64 %j.next, 100
+  br i1 %exitcond.j, label %for.i.latch, label %for.j.header
+
+for.i.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond.i = icmp eq i64 %i.next, 100
+  br i1 %exitcond.i, label %for.end, label %for.i.header
+
+for.end:
+  ret void
+}
@@ -0,0 +1,53 @@
+; RUN: opt < %s -S -loop-unroll -unroll-count=4 -verify-dom-info | FileCheck %s
+
+; Partial unrolling updates the dominator tree edge by edge. The loop has a
+; diamond and an early exit, so the exit blocks are reached from every copy
+; and their immediate dominators change.
+
+; The copies of the header are folded into the latch before them.
+; CHECK-LABEL: @early_exit(
+; CHECK: for.body:
+; CHECK: latch:
+; CHECK-NEXT: phi
+; CHECK: br i1 %is.k.1, label %found, label %check.1
+; CHECK: found:
+; CHECK-SAME: preds = %latch.2, %latch.1, %latch, %for.body
+; CHECK: check.1:
+; CHECK: check.2:
+; CHECK: check.3:
+; CHECK: latch.3:
+; CHECK: br i1 %done.3, label %exit, label %for.body
+
+define i32 @early_exit(i32* %p, i32 %k) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %latch ]
+  %gep = getelementptr inbounds i32, i32* %p, i32 %i
+  %v = load i32, i32* %gep
+  %is.k = icmp eq i32 %v, %k
+  br i1 %is.k, label %found, label %check
+
+check:
+  %odd = and i32 %v, 1
+  %is.odd = icmp ne i32 %odd, 0
+  br i1 %is.odd, label %add, label %latch
+
+add:
+  %s = add i32 %sum, %v
+  br label %latch
+
+latch:
+  %sum.next = phi i32 [ %sum, %check ], [ %s, %add ]
+  %i.next = add nuw nsw i32 %i, 1
+  %done = icmp eq i32 %i.next, 100
+  br i1 %done, label %exit, label %for.body
+
+found:
+  ret i32 %i
+
+exit:
+  ret i32 %sum.next
+}
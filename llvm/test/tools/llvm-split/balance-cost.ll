@@ -0,0 +1,57 @@
+; Partitions are balanced by the number of instructions of their functions,
+; and functions that call each other are kept together while that does not
+; unbalance the partitions.
+
+; RUN: llvm-split -j=2 -split-module-balance-cost -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; @big is too large to be merged with its caller @e.
+; CHECK0: define i32 @big
+; CHECK0: declare void @a
+; CHECK0: declare void @b
+; CHECK0: declare void @c
+; CHECK0: declare void @d
+; CHECK0: define void @e
+
+; CHECK1: declare i32 @big
+; CHECK1: define void @a
+; CHECK1: define void @b
+; CHECK1: define void @c
+; CHECK1: define void @d
+; CHECK1: declare void @e
+
+define i32 @big(i32 %x) {
+  %1 = add i32 %x, 1
+  %2 = add i32 %1, 2
+  %3 = add i32 %2, 3
+  %4 = add i32 %3, 4
+  %5 = add i32 %4, 5
+  %6 = add i32 %5, 6
+  %7 = add i32 %6, 7
+  %8 = add i32 %7, 8
+  ret i32 %8
+}
+
+define void @a() {
+  call void @b()
+  ret void
+}
+
+define void @b() {
+  ret void
+}
+
+define void @c() {
+  call void @d()
+  ret void
+}
+
+define void @d() {
+  ret void
+}
+
+define void @e() {
+  call i32 @big(i32 0)
+  ret void
+}
@@ -20,6 +20,7 @@
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/LTO/Caching.h"
 #include "llvm/LTO/LTO.h"
+#include "llvm/Support/CacheIndex.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -167,6 +168,8 @@ namespace options {
   static std::string thinlto_prefix_replace;
   // Optional path to a directory for caching ThinLTO objects.
   static std::string cache_dir;
+  // If non-zero, the maximum size of the cache directory in bytes.
+  static uint64_t cache_max_size_bytes = 0;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -209,6 +212,10 @@ namespace options {
         message(LDPL_FATAL, "thinlto-prefix-replace expects 'old;new' format");
     } else if (opt.startswith("cache-dir=")) {
       cache_dir = opt.substr(strlen("cache-dir="));
+    } else if (opt.startswith("cache-max-size-bytes=")) {
+      if (opt.substr(strlen("cache-max-size-bytes="))
+              .getAsInteger(10, cache_max_size_bytes))
+        message(LDPL_FATAL, "Invalid cache-max-size-bytes: %s", opt.data());
     } else if (opt.size() == 2 && opt[0] == 'O') {
       if (opt[1] < '0' || opt[1] > '3')
         message(LDPL_FATAL, "Optimization level must be between 0 and 3");
@@ -834,11 +841,22 @@ static ld_plugin_status allSymbolsReadHook() {
   auto AddFile = [&](size_t Task, StringRef Path) { Filenames[Task] = Path; };
 
   NativeObjectCache Cache;
-  if (!options::cache_dir.empty())
-    Cache = localCache(options::cache_dir, AddFile);
+  if (!options::cache_dir.empty()) {
+    if (options::cache_max_size_bytes)
+      Cache = indexedCache(options::cache_dir, AddFile);
+    else
+      Cache = localCache(options::cache_dir, AddFile);
+  }
 
   check(Lto->run(AddStream, Cache));
 
+  // Entries that this link uses are too recent to be evicted, so they stay
+  // in the cache until gold has read them.
+  if (!options::cache_dir.empty() && options::cache_max_size_bytes)
+    CacheIndex(options::cache_dir)
+        .setMaxSizeBytes(options::cache_max_size_bytes)
+        .prune();
+
   if (options::TheOutputType == options::OT_DISABLE ||
       options::TheOutputType == options::OT_BC_ONLY)
     return LDPS_OK;
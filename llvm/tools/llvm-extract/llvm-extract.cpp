@@ -112,7 +112,8 @@ int main(int argc, char **argv) {
 
   // Use lazy loading, since we only care about selected global values.
   SMDiagnostic Err;
-  std::unique_ptr<Module> M = getLazyIRFileModule(InputFilename, Err, Context);
+  std::unique_ptr<Module> M = getLazyIRFileModule(
+      InputFilename, Err, Context, /*ShouldLazyLoadMetadata=*/true);
 
   if (!M.get()) {
     Err.print(argv[0], errs());
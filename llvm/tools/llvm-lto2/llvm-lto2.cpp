@@ -19,10 +19,13 @@
 #include "llvm/LTO/Caching.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/MemoryCensus.h"
 #include "llvm/LTO/LTO.h"
+#include "llvm/Support/CacheIndex.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Threading.h"
+#include <mutex>
 
 using namespace llvm;
 using namespace lto;
@@ -48,6 +51,17 @@ static cl::opt<std::string> OutputFilename("o", cl::Required,
 static cl::opt<std::string> CacheDir("cache-dir", cl::desc("Cache Directory"),
                                      cl::value_desc("directory"));
 
+static cl::opt<uint64_t> CacheMaxSizeBytes(
+    "cache-max-size-bytes",
+    cl::desc("Keep the cache directory under this many bytes by evicting the "
+             "least recently used entries"),
+    cl::init(0));
+
+static cl::opt<bool> PrintMemoryCensus(
+    "print-memory-census",
+    cl::desc("Print the memory used by the IR of each task after "
+             "optimization, by kind of value"));
+
 static cl::opt<std::string> OptPipeline("opt-pipeline",
                                         cl::desc("Optimizer Pipeline"),
                                         cl::value_desc("pipeline"));
@@ -176,6 +190,22 @@ int main(int argc, char **argv) {
     check(Conf.addSaveTemps(OutputFilename + "."),
           "Config::addSaveTemps failed");
 
+  if (PrintMemoryCensus) {
+    Config::ModuleHookFn PrevHook = Conf.PostOptModuleHook;
+    Conf.PostOptModuleHook = [PrevHook](unsigned Task, const Module &M) {
+      IRMemoryCensus Census;
+      Census.addModule(M);
+      {
+        // ThinLTO backends run this hook concurrently.
+        static std::mutex PrintMutex;
+        std::lock_guard<std::mutex> Lock(PrintMutex);
+        errs() << "Task " << Task << ":\n";
+        Census.print(errs());
+      }
+      return !PrevHook || PrevHook(Task, M);
+    };
+  }
+
   // Run a custom pipeline, if asked for.
   Conf.OptPipeline = OptPipeline;
   Conf.AAPipeline = AAPipeline;
@@ -267,8 +297,15 @@ int main(int argc, char **argv) {
   };
 
   NativeObjectCache Cache;
-  if (!CacheDir.empty())
-    Cache = localCache(CacheDir, AddFile);
+  if (!CacheDir.empty()) {
+    if (CacheMaxSizeBytes)
+      Cache = indexedCache(CacheDir, AddFile);
+    else
+      Cache = localCache(CacheDir, AddFile);
+  }
 
   check(Lto.run(AddStream, Cache), "LTO::run failed");
+
+  if (!CacheDir.empty() && CacheMaxSizeBytes)
+    CacheIndex(CacheDir).setMaxSizeBytes(CacheMaxSizeBytes).prune();
 }
@@ -30,6 +30,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO/ParallelFunctionPasses.h"
 
 using namespace llvm;
 using namespace opt_tool;
@@ -47,13 +48,79 @@ static cl::opt<std::string>
                         "pipeline for handling managed aliasing queries"),
                cl::Hidden);
 
+/// Returns true if \p PassPipeline is a single function pass manager, such as
+/// "function(instcombine,gvn)".
+static bool isFunctionPipeline(StringRef PassPipeline) {
+  if (!PassPipeline.startswith("function("))
+    return false;
+  int Depth = 0;
+  for (size_t I = strlen("function"), E = PassPipeline.size(); I != E; ++I) {
+    if (PassPipeline[I] == '(')
+      ++Depth;
+    else if (PassPipeline[I] == ')' && --Depth == 0)
+      return I + 1 == E;
+  }
+  return false;
+}
+
+/// Runs \p PassPipeline on a partition of a module on a worker thread. The
+/// pipeline has already been checked on the main thread.
+static void runPartitionPipeline(Module &M, TargetMachine *TM,
+                                 StringRef PassPipeline, bool VerifyEachPass) {
+  PassBuilder PB(TM);
+  AAManager AA;
+  PB.parseAAPipeline(AA, AAPipeline);
+
+  LoopAnalysisManager LAM(DebugPM);
+  FunctionAnalysisManager FAM(DebugPM);
+  CGSCCAnalysisManager CGAM(DebugPM);
+  ModuleAnalysisManager MAM(DebugPM);
+  FAM.registerPass([&] { return std::move(AA); });
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  ModulePassManager MPM(DebugPM);
+  PB.parsePassPipeline(MPM, PassPipeline, VerifyEachPass, DebugPM);
+  MPM.run(M, MAM);
+}
+
+namespace {
+/// Runs a function pipeline on partitions of a module on multiple threads.
+class ParallelFunctionPipelinePass
+    : public PassInfoMixin<ParallelFunctionPipelinePass> {
+  unsigned NumThreads;
+  std::function<void(Module &)> RunPipeline;
+
+public:
+  ParallelFunctionPipelinePass(unsigned NumThreads,
+                               std::function<void(Module &)> RunPipeline)
+      : NumThreads(NumThreads), RunPipeline(std::move(RunPipeline)) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &) {
+    runFunctionPassesInParallel(M, NumThreads, RunPipeline);
+    return PreservedAnalyses::none();
+  }
+};
+} // end anonymous namespace
+
 bool llvm::runPassPipeline(StringRef Arg0, Module &M,
                            TargetMachine *TM, tool_output_file *Out,
                            StringRef PassPipeline, OutputKind OK,
                            VerifierKind VK,
                            bool ShouldPreserveAssemblyUseListOrder,
                            bool ShouldPreserveBitcodeUseListOrder,
-                           bool EmitSummaryIndex, bool EmitModuleHash) {
+                           bool EmitSummaryIndex, bool EmitModuleHash,
+                           unsigned FunctionPassThreads,
+                           std::function<TargetMachine *()> CreateTM) {
+  if (FunctionPassThreads > 1 && !isFunctionPipeline(PassPipeline)) {
+    errs() << Arg0 << ": -function-pass-threads requires a pass pipeline of "
+                      "the form 'function(...)'.\n";
+    return false;
+  }
+
   PassBuilder PB(TM);
 
   // Specially handle the alias analysis manager so that we can register
@@ -83,8 +150,25 @@ bool llvm::runPassPipeline(StringRef Arg0, Module &M,
   if (VK > VK_NoVerifier)
     MPM.addPass(VerifierPass());
 
-  if (!PB.parsePassPipeline(MPM, PassPipeline, VK == VK_VerifyEachPass,
-                            DebugPM)) {
+  if (FunctionPassThreads > 1) {
+    // Parse the pipeline once here to report errors. Each thread parses it
+    // again for its own pass manager.
+    ModulePassManager Unused(DebugPM);
+    if (!PB.parsePassPipeline(Unused, PassPipeline, VK == VK_VerifyEachPass,
+                              DebugPM)) {
+      errs() << Arg0 << ": unable to parse pass pipeline description.\n";
+      return false;
+    }
+
+    bool VerifyEachPass = VK == VK_VerifyEachPass;
+    MPM.addPass(ParallelFunctionPipelinePass(
+        FunctionPassThreads, [=](Module &PartM) {
+          std::unique_ptr<TargetMachine> PartTM(CreateTM());
+          runPartitionPipeline(PartM, PartTM.get(), PassPipeline,
+                               VerifyEachPass);
+        }));
+  } else if (!PB.parsePassPipeline(MPM, PassPipeline, VK == VK_VerifyEachPass,
+                                   DebugPM)) {
     errs() << Arg0 << ": unable to parse pass pipeline description.\n";
     return false;
   }
@@ -21,6 +21,8 @@
 #ifndef LLVM_TOOLS_OPT_NEWPMDRIVER_H
 #define LLVM_TOOLS_OPT_NEWPMDRIVER_H
 
+#include <functional>
+
 namespace llvm {
 class StringRef;
 class LLVMContext;
@@ -47,13 +49,19 @@ enum VerifierKind {
 /// inclusion of the new pass manager headers and the old headers into the same
 /// file. It's interface is consequentially somewhat ad-hoc, but will go away
 /// when the transition finishes.
+///
+/// If \p FunctionPassThreads is greater than one, the pipeline must consist of
+/// a single 'function(...)' pass, and it is run on that many threads. Each
+/// thread calls \p CreateTM to get its own target machine.
 bool runPassPipeline(StringRef Arg0, Module &M,
                      TargetMachine *TM, tool_output_file *Out,
                      StringRef PassPipeline, opt_tool::OutputKind OK,
                      opt_tool::VerifierKind VK,
                      bool ShouldPreserveAssemblyUseListOrder,
                      bool ShouldPreserveBitcodeUseListOrder,
-                     bool EmitSummaryIndex, bool EmitModuleHash);
+                     bool EmitSummaryIndex, bool EmitModuleHash,
+                     unsigned FunctionPassThreads,
+                     std::function<TargetMachine *()> CreateTM);
 }
 
 #endif
@@ -30,6 +30,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/LegacyPassNameParser.h"
+#include "llvm/IR/MemoryCensus.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
@@ -41,6 +42,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/PluginLoader.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
@@ -53,6 +55,7 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Coroutines.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include "llvm/Transforms/IPO/ParallelFunctionPasses.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include <algorithm>
@@ -201,6 +204,11 @@ static cl::opt<bool>
 PrintBreakpoints("print-breakpoints-for-testing",
                  cl::desc("Print select breakpoints location for testing"));
 
+static cl::opt<bool> PrintMemoryCensus(
+    "print-memory-census",
+    cl::desc("Print the memory used by the IR after optimization, by kind of "
+             "value"));
+
 static cl::opt<std::string>
 DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
@@ -241,6 +249,18 @@ static cl::opt<std::string>
                     cl::desc("YAML output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+static cl::opt<unsigned> FunctionPassThreads(
+    "function-pass-threads",
+    cl::desc("Run the early function simplification passes of -O<n> or a "
+             "'function(...)' pipeline on this many threads (the module "
+             "passes of -O<n> still run on one thread)"),
+    cl::init(1));
+
+// The optimization levels that were added with AddOptimizationPasses, in
+// order. With -function-pass-threads, each thread builds its own function
+// pass manager from this list.
+static std::vector<std::pair<unsigned, unsigned>> FunctionPassLevels;
+
 static inline void addPass(legacy::PassManagerBase &PM, Pass *P) {
   // Add the pass to the pass manager...
   PM.add(P);
@@ -250,14 +270,10 @@ static inline void addPass(legacy::PassManagerBase &PM, Pass *P) {
     PM.add(createVerifierPass());
 }
 
-/// This routine adds optimization passes based on selected optimization level,
-/// OptLevel.
-///
-/// OptLevel - Optimization Level
-static void AddOptimizationPasses(legacy::PassManagerBase &MPM,
-                                  legacy::FunctionPassManager &FPM,
-                                  TargetMachine *TM, unsigned OptLevel,
-                                  unsigned SizeLevel) {
+static void PopulateOptimizationPasses(legacy::PassManagerBase &MPM,
+                                       legacy::FunctionPassManager &FPM,
+                                       TargetMachine *TM, unsigned OptLevel,
+                                       unsigned SizeLevel) {
   if (!NoVerify || VerifyEach)
     FPM.add(createVerifierPass()); // Verify that input is correct
 
@@ -302,6 +318,18 @@ static void AddOptimizationPasses(legacy::PassManagerBase &MPM,
   Builder.populateModulePassManager(MPM);
 }
 
+/// This routine adds optimization passes based on selected optimization level,
+/// OptLevel.
+///
+/// OptLevel - Optimization Level
+static void AddOptimizationPasses(legacy::PassManagerBase &MPM,
+                                  legacy::FunctionPassManager &FPM,
+                                  TargetMachine *TM, unsigned OptLevel,
+                                  unsigned SizeLevel) {
+  FunctionPassLevels.push_back({OptLevel, SizeLevel});
+  PopulateOptimizationPasses(MPM, FPM, TM, OptLevel, SizeLevel);
+}
+
 static void AddStandardLinkPasses(legacy::PassManagerBase &PM) {
   PassManagerBuilder Builder;
   Builder.VerifyInput = true;
@@ -346,6 +374,12 @@ static TargetMachine* GetTargetMachine(Triple TheTriple, StringRef CPUStr,
                                         CMModel, GetCodeGenOptLevel());
 }
 
+static void printMemoryCensus(const Module &M) {
+  IRMemoryCensus Census;
+  Census.addModule(M);
+  Census.print(errs());
+}
+
 #ifdef LINK_POLLY_INTO_TOOLS
 namespace polly {
 void initializePollyPasses(llvm::PassRegistry &Registry);
@@ -410,6 +444,9 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (FunctionPassThreads > 1)
+    parallel::setThreadBudget(FunctionPassThreads);
+
   SMDiagnostic Err;
 
   Context.setDiscardValueNames(DiscardValueNames);
@@ -514,12 +551,18 @@ int main(int argc, char **argv) {
     // The user has asked to use the new pass manager and provided a pipeline
     // string. Hand off the rest of the functionality to the new code for that
     // layer.
-    return runPassPipeline(argv[0], *M, TM.get(), Out.get(),
-                           PassPipeline, OK, VK, PreserveAssemblyUseListOrder,
-                           PreserveBitcodeUseListOrder, EmitSummaryIndex,
-                           EmitModuleHash)
-               ? 0
-               : 1;
+    auto CreateTM = [&]() -> TargetMachine * {
+      if (!ModuleTriple.getArch())
+        return nullptr;
+      return GetTargetMachine(ModuleTriple, CPUStr, FeaturesStr, Options);
+    };
+    bool Succeeded = runPassPipeline(
+        argv[0], *M, TM.get(), Out.get(), PassPipeline, OK, VK,
+        PreserveAssemblyUseListOrder, PreserveBitcodeUseListOrder,
+        EmitSummaryIndex, EmitModuleHash, FunctionPassThreads, CreateTM);
+    if (Succeeded && PrintMemoryCensus)
+      printMemoryCensus(*M);
+    return Succeeded ? 0 : 1;
   }
 
   // Create a PassManager to hold and optimize the collection of passes we are
@@ -674,7 +717,29 @@ int main(int argc, char **argv) {
   if (OptLevelO3)
     AddOptimizationPasses(Passes, *FPasses, TM.get(), 3, 0);
 
-  if (FPasses) {
+  if (FPasses && FunctionPassThreads > 1) {
+    // Target machines cache subtargets and are not thread-safe, so each
+    // thread creates its own target machine and function pass manager.
+    runFunctionPassesInParallel(*M, FunctionPassThreads, [&](Module &PartM) {
+      std::unique_ptr<TargetMachine> PartTM;
+      if (ModuleTriple.getArch())
+        PartTM.reset(
+            GetTargetMachine(ModuleTriple, CPUStr, FeaturesStr, Options));
+
+      legacy::PassManager UnusedMPM;
+      legacy::FunctionPassManager FPM(&PartM);
+      FPM.add(createTargetTransformInfoWrapperPass(
+          PartTM ? PartTM->getTargetIRAnalysis() : TargetIRAnalysis()));
+      for (const std::pair<unsigned, unsigned> &Level : FunctionPassLevels)
+        PopulateOptimizationPasses(UnusedMPM, FPM, PartTM.get(), Level.first,
+                                   Level.second);
+
+      FPM.doInitialization();
+      for (Function &F : PartM)
+        FPM.run(F);
+      FPM.doFinalization();
+    });
+  } else if (FPasses) {
     FPasses->doInitialization();
     for (Function &F : *M)
       FPasses->run(F);
@@ -730,6 +795,9 @@ int main(int argc, char **argv) {
   // Now that we have all of the passes ready, run them.
   Passes.run(*M);
 
+  if (PrintMemoryCensus)
+    printMemoryCensus(*M);
+
   // Compare the two outputs and make sure they're the same
   if (RunTwice) {
     assert(Out);
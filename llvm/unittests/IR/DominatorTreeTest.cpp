@@ -251,6 +251,126 @@ namespace llvm {
       Passes.add(P);
       Passes.run(*M);
     }
+
+    // Replace the terminator of BB with a branch to Succs, or with a return
+    // if Succs is empty.
+    void setSuccessors(BasicBlock *BB, ArrayRef<BasicBlock *> Succs) {
+      LLVMContext &Context = BB->getContext();
+      if (TerminatorInst *TI = BB->getTerminator())
+        TI->eraseFromParent();
+      if (Succs.empty()) {
+        ReturnInst::Create(Context, BB);
+        return;
+      }
+      IntegerType *Int32Ty = Type::getInt32Ty(Context);
+      SwitchInst *SI = SwitchInst::Create(ConstantInt::get(Int32Ty, 0),
+                                          Succs[0], Succs.size() - 1, BB);
+      for (unsigned I = 1, E = Succs.size(); I != E; ++I)
+        SI->addCase(ConstantInt::get(Int32Ty, I), Succs[I]);
+    }
+
+    std::unique_ptr<Module> makeFunctionWithBlocks(LLVMContext &Context,
+                                                   unsigned NumBlocks) {
+      auto M = make_unique<Module>("M", Context);
+      Function *F = Function::Create(
+          FunctionType::get(Type::getVoidTy(Context), false),
+          GlobalValue::ExternalLinkage, "f", M.get());
+      for (unsigned I = 0; I != NumBlocks; ++I)
+        setSuccessors(BasicBlock::Create(Context, "", F), None);
+      return M;
+    }
+
+    TEST(DominatorTree, InsertDeleteEdges) {
+      LLVMContext Context;
+      std::unique_ptr<Module> M = makeFunctionWithBlocks(Context, 6);
+      Function &F = *M->begin();
+      SmallVector<BasicBlock *, 6> BBs;
+      for (BasicBlock &BB : F)
+        BBs.push_back(&BB);
+
+      // 0 -> 1 -> 2 -> 3
+      setSuccessors(BBs[0], BBs[1]);
+      setSuccessors(BBs[1], BBs[2]);
+      setSuccessors(BBs[2], BBs[3]);
+      DominatorTree DT(F);
+      EXPECT_EQ(DT.getNode(BBs[3])->getLevel(), 3u);
+      EXPECT_FALSE(DT.isReachableFromEntry(BBs[4]));
+
+      // A shortcut 0 -> 3 makes 0 the immediate dominator of 3.
+      BasicBlock *Succs0[] = {BBs[1], BBs[3]};
+      setSuccessors(BBs[0], Succs0);
+      DT.insertEdge(BBs[0], BBs[3]);
+      EXPECT_TRUE(DT.verify());
+      EXPECT_EQ(DT.getNode(BBs[3])->getIDom()->getBlock(), BBs[0]);
+      EXPECT_EQ(DT.getNode(BBs[3])->getLevel(), 1u);
+
+      // An edge to unreachable blocks brings them in: 2 -> 4 -> 5 -> 3.
+      setSuccessors(BBs[4], BBs[5]);
+      setSuccessors(BBs[5], BBs[3]);
+      BasicBlock *Succs2[] = {BBs[3], BBs[4]};
+      setSuccessors(BBs[2], Succs2);
+      DT.insertEdge(BBs[2], BBs[4]);
+      EXPECT_TRUE(DT.verify());
+      EXPECT_EQ(DT.getNode(BBs[5])->getIDom()->getBlock(), BBs[4]);
+      EXPECT_EQ(DT.getNode(BBs[4])->getLevel(), 3u);
+
+      // Deleting 1 -> 2 makes 2, 4 and 5 unreachable again.
+      setSuccessors(BBs[1], None);
+      DT.deleteEdge(BBs[1], BBs[2]);
+      EXPECT_TRUE(DT.verify());
+      EXPECT_FALSE(DT.isReachableFromEntry(BBs[2]));
+      EXPECT_FALSE(DT.isReachableFromEntry(BBs[5]));
+      EXPECT_TRUE(DT.isReachableFromEntry(BBs[3]));
+
+      // A batch that cancels out, and one that only the CFG's final state
+      // makes sense of.
+      DT.applyUpdates({{DominatorTree::Insert, BBs[1], BBs[2]},
+                       {DominatorTree::Delete, BBs[1], BBs[2]}});
+      EXPECT_TRUE(DT.verify());
+      setSuccessors(BBs[1], BBs[4]);
+      setSuccessors(BBs[0], BBs[1]);
+      DT.applyUpdates({{DominatorTree::Insert, BBs[1], BBs[4]},
+                       {DominatorTree::Delete, BBs[0], BBs[3]}});
+      EXPECT_TRUE(DT.verify());
+      EXPECT_EQ(DT.getNode(BBs[3])->getIDom()->getBlock(), BBs[5]);
+    }
+
+    TEST(DominatorTree, RandomUpdates) {
+      const unsigned NumBlocks = 24;
+      LLVMContext Context;
+      std::unique_ptr<Module> M = makeFunctionWithBlocks(Context, NumBlocks);
+      Function &F = *M->begin();
+      SmallVector<BasicBlock *, NumBlocks> BBs;
+      for (BasicBlock &BB : F)
+        BBs.push_back(&BB);
+      SmallVector<SmallVector<BasicBlock *, 4>, NumBlocks> Succs(NumBlocks);
+
+      DominatorTree DT(F);
+      uint32_t Seed = 42;
+      auto Random = [&](unsigned N) {
+        Seed = Seed * 1103515245 + 12345;
+        return (Seed >> 16) % N;
+      };
+      for (unsigned Round = 0; Round != 200; ++Round) {
+        // Toggle a few random edges, never to the entry block, as one batch.
+        SmallVector<DominatorTree::UpdateType, 4> Updates;
+        for (unsigned I = 0, E = 1 + Random(4); I != E; ++I) {
+          unsigned From = Random(NumBlocks);
+          BasicBlock *To = BBs[1 + Random(NumBlocks - 1)];
+          auto It = find(Succs[From], To);
+          if (It != Succs[From].end()) {
+            Succs[From].erase(It);
+            Updates.push_back({DominatorTree::Delete, BBs[From], To});
+          } else {
+            Succs[From].push_back(To);
+            Updates.push_back({DominatorTree::Insert, BBs[From], To});
+          }
+          setSuccessors(BBs[From], Succs[From]);
+        }
+        DT.applyUpdates(Updates);
+        ASSERT_TRUE(DT.verify()) << "after round " << Round;
+      }
+    }
   }
 }
 
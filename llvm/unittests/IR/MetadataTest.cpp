@@ -883,6 +883,27 @@ TEST_F(DILocationTest, cloneTemporary) {
   EXPECT_TRUE(L2->isTemporary());
 }
 
+TEST_F(DILocationTest, UniquingManyLocations) {
+  DISubprogram *N = getSubprogram();
+  size_t InitialSize = Context.getUniquedMDNodeMemorySize();
+
+  std::vector<DILocation *> Locations;
+  for (unsigned Line = 0; Line != 10000; ++Line)
+    Locations.push_back(DILocation::get(Context, Line, Line % 80, N));
+  size_t Size = Context.getUniquedMDNodeMemorySize();
+  EXPECT_LT(InitialSize + 10000 * sizeof(DILocation), Size);
+
+  // Looking the locations up again finds the same nodes and allocates
+  // nothing.
+  for (unsigned Line = 0; Line != 10000; ++Line)
+    EXPECT_EQ(Locations[Line], DILocation::get(Context, Line, Line % 80, N));
+  EXPECT_EQ(Size, Context.getUniquedMDNodeMemorySize());
+  EXPECT_EQ(nullptr, DILocation::getIfExists(Context, 10000, 0, N));
+
+  // A temporary copy of a location collides with it when it is uniqued.
+  EXPECT_EQ(Locations[0], MDNode::replaceWithUniqued(Locations[0]->clone()));
+}
+
 typedef MetadataTest GenericDINodeTest;
 
 TEST_F(GenericDINodeTest, get) {
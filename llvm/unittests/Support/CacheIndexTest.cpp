@@ -0,0 +1,115 @@
+//===- unittests/CacheIndexTest.cpp - CacheIndex tests --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CacheIndex.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class CacheIndexTest : public testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("CacheIndexTestDir", Dir));
+  }
+
+  void TearDown() override {
+    std::error_code EC;
+    for (sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC;
+         I.increment(EC))
+      sys::fs::remove(I->path());
+    sys::fs::remove(Dir);
+  }
+
+  std::string getPath(StringRef Name) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name);
+    return Path.str();
+  }
+
+  void addEntry(const CacheIndex &Index, StringRef Key, size_t Size) {
+    int FD;
+    SmallString<128> TempPath;
+    ASSERT_FALSE(Index.createTemporaryEntry(FD, TempPath));
+    {
+      raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      OS << std::string(Size, 'x');
+    }
+    ASSERT_FALSE(Index.commit(TempPath, Key));
+  }
+
+  void writeIndex(StringRef Contents) {
+    std::error_code EC;
+    raw_fd_ostream OS(getPath("llvmcache.index"), EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  }
+
+  SmallString<128> Dir;
+};
+
+TEST_F(CacheIndexTest, LookupAndCommit) {
+  CacheIndex Index(Dir);
+  EXPECT_FALSE(Index.lookup("a"));
+  addEntry(Index, "a", 10);
+  EXPECT_TRUE(Index.lookup("a"));
+  EXPECT_TRUE(sys::fs::exists(Index.getEntryPath("a")));
+  EXPECT_TRUE(sys::fs::exists(getPath("llvmcache.index")));
+}
+
+TEST_F(CacheIndexTest, PruneEvictsLeastRecentlyUsed) {
+  CacheIndex Index(Dir);
+  Index.setMaxSizeBytes(250).setMinEntryAge(std::chrono::seconds(0));
+  addEntry(Index, "a", 100);
+  addEntry(Index, "b", 100);
+  addEntry(Index, "c", 100);
+  // "a" was used after "b", and its older record is superseded.
+  writeIndex("a 100 1\nb 100 2\nc 100 3\na 100 4\n");
+
+  EXPECT_TRUE(Index.prune());
+  EXPECT_TRUE(sys::fs::exists(Index.getEntryPath("a")));
+  EXPECT_FALSE(sys::fs::exists(Index.getEntryPath("b")));
+  EXPECT_TRUE(sys::fs::exists(Index.getEntryPath("c")));
+  EXPECT_FALSE(sys::fs::exists(getPath("llvmcache.index.old")));
+  EXPECT_FALSE(sys::fs::exists(getPath("llvmcache.index.lock")));
+
+  // The compacted index still accounts for the remaining entries.
+  Index.setMaxSizeBytes(150);
+  EXPECT_TRUE(Index.prune());
+  EXPECT_FALSE(sys::fs::exists(Index.getEntryPath("c")));
+  EXPECT_TRUE(sys::fs::exists(Index.getEntryPath("a")));
+}
+
+TEST_F(CacheIndexTest, PruneKeepsRecentlyUsedEntries) {
+  CacheIndex Index(Dir);
+  Index.setMaxSizeBytes(1);
+  addEntry(Index, "a", 100);
+  EXPECT_TRUE(Index.prune());
+  EXPECT_TRUE(sys::fs::exists(Index.getEntryPath("a")));
+}
+
+TEST_F(CacheIndexTest, PruneSkipsWhenLocked) {
+  CacheIndex Index(Dir);
+  Index.setMaxSizeBytes(1).setMinEntryAge(std::chrono::seconds(0));
+  addEntry(Index, "a", 100);
+  {
+    std::error_code EC;
+    raw_fd_ostream Lock(getPath("llvmcache.index.lock"), EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+  }
+  EXPECT_FALSE(Index.prune());
+  EXPECT_TRUE(sys::fs::exists(Index.getEntryPath("a")));
+}
+
+} // end anonymous namespace
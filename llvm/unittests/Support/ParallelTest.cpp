@@ -0,0 +1,110 @@
+//===- llvm/unittest/Support/ParallelTest.cpp -----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Parallel.h unit tests.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Parallel.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <numeric>
+#include <random>
+#include <thread>
+
+using namespace llvm;
+
+static uint32_t array[1024 * 1024];
+
+TEST(Parallel, sort) {
+  std::mt19937 randEngine;
+  std::uniform_int_distribution<uint32_t> dist;
+
+  for (auto &i : array)
+    i = dist(randEngine);
+
+  parallel_sort(std::begin(array), std::end(array));
+  ASSERT_TRUE(std::is_sorted(std::begin(array), std::end(array)));
+}
+
+TEST(Parallel, parallel_for) {
+  // We need to test the case with a TaskSize > 1. We are white-box testing
+  // here. The TaskSize is calculated as (End - Begin) / 1024 at the time of
+  // writing.
+  uint32_t range[2050];
+  std::fill(range, range + 2050, 1);
+  parallel_for(0, 2049, [&range](size_t I) { ++range[I]; });
+
+  uint32_t expected[2049];
+  std::fill(expected, expected + 2049, 2);
+  ASSERT_TRUE(std::equal(range, range + 2049, expected));
+  // Check that we don't write past the end of the requested range.
+  ASSERT_EQ(range[2049], 1u);
+}
+
+TEST(Parallel, transform_reduce) {
+  // Sum the lengths of these strings in parallel.
+  const char *strs[] = {"a", "ab", "abc", "abcd", "abcde", "abcdef"};
+  size_t lenSum =
+      parallel_transform_reduce(std::begin(strs), std::end(strs), size_t(0),
+                                std::plus<size_t>(),
+                                [](const char *s) { return strlen(s); });
+  EXPECT_EQ(lenSum, static_cast<size_t>(21));
+
+  // Check that we handle non-divisible task sizes as above.
+  uint32_t range[2050];
+  std::fill(std::begin(range), std::end(range), 1);
+  uint32_t sum = parallel_transform_reduce(
+      std::begin(range), std::end(range), uint32_t(0), std::plus<uint32_t>(),
+      [](uint32_t x) { return x; });
+  EXPECT_EQ(sum, 2050u);
+
+  // The result of a non-commutative reduction doesn't depend on
+  // scheduling.
+  std::vector<std::string> words(5000);
+  for (size_t i = 0; i < words.size(); ++i)
+    words[i] = std::to_string(i % 10);
+  std::string concat = parallel_transform_reduce(
+      words.begin(), words.end(), std::string(),
+      [](std::string a, std::string b) { return a + b; },
+      [](const std::string &s) { return s; });
+  EXPECT_EQ(concat, std::accumulate(words.begin(), words.end(),
+                                    std::string()));
+}
+
+TEST(Parallel, nested) {
+  // Each outer task waits for an inner task group. This must not
+  // deadlock even if there are more outer tasks than threads.
+  std::atomic<size_t> count{0};
+  parallel_for(0, 64, [&](size_t) {
+    parallel_for(0, 64, [&](size_t) { ++count; });
+  });
+  EXPECT_EQ(count, 64u * 64u);
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(Parallel, syncRunsOnlyOwnTasks) {
+  // A thread waiting for a task group must not run tasks of other
+  // groups, which may be waiting for it. Here the outer tasks can't
+  // finish until the inner group has been synced.
+  std::atomic<bool> done{false};
+  parallel::TaskGroup outer;
+  for (int i = 0; i < 64; ++i)
+    outer.spawn([&] {
+      while (!done)
+        std::this_thread::yield();
+    });
+  {
+    parallel::TaskGroup inner;
+    inner.spawn([] {});
+  }
+  done = true;
+}
+#endif
@@ -0,0 +1,49 @@
+//===- unittests/TimeTraceTest.cpp - TraceEventWriter tests ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeTrace.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(TraceEventWriterTest, Empty) {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  TraceEventWriter(OS).finish();
+  EXPECT_EQ("{\"traceEvents\":[\n\n]}\n", OS.str());
+}
+
+TEST(TraceEventWriterTest, Events) {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  TraceEventWriter Writer(OS);
+  Writer.writeComplete("Total", 0, 0, 1234567);
+  Writer.writeComplete("a \"b\"\\c\n", 1, 1500, 20,
+                       {TraceEventArg("detail", "x"),
+                        TraceEventArg("bytes", uint64_t(42))});
+  Writer.writeCounter("Usage", 0, 2000, TraceEventArg("bytes", uint64_t(7)));
+  Writer.finish(TraceEventArg("peak", uint64_t(9)));
+  EXPECT_EQ(
+      "{\"traceEvents\":[\n"
+      "{\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":0.000,\"dur\":1234.567,"
+      "\"name\":\"Total\"},\n"
+      "{\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":1.500,\"dur\":0.020,"
+      "\"name\":\"a \\\"b\\\"\\\\c\\u000a\","
+      "\"args\":{\"detail\":\"x\",\"bytes\":42}},\n"
+      "{\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":2.000,\"name\":\"Usage\","
+      "\"args\":{\"bytes\":7}}\n"
+      "],\n"
+      "\"otherData\":{\"peak\":9}}\n",
+      OS.str());
+}
+
+} // end anonymous namespace
@@ -23,7 +23,8 @@
 /// The generated file defines a single method:
 ///     bool <Target>InstructionSelector::selectImpl(MachineInstr &I) const;
 /// intended to be used in InstructionSelector::select as the first-step
-/// selector for the patterns that don't require complex C++.
+/// selector for the patterns that don't require complex C++. Patterns guarded
+/// by subtarget features test them on the selector's STI member.
 ///
 /// FIXME: We'll probably want to eventually define a base
 /// "TargetGenInstructionSelector" class.
@@ -108,6 +109,28 @@ static bool isTrivialOperatorNode(const TreePatternNode *N) {
   return !N->isLeaf() && !N->hasAnyPredicate() && !N->getTransformFn();
 }
 
+/// Return true if \p CondString only combines calls to argument-less methods
+/// of the subtarget, like "Subtarget->hasSSE2() && !Subtarget->hasAVX()".
+static bool isSubtargetFeatureCheck(StringRef CondString) {
+  const StringRef Call = "Subtarget->";
+  while (!CondString.empty()) {
+    if (CondString.startswith(Call)) {
+      StringRef Method = CondString.drop_front(Call.size());
+      size_t NameLength = Method.find_first_not_of(
+          "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+      if (NameLength == 0 || NameLength == StringRef::npos ||
+          !Method.drop_front(NameLength).startswith("()"))
+        return false;
+      CondString = Method.drop_front(NameLength + 2);
+      continue;
+    }
+    if (StringRef("!&|() \t\n").find(CondString.front()) == StringRef::npos)
+      return false;
+    CondString = CondString.drop_front();
+  }
+  return true;
+}
+
 //===- Matchers -----------------------------------------------------------===//
 
 struct Matcher {
@@ -173,6 +196,13 @@ struct MatchMBBOp : public Matcher {
   }
 };
 
+struct MatchPredicate : public Matcher {
+  MatchPredicate(StringRef CondString) : CondString(CondString) {}
+  std::string CondString;
+
+  virtual void emit(raw_ostream &OS) const { OS << CondString; }
+};
+
 struct MutateOpcode : public MatchAction {
   MutateOpcode(const CodeGenInstruction *I) : I(I) {}
   const CodeGenInstruction *I;
@@ -180,6 +210,20 @@ struct MutateOpcode : public MatchAction {
   virtual void emit(raw_ostream &OS) const {
     OS << "I.setDesc(TII.get(" << I->Namespace << "::" << I->TheDef->getName()
        << "));";
+
+    // setDesc doesn't add the operands that the new opcode implies: tie the
+    // two-address operands, and add the physical registers it clobbers. The
+    // pattern doesn't use them, so they are dead.
+    for (const CGIOperandList::OperandInfo &Op : I->Operands) {
+      int TiedTo = Op.getTiedRegister();
+      if (TiedTo != -1)
+        OS << "\n    I.tieOperands(" << TiedTo << ", " << Op.MIOperandNo
+           << ");";
+    }
+    for (Record *Def : I->ImplicitDefs)
+      OS << "\n    MachineInstrBuilder(MF, &I).addDef("
+         << Def->getValueAsString("Namespace") << "::" << Def->getName()
+         << ", RegState::Implicit | RegState::Dead);";
   }
 };
 
@@ -238,9 +282,18 @@ GlobalISelEmitter::runOnPattern(const PatternToMatch &P, raw_ostream &OS) {
   MatcherEmitter M(P);
 
   // First, analyze the whole pattern.
-  // If the entire pattern has a predicate (e.g., target features), ignore it.
-  if (!P.getPredicates()->getValues().empty())
-    return SkipReason{"Pattern has a predicate"};
+  // Predicates that only test subtarget features can be checked against the
+  // subtarget of the selector; ignore the patterns with any other predicate.
+  std::vector<std::string> Predicates;
+  for (Init *PredInit : P.getPredicates()->getValues()) {
+    Record *Pred = cast<DefInit>(PredInit)->getDef();
+    std::string CondString = Pred->getValueAsString("CondString");
+    if (CondString.empty())
+      continue;
+    if (!isSubtargetFeatureCheck(CondString))
+      return SkipReason{"Pattern has a non-subtarget predicate"};
+    Predicates.push_back(CondString);
+  }
 
   // Physreg imp-defs require additional logic.  Ignore the pattern.
   if (!P.getDstRegs().empty())
@@ -262,6 +315,10 @@ GlobalISelEmitter::runOnPattern(const PatternToMatch &P, raw_ostream &OS) {
 
   auto &DstI = Target.getInstruction(DstOp);
 
+  // Physreg imp-uses would need to be defined first.  Ignore the pattern.
+  if (!DstI.ImplicitUses.empty())
+    return SkipReason{"Dst MI reads a physical register"};
+
   auto SrcGIOrNull = findNodeEquiv(Src->getOperator());
   if (!SrcGIOrNull)
     return SkipReason{"Pattern operator lacks an equivalent Instruction"};
@@ -269,6 +326,8 @@ GlobalISelEmitter::runOnPattern(const PatternToMatch &P, raw_ostream &OS) {
 
   // The operators look good: match the opcode and mutate it to the new one.
   M.Matchers.emplace_back(new MatchOpcode(&SrcGI));
+  for (const std::string &CondString : Predicates)
+    M.Matchers.emplace_back(new MatchPredicate(CondString));
   M.Actions.emplace_back(new MutateOpcode(&DstI));
 
   // Next, analyze the children, only accepting patterns that don't require
@@ -360,9 +419,11 @@ void GlobalISelEmitter::run(raw_ostream &OS) {
   emitSourceFileHeader(("Global Instruction Selector for the " +
                        Target.getName() + " target").str(), OS);
   OS << "bool " << Target.getName()
-     << "InstructionSelector::selectImpl"
-        "(MachineInstr &I) const {\n  const MachineRegisterInfo &MRI = "
-        "I.getParent()->getParent()->getRegInfo();\n";
+     << "InstructionSelector::selectImpl(MachineInstr &I) const {\n"
+        "  MachineFunction &MF = *I.getParent()->getParent();\n"
+        "  const MachineRegisterInfo &MRI = MF.getRegInfo();\n"
+        "  const auto *Subtarget = &STI;\n"
+        "  (void)Subtarget;\n";
 
   // Look through the SelectionDAG patterns we found, possibly emitting some.
   for (const PatternToMatch &Pat : CGP.ptms()) {
@@ -0,0 +1,136 @@
+#!/usr/bin/env python
+"""Measures the time to materialize the first function of a large bitcode file.
+
+This program generates a module with many functions that share TBAA metadata,
+until the bitcode file reaches the requested size. It prints
+the size of the metadata and function blocks as reported by llvm-bcanalyzer,
+and then times llvm-extract pulling out a single function, once with lazy
+loading of metadata and once with -disable-ondemand-mds-loading, which parses
+the whole module metadata block up front.
+
+Example:
+  bitcode_lazy_load_bench.py --bindir build/bin --size-mb 100
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import tempfile
+import time
+
+
+def write_module(f, num_functions):
+  # Each function calls the previous one, so that extracting @f0 needs a
+  # single function body. Function i uses TBAA tags i and i - 1, so each tag
+  # is shared by two functions and ends up in the module-level metadata
+  # block, which lazy loading doesn't have to read in full.
+  tag_base = 100 + 2 * num_functions
+  for i in range(num_functions):
+    loc = 2 * i + 101
+    f.write('define i32 @f%d(i32* %%p, i32 %%x) !dbg !%d {\n' % (i, loc - 1))
+    f.write('  %%v = load i32, i32* %%p, !dbg !%d, !tbaa !%d\n' %
+            (loc, tag_base + 2 * i))
+    if i > 0:
+      f.write('  %%w = load i32, i32* %%p, !dbg !%d, !tbaa !%d\n' %
+              (loc, tag_base + 2 * (i - 1)))
+      f.write('  %%a = add i32 %%v, %%w, !dbg !%d\n' % loc)
+      f.write('  %%r = call i32 @f%d(i32* %%p, i32 %%a), !dbg !%d\n' %
+              (i - 1, loc))
+    else:
+      f.write('  %%r = add i32 %%v, %%x, !dbg !%d\n' % loc)
+    f.write('  ret i32 %%r, !dbg !%d\n' % loc)
+    f.write('}\n\n')
+
+  f.write('!llvm.dbg.cu = !{!0}\n')
+  f.write('!llvm.module.flags = !{!3}\n')
+  f.write('!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, '
+          'producer: "bench", isOptimized: true, runtimeVersion: 0, '
+          'emissionKind: FullDebug, enums: !2)\n')
+  f.write('!1 = !DIFile(filename: "bench.c", directory: "/tmp")\n')
+  f.write('!2 = !{}\n')
+  f.write('!3 = !{i32 2, !"Debug Info Version", i32 3}\n')
+  f.write('!4 = !DISubroutineType(types: !2)\n')
+  f.write('!12 = !{!"omnipotent char", !13, i64 0}\n')
+  f.write('!13 = !{!"Simple C/C++ TBAA"}\n')
+  for i in range(num_functions):
+    sp = 2 * i + 100
+    f.write('!%d = distinct !DISubprogram(name: "f%d", scope: !1, file: !1, '
+            'line: %d, type: !4, isLocal: false, isDefinition: true, '
+            'scopeLine: %d, isOptimized: true, unit: !0, variables: !2)\n' %
+            (sp, i, i + 1, i + 1))
+    f.write('!%d = !DILocation(line: %d, column: 3, scope: !%d)\n' %
+            (sp + 1, i + 1, sp))
+    tag = tag_base + 2 * i
+    f.write('!%d = !{!%d, !%d, i64 0}\n' % (tag, tag + 1, tag + 1))
+    f.write('!%d = !{!"type%d", !12, i64 0}\n' % (tag + 1, i))
+
+
+def block_sizes(bindir, bc):
+  out = subprocess.check_output([os.path.join(bindir, 'llvm-bcanalyzer'), bc])
+  sizes = {}
+  block = None
+  for line in out.decode().splitlines():
+    m = re.match(r'\s*Block ID #\d+ \((\w+)\):', line)
+    if m:
+      block = m.group(1)
+      continue
+    m = re.match(r'\s*Total Size: (\d+)b', line)
+    if m and block:
+      sizes[block] = int(m.group(1)) // 8
+      block = None
+  return sizes
+
+
+def time_extract(bindir, bc, extra_args, repeat):
+  best = None
+  for _ in range(repeat):
+    start = time.time()
+    subprocess.check_call([os.path.join(bindir, 'llvm-extract'), '-func=f0',
+                           bc, '-o', os.devnull] + extra_args)
+    elapsed = time.time() - start
+    best = elapsed if best is None else min(best, elapsed)
+  return best
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', required=True,
+                      help='Directory containing llvm-as, llvm-bcanalyzer '
+                           'and llvm-extract')
+  parser.add_argument('--size-mb', type=int, default=100,
+                      help='Approximate size of the bitcode file')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='Number of runs; the fastest one is reported')
+  args = parser.parse_args()
+
+  tmpdir = tempfile.mkdtemp()
+  ll = os.path.join(tmpdir, 'bench.ll')
+  bc = os.path.join(tmpdir, 'bench.bc')
+
+  # Each function takes about 150 bytes of bitcode.
+  num_functions = max(args.size_mb * 1024 * 1024 // 150, 2)
+  with open(ll, 'w') as f:
+    write_module(f, num_functions)
+  subprocess.check_call([os.path.join(args.bindir, 'llvm-as'), ll, '-o', bc])
+  os.remove(ll)
+
+  print('bitcode size: %.1f MB, %d functions' %
+        (os.path.getsize(bc) / 1048576.0, num_functions))
+  for name, size in sorted(block_sizes(args.bindir, bc).items()):
+    print('  %-24s %12d bytes' % (name, size))
+
+  lazy = time_extract(args.bindir, bc, [], args.repeat)
+  eager = time_extract(args.bindir, bc, ['-disable-ondemand-mds-loading'],
+                       args.repeat)
+  print('time to first function (lazy metadata):  %.3f s' % lazy)
+  print('time to first function (eager metadata): %.3f s' % eager)
+  os.remove(bc)
+  os.rmdir(tmpdir)
+
+
+if __name__ == '__main__':
+  main()
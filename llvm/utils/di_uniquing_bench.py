@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+"""Measures the time to build and unique many DILocations.
+
+This program generates a module whose functions have one DILocation for each
+instruction, all different, and times llvm-as parsing it. Parsing a module
+with debug info spends most of its time creating and uniquing metadata
+nodes, so this is a good proxy for the cost of the uniquing tables.
+
+Example:
+  di_uniquing_bench.py --bindir build/bin --locations 2000000
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+
+def write_module(f, num_functions, locations_per_function):
+  # Metadata !0 - !4 is shared; function i has subprogram 5 + i and its
+  # locations follow all the subprograms.
+  loc = 5 + num_functions
+  for i in range(num_functions):
+    f.write('define i32 @f%d(i32 %%x) !dbg !%d {\n' % (i, 5 + i))
+    f.write('  %%v0 = add i32 %%x, 1, !dbg !%d\n' % loc)
+    for j in range(1, locations_per_function):
+      f.write('  %%v%d = add i32 %%v%d, 1, !dbg !%d\n' % (j, j - 1, loc + j))
+    f.write('  ret i32 %%v%d\n' % (locations_per_function - 1))
+    f.write('}\n\n')
+    loc += locations_per_function
+
+  f.write('!llvm.dbg.cu = !{!0}\n')
+  f.write('!llvm.module.flags = !{!3}\n')
+  f.write('!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, '
+          'producer: "bench", isOptimized: true, runtimeVersion: 0, '
+          'emissionKind: FullDebug, enums: !2)\n')
+  f.write('!1 = !DIFile(filename: "bench.c", directory: "/tmp")\n')
+  f.write('!2 = !{}\n')
+  f.write('!3 = !{i32 2, !"Debug Info Version", i32 3}\n')
+  f.write('!4 = !DISubroutineType(types: !2)\n')
+  for i in range(num_functions):
+    f.write('!%d = distinct !DISubprogram(name: "f%d", scope: !1, file: !1, '
+            'line: %d, type: !4, isLocal: false, isDefinition: true, '
+            'scopeLine: %d, isOptimized: true, unit: !0, variables: !2)\n' %
+            (5 + i, i, i + 1, i + 1))
+  loc = 5 + num_functions
+  for i in range(num_functions):
+    for j in range(locations_per_function):
+      f.write('!%d = !DILocation(line: %d, column: %d, scope: !%d)\n' %
+              (loc, j // 16 + 1, j % 16 + 1, 5 + i))
+      loc += 1
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', required=True,
+                      help='Directory containing llvm-as')
+  parser.add_argument('--locations', type=int, default=1000000,
+                      help='Number of DILocations in the module')
+  parser.add_argument('--locations-per-function', type=int, default=1000,
+                      help='Number of DILocations in each function')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='Number of runs; the fastest one is reported')
+  args = parser.parse_args()
+
+  per_function = max(args.locations_per_function, 1)
+  num_functions = max(args.locations // per_function, 1)
+  tmpdir = tempfile.mkdtemp()
+  ll = os.path.join(tmpdir, 'bench.ll')
+  with open(ll, 'w') as f:
+    write_module(f, num_functions, per_function)
+
+  best = None
+  for _ in range(args.repeat):
+    start = time.time()
+    subprocess.check_call([os.path.join(args.bindir, 'llvm-as'), ll, '-o',
+                           os.devnull])
+    elapsed = time.time() - start
+    best = elapsed if best is None else min(best, elapsed)
+  print('%d DILocations in %d functions: %.3f s' %
+        (num_functions * per_function, num_functions, best))
+  os.remove(ll)
+  os.rmdir(tmpdir)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+"""Compares the -O0 compile time of GlobalISel and FastISel.
+
+This program compiles each bitcode or textual IR file it is given with llc at
+-O0, once with the default FastISel/SelectionDAG path and once with
+-global-isel, and reports the time llc took (the fastest of several runs). It
+also reports how many functions GlobalISel could not handle and left to
+SelectionDAG: those make the GlobalISel time an overestimate, since both
+selectors run on them. Bitcode for a whole program can be collected from the
+LLVM test-suite by building it with -save-temps.
+
+Example:
+  gisel_bench.py --bindir build/bin test-suite-build/**/*.bc
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import time
+
+SELECTORS = [
+    ('fastisel', []),
+    ('globalisel', ['-global-isel', '-global-isel-abort=2']),
+]
+
+FALLBACK_RE = re.compile(r'Instruction selection used fallback path for')
+
+
+def run_llc(llc, path, selector_args, extra_args):
+  cmd = [llc, path, '-o', os.devnull, '-filetype=obj', '-O0'] + \
+      selector_args + extra_args
+  start = time.time()
+  proc = subprocess.Popen(cmd, stderr=subprocess.PIPE,
+                          universal_newlines=True)
+  _, err = proc.communicate()
+  elapsed = time.time() - start
+  if proc.returncode != 0:
+    raise RuntimeError('%s failed:\n%s' % (' '.join(cmd), err))
+  fallbacks = sum(1 for line in err.splitlines() if FALLBACK_RE.search(line))
+  return elapsed, fallbacks
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', required=True,
+                      help='Directory containing llc')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='Number of runs; the fastest one is reported')
+  parser.add_argument('--llc-arg', action='append', default=[],
+                      help='Extra argument to pass to llc')
+  parser.add_argument('inputs', nargs='+', help='Bitcode or IR files')
+  args = parser.parse_args()
+
+  llc = os.path.join(args.bindir, 'llc')
+  totals = dict((name, 0.0) for name, _ in SELECTORS)
+  total_fallbacks = 0
+  print('%-40s' % 'file' +
+        ''.join('%14s' % (name + ' s') for name, _ in SELECTORS) +
+        '%10s' % 'fallbacks')
+  for path in args.inputs:
+    row = '%-40s' % os.path.basename(path)[-40:]
+    for name, selector_args in SELECTORS:
+      best = None
+      for _ in range(args.repeat):
+        elapsed, fallbacks = run_llc(llc, path, selector_args, args.llc_arg)
+        best = elapsed if best is None else min(best, elapsed)
+      totals[name] += best
+      row += '%14.3f' % best
+    total_fallbacks += fallbacks
+    print(row + '%10d' % fallbacks)
+  print('%-40s' % 'total' +
+        ''.join('%14.3f' % totals[name] for name, _ in SELECTORS) +
+        '%10d' % total_fallbacks)
+
+
+if __name__ == '__main__':
+  main()
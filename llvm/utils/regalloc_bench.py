@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+"""Compares the compile time and spill code of the register allocators.
+
+This program compiles each bitcode or textual IR file it is given with llc,
+once for each register allocator, and reports the time llc took (the fastest
+of several runs) and the number of spill and reload instructions the allocator
+inserted. Bitcode for a whole program can be collected from the LLVM
+test-suite by building it with -save-temps, or with -flto and the
+-save-temps option of the linker.
+
+The spill counts come from -stats, so llc must be built with assertions or
+with LLVM_FORCE_ENABLE_STATS.
+
+Example:
+  regalloc_bench.py --bindir build/bin -O1 test-suite-build/**/*.bc
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import time
+
+ALLOCATORS = ['fast', 'linearscan', 'greedy']
+
+# Statistics of the regalloc debug type that count inserted spill code. The
+# fast allocator counts its own stores and loads; the others use the inline
+# spiller.
+SPILL_STATS = [
+    'Number of stores added',
+    'Number of loads added',
+    'Number of spills inserted',
+    'Number of reloads inserted',
+]
+
+STAT_RE = re.compile(r'^\s*(\d+)\s+regalloc\s+-\s+(.*?)\s*$')
+
+
+def run_llc(llc, path, allocator, opt_level, extra_args):
+  cmd = [llc, path, '-o', os.devnull, '-filetype=obj', '-O%s' % opt_level,
+         '-regalloc=%s' % allocator, '-stats'] + extra_args
+  start = time.time()
+  proc = subprocess.Popen(cmd, stderr=subprocess.PIPE,
+                          universal_newlines=True)
+  _, err = proc.communicate()
+  elapsed = time.time() - start
+  if proc.returncode != 0:
+    raise RuntimeError('%s failed:\n%s' % (' '.join(cmd), err))
+  spills = 0
+  for line in err.splitlines():
+    m = STAT_RE.match(line)
+    if m and m.group(2) in SPILL_STATS:
+      spills += int(m.group(1))
+  return elapsed, spills
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', required=True,
+                      help='Directory containing llc')
+  parser.add_argument('-O', dest='opt_level', default='2',
+                      help='Optimization level to pass to llc')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='Number of runs; the fastest one is reported')
+  parser.add_argument('--llc-arg', action='append', default=[],
+                      help='Extra argument to pass to llc')
+  parser.add_argument('inputs', nargs='+', help='Bitcode or IR files')
+  args = parser.parse_args()
+
+  llc = os.path.join(args.bindir, 'llc')
+  totals = dict((a, [0.0, 0]) for a in ALLOCATORS)
+  print('%-40s' % 'file' +
+        ''.join('%12s %8s' % (a + ' s', 'spills') for a in ALLOCATORS))
+  for path in args.inputs:
+    row = '%-40s' % os.path.basename(path)[-40:]
+    for allocator in ALLOCATORS:
+      best = None
+      for _ in range(args.repeat):
+        elapsed, spills = run_llc(llc, path, allocator, args.opt_level,
+                                  args.llc_arg)
+        best = elapsed if best is None else min(best, elapsed)
+      totals[allocator][0] += best
+      totals[allocator][1] += spills
+      row += '%12.3f %8d' % (best, spills)
+    print(row)
+  print('%-40s' % 'total' +
+        ''.join('%12.3f %8d' % tuple(totals[a]) for a in ALLOCATORS))
+
+
+if __name__ == '__main__':
+  main()
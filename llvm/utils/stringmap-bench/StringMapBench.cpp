@@ -0,0 +1,164 @@
+//===- StringMapBench - Benchmark StringMap on symbol names ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program times hashing, inserting and looking up symbol names in a
+// StringMap, and outputs the run time. The names are read from a file with one
+// name per line, such as the output of "llvm-nm -just-symbol-name", or are
+// generated to look like the mangled C++ and C names of a large program.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string>
+    Input(cl::Positional, cl::desc("<file with one name per line>"));
+
+static cl::opt<unsigned> NumNames("names",
+                                  cl::desc("Number of names to generate"),
+                                  cl::init(1000000));
+
+static cl::opt<unsigned> Iterations("iterations",
+                                    cl::desc("Number of times to run each "
+                                             "benchmark"),
+                                    cl::init(5));
+
+/// Returns a random identifier of Itanium-mangled length and alphabet.
+static std::string createIdentifier(std::mt19937 &Rand) {
+  static const char Chars[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+  std::string Id;
+  unsigned Length = 3 + Rand() % 16;
+  for (unsigned I = 0; I != Length; ++I)
+    Id += Chars[Rand() % (I == 0 ? 53 : sizeof(Chars) - 1)];
+  return Id;
+}
+
+/// Creates names that share namespaces and classes like the symbols of a C++
+/// program do, with a sprinkle of short C names.
+static std::vector<std::string> createNames(unsigned N) {
+  std::mt19937 Rand(42);
+  std::vector<std::string> Namespaces, Classes;
+  for (unsigned I = 0; I != 20; ++I)
+    Namespaces.push_back(createIdentifier(Rand));
+  for (unsigned I = 0; I != 2000; ++I)
+    Classes.push_back(createIdentifier(Rand));
+
+  static const char *const Params[] = {"v", "i", "j", "Pc", "PKc", "RKS_",
+                                       "RKNS_9StringRefE", "m", "b"};
+  std::vector<std::string> Names;
+  Names.reserve(N);
+  for (unsigned I = 0; I != N; ++I) {
+    if (Rand() % 8 == 0) {
+      Names.push_back(createIdentifier(Rand));
+      continue;
+    }
+    std::string Name = "_ZN";
+    for (unsigned J = 0, E = 1 + Rand() % 2; J != E; ++J) {
+      const std::string &NS = Namespaces[Rand() % Namespaces.size()];
+      Name += utostr(NS.size()) + NS;
+    }
+    const std::string &Class = Classes[Rand() % Classes.size()];
+    std::string Method = createIdentifier(Rand);
+    Name += utostr(Class.size()) + Class + utostr(Method.size()) + Method + "E";
+    for (unsigned J = 0, E = 1 + Rand() % 3; J != E; ++J)
+      Name += Params[Rand() % array_lengthof(Params)];
+    Names.push_back(std::move(Name));
+  }
+  return Names;
+}
+
+static void benchmark(TimerGroup &Group, ArrayRef<std::string> Names) {
+  // Names that are not in the map, but share their prefix with names that are.
+  std::vector<std::string> Misses;
+  Misses.reserve(Names.size());
+  for (const std::string &Name : Names)
+    Misses.push_back(Name + "x");
+
+  Timer Bernstein("hash.bernstein", "Hash: Bernstein (HashString)", Group);
+  Timer XXHash("hash.xxhash", "Hash: xxHash64", Group);
+  Timer Insert("insert", "StringMap: Insert", Group);
+  Timer Hit("lookup.hit", "StringMap: Successful lookup", Group);
+  Timer Miss("lookup.miss", "StringMap: Failed lookup", Group);
+
+  uint64_t Sum = 0;
+  for (unsigned I = 0; I != Iterations; ++I) {
+    Bernstein.startTimer();
+    for (const std::string &Name : Names)
+      Sum += HashString(Name);
+    Bernstein.stopTimer();
+
+    XXHash.startTimer();
+    for (const std::string &Name : Names)
+      Sum += xxHash64(Name);
+    XXHash.stopTimer();
+
+    StringMap<unsigned> Map;
+    Insert.startTimer();
+    for (const std::string &Name : Names)
+      ++Map[Name];
+    Insert.stopTimer();
+
+    Hit.startTimer();
+    for (const std::string &Name : Names)
+      Sum += Map.count(Name);
+    Hit.stopTimer();
+
+    Miss.startTimer();
+    for (const std::string &Name : Misses)
+      Sum += Map.count(Name);
+    Miss.stopTimer();
+  }
+  volatile uint64_t DontOptimizeOut = Sum;
+  (void)DontOptimizeOut;
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "StringMap benchmark\n");
+
+  std::vector<std::string> Names;
+  if (Input.getNumOccurrences()) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+        MemoryBuffer::getFileOrSTDIN(Input);
+    if (!BufOrErr) {
+      errs() << Input << ": " << BufOrErr.getError().message() << '\n';
+      return 1;
+    }
+    SmallVector<StringRef, 0> Lines;
+    BufOrErr.get()->getBuffer().split(Lines, '\n', -1, false);
+    for (StringRef Line : Lines)
+      Names.push_back(Line.trim());
+  } else {
+    Names = createNames(NumNames);
+  }
+
+  if (Names.empty()) {
+    errs() << "No names to benchmark\n";
+    return 1;
+  }
+  uint64_t Bytes = 0;
+  for (const std::string &Name : Names)
+    Bytes += Name.size();
+  outs() << Names.size() << " names of " << Bytes / Names.size()
+         << " bytes on average\n";
+
+  TimerGroup Group("stringmap", "StringMap benchmark");
+  benchmark(Group, Names);
+  return 0;
+}